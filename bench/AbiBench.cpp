@@ -0,0 +1,145 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include "BenchData.h"
+#include "../utils/Contract.h"
+#include "abi/UniswapV2Pair.h"
+#include "abi/UniswapV3Pool.h"
+
+// Selector-only call: getReserves()
+static void BM_EncodeFunction_NoArgs(benchmark::State &state) {
+    Contract pair(BenchData::payloads()["pools"]["uniswapV2"], BenchData::path("abis/uniswap_v2_pair.json"));
+    for (auto _: state) {
+        benchmark::DoNotOptimize(pair.encodeFunction("getReserves"));
+    }
+}
+
+BENCHMARK(BM_EncodeFunction_NoArgs);
+
+// One int24 argument, the shape of every V3 tick sub-call
+static void BM_EncodeFunction_Ticks(benchmark::State &state) {
+    Contract pool(BenchData::payloads()["pools"]["uniswapV3"], BenchData::path("abis/uniswap_v3_pool.json"));
+    const json params = json::array({-197690});
+    for (auto _: state) {
+        benchmark::DoNotOptimize(pool.encodeFunction("ticks", params));
+    }
+}
+
+BENCHMARK(BM_EncodeFunction_Ticks);
+
+// Address argument: balanceOf(address)
+static void BM_EncodeFunction_Address(benchmark::State &state) {
+    Contract token(BenchData::payloads()["erc20"]["address"], BenchData::path("abis/erc20.json"));
+    const json params = json::array({"0xC6962004f452bE9203591991D15f6b388e09E8D0"});
+    for (auto _: state) {
+        benchmark::DoNotOptimize(token.encodeFunction("balanceOf", params));
+    }
+}
+
+BENCHMARK(BM_EncodeFunction_Address);
+
+// Three static words
+static void BM_DecodeResponse_GetReserves(benchmark::State &state) {
+    Contract pair(BenchData::payloads()["pools"]["uniswapV2"], BenchData::path("abis/uniswap_v2_pair.json"));
+    const std::string response = BenchData::payloads()["getReserves"];
+    for (auto _: state) {
+        benchmark::DoNotOptimize(pair.decodeResponse(response, "getReserves"));
+    }
+}
+
+BENCHMARK(BM_DecodeResponse_GetReserves);
+
+// Seven static words with a 160-bit price
+static void BM_DecodeResponse_Slot0(benchmark::State &state) {
+    Contract pool(BenchData::payloads()["pools"]["uniswapV3"], BenchData::path("abis/uniswap_v3_pool.json"));
+    const std::string response = BenchData::payloads()["slot0"];
+    for (auto _: state) {
+        benchmark::DoNotOptimize(pool.decodeResponse(response, "slot0"));
+    }
+}
+
+BENCHMARK(BM_DecodeResponse_Slot0);
+
+// Eight words including signed 128-bit and full-width 256-bit values
+static void BM_DecodeResponse_Ticks(benchmark::State &state) {
+    Contract pool(BenchData::payloads()["pools"]["uniswapV3"], BenchData::path("abis/uniswap_v3_pool.json"));
+    std::string response;
+    for (const auto &tick: BenchData::payloads()["ticks"]) {
+        response = tick["result"];
+        if (response.substr(2, 64) != std::string(64, '0')) break;
+    }
+    for (auto _: state) {
+        benchmark::DoNotOptimize(pool.decodeResponse(response, "ticks"));
+    }
+}
+
+BENCHMARK(BM_DecodeResponse_Ticks);
+
+// Dynamic string: name()
+static void BM_DecodeResponse_String(benchmark::State &state) {
+    Contract token(BenchData::payloads()["erc20"]["address"], BenchData::path("abis/erc20.json"));
+    const std::string response = BenchData::payloads()["erc20"]["name"];
+    for (auto _: state) {
+        benchmark::DoNotOptimize(token.decodeResponse(response, "name"));
+    }
+}
+
+BENCHMARK(BM_DecodeResponse_String);
+
+// Fits in 64 bits, takes the stoull path
+static void BM_DecodeUint_Small(benchmark::State &state) {
+    const std::string word = std::string(56, '0') + "0123abcd";
+    for (auto _: state) {
+        benchmark::DoNotOptimize(Contract::decodeUint(word));
+    }
+}
+
+BENCHMARK(BM_DecodeUint_Small);
+
+// 160-bit and full-width values go through GMP
+static void BM_DecodeUint_Large(benchmark::State &state) {
+    const std::string word = state.range(0) == 160
+                                 ? std::string(24, '0') + "0000035a7fa2e0bb1fe5d9ff0bd6d94a4c1a2b3c"
+                                 : "fedcba9876543210fedcba9876543210fedcba9876543210fedcba9876543210";
+    for (auto _: state) {
+        benchmark::DoNotOptimize(Contract::decodeUint(word));
+    }
+}
+
+BENCHMARK(BM_DecodeUint_Large)->Arg(160)->Arg(256);
+
+// Negative two's complement, as for liquidityNet and tick
+static void BM_DecodeInt_Negative(benchmark::State &state) {
+    const std::string word = "fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffcfbc8";
+    for (auto _: state) {
+        benchmark::DoNotOptimize(Contract::decodeInt(word));
+    }
+}
+
+BENCHMARK(BM_DecodeInt_Negative);
+
+// Generated binding counterparts of the runtime codec benchmarks above
+static void BM_Typed_EncodeTicks(benchmark::State &state) {
+    for (auto _: state) {
+        benchmark::DoNotOptimize(abi::UniswapV3Pool::calls::ticks::encode(-197690));
+    }
+}
+
+BENCHMARK(BM_Typed_EncodeTicks);
+
+static void BM_Typed_DecodeGetReserves(benchmark::State &state) {
+    const std::string response = BenchData::payloads()["getReserves"];
+    for (auto _: state) {
+        benchmark::DoNotOptimize(abi::UniswapV2Pair::calls::getReserves::decode(response));
+    }
+}
+
+BENCHMARK(BM_Typed_DecodeGetReserves);
+
+static void BM_Typed_DecodeSlot0(benchmark::State &state) {
+    const std::string response = BenchData::payloads()["slot0"];
+    for (auto _: state) {
+        benchmark::DoNotOptimize(abi::UniswapV3Pool::calls::slot0::decode(response));
+    }
+}
+
+BENCHMARK(BM_Typed_DecodeSlot0);
@@ -0,0 +1,62 @@
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../exchanges/Backfill.h"
+#include "../utils/HttpServer.h"
+#include "../utils/Web3Client.h"
+
+// Archive stand-in answering every eth_call with zero words after a fixed 5 ms, like a remote node
+static HttpResponse serveArchive(const HttpRequest &request) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    const json body = json::parse(request.body);
+    if (!body.is_array()) {
+        return {200, "application/json", json{{"jsonrpc", "2.0"}, {"id", body["id"]},
+                                              {"result", {{"timestamp", "0x6553f100"}}}}.dump()};
+    }
+    json responses = json::array();
+    for (const auto &call: body) {
+        responses.push_back({{"jsonrpc", "2.0"}, {"id", call["id"]}, {"result", "0x" + std::string(7 * 64, '0')}});
+    }
+    return {200, "application/json", responses.dump()};
+}
+
+// 64 V2 and 32 V3 pools over 32 blocks in batches of 32 calls; range(0) is the allowed concurrency
+static void BM_Backfill(benchmark::State &state) {
+    HttpServer archive(0, serveArchive);
+    archive.start();
+    auto web3 = std::make_shared<Web3Client>("http://127.0.0.1:" + std::to_string(archive.port()));
+    web3->setCacheEnabled(false);
+
+    BackfillEngine engine(web3);
+    std::vector<std::string> v2;
+    std::vector<std::string> v3;
+    for (int i = 0; i < 96; i++) {
+        std::stringstream address;
+        address << "0x" << std::hex << 0x1000 + i;
+        (i < 64 ? v2 : v3).push_back(address.str());
+    }
+    engine.addPools("UniswapV2", BackfillKind::UniswapV2, v2);
+    engine.addPools("UniswapV3", BackfillKind::UniswapV3, v3);
+
+    BackfillOptions options;
+    options.fromBlock = 18000000;
+    options.toBlock = options.fromBlock + 31;
+    options.concurrency = state.range(0);
+    options.batchSize = 32;
+    options.storePath = (std::filesystem::temp_directory_path() / "deds_backfill_bench.dcol").string();
+
+    uint64_t calls = 0;
+    for (auto _: state) {
+        calls += engine.run(options).calls;
+    }
+    archive.stop();
+    std::filesystem::remove(options.storePath);
+    state.SetItemsProcessed(static_cast<int64_t>(calls));
+}
+
+BENCHMARK(BM_Backfill)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Unit(benchmark::kMillisecond)->UseRealTime();
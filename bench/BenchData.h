@@ -0,0 +1,22 @@
+#ifndef BENCH_DATA_H
+#define BENCH_DATA_H
+
+#include <string>
+#include <nlohmann/json.hpp>
+#include "../utils/Utils.h"
+
+using json = nlohmann::json;
+
+// Recorded eth_call payloads shared by all benchmarks, see bench/data/payloads.json
+struct BenchData {
+    static std::string path(const std::string &relative) {
+        return std::string(DEDS_SOURCE_DIR) + "/" + relative;
+    }
+
+    static const json &payloads() {
+        static const json data = json::parse(Utils::loadFile(path("bench/data/payloads.json")));
+        return data;
+    }
+};
+
+#endif //BENCH_DATA_H
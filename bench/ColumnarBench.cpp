@@ -0,0 +1,53 @@
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include "../exchanges/ColumnarWriter.h"
+
+// Change set shaped like a V3 tick refresh: rows tick rows spread over 50 pools
+static ChangeSetPtr makeTickChanges(const size_t rows, const uint64_t block) {
+    auto changes = std::make_shared<ChangeSet>();
+    changes->exchange = "UniswapV3";
+    changes->block = block;
+    changes->timestamp = 1700000000000 + static_cast<int64_t>(block) * 250;
+    for (size_t i = 0; i < rows; i++) {
+        PoolChange change{"0x" + std::string(38, 'a') + std::to_string(10 + i % 50), PoolChange::Kind::TickLiquidity};
+        change.tick = -197690 + static_cast<int>(i) * 10;
+        change.after = {mpz_class(static_cast<long>(i * 1000003 % 7919) - 4000) * 1000000000, mpz_class(i * 31337)};
+        changes->changes.push_back(std::move(change));
+    }
+    return changes;
+}
+
+// Sustained rows/sec through the background writer, wall time until flushed; arg 1 compresses chunks with zlib
+static void BM_ColumnarWrite(benchmark::State &state) {
+    ColumnarOptions options;
+    options.compress = state.range(0) != 0;
+    const std::string path = (std::filesystem::temp_directory_path() / "deds_columnar_bench.dcol").string();
+
+    std::vector<ChangeSetPtr> cycles;
+    for (uint64_t block = 0; block < 64; block++) {
+        cycles.push_back(makeTickChanges(1000, block));
+    }
+
+    uint64_t bytes = 0;
+    for (auto _: state) {
+        ColumnarWriter writer(path, options);
+        for (const auto &changes: cycles) {
+            while (!writer.append(changes)) {
+                writer.flush();
+            }
+        }
+        writer.flush();
+        bytes = writer.bytesWritten();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * cycles.size() * 1000));
+    state.counters["bytes_per_row"] = static_cast<double>(bytes) / static_cast<double>(cycles.size() * 1000);
+    std::filesystem::remove(path);
+}
+
+BENCHMARK(BM_ColumnarWrite)->Arg(0)
+#ifdef DEDS_HAVE_ZLIB
+    ->Arg(1)
+#endif
+    ->UseRealTime()->Unit(benchmark::kMillisecond);
@@ -0,0 +1,123 @@
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <gmpxx.h>
+#include "BenchData.h"
+#include "../exchanges/EventEngine.h"
+#include "../exchanges/adapters/Uniswap/UniswapEvents.h"
+#include "../exchanges/adapters/Uniswap/UniswapV2.h"
+#include "../exchanges/adapters/Uniswap/UniswapV3.h"
+#include "../testing/StandInChain.h"
+
+constexpr int EventPools = 100;
+constexpr int EventBlocks = 1000;
+
+// Stand-in for the adapters' constructors: every pool has the same two tokens, a 0.3% fee and no reserves
+static json answerConstructors(const json &call) {
+    if (call["method"] == "eth_blockNumber") return "0x1";
+    const std::string data = call["params"][0]["data"];
+    if (data.starts_with("0xddca3f43")) return "0x" + std::string(61, '0') + "bb8";
+    if (data.starts_with("0x0dfe1681") || data.starts_with("0xd21220a7")) {
+        return "0x" + std::string(62, '0') + (data[3] == 'd' ? "e0" : "e1");
+    }
+    return "0x" + std::string(3 * 64, '0');
+}
+
+static std::string poolAddress(const int index) {
+    std::stringstream address;
+    address << "0x" << std::setw(40) << std::setfill('0') << std::hex << index;
+    return address.str();
+}
+
+// ABI words of signed values
+static std::string words(const std::vector<mpz_class> &values) {
+    std::string result = "0x";
+    for (mpz_class value: values) {
+        if (value < 0) value += mpz_class(1) << 256;
+        const std::string hex = value.get_str(16);
+        result += std::string(64 - hex.size(), '0') + hex;
+    }
+    return result;
+}
+
+// A day-like stream from the pools' creation: V3 pools initialized with five positions each, then per block
+// 20 swaps and 20 syncs on random pools and a Mint or Burn every other block
+static std::string writeStream(const std::filesystem::path &path) {
+    std::mt19937 random(7);
+    std::ofstream out(path);
+    uint64_t logIndex = 0;
+    const auto emit = [&](const int pool, const uint64_t block, const std::string_view topic, json topics,
+                          const std::vector<mpz_class> &data) {
+        topics.insert(topics.begin(), std::string(topic));
+        out << json{
+            {"address", poolAddress(pool)}, {"blockNumber", "0x" + mpz_class(block).get_str(16)},
+            {"logIndex", "0x" + mpz_class(logIndex++).get_str(16)}, {"topics", topics}, {"data", words(data)}
+        }.dump() << '\n';
+    };
+    const auto tickTopic = [](const int tick) { return words({tick}); };
+    const auto sqrtPrice = [](const int tick) { return mpz_class(std::exp(tick * std::log(1.0001) / 2) * 0x1p96); };
+
+    std::vector<int> ticks(EventPools, 0);
+    for (int pool = 0; pool < EventPools; pool++) {
+        emit(EventPools + pool, 1, uniswapEvents::InitializeTopic, json::array(), {sqrtPrice(0), 0});
+        for (int position = 1; position <= 5; position++) {
+            emit(EventPools + pool, 1, uniswapEvents::MintTopic,
+                 {words({1}), tickTopic(-position * 600), tickTopic(position * 600)}, {1, 1000000, 0, 0});
+        }
+        emit(pool, 1, uniswapEvents::SyncTopic, json::array(), {1000000, 1000000});
+    }
+    for (uint64_t block = 2; block <= EventBlocks + 1; block++) {
+        logIndex = 0;
+        for (int i = 0; i < 20; i++) {
+            const int pool = static_cast<int>(random() % EventPools);
+            ticks[pool] = std::clamp(ticks[pool] + static_cast<int>(random() % 121) - 60, -590, 590);
+            emit(EventPools + pool, block, uniswapEvents::SwapTopic, {words({1}), words({1})},
+                 {1, -1, sqrtPrice(ticks[pool]), 5000000, ticks[pool]});
+            emit(static_cast<int>(random() % EventPools), block, uniswapEvents::SyncTopic, json::array(),
+                 {1000000 + random() % 1000, 1000000 + random() % 1000});
+        }
+        const int pool = static_cast<int>(random() % EventPools);
+        const bool mint = block % 4 == 0;
+        emit(EventPools + pool, block, mint ? uniswapEvents::MintTopic : uniswapEvents::BurnTopic,
+             {words({1}), tickTopic(-60), tickTopic(60)}, {mint ? 1 : 10, mint ? 10 : 0, 0, 0});
+    }
+    return path.string();
+}
+
+// Replay of the stream into fresh V2 and V3 adapters; range(0) is the blocks per published snapshot
+static void BM_EventReplay(benchmark::State &state) {
+    StandInChain chain("eventbench", answerConstructors);
+    chain.start();
+    std::vector<std::string> v2Pools, v3Pools;
+    for (int pool = 0; pool < EventPools; pool++) {
+        v2Pools.push_back(poolAddress(pool));
+        v3Pools.push_back(poolAddress(EventPools + pool));
+    }
+    chain.writePools("uniswapV2.txt", v2Pools);
+    chain.writePools("uniswapV3.txt", v3Pools);
+    const std::string stream = writeStream(chain.dataDir() / "logs.jsonl");
+    ChainConfig config = chain.config();
+    config.abiDir = BenchData::path("abis");
+    auto web3 = chain.client();
+    UniswapV2 v2(web3, config);
+    UniswapV3 v3(web3, 5, config);
+    chain.stop();
+
+    EventEngine engine(web3, {&v2, &v3}, {.replayStep = static_cast<uint64_t>(state.range(0))});
+    size_t logs = 0;
+    for (auto _: state) {
+        engine.reset();
+        logs += engine.replay(stream);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(logs));
+}
+
+BENCHMARK(BM_EventReplay)->Arg(1)->Arg(10)->Arg(100)->Unit(benchmark::kMillisecond);
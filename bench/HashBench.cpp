@@ -0,0 +1,107 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include "../utils/Keccak.h"
+#include "../utils/Web3Client.h"
+
+#ifdef DEDS_HAVE_CRYPTOPP
+#include <cryptopp/keccak.h>
+#include <cryptopp/filters.h>
+#endif
+
+// Keccak-256 over function signatures (short) up to calldata-sized inputs
+static void BM_Keccak256(benchmark::State &state) {
+    const std::string input(static_cast<size_t>(state.range(0)), 'a');
+    for (auto _: state) {
+        benchmark::DoNotOptimize(Web3Client::keccak256(input));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(BM_Keccak256)->Arg(13)->Arg(32)->Arg(64)->Arg(136)->Arg(1024);
+
+// Function selector derivation as done by encodeFunction
+static void BM_Keccak256_Selector(benchmark::State &state) {
+    const std::string signature = "ticks(int24)";
+    for (auto _: state) {
+        benchmark::DoNotOptimize(Web3Client::bytesToHex(Web3Client::keccak256(signature).substr(0, 4)));
+    }
+}
+
+BENCHMARK(BM_Keccak256_Selector);
+
+// Native single hash into a caller buffer, no allocation
+static void BM_KeccakNative(benchmark::State &state) {
+    const std::string input(static_cast<size_t>(state.range(0)), 'a');
+    uint8_t digest[Keccak::DigestSize];
+    for (auto _: state) {
+        Keccak::hash(input.data(), input.size(), digest);
+        benchmark::DoNotOptimize(digest);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(BM_KeccakNative)->Arg(13)->Arg(32)->Arg(64)->Arg(136)->Arg(1024);
+
+// Multi-buffer hashing of 64-byte inputs, the shape of mapping storage keys keccak(key . slot)
+static void BM_KeccakBatch(benchmark::State &state) {
+    std::vector<std::string> inputs;
+    for (int i = 0; i < state.range(0); i++) {
+        inputs.push_back(std::string(60, '\0') + std::string(reinterpret_cast<const char *>(&i), 4));
+    }
+    const std::vector<std::string_view> views(inputs.begin(), inputs.end());
+    std::vector<uint8_t> digests(views.size() * Keccak::DigestSize);
+
+    for (auto _: state) {
+        Keccak::hashBatch(views.data(), views.size(), digests.data());
+        benchmark::DoNotOptimize(digests.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(BM_KeccakBatch)->Arg(4)->Arg(64)->Arg(1024);
+
+// Same inputs hashed one by one, baseline for BM_KeccakBatch
+static void BM_KeccakBatchScalar(benchmark::State &state) {
+    std::vector<std::string> inputs;
+    for (int i = 0; i < state.range(0); i++) {
+        inputs.push_back(std::string(60, '\0') + std::string(reinterpret_cast<const char *>(&i), 4));
+    }
+    std::vector<uint8_t> digests(inputs.size() * Keccak::DigestSize);
+
+    for (auto _: state) {
+        for (size_t i = 0; i < inputs.size(); i++) {
+            Keccak::hash(inputs[i].data(), inputs[i].size(), digests.data() + i * Keccak::DigestSize);
+        }
+        benchmark::DoNotOptimize(digests.data());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(BM_KeccakBatchScalar)->Arg(4)->Arg(64)->Arg(1024);
+
+#ifdef DEDS_HAVE_CRYPTOPP
+// Previous implementation: CryptoPP StringSource/HashFilter/StringSink pipeline
+static void BM_KeccakCryptoPP(benchmark::State &state) {
+    const std::string input(static_cast<size_t>(state.range(0)), 'a');
+    for (auto _: state) {
+        std::string digest;
+        CryptoPP::Keccak_256 hash;
+        CryptoPP::StringSource ss(input, true, new CryptoPP::HashFilter(hash, new CryptoPP::StringSink(digest)));
+        benchmark::DoNotOptimize(digest);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(BM_KeccakCryptoPP)->Arg(13)->Arg(32)->Arg(64)->Arg(136)->Arg(1024);
+#endif
+
+static void BM_BytesToHex(benchmark::State &state) {
+    const std::string bytes(static_cast<size_t>(state.range(0)), '\xab');
+    for (auto _: state) {
+        benchmark::DoNotOptimize(Web3Client::bytesToHex(bytes));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(BM_BytesToHex)->Arg(4)->Arg(32)->Arg(256);
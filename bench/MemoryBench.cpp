@@ -0,0 +1,131 @@
+#include <benchmark/benchmark.h>
+#include <malloc.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include "BenchData.h"
+#include "../exchanges/Pool.h"
+#include "../utils/Arena.h"
+#include "../utils/Web3Client.h"
+
+// Heap bytes in use (glibc), small chunks plus mmapped ones
+static size_t heapInUse() {
+    const struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+// Realistic 0x-prefixed address for index i
+static std::string addressOf(const size_t i) {
+    char buffer[43];
+    std::snprintf(buffer, sizeof(buffer), "0x%040zx", i);
+    return buffer;
+}
+
+// Pool layout before token ids and arenas: private token copies, separately allocated contract
+struct LegacyPool {
+    std::string address;
+    std::string exchange;
+    mpf_class fee;
+
+    std::vector<std::unique_ptr<Token> > tokens;
+    std::unique_ptr<Contract> poolContract;
+};
+
+// Token records as registered: about two pools per token, like the V2 pair list
+static std::vector<Token> makeTokens(const size_t pools) {
+    std::vector<Token> tokens;
+    for (size_t i = 0; i < pools / 2 + 2; i++) {
+        tokens.push_back({addressOf(0x70000000 + i), "TKN", "Benchmark Token " + std::to_string(i), 18, 0});
+    }
+    return tokens;
+}
+
+// Heap per pool with per-pool token copies, one allocation per pool and token (contracts excluded)
+static void BM_PoolMemory_Legacy(benchmark::State &state) {
+    const auto count = static_cast<size_t>(state.range(0));
+    const std::vector<Token> tokens = makeTokens(count);
+    size_t bytes = 0;
+    for (auto _: state) {
+        // The owning container is the same pools map either way, keep it out of the measurement
+        std::vector<std::unique_ptr<LegacyPool> > pools;
+        pools.reserve(count);
+        const size_t before = heapInUse();
+        for (size_t i = 0; i < count; i++) {
+            auto pool = std::make_unique<LegacyPool>();
+            pool->address = addressOf(i);
+            pool->exchange = "UniswapV2";
+            pool->fee = 0.997;
+            pool->tokens.push_back(std::make_unique<Token>(tokens[i / 2]));
+            pool->tokens.push_back(std::make_unique<Token>(tokens[i / 2 + 1]));
+            pools.push_back(std::move(pool));
+        }
+        bytes = heapInUse() - before;
+        benchmark::DoNotOptimize(pools.data());
+    }
+    state.counters["bytes_per_pool"] = static_cast<double>(bytes) / static_cast<double>(count);
+}
+
+BENCHMARK(BM_PoolMemory_Legacy)->Arg(10000)->Arg(100000)->Iterations(1)->Unit(benchmark::kMillisecond);
+
+// Heap per pool with registry token ids in an arena (contracts excluded)
+static void BM_PoolMemory_Arena(benchmark::State &state) {
+    const auto count = static_cast<size_t>(state.range(0));
+    std::vector<TokenId> ids;
+    for (const Token &token: makeTokens(count)) {
+        ids.push_back(TokenRegistry::instance().insert(token));
+    }
+    size_t bytes = 0;
+    for (auto _: state) {
+        const size_t before = heapInUse();
+        Arena<Pool> arena;
+        for (size_t i = 0; i < count; i++) {
+            Pool *pool = arena.create();
+            pool->address = addressOf(i);
+            pool->exchange = "UniswapV2";
+            pool->fee = 0.997;
+            pool->tokens = {ids[i / 2], ids[i / 2 + 1]};
+        }
+        bytes = heapInUse() - before;
+        benchmark::DoNotOptimize(&arena);
+    }
+    state.counters["bytes_per_pool"] = static_cast<double>(bytes) / static_cast<double>(count);
+}
+
+BENCHMARK(BM_PoolMemory_Arena)->Arg(10000)->Arg(100000)->Iterations(1)->Unit(benchmark::kMillisecond);
+
+// Heap of one pool contract once its ABI is registered: the address and a pointer to the shared ABI
+static void BM_ContractMemory(benchmark::State &state) {
+    const std::string abiPath = BenchData::path("abis/uniswap_v2_pair.json");
+    AbiRegistry::instance().load(abiPath);
+    size_t bytes = 0;
+    for (auto _: state) {
+        const size_t before = heapInUse();
+        Arena<Contract> arena;
+        arena.create(addressOf(1), abiPath);
+        bytes = heapInUse() - before;
+        benchmark::DoNotOptimize(&arena);
+    }
+    state.counters["bytes_per_pool"] = static_cast<double>(bytes);
+}
+
+BENCHMARK(BM_ContractMemory)->Iterations(1);
+
+// Heap of a V3-style batch of 5000 ticks calls, each request a handle to the pool contract
+static void BM_CallBatchMemory(benchmark::State &state) {
+    const Contract pool(addressOf(1), BenchData::path("abis/uniswap_v3_pool.json"));
+    const auto count = static_cast<size_t>(state.range(0));
+    size_t bytes = 0;
+    for (auto _: state) {
+        const size_t before = heapInUse();
+        std::vector<CallRequest> calls;
+        calls.reserve(count);
+        for (size_t i = 0; i < count; i++) {
+            calls.emplace_back(pool, "ticks", json::array({-197690 + static_cast<int>(i) * 10}));
+        }
+        bytes = heapInUse() - before;
+        benchmark::DoNotOptimize(calls.data());
+    }
+    state.counters["bytes"] = static_cast<double>(bytes);
+}
+
+BENCHMARK(BM_CallBatchMemory)->Arg(5000)->Iterations(1);
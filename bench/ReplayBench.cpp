@@ -0,0 +1,68 @@
+#include <benchmark/benchmark.h>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include "../utils/RpcReplayServer.h"
+#include "../utils/Web3Client.h"
+#include "../exchanges/adapters/Uniswap/UniswapV2.h"
+#include "../exchanges/adapters/Uniswap/UniswapV3.h"
+
+// End-to-end update cycles against a local stand-in node replaying DEDS_REPLAY_RECORDING
+// (record one with `DEDS --record run.jsonl`); range(0) is the simulated per-request latency in ms
+static std::unique_ptr<RpcReplayServer> startReplay(benchmark::State &state) {
+    const char *recording = std::getenv("DEDS_REPLAY_RECORDING");
+    if (!recording) {
+        state.SkipWithError("DEDS_REPLAY_RECORDING is not set");
+        return nullptr;
+    }
+
+    ReplayOptions options;
+    options.latency = std::chrono::milliseconds(state.range(0));
+    auto server = std::make_unique<RpcReplayServer>(recording, options);
+    server->start();
+    return server;
+}
+
+static void BM_ReplayUpdatePoolsV2(benchmark::State &state) {
+    const auto server = startReplay(state);
+    if (!server) return;
+
+    const auto web3 = std::make_shared<Web3Client>(server->url());
+    web3->setCacheEnabled(false);
+    UniswapV2 uniV2(web3);
+    // Cycles that hit a request missing from the recording fail, they still count as iterations
+    size_t failed = 0;
+    for (auto _: state) {
+        try {
+            uniV2.updatePools();
+        } catch (const std::exception &) {
+            failed++;
+        }
+    }
+    state.counters["misses"] = static_cast<double>(server->stats().misses);
+    state.counters["failed_cycles"] = static_cast<double>(failed);
+}
+
+BENCHMARK(BM_ReplayUpdatePoolsV2)->Arg(0)->Arg(20)->Unit(benchmark::kMillisecond);
+
+static void BM_ReplayUpdatePoolsV3(benchmark::State &state) {
+    const auto server = startReplay(state);
+    if (!server) return;
+
+    const auto web3 = std::make_shared<Web3Client>(server->url());
+    web3->setCacheEnabled(false);
+    UniswapV3 uniV3(web3, 5);
+    // Cycles that hit a request missing from the recording fail, they still count as iterations
+    size_t failed = 0;
+    for (auto _: state) {
+        try {
+            uniV3.updatePools();
+        } catch (const std::exception &) {
+            failed++;
+        }
+    }
+    state.counters["misses"] = static_cast<double>(server->stats().misses);
+    state.counters["failed_cycles"] = static_cast<double>(failed);
+}
+
+BENCHMARK(BM_ReplayUpdatePoolsV3)->Arg(0)->Arg(20)->Unit(benchmark::kMillisecond);
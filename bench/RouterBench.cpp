@@ -0,0 +1,128 @@
+#include <benchmark/benchmark.h>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+#include "../exchanges/DepthCurve.h"
+#include "../exchanges/Router.h"
+#include "../exchanges/adapters/Uniswap/UniswapSwap.h"
+
+// Hub tokens paired with each other on every venue, the rest of the tokens hang off one to three hubs
+constexpr TokenId Hubs = 8;
+
+// Synthetic market of V2 pairs and V3 pools at several fee tiers, prices consistent across pools
+static std::vector<std::shared_ptr<const SwapPool> > syntheticPools(const size_t poolCount) {
+    std::mt19937_64 random(42);
+    std::uniform_real_distribution unit(0.0, 1.0);
+    std::vector<double> prices;
+    const auto priceOf = [&](const TokenId token) {
+        while (prices.size() <= token) prices.push_back(std::exp(unit(random) * 6 - 3));
+        return prices[token];
+    };
+
+    std::vector<std::shared_ptr<const SwapPool> > pools;
+    const auto addPool = [&](const TokenId token0, const TokenId token1, const double depth) {
+        const double price = priceOf(token0) / priceOf(token1);
+        if (pools.size() % 2 == 0) {
+            auto pool = std::make_shared<UniswapSwapPool>(std::make_shared<const DepthCurve>(
+                DepthCurve::constantProduct(depth / priceOf(token0), depth / priceOf(token1), 0.003)));
+            pool->tokens = {token0, token1};
+            pools.push_back(std::move(pool));
+            return;
+        }
+        // Ten overlapping positions around the price within a 200-spacing window, as the adapter fetches it
+        constexpr int spacing = 60;
+        const int tick = static_cast<int>(std::floor(std::log(price) / std::log(1.0001)));
+        const int center = tick / spacing * spacing;
+        std::map<int, double> net;
+        double inRange = 0;
+        for (int position = 0; position < 10; position++) {
+            const int width = 1 + static_cast<int>(unit(random) * 100);
+            const int lower = center - width * spacing;
+            const int upper = center + width * spacing;
+            const double liquidity = depth / std::sqrt(priceOf(token0) * priceOf(token1)) / 10;
+            net[lower] += liquidity;
+            net[upper] -= liquidity;
+            inRange += liquidity;
+        }
+        auto pool = std::make_shared<UniswapSwapPool>(std::make_shared<const DepthCurve>(DepthCurve::concentrated(
+            std::sqrt(price), tick, inRange, {net.begin(), net.end()},
+            {center - 200 * spacing, center + 200 * spacing}, 0.003)));
+        pool->tokens = {token0, token1};
+        pools.push_back(std::move(pool));
+    };
+
+    for (TokenId a = 0; a < Hubs && pools.size() < poolCount; a++) {
+        for (TokenId b = a + 1; b < Hubs && pools.size() < poolCount; b++) {
+            for (int venue = 0; venue < 4; venue++) addPool(a, b, 1e9);
+        }
+    }
+    for (TokenId token = Hubs; pools.size() < poolCount; token++) {
+        const int pairs = 1 + static_cast<int>(unit(random) * 3);
+        for (int pair = 0; pair < pairs && pools.size() < poolCount; pair++) {
+            addPool(static_cast<TokenId>(unit(random) * Hubs), token, 1e6 + unit(random) * 1e8);
+        }
+    }
+    return pools;
+}
+
+// Split-route quote between two hubs, the densest query; range(1) is the number of search threads
+static void BM_RouteQuote(benchmark::State &state) {
+    std::unique_ptr<ThreadPool> threadPool;
+    if (state.range(1) > 1) threadPool = std::make_unique<ThreadPool>(state.range(1));
+    Router router({.threadPool = threadPool.get()});
+    router.build(syntheticPools(state.range(0)));
+
+    size_t paths = 0;
+    for (auto _: state) {
+        const RouteQuote quote = router.quote(0, 1, 1e7);
+        paths = quote.pathsEvaluated;
+        benchmark::DoNotOptimize(quote.amountOut);
+    }
+    state.counters["paths"] = static_cast<double>(paths);
+}
+
+BENCHMARK(BM_RouteQuote)->ArgsProduct({{1000, 5000}, {1, 4}})->Unit(benchmark::kMicrosecond);
+
+// Quote from a long-tail token to another, every path runs through the hubs
+static void BM_RouteQuoteLongTail(benchmark::State &state) {
+    Router router;
+    const auto pools = syntheticPools(state.range(0));
+    const TokenId last = std::max(pools.back()->tokens[1], Hubs + 1);
+    router.build(pools);
+
+    size_t paths = 0;
+    for (auto _: state) {
+        const RouteQuote quote = router.quote(Hubs, last, 1e5);
+        paths = quote.pathsEvaluated;
+        benchmark::DoNotOptimize(quote.amountOut);
+    }
+    state.counters["paths"] = static_cast<double>(paths);
+}
+
+BENCHMARK(BM_RouteQuoteLongTail)->Arg(1000)->Arg(5000)->Unit(benchmark::kMicrosecond);
+
+// V3 pool with range(0) initialized ticks spread over its window
+static DepthCurve tickedCurve(const int tickCount) {
+    std::vector<std::pair<int, double> > ticks;
+    double liquidity = 0;
+    for (int i = tickCount / 2; i >= 1; i--) ticks.emplace_back(-60 * i, 1e5);
+    for (int i = 1; i <= tickCount / 2; i++) {
+        ticks.emplace_back(60 * i, -1e5);
+        liquidity += 1e5;
+    }
+    return DepthCurve::concentrated(1, 0, liquidity, ticks, {-60 * tickCount, 60 * tickCount}, 0.003);
+}
+
+// Output of a trade that crosses most of the window, plus the input that moves the price 1%, from the depth curve
+static void BM_DepthCurveQuery(benchmark::State &state) {
+    const DepthCurve curve = tickedCurve(static_cast<int>(state.range(0)));
+    const double amount = curve.amountOut(1e12, false) * 0.9;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(curve.amountOut(amount, true));
+        benchmark::DoNotOptimize(curve.maxInput(0.01, true));
+    }
+}
+
+BENCHMARK(BM_DepthCurveQuery)->Arg(20)->Arg(200)->Arg(2000);
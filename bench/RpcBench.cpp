@@ -0,0 +1,64 @@
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include "BenchData.h"
+#include "../utils/Contract.h"
+#include "../utils/Web3Client.h"
+#include "../exchanges/adapters/Uniswap/UniswapV3.h"
+
+// JSON batch construction and serialization for N tick sub-calls, as sent by multicall
+static void BM_BuildCallBatch(benchmark::State &state) {
+    Contract pool(BenchData::payloads()["pools"]["uniswapV3"], BenchData::path("abis/uniswap_v3_pool.json"));
+    std::vector<std::pair<std::string, std::string> > targets;
+    for (int i = 0; i < state.range(0); i++) {
+        targets.emplace_back(pool.address, pool.encodeFunction("ticks", json::array({-197690 + i * 10})));
+    }
+
+    for (auto _: state) {
+        benchmark::DoNotOptimize(Web3Client::buildCallBatch(targets, "latest", 1).dump());
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(BM_BuildCallBatch)->Arg(100)->Arg(1000)->Arg(5000);
+
+// Decoding a recorded batch response: N eth_call results through decodeResponse
+static void BM_DecodeTickBatch(benchmark::State &state) {
+    Contract pool(BenchData::payloads()["pools"]["uniswapV3"], BenchData::path("abis/uniswap_v3_pool.json"));
+    const json &ticks = BenchData::payloads()["ticks"];
+
+    for (auto _: state) {
+        json results = json::object();
+        for (int i = 0; i < state.range(0); i++) {
+            const std::string &response = ticks[i % ticks.size()]["result"].get_ref<const std::string &>();
+            results["ticks"].push_back(pool.decodeResponse(response, "ticks"));
+        }
+        benchmark::DoNotOptimize(results);
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+}
+
+BENCHMARK(BM_DecodeTickBatch)->Arg(101)->Arg(1010);
+
+// UniswapV3 tick-result processing over the recorded window replicated across pools
+static void BM_ProcessTickResults(benchmark::State &state) {
+    Contract pool(BenchData::payloads()["pools"]["uniswapV3"], BenchData::path("abis/uniswap_v3_pool.json"));
+    const json &ticks = BenchData::payloads()["ticks"];
+
+    json tickResults = json::object();
+    std::vector<std::pair<std::string, int> > tickCallToPool;
+    for (int p = 0; p < state.range(0); p++) {
+        const std::string address = "0x" + std::string(38, '0') + std::to_string(10 + p % 90);
+        for (const auto &tick: ticks) {
+            tickResults["ticks"].push_back(pool.decodeResponse(tick["result"], "ticks"));
+            tickCallToPool.emplace_back(address + std::to_string(p / 90), tick["tick"].get<int>());
+        }
+    }
+
+    for (auto _: state) {
+        benchmark::DoNotOptimize(UniswapV3::processTickResults(tickResults, tickCallToPool));
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * tickCallToPool.size()));
+}
+
+BENCHMARK(BM_ProcessTickResults)->Arg(1)->Arg(10)->Arg(100);
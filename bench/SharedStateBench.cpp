@@ -0,0 +1,122 @@
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <new>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "../exchanges/ExchangeBase.h"
+#include "../exchanges/SharedStatePublisher.h"
+#include "../exchanges/SharedStateReader.h"
+
+namespace {
+    constexpr size_t HandoffPools = 1000;
+
+    // Exchange with hand-made pools, the publisher only needs their addresses and tokens
+    class SharedStateBenchExchange final : public ExchangeBase {
+    public:
+        SharedStateBenchExchange() : ExchangeBase(nullptr, "Bench") {
+            const TokenId weth = TokenRegistry::instance().insert({"0xweth", "WETH", "Wrapped Ether", 18, 0});
+            const TokenId usdc = TokenRegistry::instance().insert({"0xusdc", "USDC", "USD Coin", 6, 1});
+            for (size_t i = 0; i < HandoffPools; i++) {
+                std::stringstream address;
+                address << "0x" << std::setw(40) << std::setfill('0') << std::hex << i;
+                Pool *pool = poolArena.create();
+                pool->address = address.str();
+                pool->tokens = {weth, usdc};
+                pools[pool->address] = pool;
+            }
+        }
+
+        void updatePools() override {
+        }
+    };
+
+    // Written by the reader process, in a mapping shared across the fork
+    struct Acknowledgement {
+        std::atomic<uint64_t> block{0};
+        std::atomic<int64_t> seenAt{0};
+        std::atomic<bool> stop{false};
+    };
+
+    // Spin, but let the other process run when both share a core
+    void relax(uint32_t &spins) {
+        if (++spins % 1024 == 0) std::this_thread::yield();
+    }
+
+    int64_t monotonicNanos() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+}
+
+// Round trip through a reader in another process: publish one pool's reserves, the reader polls the record's
+// sequence, copies it and acknowledges its block. handoff_ns is publish start to the reader's consistent copy,
+// on the shared monotonic clock
+static void BM_SharedStateHandoff(benchmark::State &state) {
+    const std::string name = "/deds_bench_" + std::to_string(getpid());
+    SharedStateBenchExchange exchange;
+    SharedStatePublisher publisher(name, {&exchange});
+    const std::string poolAddress = exchange.pools.begin()->first;
+
+    void *shared = mmap(nullptr, sizeof(Acknowledgement), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    auto *ack = new(shared) Acknowledgement{};
+    const pid_t child = fork();
+    if (child == 0) {
+        SharedStateReader reader(name);
+        const size_t index = *reader.indexOf(poolAddress);
+        uint32_t sequence = 0;
+        uint32_t spins = 0;
+        while (!ack->stop.load(std::memory_order_relaxed)) {
+            if (reader.sequence(index) == sequence) {
+                relax(spins);
+                continue;
+            }
+            const SharedPool pool = reader.read(index);
+            sequence = pool.sequence;
+            ack->seenAt.store(monotonicNanos(), std::memory_order_relaxed);
+            ack->block.store(pool.block, std::memory_order_release);
+        }
+        _exit(0);
+    }
+
+    ChangeSet changes;
+    changes.exchange = exchange.name;
+    changes.changes = {{poolAddress, PoolChange::Kind::Reserves, 0, {}, {mpz_class(1), mpz_class(2500)}}};
+    uint64_t block = 0;
+    int64_t handoff = 0;
+    for (auto _: state) {
+        changes.block = ++block;
+        changes.changes[0].after[0] = block;
+        const int64_t start = monotonicNanos();
+        publisher.apply(changes);
+        uint32_t spins = 0;
+        while (ack->block.load(std::memory_order_acquire) != block) relax(spins);
+        handoff += ack->seenAt.load(std::memory_order_relaxed) - start;
+    }
+    ack->stop = true;
+    waitpid(child, nullptr, 0);
+    munmap(shared, sizeof(Acknowledgement));
+    state.counters["handoff_ns"] = benchmark::Counter(static_cast<double>(handoff) / static_cast<double>(block));
+}
+
+// One consistent record copy with no writer active
+static void BM_SharedStateRead(benchmark::State &state) {
+    const std::string name = "/deds_bench_read_" + std::to_string(getpid());
+    SharedStateBenchExchange exchange;
+    SharedStatePublisher publisher(name, {&exchange});
+    SharedStateReader reader(name);
+    size_t index = 0;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(reader.read(index));
+        index = (index + 1) % HandoffPools;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_SharedStateHandoff)->UseRealTime();
+BENCHMARK(BM_SharedStateRead);
@@ -0,0 +1,85 @@
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../utils/HttpServer.h"
+#include "../utils/Web3Client.h"
+
+// Node stand-in answering ticks() batches after 10 ms. One tick in four is initialized and carries
+// incompressible liquidity and fee growth words, the rest are zero, roughly what a window around the price looks like
+static HttpResponse serveTicks(const HttpRequest &request) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    static const std::string hex = "0123456789abcdef";
+    json responses = json::array();
+    for (const auto &call: json::parse(request.body)) {
+        const uint64_t id = call["id"].get<uint64_t>();
+        std::string result = "0x" + std::string(8 * 64, '0');
+        if (id % 4 == 0) {
+            uint64_t seed = id * 0x9e3779b97f4a7c15ULL;
+            for (size_t i = 2 + 32; i < 2 + 4 * 64; i++) {
+                seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+                result[i] = hex[seed >> 60];
+            }
+            result.back() = '1';
+        }
+        responses.push_back({{"jsonrpc", "2.0"}, {"id", call["id"]}, {"result", result}});
+    }
+    return {200, "application/json", responses.dump()};
+}
+
+// 20000 ticks() calls in batches of 500 from 8 threads. range(0): bit 0 compression, bit 1 h2c instead of HTTP/1.1
+static void BM_TickRefresh(benchmark::State &state) {
+    HttpServer node(0, serveTicks);
+    node.start();
+
+    TransportOptions transport;
+    transport.compression = state.range(0) & 1;
+    transport.httpVersion = state.range(0) & 2 ? HttpVersion::Http2PriorKnowledge : HttpVersion::Http1;
+    const std::string chain = "bench_transport_" + std::to_string(state.range(0));
+    auto web3 = std::make_shared<Web3Client>("http://127.0.0.1:" + std::to_string(node.port()), chain, transport);
+    web3->setCacheEnabled(false);
+
+    constexpr size_t Calls = 20000;
+    constexpr size_t BatchSize = 500;
+    constexpr size_t Threads = 8;
+    std::vector<std::pair<std::string, std::string> > calls;
+    for (size_t i = 0; i < Calls; i++) {
+        calls.emplace_back("0x" + std::string(39, '0') + "1", "0xf30dba93" + std::string(64, '0'));
+    }
+
+    Counter &wireBytes = Metrics::instance().counter("deds_rpc_wire_bytes_in_total", web3->labels(), "");
+    Counter &decodedBytes = Metrics::instance().counter("deds_rpc_bytes_in_total", web3->labels(), "");
+    Counter &connections = Metrics::instance().counter("deds_rpc_connections_total", web3->labels(), "");
+    const uint64_t wireBefore = wireBytes.value();
+    const uint64_t decodedBefore = decodedBytes.value();
+    const uint64_t connectionsBefore = connections.value();
+
+    for (auto _: state) {
+        std::atomic<size_t> next{0};
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < Threads; t++) {
+            workers.emplace_back([&] {
+                for (size_t first; (first = next.fetch_add(BatchSize)) < Calls;) {
+                    const std::vector chunk(calls.begin() + static_cast<long>(first),
+                                            calls.begin() + static_cast<long>(std::min(first + BatchSize, Calls)));
+                    benchmark::DoNotOptimize(web3->multicallRaw(chunk, "latest"));
+                }
+            });
+        }
+        for (auto &worker: workers) {
+            worker.join();
+        }
+    }
+    node.stop();
+
+    const auto refreshes = static_cast<double>(state.iterations());
+    state.counters["wire_bytes"] = static_cast<double>(wireBytes.value() - wireBefore) / refreshes;
+    state.counters["decoded_bytes"] = static_cast<double>(decodedBytes.value() - decodedBefore) / refreshes;
+    state.counters["connections"] = static_cast<double>(connections.value() - connectionsBefore) / refreshes;
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * Calls));
+}
+
+BENCHMARK(BM_TickRefresh)->DenseRange(0, 3)->Unit(benchmark::kMillisecond)->UseRealTime();
@@ -0,0 +1,267 @@
+#include "Backfill.h"
+
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <optional>
+#include <ranges>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "ColumnarWriter.h"
+#include "../utils/Metrics.h"
+#include "../utils/ThreadPool.h"
+#include "../utils/Utils.h"
+#include "abi/UniswapV2Pair.h"
+#include "abi/UniswapV3Pool.h"
+
+namespace V2 = abi::UniswapV2Pair::calls;
+namespace V3 = abi::UniswapV3Pool::calls;
+
+// Constructor: Share the client, its cache and metrics with the live scraper
+BackfillEngine::BackfillEngine(std::shared_ptr<Web3Client> web3Client) : web3{std::move(web3Client)} {
+}
+
+// Register pools, sorted so batches are the same on every run
+void BackfillEngine::addPools(const std::string &exchange, const BackfillKind kind,
+                              std::vector<std::string> addresses) {
+    std::ranges::sort(addresses);
+    poolSets.push_back({exchange, kind, std::move(addresses)});
+}
+
+// Register all pools of an exchange
+void BackfillEngine::addExchange(const ExchangeBase &exchange, const BackfillKind kind) {
+    std::vector<std::string> addresses;
+    for (const auto &address: exchange.pools | std::views::keys) {
+        addresses.push_back(address);
+    }
+    addPools(exchange.name, kind, std::move(addresses));
+}
+
+// Archive nodes drop requests under load, retry a call batch or block header with backoff before giving up
+template<typename Fetch>
+auto BackfillEngine::fetchWithRetry(const Fetch &fetch, const int retries) -> decltype(fetch()) {
+    static Counter &retried = Metrics::instance().counter("deds_backfill_retries_total", {},
+                                                          "Backfill requests retried after an error");
+    for (int attempt = 0;; attempt++) {
+        try {
+            return fetch();
+        } catch (const std::exception &) {
+            if (attempt >= retries) throw;
+            retried.inc();
+            std::this_thread::sleep_for(std::chrono::milliseconds(100) * (1 << attempt));
+        }
+    }
+}
+
+// Checkpoint on disk: the range it belongs to, the next block to fetch and the store size at that point
+struct Checkpoint {
+    uint64_t next = 0;
+    uint64_t storeBytes = 0;
+};
+
+// Load a checkpoint of the same range, a different range is an error rather than a silent restart
+static std::optional<Checkpoint> loadCheckpoint(const BackfillOptions &options) {
+    if (options.checkpointPath.empty() || !std::filesystem::exists(options.checkpointPath)) {
+        return std::nullopt;
+    }
+    const json saved = json::parse(Utils::loadFile(options.checkpointPath));
+    if (saved["fromBlock"] != options.fromBlock || saved["toBlock"] != options.toBlock ||
+        saved["step"] != options.step || saved["storePath"] != options.storePath) {
+        throw std::runtime_error{"Backfill: checkpoint " + options.checkpointPath + " is for a different range"};
+    }
+    return Checkpoint{saved["next"].get<uint64_t>(), saved["storeBytes"].get<uint64_t>()};
+}
+
+// Replace the checkpoint atomically
+static void saveCheckpoint(const BackfillOptions &options, const Checkpoint &checkpoint) {
+    const json saved = {
+        {"fromBlock", options.fromBlock}, {"toBlock", options.toBlock}, {"step", options.step},
+        {"storePath", options.storePath}, {"next", checkpoint.next}, {"storeBytes", checkpoint.storeBytes}
+    };
+    const std::string temporary = options.checkpointPath + ".tmp";
+    {
+        std::ofstream out(temporary, std::ios::trunc);
+        out << saved.dump(2);
+        if (!out) {
+            throw std::runtime_error{"Backfill: cannot write checkpoint " + temporary};
+        }
+    }
+    std::filesystem::rename(temporary, options.checkpointPath);
+}
+
+// Fetch every sampled block, keeping at most 2 x concurrency batches queued ahead of the oldest block
+BackfillReport BackfillEngine::run(const BackfillOptions &options) {
+    if (options.step == 0 || options.concurrency == 0 || options.batchSize == 0 ||
+        options.fromBlock > options.toBlock || options.storePath.empty()) {
+        throw std::invalid_argument{"Backfill: invalid options"};
+    }
+
+    Metrics &metrics = Metrics::instance();
+    Counter &blocksDone = metrics.counter("deds_backfill_blocks_total", {}, "Sampled blocks written by backfill");
+    Gauge &nextBlock = metrics.gauge("deds_backfill_next_block", {}, "Next block the backfill will fetch");
+
+    // Calldata does not depend on the block, build the per-block call list once
+    enum class What { Reserves, Slot0, Liquidity };
+    struct Call {
+        size_t set;
+        const std::string *pool;
+        What what;
+    };
+    std::vector<Call> calls;
+    std::vector<std::pair<std::string, std::string> > targets;
+    for (size_t set = 0; set < poolSets.size(); set++) {
+        for (const std::string &pool: poolSets[set].addresses) {
+            if (poolSets[set].kind == BackfillKind::UniswapV2) {
+                calls.push_back({set, &pool, What::Reserves});
+                targets.emplace_back(pool, V2::getReserves::encode());
+            } else {
+                calls.push_back({set, &pool, What::Slot0});
+                targets.emplace_back(pool, V3::slot0::encode());
+                calls.push_back({set, &pool, What::Liquidity});
+                targets.emplace_back(pool, V3::liquidity::encode());
+            }
+        }
+    }
+    std::vector<std::vector<std::pair<std::string, std::string> > > batches;
+    for (size_t begin = 0; begin < targets.size(); begin += options.batchSize) {
+        const size_t end = std::min(targets.size(), begin + options.batchSize);
+        batches.emplace_back(targets.begin() + begin, targets.begin() + end);
+    }
+
+    BackfillReport report;
+    const auto started = std::chrono::steady_clock::now();
+    const std::optional<Checkpoint> resume = loadCheckpoint(options);
+    report.resumedFrom = resume ? resume->next : options.fromBlock;
+    if (report.resumedFrom > options.toBlock) {
+        return report;
+    }
+
+    // Cut anything written after the checkpoint, those blocks are fetched again
+    ColumnarOptions storeOptions;
+    storeOptions.compress = options.compress;
+    if (resume) {
+        std::error_code error;
+        if (std::filesystem::file_size(options.storePath, error) > resume->storeBytes && !error) {
+            std::filesystem::resize_file(options.storePath, resume->storeBytes);
+        }
+        storeOptions.append = true;
+    }
+    ColumnarWriter store(options.storePath, storeOptions);
+
+    struct BlockJob {
+        uint64_t block;
+        std::vector<std::future<std::vector<std::string> > > batches;
+        std::future<int64_t> timestamp;
+    };
+    std::deque<BlockJob> inFlight;
+    size_t queuedBatches = 0;
+    size_t sinceCheckpoint = 0;
+
+    // Declared after everything its tasks reference, so it is joined first on the way out
+    ThreadPool workers(options.concurrency);
+
+    const auto checkpoint = [&](const uint64_t next) {
+        nextBlock.set(static_cast<double>(next));
+        if (options.checkpointPath.empty()) return;
+        store.flush();
+        saveCheckpoint(options, {next, store.bytesWritten()});
+        sinceCheckpoint = 0;
+    };
+
+    // Decode the oldest block into one change set per exchange and hand them to the store
+    const auto completeOldest = [&] {
+        BlockJob job = std::move(inFlight.front());
+        inFlight.pop_front();
+        queuedBatches -= job.batches.size();
+
+        const int64_t timestamp = job.timestamp.get();
+        std::vector<std::shared_ptr<ChangeSet> > changeSets;
+        for (const PoolSet &set: poolSets) {
+            auto changes = std::make_shared<ChangeSet>();
+            changes->exchange = set.exchange;
+            changes->block = job.block;
+            changes->timestamp = timestamp;
+            changeSets.push_back(std::move(changes));
+        }
+
+        size_t index = 0;
+        for (auto &batch: job.batches) {
+            for (const std::string &response: batch.get()) {
+                const Call &call = calls[index++];
+                std::vector<PoolChange> &changes = changeSets[call.set]->changes;
+                try {
+                    if (call.what == What::Reserves) {
+                        const auto reserves = V2::getReserves::decode(response);
+                        changes.push_back({*call.pool, PoolChange::Kind::Reserves, 0, {},
+                                           {reserves._reserve0, reserves._reserve1}});
+                    } else if (call.what == What::Slot0) {
+                        const auto slot0 = V3::slot0::decode(response);
+                        changes.push_back({*call.pool, PoolChange::Kind::SqrtPrice, 0, {},
+                                           {slot0.sqrtPriceX96, mpz_class(static_cast<long>(slot0.tick))}});
+                    } else {
+                        changes.push_back({*call.pool, PoolChange::Kind::Liquidity, 0, {},
+                                           {V3::liquidity::decode(response), 0}});
+                    }
+                } catch (const std::exception &) {
+                    report.emptyCalls++;
+                }
+            }
+        }
+        report.calls += calls.size();
+
+        for (auto &changes: changeSets) {
+            ChangeSetPtr shared = std::move(changes);
+            while (!store.append(shared)) {
+                store.flush();
+            }
+        }
+        report.blocks++;
+        blocksDone.inc();
+        if (++sinceCheckpoint >= options.checkpointEvery) {
+            checkpoint(job.block + options.step);
+        }
+    };
+
+    for (uint64_t block = report.resumedFrom; block <= options.toBlock; block += options.step) {
+        while (!inFlight.empty() && queuedBatches >= 2 * options.concurrency) {
+            completeOldest();
+        }
+
+        std::stringstream tag;
+        tag << "0x" << std::hex << block;
+        BlockJob job{block, {}, {}};
+        job.timestamp = workers.submit([this, blockTag = tag.str(), &options] {
+            return fetchWithRetry([this, &blockTag] {
+                const json header = web3->sendRpcRequest("eth_getBlockByNumber", json::array({blockTag, false}));
+                if (!header.is_object() || !header.contains("timestamp")) {
+                    throw std::runtime_error{"Backfill: archive node has no block " + blockTag};
+                }
+                return static_cast<int64_t>(std::stoull(header["timestamp"].get<std::string>(), nullptr, 16)) * 1000;
+            }, options.retries);
+        });
+        for (const auto &batch: batches) {
+            job.batches.push_back(workers.submit([this, &batch, blockTag = tag.str(), &options] {
+                return fetchWithRetry([this, &batch, &blockTag] { return web3->multicallRaw(batch, blockTag); },
+                                      options.retries);
+            }));
+        }
+        queuedBatches += job.batches.size();
+        inFlight.push_back(std::move(job));
+
+        if (options.toBlock - block < options.step) break;
+    }
+    while (!inFlight.empty()) {
+        completeOldest();
+    }
+    // A failed store write throws here even when no checkpoint is kept
+    store.flush();
+    checkpoint(options.toBlock + 1);
+
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+    return report;
+}
@@ -0,0 +1,76 @@
+#ifndef BACKFILL_H
+#define BACKFILL_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ExchangeBase.h"
+#include "../utils/Web3Client.h"
+
+// Which state calls a pool gets: getReserves, or slot0 + liquidity
+enum class BackfillKind { UniswapV2, UniswapV3 };
+
+struct BackfillOptions {
+    uint64_t fromBlock = 0;
+    // Inclusive
+    uint64_t toBlock = 0;
+    uint64_t step = 1;
+    // eth_call batches in flight at once
+    size_t concurrency = 4;
+    size_t batchSize = 250;
+    // Attempts per batch after the first, with exponential backoff
+    int retries = 3;
+    // Column file the samples are written to, see ColumnarWriter
+    std::string storePath;
+    bool compress = false;
+    // Empty disables resuming
+    std::string checkpointPath;
+    // Sampled blocks between checkpoints
+    size_t checkpointEvery = 16;
+};
+
+struct BackfillReport {
+    // First block this run fetched, after the checkpoint
+    uint64_t resumedFrom = 0;
+    uint64_t blocks = 0;
+    uint64_t calls = 0;
+    // Calls that returned no data, typically a pool not deployed yet at that block
+    uint64_t emptyCalls = 0;
+    double seconds = 0;
+};
+
+// Samples pool state at every step-th block of a range against an archive node and writes one row group
+// per exchange and block. Batches of all pools and blocks run on a private pool of `concurrency` threads;
+// blocks complete in order, so a checkpoint (next block + store size) marks an exact resume point
+class BackfillEngine {
+public:
+    explicit BackfillEngine(std::shared_ptr<Web3Client> web3Client);
+
+    void addPools(const std::string &exchange, BackfillKind kind, std::vector<std::string> addresses);
+
+    // Every pool of a loaded exchange
+    void addExchange(const ExchangeBase &exchange, BackfillKind kind);
+
+    // Fetch the range, resuming from the checkpoint if it matches the range. Throws on a batch that
+    // keeps failing or a failed store write; the last checkpoint stays valid
+    BackfillReport run(const BackfillOptions &options);
+
+private:
+    struct PoolSet {
+        std::string exchange;
+        BackfillKind kind;
+        std::vector<std::string> addresses;
+    };
+
+    std::shared_ptr<Web3Client> web3;
+    std::vector<PoolSet> poolSets;
+
+    // Run one node request, retried with backoff
+    template<typename Fetch>
+    static auto fetchWithRetry(const Fetch &fetch, int retries) -> decltype(fetch());
+};
+
+#endif //BACKFILL_H
@@ -0,0 +1,181 @@
+#include "BlockDriver.h"
+
+#include <algorithm>
+#include <optional>
+
+// Constructor: Drive an orchestrator whose adapters are added already or still loading
+BlockDriver::BlockDriver(UpdateOrchestrator &orchestrator, DriverOptions options)
+    : orchestrator{orchestrator}, options{options},
+      cyclesTotal{
+          Metrics::instance().counter("deds_driver_cycles_total", orchestrator.getWeb3Client()->labels(),
+                                      "Cycles run by the block driver")
+      },
+      skippedTotal{
+          Metrics::instance().counter("deds_driver_skipped_total", orchestrator.getWeb3Client()->labels(),
+                                      "Heads or cadence ticks skipped because a cycle was running")
+      },
+      pollErrors{
+          Metrics::instance().counter("deds_head_poll_errors_total", orchestrator.getWeb3Client()->labels(),
+                                      "Failed eth_blockNumber polls")
+      },
+      headBlock{
+          Metrics::instance().gauge("deds_head_block", orchestrator.getWeb3Client()->labels(),
+                                    "Newest head seen by the block driver")
+      },
+      headToState{
+          Metrics::instance().histogram("deds_head_to_state_seconds", orchestrator.getWeb3Client()->labels(),
+                                        "From a new head to every exchange having published")
+      },
+      behindHistogram{
+          Metrics::instance().histogram("deds_blocks_behind", orchestrator.getWeb3Client()->labels(),
+                                        "Observed head minus oldest state block after a cycle",
+                                        Histogram::sizeBuckets())
+      },
+      behindGauge{
+          Metrics::instance().gauge("deds_blocks_behind_last", orchestrator.getWeb3Client()->labels(),
+                                    "Observed head minus oldest state block after the last cycle")
+      } {
+}
+
+// Set the per-cycle callback
+void BlockDriver::onCycle(CycleCallback cycleCallback) {
+    callback = std::move(cycleCallback);
+}
+
+// Poll for new heads and wake the cycle loop when one arrives
+void BlockDriver::watchHeads() {
+    const std::shared_ptr<Web3Client> web3 = orchestrator.getWeb3Client();
+
+    std::unique_lock lock(mutex);
+    while (!stopping) {
+        lock.unlock();
+        std::optional<uint64_t> head;
+        try {
+            head = web3->getBlockNumber();
+        } catch (const std::exception &) {
+            pollErrors.inc();
+        }
+        const auto now = std::chrono::steady_clock::now();
+        lock.lock();
+
+        if (head && *head > latestHead) {
+            latestHead = *head;
+            latestSeen = now;
+            headBlock.set(static_cast<double>(*head));
+            wake.notify_all();
+        }
+        // State ages between cycles too, a stuck or slow cycle shows up here before it finishes
+        if (head) {
+            for (const ExchangeBase *exchange: polled) exchange->recordStaleness(*head);
+        }
+        wake.wait_for(lock, options.pollInterval, [this] { return stopping; });
+    }
+}
+
+// Run one orchestrator cycle and record how far the published state trails the head
+DrivenCycle BlockDriver::runCycle(const uint64_t head, const std::chrono::steady_clock::time_point seen,
+                                  const uint64_t skippedBefore) {
+    DrivenCycle cycle;
+    cycle.chain = orchestrator.getWeb3Client()->getChain();
+    cycle.head = head;
+    cycle.skipped = skippedBefore;
+    cycle.report = orchestrator.runCycle();
+
+    // An exchange whose cycle failed keeps its older block and holds the whole state back
+    const auto &exchanges = orchestrator.getExchanges();
+    if (polled.size() != exchanges.size()) {
+        std::lock_guard lock(mutex);
+        polled.clear();
+        for (const auto &exchange: exchanges) polled.push_back(exchange.get());
+    }
+    if (!exchanges.empty()) {
+        cycle.stateBlock = UINT64_MAX;
+        for (const auto &exchange: exchanges) {
+            cycle.stateBlock = std::min(cycle.stateBlock, exchange->stateBlock());
+        }
+    }
+    const uint64_t newest = std::max(head, orchestrator.getWeb3Client()->getObservedHead());
+    cycle.blocksBehind = newest > cycle.stateBlock ? newest - cycle.stateBlock : 0;
+    if (head != 0) {
+        cycle.headToStateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - seen).count();
+        headToState.observe(cycle.headToStateSeconds);
+    }
+
+    behindHistogram.observe(static_cast<double>(cycle.blocksBehind));
+    behindGauge.set(static_cast<double>(cycle.blocksBehind));
+    cyclesTotal.inc();
+    skippedTotal.inc(skippedBefore);
+    cycles.fetch_add(1, std::memory_order_relaxed);
+    skipped.fetch_add(skippedBefore, std::memory_order_relaxed);
+    return cycle;
+}
+
+// Cycle loop: wait for a newer head (or the next tick), then run at the newest head only
+void BlockDriver::run() {
+    std::thread watcher(&BlockDriver::watchHeads, this);
+
+    const bool perBlock = options.cadence.count() == 0;
+    uint64_t lastCycled = 0;
+    uint64_t missedTicks = 0;
+    auto nextTick = std::chrono::steady_clock::now();
+
+    while (true) {
+        uint64_t head;
+        std::chrono::steady_clock::time_point seen;
+        {
+            std::unique_lock lock(mutex);
+            if (perBlock) {
+                wake.wait(lock, [&] { return stopping || latestHead > lastCycled; });
+            } else {
+                wake.wait_until(lock, nextTick, [this] { return stopping; });
+            }
+            if (stopping) break;
+            head = latestHead;
+            seen = latestSeen;
+        }
+
+        uint64_t skippedBefore = missedTicks;
+        if (perBlock && lastCycled != 0 && head > lastCycled + 1) {
+            skippedBefore = head - lastCycled - 1;
+        }
+        const DrivenCycle cycle = runCycle(head, seen, skippedBefore);
+        // Adapters read their own head, a state already past `head` makes those blocks done too
+        lastCycled = std::max(head, cycle.stateBlock);
+
+        // Ticks that passed during a long cycle are dropped, not run back to back
+        missedTicks = 0;
+        if (!perBlock) {
+            const auto now = std::chrono::steady_clock::now();
+            nextTick += options.cadence;
+            while (nextTick <= now) {
+                nextTick += options.cadence;
+                missedTicks++;
+            }
+        }
+
+        if (callback) callback(cycle);
+        if (options.maxCycles != 0 && cycles.load(std::memory_order_relaxed) >= options.maxCycles) break;
+    }
+
+    stop();
+    watcher.join();
+}
+
+// Ask run() to return, the cycle in progress completes first
+void BlockDriver::stop() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+}
+
+// Get cycles run so far
+uint64_t BlockDriver::cyclesRun() const {
+    return cycles.load(std::memory_order_relaxed);
+}
+
+// Get heads or ticks skipped so far
+uint64_t BlockDriver::cyclesSkipped() const {
+    return skipped.load(std::memory_order_relaxed);
+}
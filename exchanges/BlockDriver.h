@@ -0,0 +1,98 @@
+#ifndef BLOCK_DRIVER_H
+#define BLOCK_DRIVER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "UpdateOrchestrator.h"
+
+struct DriverOptions {
+    // How often eth_blockNumber is polled for a new head
+    std::chrono::milliseconds pollInterval{250};
+    // 0 runs one cycle per new head, otherwise one cycle per interval
+    std::chrono::milliseconds cadence{0};
+    // Stop after this many cycles, 0 runs until stop()
+    uint64_t maxCycles = 0;
+};
+
+// Outcome of one driven cycle
+struct DrivenCycle {
+    // Chain of the driven client, empty for a single-chain process
+    std::string chain;
+    // Newest head when the cycle started
+    uint64_t head = 0;
+    // Oldest block any exchange's state was read at once the cycle finished
+    uint64_t stateBlock = 0;
+    // Newest observed head minus stateBlock at that point
+    uint64_t blocksBehind = 0;
+    // Heads (or cadence ticks) passed over while the previous cycle was still running
+    uint64_t skipped = 0;
+    // From the watcher first seeing head to every exchange having published
+    double headToStateSeconds = 0;
+    CycleReport report;
+};
+
+// Runs an orchestrator's update cycles from new heads or at a fixed cadence. Cycles never overlap and are
+// never queued: a cycle that runs long makes the next one start at the newest head, the rest are skipped
+class BlockDriver {
+public:
+    using CycleCallback = std::function<void(const DrivenCycle &)>;
+
+    explicit BlockDriver(UpdateOrchestrator &orchestrator, DriverOptions options = {});
+
+    BlockDriver(const BlockDriver &) = delete;
+
+    BlockDriver &operator=(const BlockDriver &) = delete;
+
+    // Called on the cycle thread after every cycle, set before run()
+    void onCycle(CycleCallback callback);
+
+    // Watch heads and run cycles on the calling thread until stop() or maxCycles
+    void run();
+
+    // Let run() return after the cycle in progress, safe from any thread
+    void stop();
+
+    [[nodiscard]] uint64_t cyclesRun() const;
+
+    [[nodiscard]] uint64_t cyclesSkipped() const;
+
+private:
+    UpdateOrchestrator &orchestrator;
+    DriverOptions options;
+    CycleCallback callback;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    // Newest head and when the watcher first saw it
+    uint64_t latestHead = 0;
+    std::chrono::steady_clock::time_point latestSeen;
+    // Loaded exchanges, set by the cycle thread, whose staleness every poll refreshes
+    std::vector<const ExchangeBase *> polled;
+
+    std::atomic<uint64_t> cycles{0};
+    std::atomic<uint64_t> skipped{0};
+
+    // Labelled with the client's chain, so several drivers can share the registry
+    Counter &cyclesTotal;
+    Counter &skippedTotal;
+    Counter &pollErrors;
+    Gauge &headBlock;
+    Histogram &headToState;
+    Histogram &behindHistogram;
+    Gauge &behindGauge;
+
+    void watchHeads();
+
+    DrivenCycle runCycle(uint64_t head, std::chrono::steady_clock::time_point seen, uint64_t skippedBefore);
+};
+
+#endif //BLOCK_DRIVER_H
@@ -0,0 +1,73 @@
+#ifndef CHAIN_CONFIG_H
+#define CHAIN_CONFIG_H
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <nlohmann/json.hpp>
+#include "RefreshScheduler.h"
+#include "../utils/HttpTransport.h"
+
+// How adapters read pool state: eth_call of the view functions, eth_getStorageAt of the slots behind them, or
+// one eth_call of a tick lens per group of pools (UniswapV3, other adapters use Call)
+enum class StateRead { Call, Storage, Lens };
+
+// "call", "storage" or "lens"
+inline StateRead parseStateRead(const std::string &name) {
+    if (name == "call") {
+        return StateRead::Call;
+    }
+    if (name == "storage") {
+        return StateRead::Storage;
+    }
+    if (name == "lens") {
+        return StateRead::Lens;
+    }
+    throw std::invalid_argument{"Unknown state read: " + name};
+}
+
+// One chain scraped by the process: its endpoint, pool lists, ABI files and share of the update pool.
+// The defaults are the single-chain setup, paths relative to the build directory
+struct ChainConfig {
+    // Labels metrics and scopes the token registry, empty for a single-chain process
+    std::string name;
+    std::string rpcUrl = "https://arb1.arbitrum.io/rpc";
+    // Holds uniswapV2.txt and uniswapV3.txt
+    std::string dataDir = "../data";
+    std::string abiDir = "../abis";
+    // Shared pool threads this chain's update tasks may hold at once, 0 for no limit
+    size_t concurrency = 0;
+    int tickRange = 5;
+    StateRead stateRead = StateRead::Call;
+    // UniswapV3 keeps its tick windows between cycles and reads only new edge ticks and those touched by
+    // Mint/Burn logs; needs eth_getLogs
+    bool slidingTicks = false;
+    TransportOptions transport;
+    // Pool refresh tiers of the chain's adapters, off by default
+    TierPolicy refresh;
+
+    // Fields missing from the object keep their defaults
+    static ChainConfig fromJson(const nlohmann::json &config) {
+        ChainConfig chain;
+        chain.name = config.value("name", chain.name);
+        chain.rpcUrl = config.value("rpcUrl", chain.rpcUrl);
+        chain.dataDir = config.value("dataDir", chain.dataDir);
+        chain.abiDir = config.value("abiDir", chain.abiDir);
+        chain.concurrency = config.value("concurrency", chain.concurrency);
+        chain.tickRange = config.value("tickRange", chain.tickRange);
+        if (config.contains("stateRead")) {
+            chain.stateRead = parseStateRead(config["stateRead"].get<std::string>());
+        }
+        chain.slidingTicks = config.value("slidingTicks", chain.slidingTicks);
+        if (config.contains("http")) {
+            chain.transport.httpVersion = parseHttpVersion(config["http"].get<std::string>());
+        }
+        chain.transport.compression = config.value("compression", chain.transport.compression);
+        if (config.contains("refresh")) {
+            chain.refresh = TierPolicy::fromJson(config["refresh"]);
+        }
+        return chain;
+    }
+};
+
+#endif //CHAIN_CONFIG_H
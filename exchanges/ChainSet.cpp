@@ -0,0 +1,107 @@
+#include "ChainSet.h"
+
+#include <stdexcept>
+
+#include "adapters/Uniswap/UniswapV2.h"
+#include "adapters/Uniswap/UniswapV3.h"
+
+// Constructor: Start the pool shared by every chain
+ChainSet::ChainSet(const size_t threadCount) : threadPool{threadCount} {
+}
+
+// Create the chain's client, budget and orchestrator on the shared pool
+UpdateOrchestrator &ChainSet::addChain(const ChainConfig &config) {
+    if (config.name.empty()) {
+        throw std::invalid_argument{"ChainSet: every chain needs a name"};
+    }
+    for (const auto &chain: chains) {
+        if (chain->config.name == config.name) {
+            throw std::invalid_argument{"ChainSet: duplicate chain " + config.name};
+        }
+    }
+
+    auto chain = std::make_unique<Chain>();
+    chain->config = config;
+    if (config.concurrency != 0) {
+        chain->budget = std::make_shared<ConcurrencyBudget>(config.concurrency);
+    }
+    chain->orchestrator = std::make_unique<UpdateOrchestrator>(
+        std::make_shared<Web3Client>(config.rpcUrl, config.name, config.transport), threadPool, chain->budget);
+    chains.push_back(std::move(chain));
+    return *chains.back()->orchestrator;
+}
+
+// Add a chain with the bundled Uniswap adapters
+UpdateOrchestrator &ChainSet::addUniswapChain(const ChainConfig &config) {
+    UpdateOrchestrator &orchestrator = addChain(config);
+    orchestrator.addExchange<UniswapV2>(config);
+    orchestrator.addExchange<UniswapV3>(config.tickRange, config);
+    return orchestrator;
+}
+
+// Find a chain by name
+const ChainSet::Chain &ChainSet::find(const std::string &name) const {
+    for (const auto &chain: chains) {
+        if (chain->config.name == name) {
+            return *chain;
+        }
+    }
+    throw std::out_of_range{"ChainSet: unknown chain " + name};
+}
+
+// Get a chain's orchestrator
+UpdateOrchestrator &ChainSet::chain(const std::string &name) {
+    return *find(name).orchestrator;
+}
+
+// Get a chain's configuration
+const ChainConfig &ChainSet::config(const std::string &name) const {
+    return find(name).config;
+}
+
+// Get chain names in registration order
+std::vector<std::string> ChainSet::chainNames() const {
+    std::vector<std::string> names;
+    for (const auto &chain: chains) {
+        names.push_back(chain->config.name);
+    }
+    return names;
+}
+
+// One driver thread per chain, the threads mostly wait for heads while cycles run on the shared pool
+void ChainSet::run(const DriverOptions &options, const BlockDriver::CycleCallback &callback) {
+    // Loading can take minutes, so it is waited for without the lock and stop() returns meanwhile
+    for (const auto &chain: chains) {
+        chain->orchestrator->waitLoaded();
+    }
+    {
+        std::lock_guard lock(driversMutex);
+        if (stopping) return;
+        for (const auto &chain: chains) {
+            chain->driver = std::make_unique<BlockDriver>(*chain->orchestrator, options);
+            if (callback) chain->driver->onCycle(callback);
+        }
+    }
+
+    std::vector<std::thread> drivers;
+    for (const auto &chain: chains) {
+        drivers.emplace_back([&driver = *chain->driver] { driver.run(); });
+    }
+    for (auto &driver: drivers) {
+        driver.join();
+    }
+}
+
+// Stop every chain's driver
+void ChainSet::stop() {
+    std::lock_guard lock(driversMutex);
+    stopping = true;
+    for (const auto &chain: chains) {
+        if (chain->driver) chain->driver->stop();
+    }
+}
+
+// Get the shared pool
+ThreadPool &ChainSet::getThreadPool() {
+    return threadPool;
+}
@@ -0,0 +1,66 @@
+#ifndef CHAIN_SET_H
+#define CHAIN_SET_H
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "BlockDriver.h"
+#include "ChainConfig.h"
+#include "UpdateOrchestrator.h"
+#include "../utils/ConcurrencyBudget.h"
+#include "../utils/ThreadPool.h"
+
+// Several chains scraped side by side in one process. Every chain has its own client, adapters and
+// block driver; they share one update thread pool plus the process-wide ABI, token and metrics registries.
+// A chain's concurrency budget caps the pool threads it holds, so a slow chain cannot starve the others
+class ChainSet {
+public:
+    explicit ChainSet(size_t threadCount = std::thread::hardware_concurrency());
+
+    ChainSet(const ChainSet &) = delete;
+
+    ChainSet &operator=(const ChainSet &) = delete;
+
+    // Register a chain, add its exchanges through the returned orchestrator
+    UpdateOrchestrator &addChain(const ChainConfig &config);
+
+    // Register a chain with UniswapV2 and UniswapV3 loaded from its data directory
+    UpdateOrchestrator &addUniswapChain(const ChainConfig &config);
+
+    // Throws std::out_of_range for an unknown chain
+    [[nodiscard]] UpdateOrchestrator &chain(const std::string &name);
+
+    [[nodiscard]] const ChainConfig &config(const std::string &name) const;
+
+    [[nodiscard]] std::vector<std::string> chainNames() const;
+
+    // Run every chain's block driver on its own thread until stop() or each reaches maxCycles
+    void run(const DriverOptions &options, const BlockDriver::CycleCallback &callback = {});
+
+    // Let run() return after the cycles in progress, or once adapters are loaded if it is still waiting for them;
+    // returns without waiting, safe from any thread
+    void stop();
+
+    ThreadPool &getThreadPool();
+
+private:
+    struct Chain {
+        ChainConfig config;
+        std::shared_ptr<ConcurrencyBudget> budget;
+        std::unique_ptr<UpdateOrchestrator> orchestrator;
+        std::unique_ptr<BlockDriver> driver;
+    };
+
+    ThreadPool threadPool;
+    // Declared after the pool, chains are torn down while it is still running
+    std::vector<std::unique_ptr<Chain> > chains;
+    std::mutex driversMutex;
+    bool stopping = false;
+
+    [[nodiscard]] const Chain &find(const std::string &name) const;
+};
+
+#endif //CHAIN_SET_H
@@ -0,0 +1,46 @@
+#ifndef CHANGE_SET_H
+#define CHANGE_SET_H
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <gmpxx.h>
+
+#include "../utils/BoundedQueue.h"
+
+// One changed value of one pool between two consecutive update cycles
+struct PoolChange {
+    enum class Kind { Reserves, SqrtPrice, TickLiquidity, Liquidity };
+
+    std::string pool;
+    Kind kind;
+    // Only meaningful for TickLiquidity
+    int tick = 0;
+
+    // Reserves: {reserve0, reserve1}; SqrtPrice: {sqrtPriceX96, current tick}
+    // TickLiquidity: {liquidityNet, liquidityGross}; Liquidity: {in-range liquidity, 0}
+    // A value that did not exist before (new pool, newly initialized tick) is zero
+    std::array<mpz_class, 2> before;
+    std::array<mpz_class, 2> after;
+};
+
+// Everything an update cycle changed, tagged with the snapshot it produced
+struct ChangeSet {
+    std::string exchange;
+    uint64_t block = 0;
+    uint64_t version = 0;
+    // Unix milliseconds when the cycle published it, stamped by ExchangeBase::publishChanges if unset
+    int64_t timestamp = 0;
+    std::vector<PoolChange> changes;
+
+    [[nodiscard]] bool empty() const { return changes.empty(); }
+};
+
+using ChangeSetPtr = std::shared_ptr<const ChangeSet>;
+
+// Bounded queue of change sets, shared by any number of exchanges and consumers
+using ChangeQueue = BoundedQueue<ChangeSetPtr>;
+
+#endif //CHANGE_SET_H
@@ -0,0 +1,500 @@
+#include "ColumnarWriter.h"
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#ifdef DEDS_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#include "../utils/Metrics.h"
+
+namespace columnar {
+    constexpr char FileMagic[8] = {'D', 'E', 'D', 'S', 'C', 'O', 'L', '1'};
+    constexpr uint32_t FileVersion = 1;
+    constexpr uint32_t RowGroupMagic = 0x50524752; // "RGRP"
+
+    // Two's complement 256-bit big-endian word
+    Word toWord(const mpz_class &value) {
+        static const mpz_class modulus = mpz_class(1) << 256;
+        mpz_class unsignedValue = value;
+        if (unsignedValue < 0) {
+            unsignedValue += modulus;
+        }
+        Word word{};
+        size_t count = 0;
+        uint8_t bytes[32];
+        mpz_export(bytes, &count, 1, 1, 1, 0, unsignedValue.get_mpz_t());
+        if (count > 32) {
+            throw std::runtime_error{"Columnar: value wider than 256 bits"};
+        }
+        std::memcpy(word.data() + 32 - count, bytes, count);
+        return word;
+    }
+
+    // Read back a word, sign-extending if the column is signed
+    mpz_class fromWord(const Word &word, const bool isSigned) {
+        mpz_class value;
+        mpz_import(value.get_mpz_t(), word.size(), 1, 1, 1, 0, word.data());
+        if (isSigned && (word[0] & 0x80) != 0) {
+            value -= mpz_class(1) << 256;
+        }
+        return value;
+    }
+
+    // Append a little-endian integer
+    template<typename T>
+    static void put(std::vector<uint8_t> &out, const T value) {
+        const size_t offset = out.size();
+        out.resize(offset + sizeof(T));
+        std::memcpy(out.data() + offset, &value, sizeof(T));
+    }
+
+    static void putString(std::vector<uint8_t> &out, const std::string &value) {
+        if (value.size() > UINT16_MAX) {
+            throw std::runtime_error{"Columnar: string too long"};
+        }
+        put<uint16_t>(out, static_cast<uint16_t>(value.size()));
+        out.insert(out.end(), value.begin(), value.end());
+    }
+
+    // A read past the end of the file, the only failure an append may cut off as a crashed tail
+    struct TruncatedFile : std::runtime_error {
+        using std::runtime_error::runtime_error;
+    };
+
+    // Bounds-checked reader over a loaded file
+    struct Cursor {
+        const std::vector<uint8_t> &data;
+        size_t offset = 0;
+
+        [[nodiscard]] bool atEnd() const { return offset == data.size(); }
+
+        const uint8_t *take(const size_t size) {
+            if (size > data.size() - offset) {
+                throw TruncatedFile{"Columnar: truncated file at byte " + std::to_string(offset)};
+            }
+            const uint8_t *pointer = data.data() + offset;
+            offset += size;
+            return pointer;
+        }
+
+        template<typename T>
+        T get() {
+            T value;
+            std::memcpy(&value, take(sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        std::string getString() {
+            const auto size = get<uint16_t>();
+            const uint8_t *pointer = take(size);
+            return {reinterpret_cast<const char *>(pointer), size};
+        }
+    };
+
+    // Copy a raw chunk into a typed column
+    template<typename T>
+    static void decodeColumn(const std::vector<uint8_t> &raw, std::vector<T> &column, const size_t rows) {
+        column.resize(rows);
+        std::memcpy(column.data(), raw.data(), raw.size());
+    }
+
+    // Bytes per row of a column this version reads, 0 for columns added later
+    static size_t valueSize(const Column column) {
+        switch (column) {
+            case Column::Block:
+            case Column::Timestamp: return 8;
+            case Column::Pool:
+            case Column::Tick:
+            case Column::CurrentTick: return 4;
+            case Column::Kind: return 1;
+            case Column::Reserve0:
+            case Column::Reserve1:
+            case Column::SqrtPriceX96:
+            case Column::LiquidityNet:
+            case Column::LiquidityGross:
+            case Column::Liquidity: return sizeof(Word);
+            default: return 0;
+        }
+    }
+
+    // Read a file into memory
+    static std::vector<uint8_t> loadBytes(const std::string &path) {
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream) {
+            throw std::runtime_error{"Columnar: cannot open " + path};
+        }
+        return {std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+    }
+
+    // One row group after its magic, new pool addresses go to the file's dictionary
+    static RowGroup parseRowGroup(Cursor &cursor, File &file) {
+        RowGroup group;
+        const auto rows = cursor.get<uint32_t>();
+        group.exchange = cursor.getString();
+        const auto newPools = cursor.get<uint32_t>();
+        for (uint32_t i = 0; i < newPools; i++) {
+            file.pools.push_back(cursor.getString());
+        }
+
+        const auto columns = cursor.get<uint8_t>();
+        for (uint8_t c = 0; c < columns; c++) {
+            const auto column = static_cast<Column>(cursor.get<uint8_t>());
+            const auto codec = static_cast<Codec>(cursor.get<uint8_t>());
+            const auto rawSize = cursor.get<uint64_t>();
+            const auto storedSize = cursor.get<uint64_t>();
+            // Sizes are checked before anything is allocated. Raw chunks are stored as is, zlib ones only when
+            // smaller, and deflate expands at most 1032 to 1
+            if (codec != Codec::Raw && codec != Codec::Zlib) {
+                throw std::runtime_error{"Columnar: unknown codec"};
+            }
+            if (codec == Codec::Raw ? storedSize != rawSize : storedSize >= rawSize || rawSize / 1032 > storedSize) {
+                throw std::runtime_error{"Columnar: bad chunk sizes at byte " + std::to_string(cursor.offset)};
+            }
+            const size_t size = valueSize(column);
+            if (size != 0 && rawSize != static_cast<uint64_t>(rows) * size) {
+                throw std::runtime_error{"Columnar: column size does not match row count"};
+            }
+            const uint8_t *stored = cursor.take(storedSize);
+            if (size == 0) {
+                // Columns added by later versions are skipped
+                continue;
+            }
+
+            std::vector<uint8_t> raw(rawSize);
+            if (codec == Codec::Raw) {
+                std::memcpy(raw.data(), stored, rawSize);
+            } else {
+#ifdef DEDS_HAVE_ZLIB
+                uLongf decoded = rawSize;
+                if (uncompress(raw.data(), &decoded, stored, storedSize) != Z_OK || decoded != rawSize) {
+                    throw std::runtime_error{"Columnar: corrupt zlib chunk"};
+                }
+#else
+                throw std::runtime_error{"Columnar: zlib chunk in a build without zlib"};
+#endif
+            }
+
+            switch (column) {
+                case Column::Block: decodeColumn(raw, group.block, rows); break;
+                case Column::Timestamp: decodeColumn(raw, group.timestamp, rows); break;
+                case Column::Pool: decodeColumn(raw, group.pool, rows); break;
+                case Column::Kind: decodeColumn(raw, group.kind, rows); break;
+                case Column::Reserve0: decodeColumn(raw, group.reserve0, rows); break;
+                case Column::Reserve1: decodeColumn(raw, group.reserve1, rows); break;
+                case Column::SqrtPriceX96: decodeColumn(raw, group.sqrtPriceX96, rows); break;
+                case Column::Tick: decodeColumn(raw, group.tick, rows); break;
+                case Column::LiquidityNet: decodeColumn(raw, group.liquidityNet, rows); break;
+                case Column::LiquidityGross: decodeColumn(raw, group.liquidityGross, rows); break;
+                case Column::Liquidity: decodeColumn(raw, group.liquidity, rows); break;
+                case Column::CurrentTick: decodeColumn(raw, group.currentTick, rows); break;
+                default: break;
+            }
+        }
+        return group;
+    }
+
+    // Parse row groups into file, stopping cleanly at a tail cut short by the end of the file when tolerated. Bad
+    // magic, bad chunk headers and undecodable chunks throw either way
+    static uint64_t parse(const std::vector<uint8_t> &data, const std::string &path, File &file,
+                          const bool tolerateTruncation) {
+        Cursor cursor{data};
+
+        if (std::memcmp(cursor.take(sizeof(FileMagic)), FileMagic, sizeof(FileMagic)) != 0) {
+            throw std::runtime_error{"Columnar: not a column file: " + path};
+        }
+        if (const auto version = cursor.get<uint32_t>(); version != FileVersion) {
+            throw std::runtime_error{"Columnar: unsupported version " + std::to_string(version)};
+        }
+        cursor.get<uint32_t>();
+
+        uint64_t validBytes = cursor.offset;
+        while (!cursor.atEnd()) {
+            const size_t knownPools = file.pools.size();
+            try {
+                if (cursor.get<uint32_t>() != RowGroupMagic) {
+                    throw std::runtime_error{"Columnar: bad row group at byte " + std::to_string(cursor.offset)};
+                }
+                file.rowGroups.push_back(parseRowGroup(cursor, file));
+            } catch (const TruncatedFile &) {
+                if (!tolerateTruncation) throw;
+                file.pools.resize(knownPools);
+                break;
+            }
+            validBytes = cursor.offset;
+        }
+        return validBytes;
+    }
+
+    // Load a whole file
+    File read(const std::string &path) {
+        File file;
+        parse(loadBytes(path), path, file, false);
+        return file;
+    }
+
+    // Load the complete row groups of a file
+    File readComplete(const std::string &path, uint64_t &validBytes) {
+        File file;
+        validBytes = parse(loadBytes(path), path, file, true);
+        return file;
+    }
+}
+
+using namespace columnar;
+
+// Constructor: Write the file header and start the writer thread
+ColumnarWriter::ColumnarWriter(const std::string &path, ColumnarOptions options) : options{options}, path{path} {
+#ifndef DEDS_HAVE_ZLIB
+    if (options.compress) {
+        throw std::runtime_error{"ColumnarWriter: compression requested but built without zlib"};
+    }
+#endif
+    std::error_code error;
+    if (options.append && std::filesystem::file_size(path, error) > 0 && !error) {
+        // Rebuild the pool dictionary and drop a row group a crash left half-written
+        uint64_t validBytes = 0;
+        const File existing = readComplete(path, validBytes);
+        for (const std::string &pool: existing.pools) {
+            poolIds.emplace(pool, static_cast<uint32_t>(poolIds.size()));
+        }
+        std::filesystem::resize_file(path, validBytes);
+        file = std::fopen(path.c_str(), "ab");
+        bytes.store(validBytes, std::memory_order_relaxed);
+    } else {
+        file = std::fopen(path.c_str(), "wb");
+    }
+    if (!file) {
+        throw std::runtime_error{"ColumnarWriter: cannot open " + path};
+    }
+    // Row groups are encoded whole before writing, stdio buffering would only defer their write errors
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    if (bytes.load(std::memory_order_relaxed) == 0) {
+        std::vector<uint8_t> header(FileMagic, FileMagic + sizeof(FileMagic));
+        put<uint32_t>(header, FileVersion);
+        put<uint32_t>(header, 0);
+        writeBytes(header.data(), header.size());
+    }
+
+    worker = std::thread([this] { run(); });
+}
+
+// Destructor: Stop receiving, drain the queue, close the file
+ColumnarWriter::~ColumnarWriter() {
+    for (const auto &[exchange, id]: subscriptions) {
+        exchange->unsubscribe(id);
+    }
+    {
+        std::lock_guard lock(queueMutex);
+        stopping = true;
+    }
+    queueReady.notify_one();
+    worker.join();
+    std::fclose(file);
+}
+
+// Hand the change set to the writer thread
+bool ColumnarWriter::append(ChangeSetPtr changes) {
+    if (!changes || changes->empty()) {
+        return true;
+    }
+    {
+        std::lock_guard lock(queueMutex);
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        if (queue.size() >= options.maxPending) {
+            static Counter &dropped = Metrics::instance().counter("deds_columnar_dropped_total", {},
+                                                                  "Change sets dropped by a full columnar writer queue");
+            dropped.inc();
+            return false;
+        }
+        queue.push_back(std::move(changes));
+        enqueued++;
+    }
+    queueReady.notify_one();
+    return true;
+}
+
+// Wait until the writer thread caught up with everything enqueued before the call, rethrow a failed write
+void ColumnarWriter::flush() {
+    std::unique_lock lock(queueMutex);
+    const uint64_t target = enqueued;
+    queueDrained.wait(lock, [&] { return written >= target; });
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// Writer thread: encode and write one row group per change set. After a failed write the rest is dropped so the
+// file ends at its last complete row group
+void ColumnarWriter::run() {
+    std::unique_lock lock(queueMutex);
+    while (true) {
+        queueReady.wait(lock, [this] { return stopping || !queue.empty(); });
+        while (!queue.empty()) {
+            ChangeSetPtr changes = std::move(queue.front());
+            queue.pop_front();
+            if (!error) {
+                lock.unlock();
+                std::exception_ptr failure;
+                try {
+                    writeRowGroup(*changes);
+                } catch (const std::exception &) {
+                    failure = std::current_exception();
+                }
+                lock.lock();
+                error = failure;
+            }
+            written++;
+        }
+        queueDrained.notify_all();
+        if (stopping) {
+            return;
+        }
+    }
+}
+
+// Encode the change set column by column
+void ColumnarWriter::writeRowGroup(const ChangeSet &changes) {
+    static Histogram &writeTime = Metrics::instance().histogram("deds_columnar_write_seconds", {},
+                                                                "Row group encode and write duration");
+    ScopedTimer timer(writeTime);
+
+    const size_t rowCount = changes.changes.size();
+    buffer.clear();
+    put<uint32_t>(buffer, RowGroupMagic);
+    put<uint32_t>(buffer, static_cast<uint32_t>(rowCount));
+    putString(buffer, changes.exchange);
+
+    // Dictionary entries for pools this file has not seen yet, kept apart until the row group is on disk
+    std::vector<uint32_t> poolColumn(rowCount);
+    std::unordered_map<std::string_view, uint32_t> staged;
+    std::vector<const std::string *> newPools;
+    for (size_t i = 0; i < rowCount; i++) {
+        const std::string &pool = changes.changes[i].pool;
+        if (const auto known = poolIds.find(pool); known != poolIds.end()) {
+            poolColumn[i] = known->second;
+            continue;
+        }
+        auto [it, inserted] = staged.try_emplace(pool, static_cast<uint32_t>(poolIds.size() + staged.size()));
+        if (inserted) {
+            newPools.push_back(&pool);
+        }
+        poolColumn[i] = it->second;
+    }
+    put<uint32_t>(buffer, static_cast<uint32_t>(newPools.size()));
+    for (const std::string *pool: newPools) {
+        putString(buffer, *pool);
+    }
+
+    put<uint8_t>(buffer, static_cast<uint8_t>(ColumnCount));
+    std::vector<uint8_t> compressed;
+    const auto writeColumn = [&](const Column column, const void *data, const size_t size) {
+        Codec codec = Codec::Raw;
+        const void *stored = data;
+        size_t storedSize = size;
+#ifdef DEDS_HAVE_ZLIB
+        if (options.compress && size > 0) {
+            uLongf bound = compressBound(size);
+            compressed.resize(bound);
+            if (compress2(compressed.data(), &bound, static_cast<const Bytef *>(data), size,
+                          options.compressionLevel) == Z_OK && bound < size) {
+                codec = Codec::Zlib;
+                stored = compressed.data();
+                storedSize = bound;
+            }
+        }
+#endif
+        put<uint8_t>(buffer, static_cast<uint8_t>(column));
+        put<uint8_t>(buffer, static_cast<uint8_t>(codec));
+        put<uint64_t>(buffer, size);
+        put<uint64_t>(buffer, storedSize);
+        const auto *begin = static_cast<const uint8_t *>(stored);
+        buffer.insert(buffer.end(), begin, begin + storedSize);
+    };
+    const auto writeValues = [&](const Column column, const auto &values) {
+        writeColumn(column, values.data(), values.size() * sizeof(values[0]));
+    };
+
+    // Block and timestamp repeat per row so a column can be scanned on its own
+    writeValues(Column::Block, std::vector<uint64_t>(rowCount, changes.block));
+    writeValues(Column::Timestamp, std::vector<int64_t>(rowCount, changes.timestamp));
+    writeValues(Column::Pool, poolColumn);
+
+    std::vector<uint8_t> kinds(rowCount);
+    std::vector<int32_t> ticks(rowCount, 0);
+    std::vector<int32_t> currentTicks(rowCount, 0);
+    std::array<std::vector<Word>, 6> words;
+    for (auto &column: words) {
+        column.assign(rowCount, Word{});
+    }
+    for (size_t i = 0; i < rowCount; i++) {
+        const PoolChange &change = changes.changes[i];
+        kinds[i] = static_cast<uint8_t>(change.kind);
+        switch (change.kind) {
+            case PoolChange::Kind::Reserves:
+                words[0][i] = toWord(change.after[0]);
+                words[1][i] = toWord(change.after[1]);
+                break;
+            case PoolChange::Kind::SqrtPrice:
+                words[2][i] = toWord(change.after[0]);
+                currentTicks[i] = static_cast<int32_t>(change.after[1].get_si());
+                break;
+            case PoolChange::Kind::TickLiquidity:
+                ticks[i] = change.tick;
+                words[3][i] = toWord(change.after[0]);
+                words[4][i] = toWord(change.after[1]);
+                break;
+            case PoolChange::Kind::Liquidity:
+                words[5][i] = toWord(change.after[0]);
+                break;
+        }
+    }
+    writeValues(Column::Kind, kinds);
+    writeValues(Column::Reserve0, words[0]);
+    writeValues(Column::Reserve1, words[1]);
+    writeValues(Column::SqrtPriceX96, words[2]);
+    writeValues(Column::Tick, ticks);
+    writeValues(Column::LiquidityNet, words[3]);
+    writeValues(Column::LiquidityGross, words[4]);
+    writeValues(Column::Liquidity, words[5]);
+    writeValues(Column::CurrentTick, currentTicks);
+
+    writeBytes(buffer.data(), buffer.size());
+    for (const std::string *pool: newPools) {
+        poolIds.emplace(*pool, staged.at(*pool));
+    }
+    rows.fetch_add(rowCount, std::memory_order_relaxed);
+    rowGroups.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Write and flush, or cut the file back to its last good size and throw
+void ColumnarWriter::writeBytes(const void *data, const size_t size) {
+    const bool complete = std::fwrite(data, 1, size, file) == size;
+    if (!complete || std::fflush(file) != 0) {
+        const std::string reason = std::strerror(errno);
+        std::clearerr(file);
+        std::error_code ignored;
+        std::filesystem::resize_file(path, bytes.load(std::memory_order_relaxed), ignored);
+        throw std::runtime_error{"ColumnarWriter: write to " + path + " failed: " + reason};
+    }
+    bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+// Rows written so far
+uint64_t ColumnarWriter::rowsWritten() const {
+    return rows.load(std::memory_order_relaxed);
+}
+
+// Row groups written so far
+uint64_t ColumnarWriter::rowGroupsWritten() const {
+    return rowGroups.load(std::memory_order_relaxed);
+}
+
+// Bytes written so far, header included
+uint64_t ColumnarWriter::bytesWritten() const {
+    return bytes.load(std::memory_order_relaxed);
+}
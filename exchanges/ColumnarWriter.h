@@ -0,0 +1,163 @@
+#ifndef COLUMNAR_WRITER_H
+#define COLUMNAR_WRITER_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ChangeSet.h"
+#include "ExchangeBase.h"
+
+// Chunked column file of pool changes, one row group per change set (see README "Columnar Export")
+//   file:      "DEDSCOL1" u32 version u32 reserved
+//   row group: u32 'RGRP' u32 rows, exchange name, new pool addresses, then one chunk per column:
+//              u8 column u8 codec u64 raw size u64 stored size, data
+// Integers are little-endian, strings are u16 length + bytes. 256-bit values are 32-byte big-endian
+// two's complement words, like ABI words. Pool ids index the addresses in order of first appearance
+namespace columnar {
+    enum class Column : uint8_t {
+        Block, Timestamp, Pool, Kind, Reserve0, Reserve1, SqrtPriceX96, Tick, LiquidityNet, LiquidityGross, Liquidity,
+        CurrentTick
+    };
+
+    constexpr size_t ColumnCount = 12;
+
+    enum class Codec : uint8_t { Raw, Zlib };
+
+    using Word = std::array<uint8_t, 32>;
+
+    // Two's complement 256-bit big-endian word
+    Word toWord(const mpz_class &value);
+
+    mpz_class fromWord(const Word &word, bool isSigned);
+
+    // Decoded row group
+    struct RowGroup {
+        std::string exchange;
+        std::vector<uint64_t> block;
+        std::vector<int64_t> timestamp;
+        std::vector<uint32_t> pool;
+        std::vector<uint8_t> kind;
+        std::vector<Word> reserve0;
+        std::vector<Word> reserve1;
+        std::vector<Word> sqrtPriceX96;
+        // Index of the tick a TickLiquidity row describes
+        std::vector<int32_t> tick;
+        std::vector<Word> liquidityNet;
+        std::vector<Word> liquidityGross;
+        // In-range liquidity of Liquidity rows
+        std::vector<Word> liquidity;
+        // Pool's current tick on SqrtPrice rows, empty in files written before the column existed
+        std::vector<int32_t> currentTick;
+
+        [[nodiscard]] size_t rows() const { return block.size(); }
+    };
+
+    // Whole file as row groups, pool addresses indexed by pool id
+    struct File {
+        std::vector<std::string> pools;
+        std::vector<RowGroup> rowGroups;
+    };
+
+    File read(const std::string &path);
+
+    // Like read, but stops at a row group cut short by the end of the file instead of throwing; validBytes is where
+    // it starts. Corrupt contents still throw
+    File readComplete(const std::string &path, uint64_t &validBytes);
+}
+
+struct ColumnarOptions {
+    // Continue an existing file instead of truncating it, an incomplete trailing row group is cut off. A file that
+    // is corrupt before its end is left alone and the constructor throws
+    bool append = false;
+    // Compress column chunks with zlib, requires a build with DEDS_HAVE_ZLIB
+    bool compress = false;
+    int compressionLevel = 1;
+    // Change sets waiting for the writer thread; beyond that new ones are dropped and counted
+    size_t maxPending = 4096;
+};
+
+// Streams change sets to a column file from a background thread, producers only enqueue a pointer
+class ColumnarWriter {
+public:
+    // Creates or truncates the file, or continues it in append mode
+    explicit ColumnarWriter(const std::string &path, ColumnarOptions options = {});
+
+    // Drains what is queued, then unsubscribes and closes the file
+    ~ColumnarWriter();
+
+    ColumnarWriter(const ColumnarWriter &) = delete;
+
+    ColumnarWriter &operator=(const ColumnarWriter &) = delete;
+
+    // Queue a change set, never blocks on disk. Returns false if dropped because the queue is full, throws once a
+    // write has failed
+    bool append(ChangeSetPtr changes);
+
+    // Record the exchange's change sets, starting with its current snapshot as one row group
+    template<typename Exchange>
+    void attach(Exchange &exchange) {
+        const size_t id = exchange.subscribe([this](const ChangeSetPtr &changes) { append(changes); });
+        subscriptions.emplace_back(&exchange, id);
+        const auto current = exchange.snapshot();
+        auto seed = std::make_shared<ChangeSet>();
+        seed->exchange = exchange.name;
+        seed->block = current.block();
+        seed->version = current.version();
+        seed->changes = Exchange::diffStates({}, *current);
+        append(std::move(seed));
+    }
+
+    // Block until everything queued so far is written and flushed to the OS, throws once a write has failed
+    void flush();
+
+    [[nodiscard]] uint64_t rowsWritten() const;
+
+    [[nodiscard]] uint64_t rowGroupsWritten() const;
+
+    // Size of the file's complete row groups, header and appended-to contents included
+    [[nodiscard]] uint64_t bytesWritten() const;
+
+private:
+    ColumnarOptions options;
+    std::string path;
+    FILE *file = nullptr;
+
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::condition_variable queueDrained;
+    std::deque<ChangeSetPtr> queue;
+    uint64_t enqueued = 0;
+    uint64_t written = 0;
+    bool stopping = false;
+    // First failed write, nothing is written after it
+    std::exception_ptr error;
+
+    // Writer thread state
+    std::unordered_map<std::string, uint32_t> poolIds;
+    std::vector<uint8_t> buffer;
+    std::atomic<uint64_t> rows{0};
+    std::atomic<uint64_t> rowGroups{0};
+    std::atomic<uint64_t> bytes{0};
+
+    std::vector<std::pair<ExchangeBase *, size_t> > subscriptions;
+    std::thread worker;
+
+    void run();
+
+    void writeRowGroup(const ChangeSet &changes);
+
+    void writeBytes(const void *data, size_t size);
+};
+
+#endif //COLUMNAR_WRITER_H
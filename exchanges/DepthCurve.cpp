@@ -0,0 +1,122 @@
+#include "DepthCurve.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// One breakpoint at the current price that never ends
+DepthCurve DepthCurve::constantProduct(const double reserve0, const double reserve1, const double feeRate) {
+    DepthCurve curve;
+    curve.feeRate = feeRate;
+    if (reserve0 <= 0 || reserve1 <= 0) {
+        curve.sides = {std::vector<Point>{{}}, std::vector<Point>{{}}};
+        return curve;
+    }
+    curve.sqrtPrice = std::sqrt(reserve1 / reserve0);
+    const Point start{curve.sqrtPrice, 0, 0, std::sqrt(reserve0) * std::sqrt(reserve1)};
+    curve.sides = {std::vector<Point>{start}, std::vector<Point>{start}};
+    return curve;
+}
+
+// Walk out from the current tick once per side, accumulating each range's amounts like a swap would
+DepthCurve DepthCurve::concentrated(const double sqrtPrice, const int tick, const double liquidity,
+                                    const std::vector<std::pair<int, double> > &ticks,
+                                    const std::pair<int, int> window, const double feeRate) {
+    DepthCurve curve;
+    curve.sqrtPrice = sqrtPrice;
+    curve.feeRate = feeRate;
+    const double grossUp = 1 / (1 - feeRate);
+
+    // Close the segment from the side's last point at target and open the next one with the new liquidity
+    const auto extend = [&](std::vector<Point> &side, const bool down, double target, const double nextLiquidity) {
+        const Point &last = side.back();
+        target = down ? std::min(target, last.sqrtPrice) : std::max(target, last.sqrtPrice);
+        const double netIn = down ? last.liquidity * (1 / target - 1 / last.sqrtPrice)
+                                  : last.liquidity * (target - last.sqrtPrice);
+        const double out = down ? last.liquidity * (last.sqrtPrice - target)
+                                : last.liquidity * (1 / last.sqrtPrice - 1 / target);
+        side.push_back({target, last.amountIn + netIn * grossUp, last.amountOut + out, std::max(0.0, nextLiquidity)});
+    };
+
+    // Ticks at or below the current one are crossed on the way down and their liquidityNet leaves the range
+    const auto above = std::ranges::upper_bound(ticks, tick, {}, &std::pair<int, double>::first);
+    std::vector<Point> &down = curve.sides[0];
+    down.push_back({sqrtPrice, 0, 0, liquidity});
+    for (auto it = std::make_reverse_iterator(above); it != ticks.rend() && it->first >= window.first; ++it) {
+        extend(down, true, sqrtPriceAt(it->first), down.back().liquidity - it->second);
+    }
+    extend(down, true, sqrtPriceAt(window.first), 0);
+
+    std::vector<Point> &up = curve.sides[1];
+    up.push_back({sqrtPrice, 0, 0, liquidity});
+    for (auto it = above; it != ticks.end() && it->first <= window.second; ++it) {
+        extend(up, false, sqrtPriceAt(it->first), up.back().liquidity + it->second);
+    }
+    extend(up, false, sqrtPriceAt(window.second), 0);
+    return curve;
+}
+
+// Price at a tick boundary
+double DepthCurve::sqrtPriceAt(const int tick) {
+    static const double halfLogBase = std::log(1.0001) / 2;
+    return std::exp(tick * halfLogBase);
+}
+
+// Binary search on cumulative input; of points sharing an input (an empty range), the furthest
+const DepthCurve::Point &DepthCurve::segmentFor(const double amountIn, const bool zeroForOne) const {
+    const std::vector<Point> &side = sides[zeroForOne ? 0 : 1];
+    return *std::prev(std::ranges::upper_bound(side, amountIn, {}, &Point::amountIn));
+}
+
+// Constant liquidity step: token0 in moves sqrtPrice to L s / (L + x s), token1 in to s + x / L
+double DepthCurve::priceAfter(const Point &point, const double netIn, const bool zeroForOne) {
+    return zeroForOne ? point.liquidity * point.sqrtPrice / (point.liquidity + netIn * point.sqrtPrice)
+                      : point.sqrtPrice + netIn / point.liquidity;
+}
+
+// Cumulative output at the segment start plus the partial segment. The step is L s^2 x / (L + x s) for token0 in and
+// y / (s (s + y / L)) for token1 in, the same as L (s - s') and L (1/s - 1/s') without subtracting two close prices,
+// which loses small trades against deep pools
+double DepthCurve::amountOut(const double amountIn, const bool zeroForOne) const {
+    if (amountIn <= 0) return 0;
+    const Point &point = segmentFor(amountIn, zeroForOne);
+    if (point.liquidity <= 0) return point.amountOut;
+    const double netIn = (amountIn - point.amountIn) * (1 - feeRate);
+    const double liquidity = point.liquidity;
+    const double price = point.sqrtPrice;
+    return point.amountOut + (zeroForOne ? liquidity * price * (price * netIn) / (liquidity + netIn * price)
+                                         : netIn / (price * (price + netIn / liquidity)));
+}
+
+// Relative move of the marginal rate, token1 per token0 when selling token0 and its inverse otherwise
+double DepthCurve::priceImpact(const double amountIn, const bool zeroForOne) const {
+    if (amountIn <= 0 || sqrtPrice <= 0) return 0;
+    const Point &point = segmentFor(amountIn, zeroForOne);
+    const double next = point.liquidity <= 0
+                            ? point.sqrtPrice
+                            : priceAfter(point, (amountIn - point.amountIn) * (1 - feeRate), zeroForOne);
+    const double ratio = next / sqrtPrice;
+    return zeroForOne ? 1 - ratio * ratio : 1 - 1 / (ratio * ratio);
+}
+
+// Binary search on price for the impact's target, then invert the segment's step
+double DepthCurve::maxInput(const double impact, const bool zeroForOne) const {
+    if (impact <= 0 || sqrtPrice <= 0) return 0;
+    if (impact >= 1) return capacity(zeroForOne);
+    const double target = zeroForOne ? sqrtPrice * std::sqrt(1 - impact) : sqrtPrice / std::sqrt(1 - impact);
+
+    const std::vector<Point> &side = sides[zeroForOne ? 0 : 1];
+    const Point &point = *std::prev(std::ranges::partition_point(side, [&](const Point &candidate) {
+        return zeroForOne ? candidate.sqrtPrice >= target : candidate.sqrtPrice <= target;
+    }));
+    if (point.liquidity <= 0) return point.amountIn;
+    const double netIn = zeroForOne ? point.liquidity * (1 / target - 1 / point.sqrtPrice)
+                                    : point.liquidity * (target - point.sqrtPrice);
+    return point.amountIn + netIn / (1 - feeRate);
+}
+
+// End of the last segment, none when it is unbounded
+double DepthCurve::capacity(const bool zeroForOne) const {
+    const Point &last = sides[zeroForOne ? 0 : 1].back();
+    return last.liquidity > 0 ? std::numeric_limits<double>::infinity() : last.amountIn;
+}
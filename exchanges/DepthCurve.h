@@ -0,0 +1,63 @@
+#ifndef DEPTH_CURVE_H
+#define DEPTH_CURVE_H
+
+#include <array>
+#include <utility>
+#include <vector>
+
+// Precomputed liquidity depth of one pool in both swap directions: cumulative input and output at every price
+// where the in-range liquidity changes. Between two breakpoints liquidity is constant, so price impact, output
+// and the largest input for a given impact are a binary search plus one closed-form step, with no tick walk.
+// Amounts are raw token units in double precision, prices are sqrt(token1 / token0) in raw units.
+// Built once per pool state and immutable after, so it can be shared between snapshots
+class DepthCurve {
+public:
+    // Price where the in-range liquidity changes, with the cumulative amounts to reach it from the current price
+    struct Point {
+        double sqrtPrice = 0;
+        // Input including the fee
+        double amountIn = 0;
+        double amountOut = 0;
+        // Liquidity from this price on, away from the current price. Positive on the last point means the
+        // curve continues without limit, as constant product does; zero there is the end of the known range
+        double liquidity = 0;
+    };
+
+    // x * y = k, one unbounded segment with liquidity sqrt(k). feeRate is the share of the input kept by the pool
+    static DepthCurve constantProduct(double reserve0, double reserve1, double feeRate);
+
+    // Concentrated liquidity. ticks are the initialized (tick, liquidityNet) in the fetched window, ascending; the
+    // curve ends at the window edges, past which the liquidity is unknown
+    static DepthCurve concentrated(double sqrtPrice, int tick, double liquidity,
+                                   const std::vector<std::pair<int, double> > &ticks, std::pair<int, int> window,
+                                   double feeRate);
+
+    // Output for an exact input of token0 (zeroForOne) or token1, capped at the end of the known range
+    [[nodiscard]] double amountOut(double amountIn, bool zeroForOne) const;
+
+    // Fraction the marginal rate (output per input before the fee) falls after the input, e.g. 0.01 for 1%
+    [[nodiscard]] double priceImpact(double amountIn, bool zeroForOne) const;
+
+    // Largest input that moves the price by at most impact, capped at capacity
+    [[nodiscard]] double maxInput(double impact, bool zeroForOne) const;
+
+    // Input that exhausts the known range, infinity for an unbounded side
+    [[nodiscard]] double capacity(bool zeroForOne) const;
+
+    double sqrtPrice = 0;
+    double feeRate = 0;
+    // Breakpoints from the current price outwards: [0] as the price falls (selling token0), [1] as it rises
+    std::array<std::vector<Point>, 2> sides;
+
+    // sqrt(1.0001^tick)
+    static double sqrtPriceAt(int tick);
+
+private:
+    // Last breakpoint at or before the input on a side
+    [[nodiscard]] const Point &segmentFor(double amountIn, bool zeroForOne) const;
+
+    // Price after a net (after fee) input from a breakpoint, within its segment
+    static double priceAfter(const Point &point, double netIn, bool zeroForOne);
+};
+
+#endif //DEPTH_CURVE_H
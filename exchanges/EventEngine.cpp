@@ -0,0 +1,245 @@
+#include "EventEngine.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <ranges>
+#include <sstream>
+#include <stdexcept>
+
+#include "../utils/Metrics.h"
+
+using json = nlohmann::json;
+
+// Block number and log index of a log, 0 for a missing quantity
+static std::pair<uint64_t, uint64_t> logPosition(const json &log) {
+    const auto quantity = [&log](const char *field) -> uint64_t {
+        const auto it = log.find(field);
+        return it == log.end() || !it->is_string() ? 0 : std::stoull(it->get<std::string>(), nullptr, 16);
+    };
+    return {quantity("blockNumber"), quantity("logIndex")};
+}
+
+// JSON-RPC quantity
+static std::string hexQuantity(const uint64_t value) {
+    std::ostringstream out;
+    out << "0x" << std::hex << value;
+    return out.str();
+}
+
+static std::string lowercase(std::string address) {
+    std::ranges::transform(address, address.begin(), [](const unsigned char c) { return std::tolower(c); });
+    return address;
+}
+
+// Index every pool by its lowercase address and collect the topics the exchanges consume
+EventEngine::EventEngine(std::shared_ptr<Web3Client> web3Client, std::vector<ExchangeBase *> exchangeList,
+                         EventEngineOptions engineOptions)
+    : options(engineOptions), web3(std::move(web3Client)), exchanges(std::move(exchangeList)),
+      applied(exchanges.size(), 0) {
+    for (size_t i = 0; i < exchanges.size(); i++) {
+        for (const auto &address: exchanges[i]->pools | std::views::keys) {
+            std::string lower = lowercase(address);
+            addresses.push_back(lower);
+            owners.emplace(std::move(lower), std::pair{i, address});
+        }
+        for (std::string &topic: exchanges[i]->eventTopics()) {
+            if (std::ranges::find(topics, topic) == topics.end()) topics.push_back(std::move(topic));
+        }
+    }
+}
+
+// One head per call, errors leave the states where they were and the next call retries the range
+uint64_t EventEngine::update() {
+    try {
+        const uint64_t head = web3->getBlockNumber();
+        catchUp(head);
+        if (options.reconcileInterval > 0 && head >= reconciledAt + options.reconcileInterval) {
+            reconcile();
+        }
+    } catch (const std::exception &e) {
+        Metrics::instance().counter("deds_event_errors_total", web3->labels(), "Failed event engine updates").inc();
+        std::cerr << "Error applying pool events: " << e.what() << std::endl;
+    }
+    return block();
+}
+
+// Read exchanges without a state, or past the head after a reorg, then apply the logs the rest are missing
+void EventEngine::catchUp(const uint64_t head) {
+    for (size_t i = 0; i < exchanges.size(); i++) {
+        if (applied[i] != 0 && applied[i] <= head) continue;
+        exchanges[i]->updatePools();
+        applied[i] = exchanges[i]->stateBlock();
+        if (applied[i] == 0) {
+            throw std::runtime_error{"EventEngine: initial read of " + exchanges[i]->name + " failed"};
+        }
+        reconciledAt = head;
+    }
+
+    const uint64_t from = block() + 1;
+    if (from > head) return;
+    std::vector<json> logs = fetchLogs(from, head);
+    if (recording.is_open()) {
+        for (const json &log: logs) recording << log.dump() << '\n';
+        recording.flush();
+    }
+    apply(std::move(logs), head);
+}
+
+// Compare each exchange's event state with a read at the block it is valid at
+size_t EventEngine::reconcile() {
+    const uint64_t head = web3->getBlockNumber();
+    catchUp(head);
+
+    const MetricLabels labels = web3->labels();
+    Metrics &metrics = Metrics::instance();
+    size_t drifted = 0;
+    for (size_t i = 0; i < exchanges.size(); i++) {
+        const auto drift = exchanges[i]->reconcile(applied[i]);
+        applied[i] = std::max(applied[i], exchanges[i]->stateBlock());
+        if (!drift) {
+            metrics.counter("deds_event_reconcile_skipped_total", labels,
+                            "Reconciliations by adapters that cannot read at a given block").inc();
+            continue;
+        }
+        if (!drift->empty()) {
+            std::cerr << exchanges[i]->name << " event state drifted on " << drift->size()
+                    << " values, replaced by the RPC read" << std::endl;
+        }
+        drifted += drift->size();
+    }
+    metrics.counter("deds_event_drift_total", labels, "Values the event state had wrong at reconciliation")
+            .inc(drifted);
+    reconciledAt = head;
+    return drifted;
+}
+
+// Every block range and address group is one eth_getLogs, merged into block and log order
+std::vector<json> EventEngine::fetchLogs(const uint64_t fromBlock, const uint64_t toBlock) const {
+    std::vector<std::pair<std::pair<uint64_t, uint64_t>, json> > found;
+    const size_t perCall = std::max<size_t>(options.poolsPerCall, 1);
+    const uint64_t range = std::max<uint64_t>(options.maxBlockRange, 1);
+    for (uint64_t begin = fromBlock; begin <= toBlock; begin += range) {
+        const uint64_t end = std::min(toBlock, begin + range - 1);
+        for (size_t first = 0; first < addresses.size(); first += perCall) {
+            const size_t last = std::min(first + perCall, addresses.size());
+            const json filter = {
+                {"fromBlock", hexQuantity(begin)}, {"toBlock", hexQuantity(end)},
+                {"address", std::vector<std::string>(addresses.begin() + static_cast<std::ptrdiff_t>(first),
+                                                     addresses.begin() + static_cast<std::ptrdiff_t>(last))},
+                {"topics", json::array({topics})}
+            };
+            json result = web3->sendRpcRequest("eth_getLogs", json::array({filter}));
+            for (json &log: result) {
+                if (log.value("removed", false)) continue;
+                found.emplace_back(logPosition(log), std::move(log));
+            }
+        }
+    }
+    std::ranges::stable_sort(found, {}, &std::pair<std::pair<uint64_t, uint64_t>, json>::first);
+
+    std::vector<json> logs;
+    logs.reserve(found.size());
+    for (auto &entry: found) logs.push_back(std::move(entry.second));
+    return logs;
+}
+
+// Group by owning exchange, dropping logs an exchange's state already includes
+size_t EventEngine::apply(std::vector<json> logs, const uint64_t block) {
+    std::vector<std::vector<PoolLog> > byExchange(exchanges.size());
+    for (json &log: logs) {
+        const auto address = log.find("address");
+        if (address == log.end()) continue;
+        const auto owner = owners.find(lowercase(address->get<std::string>()));
+        if (owner == owners.end()) continue;
+        const auto &[index, pool] = owner->second;
+        if (logPosition(log).first <= applied[index]) continue;
+        byExchange[index].push_back({pool, std::move(log)});
+    }
+
+    size_t total = 0;
+    for (size_t i = 0; i < exchanges.size(); i++) {
+        if (!byExchange[i].empty()) {
+            total += exchanges[i]->applyLogs(byExchange[i], block);
+            // Pools the logs moved are re-read by the next RPC read whatever their refresh tier
+            std::vector<std::string> moved;
+            for (const PoolLog &poolLog: byExchange[i]) moved.push_back(poolLog.pool);
+            exchanges[i]->refreshScheduler.touch(moved);
+        }
+        applied[i] = std::max(applied[i], block);
+    }
+    Metrics::instance().counter("deds_event_logs_total", web3->labels(), "Pool logs applied by the event engine")
+            .inc(total);
+    return total;
+}
+
+// Range by range, so the stream never has to fit in memory
+size_t EventEngine::download(const uint64_t fromBlock, const uint64_t toBlock, const std::string &path) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error{"EventEngine: cannot write " + path};
+    const uint64_t range = std::max<uint64_t>(options.maxBlockRange, 1);
+    size_t written = 0;
+    for (uint64_t begin = fromBlock; begin <= toBlock; begin += range) {
+        for (const json &log: fetchLogs(begin, std::min(toBlock, begin + range - 1))) {
+            out << log.dump() << '\n';
+            written++;
+        }
+    }
+    return written;
+}
+
+// Append, so a restarted recorder continues its stream
+void EventEngine::startRecording(const std::string &path) {
+    recording.open(path, std::ios::app);
+    if (!recording) throw std::runtime_error{"EventEngine: cannot write " + path};
+}
+
+// Empty states at block 0, so the next update reads them again unless a replay fills them first
+void EventEngine::reset() {
+    for (ExchangeBase *exchange: exchanges) exchange->clearState();
+    std::ranges::fill(applied, 0);
+    reconciledAt = 0;
+}
+
+// Collect replayStep blocks of logs, apply them as one snapshot, repeat
+size_t EventEngine::replay(const std::string &path, const std::function<void(uint64_t block)> &onBlock) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error{"EventEngine: cannot open " + path};
+    const uint64_t step = std::max<uint64_t>(options.replayStep, 1);
+
+    std::vector<json> pending;
+    std::pair<uint64_t, uint64_t> last{0, 0};
+    uint64_t blocks = 0;
+    size_t total = 0;
+    const auto flush = [&] {
+        if (pending.empty()) return;
+        total += apply(std::move(pending), last.first);
+        pending = {};
+        blocks = 0;
+        if (onBlock) onBlock(last.first);
+    };
+
+    for (std::string line; std::getline(in, line);) {
+        if (line.empty()) continue;
+        json log = json::parse(line);
+        const std::pair<uint64_t, uint64_t> position = logPosition(log);
+        if (position < last) {
+            throw std::runtime_error{"EventEngine: " + path + " goes back from block " + std::to_string(last.first) +
+                                     " log " + std::to_string(last.second) + " to block " +
+                                     std::to_string(position.first)};
+        }
+        if (position.first != last.first) {
+            if (blocks == step) flush();
+            blocks++;
+        }
+        last = position;
+        pending.push_back(std::move(log));
+    }
+    flush();
+    return total;
+}
+
+// The least advanced exchange bounds the engine
+uint64_t EventEngine::block() const {
+    return applied.empty() ? 0 : *std::ranges::min_element(applied);
+}
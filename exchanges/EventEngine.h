@@ -0,0 +1,86 @@
+#ifndef EVENT_ENGINE_H
+#define EVENT_ENGINE_H
+
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "ExchangeBase.h"
+#include "../utils/Web3Client.h"
+
+struct EventEngineOptions {
+    // Blocks between RPC reconciliations, 0 never reconciles
+    uint64_t reconcileInterval = 1000;
+    // Pools per eth_getLogs address filter
+    size_t poolsPerCall = 1000;
+    // Longest block range per eth_getLogs, nodes cap it
+    uint64_t maxBlockRange = 2000;
+    // Blocks applied per published snapshot in replay; onBlock sees the last block of each step
+    uint64_t replayStep = 1;
+};
+
+// Keeps the exchanges' state current by applying their pools' logs instead of re-reading the pools. The first
+// update reads every exchange over RPC; later ones fetch the logs since and hand them to applyLogs in block and
+// log order. Every reconcileInterval blocks the state is read over RPC again, which replaces it, and any
+// difference is counted as drift. The same path replays a recorded log stream without a node: from an empty
+// state, the logs since the pools' creation rebuild their exact state at every block.
+// Not thread-safe; the exchanges must not be updated by anything else meanwhile
+class EventEngine {
+public:
+    EventEngine(std::shared_ptr<Web3Client> web3Client, std::vector<ExchangeBase *> exchangeList,
+                EventEngineOptions engineOptions = {});
+
+    // Bring every exchange to the head and reconcile when due. Returns the block all states are at
+    uint64_t update();
+
+    // Catch up to the head, then read every exchange over RPC at the block its state is at. Returns the values that
+    // had drifted
+    size_t reconcile();
+
+    // Write the exchanges' logs of [fromBlock, toBlock] as JSON lines, for replay. Returns the logs written
+    size_t download(uint64_t fromBlock, uint64_t toBlock, const std::string &path);
+
+    // Append the logs of every later update to a JSON-lines file
+    void startRecording(const std::string &path);
+
+    // Clear every exchange's state so a replay starts from nothing
+    void reset();
+
+    // Apply a JSON-lines log stream in block order, as fast as applyLogs goes. Blocks must not decrease; logs at
+    // or below the block an exchange is already at are skipped. Returns the logs applied
+    size_t replay(const std::string &path, const std::function<void(uint64_t block)> &onBlock = {});
+
+    // Oldest block an exchange's state is at
+    [[nodiscard]] uint64_t block() const;
+
+    EventEngineOptions options;
+
+private:
+    std::shared_ptr<Web3Client> web3;
+    std::vector<ExchangeBase *> exchanges;
+    // Lowercase pool address to its exchange's index and its key in pools
+    std::unordered_map<std::string, std::pair<size_t, std::string> > owners;
+    std::vector<std::string> addresses;
+    std::vector<std::string> topics;
+    // Block each exchange's state is valid at, 0 before its first read
+    std::vector<uint64_t> applied;
+    uint64_t reconciledAt = 0;
+    std::ofstream recording;
+
+    // Logs of every pool in [fromBlock, toBlock], sorted by block and log index
+    std::vector<nlohmann::json> fetchLogs(uint64_t fromBlock, uint64_t toBlock) const;
+
+    // Hand each exchange its logs past the block it is at and move it to block
+    size_t apply(std::vector<nlohmann::json> logs, uint64_t block);
+
+    // A full read of any exchange that has no state yet, then the logs up to head
+    void catchUp(uint64_t head);
+};
+
+#endif //EVENT_ENGINE_H
@@ -1,16 +1,24 @@
 #include "ExchangeBase.h"
 
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <ranges>
+#include <utility>
+
 using string = std::string;
 
 // Base constructor for all exchange implementations
-ExchangeBase::ExchangeBase(std::shared_ptr<Web3Client> web3Client, std::string exchangeName)
-    : name{std::move(exchangeName)}, web3{web3Client} {
+ExchangeBase::ExchangeBase(std::shared_ptr<Web3Client> web3Client, std::string exchangeName, ChainConfig chainConfig)
+    : name{std::move(exchangeName)}, chain{std::move(chainConfig)}, refreshScheduler{chain.refresh},
+      web3{web3Client},
+      staleness{Metrics::instance().gauge("deds_state_staleness_blocks", labels(), "Observed head minus state block")} {
 }
 
 // Find token index in pool's token list
 std::optional<int> ExchangeBase::getLocalIndex(const Token &token, const Pool &pool) {
     for (int i = 0; i < pool.tokens.size(); i++) {
-        if (pool.tokens[i]->address == token.address) {
+        if (pool.tokens[i] == static_cast<TokenId>(token.tokenGlobalIndice)) {
             return i;
         }
     }
@@ -18,14 +26,290 @@ std::optional<int> ExchangeBase::getLocalIndex(const Token &token, const Pool &p
 }
 
 // Add token to global registry if not exists
-void ExchangeBase::addToken(const string &address) {
-    if (!tokens.contains(address)) {
-        Token token;
-        token.address = address;
-        token.ERC20sync(web3);
-        tokens[address] = token;
-        token.tokenGlobalIndice = tokens.size() - 1;
+// Metadata is fetched outside the lock, concurrent first sightings of a token coalesce in the call cache
+TokenId ExchangeBase::addToken(const string &address) {
+    TokenRegistry &registry = TokenRegistry::instance();
+    if (std::optional<TokenId> known = registry.find(address, chain.name)) {
+        return *known;
+    }
+
+    Token token;
+    token.address = address;
+    token.chain = chain.name;
+    token.ERC20sync(web3, chain.abiDir);
+    return registry.insert(std::move(token));
+}
+
+// Copy of a registered token
+std::optional<Token> ExchangeBase::getToken(const string &address, const string &chain) {
+    TokenRegistry &registry = TokenRegistry::instance();
+    if (std::optional<TokenId> id = registry.find(address, chain)) {
+        return registry.get(*id);
+    }
+    return std::nullopt;
+}
+
+// Build metric labels, chain first
+MetricLabels ExchangeBase::labels(MetricLabels extra) const {
+    extra.insert(extra.begin(), {"exchange", name});
+    if (!chain.name.empty()) {
+        extra.insert(extra.begin(), {"chain", chain.name});
+    }
+    return extra;
+}
+
+// Set the pool share for update subtasks
+void ExchangeBase::setBudget(std::shared_ptr<ConcurrencyBudget> concurrencyBudget) {
+    budget = std::move(concurrencyBudget);
+}
+
+// Get per-stage duration histogram, labelled by exchange and stage
+Histogram &ExchangeBase::stageHistogram(const std::string &stage) const {
+    return Metrics::instance().histogram("deds_update_stage_seconds", labels({{"stage", stage}}),
+                                         "updatePools stage duration");
+}
+
+// Publish pools refreshed and how many blocks the state lags the observed head
+void ExchangeBase::recordCycle(const size_t poolsRefreshed, const uint64_t stateBlock) const {
+    Metrics &metrics = Metrics::instance();
+    const MetricLabels labels = this->labels();
+    const uint64_t head = web3->getObservedHead();
+
+    metrics.counter("deds_update_cycles_total", labels, "Completed updatePools cycles").inc();
+    metrics.gauge("deds_pools_refreshed", labels, "Pools refreshed in the last cycle")
+            .set(static_cast<double>(poolsRefreshed));
+    metrics.gauge("deds_state_block", labels, "Block the published state was read at")
+            .set(static_cast<double>(stateBlock));
+    lastStateBlock.store(stateBlock, std::memory_order_release);
+    recordStaleness(head);
+}
+
+// Head minus the block of the last published state
+void ExchangeBase::recordStaleness(const uint64_t head) const {
+    const uint64_t stateBlock = lastStateBlock.load(std::memory_order_acquire);
+    staleness.set(head > stateBlock ? static_cast<double>(head - stateBlock) : 0.0);
+}
+
+// Collect pool addresses and ask the scheduler, again after the pools it skips are checked for logs
+std::vector<std::string> ExchangeBase::poolsDue(const uint64_t block) {
+    std::vector<std::string> addresses;
+    addresses.reserve(pools.size());
+    for (const auto &address: pools | std::views::keys) {
+        addresses.push_back(address);
+    }
+    std::vector<std::string> due = refreshScheduler.due(addresses, block);
+    if (due.size() == addresses.size()) {
+        return due;
+    }
+
+    const std::unordered_set<std::string> selected(due.begin(), due.end());
+    std::vector<std::string> skipped;
+    for (const auto &address: addresses) {
+        if (!selected.contains(address)) skipped.push_back(address);
+    }
+    scanSkippedPools(skipped, block);
+    return refreshScheduler.due(addresses, block);
+}
+
+// One eth_getLogs per logPoolsPerCall pools. A failed scan leaves the pools at their older current block, where the
+// state block shows them until their tier refreshes them
+void ExchangeBase::scanSkippedPools(const std::vector<std::string> &skipped, const uint64_t block) {
+    const std::vector<std::string> topics = eventTopics();
+    uint64_t from = block;
+    for (const auto &address: skipped) {
+        const uint64_t current = currentBlock(address);
+        from = std::min(from, current == 0 ? block : current);
+    }
+    if (topics.empty() || from >= block) {
+        return;
+    }
+
+    std::unordered_map<std::string, std::string> byLowercase;
+    std::vector<std::string> addresses;
+    for (const auto &address: skipped) {
+        std::string lower = address;
+        std::ranges::transform(lower, lower.begin(), [](const unsigned char c) { return std::tolower(c); });
+        byLowercase.emplace(lower, address);
+        addresses.push_back(std::move(lower));
+    }
+
+    std::vector<std::string> active;
+    try {
+        ScopedTimer timer(stageHistogram("activity"));
+        const size_t perCall = std::max<size_t>(logPoolsPerCall, 1);
+        for (size_t begin = 0; begin < addresses.size(); begin += perCall) {
+            const size_t end = std::min(begin + perCall, addresses.size());
+            const nlohmann::json filter = {
+                {"fromBlock", Web3Client::blockTag(from + 1)}, {"toBlock", Web3Client::blockTag(block)},
+                {"address", std::vector<std::string>(addresses.begin() + static_cast<std::ptrdiff_t>(begin),
+                                                     addresses.begin() + static_cast<std::ptrdiff_t>(end))},
+                {"topics", nlohmann::json::array({topics})}
+            };
+            for (const auto &log: web3->sendRpcRequest("eth_getLogs", nlohmann::json::array({filter}))) {
+                if (log.value("removed", false)) continue;
+                std::string address = log.value("address", "");
+                std::ranges::transform(address, address.begin(), [](const unsigned char c) { return std::tolower(c); });
+                if (const auto pool = byLowercase.find(address); pool != byLowercase.end()) {
+                    active.push_back(pool->second);
+                }
+            }
+        }
+    } catch (const std::exception &e) {
+        std::cerr << "Error fetching logs of the pools " << name << " skips, their state ages: " << e.what()
+                << std::endl;
+        return;
+    }
+
+    refreshScheduler.touch(active);
+    const std::unordered_set<std::string> moved(active.begin(), active.end());
+    for (const auto &address: skipped) {
+        if (!moved.contains(address) && currentBlock(address) != 0) currentBlocks[address] = block;
+    }
+}
+
+// Stamp the read pools and find the oldest pool
+uint64_t ExchangeBase::recordReads(const std::vector<std::string> &read, const uint64_t block) {
+    for (const auto &address: read) {
+        currentBlocks[address] = block;
+    }
+    uint64_t oldest = block;
+    for (const auto &address: pools | std::views::keys) {
+        if (const uint64_t current = currentBlock(address); current != 0) {
+            oldest = std::min(oldest, current);
+        }
     }
+    return oldest;
+}
+
+// Move the baseline instead of stamping every pool, so an applied event batch costs nothing per untouched pool
+uint64_t ExchangeBase::recordReads(const uint64_t block) {
+    currentBlocks.clear();
+    baselineBlock = block;
+    return block;
 }
 
-std::unordered_map<std::string, Token> ExchangeBase::tokens;
+uint64_t ExchangeBase::currentBlock(const std::string &address) const {
+    const auto it = currentBlocks.find(address);
+    return it == currentBlocks.end() ? baselineBlock : it->second;
+}
+
+// Re-tier the refreshed pools, count what tiering skipped
+void ExchangeBase::recordRefresh(const std::vector<std::string> &refreshed,
+                                 const std::unordered_set<std::string> &changed, const uint64_t block) {
+    if (!refreshScheduler.enabled()) {
+        return;
+    }
+    refreshScheduler.recordRefresh(refreshed, changed, block);
+
+    Metrics &metrics = Metrics::instance();
+    metrics.counter("deds_pools_deferred_total", labels(), "Pool refreshes skipped by tiering")
+            .inc(pools.size() - std::min(refreshed.size(), pools.size()));
+    const std::array<size_t, 3> counts = refreshScheduler.tierCounts();
+    const std::array<const char *, 3> tierNames{"hot", "warm", "cold"};
+    for (size_t tier = 0; tier < counts.size(); tier++) {
+        metrics.gauge("deds_pools_by_tier", labels({{"tier", tierNames[tier]}}), "Pools per refresh tier")
+                .set(static_cast<double>(counts[tier]));
+    }
+}
+
+// Get block of the last completed cycle
+uint64_t ExchangeBase::stateBlock() const {
+    return lastStateBlock.load(std::memory_order_acquire);
+}
+
+// Count a failed update cycle
+void ExchangeBase::recordCycleError() const {
+    Metrics::instance().counter("deds_update_errors_total", labels(), "Failed updatePools cycles").inc();
+}
+
+// Register a change set callback
+size_t ExchangeBase::subscribe(ChangeCallback callback) {
+    std::lock_guard lock(subscribersMutex);
+    const size_t id = nextSubscriberId++;
+    subscribers.push_back(std::make_shared<Subscription>(Subscription{id, std::move(callback)}));
+    subscriberCount.store(subscribers.size(), std::memory_order_release);
+    return id;
+}
+
+// Register a queue as a subscriber
+size_t ExchangeBase::subscribe(std::shared_ptr<ChangeQueue> queue) {
+    Counter &dropped = Metrics::instance().counter("deds_changesets_dropped_total", labels(),
+                                                   "Change sets dropped because a subscriber queue was full");
+    return subscribe([queue = std::move(queue), &dropped](const ChangeSetPtr &changes) {
+        if (!queue->tryPush(changes)) {
+            dropped.inc();
+        }
+    });
+}
+
+// Subscription whose callback this thread is running, see unsubscribe
+static thread_local const void *deliveringTo = nullptr;
+
+// Remove a subscriber by id, then wait for the deliveries already handed to it
+void ExchangeBase::unsubscribe(const size_t id) {
+    std::unique_lock lock(subscribersMutex);
+    const auto it = std::ranges::find_if(subscribers, [id](const auto &subscriber) { return subscriber->id == id; });
+    if (it == subscribers.end()) {
+        return;
+    }
+    const std::shared_ptr<Subscription> removed = *it;
+    subscribers.erase(it);
+    subscriberCount.store(subscribers.size(), std::memory_order_release);
+
+    const size_t own = deliveringTo == removed.get() ? 1 : 0;
+    deliveriesDone.wait(lock, [&removed, own] { return removed->deliveries <= own; });
+}
+
+// Check for subscribers without locking
+bool ExchangeBase::hasSubscribers() const {
+    return subscriberCount.load(std::memory_order_acquire) > 0;
+}
+
+// Share one immutable change set between all subscribers, callbacks run outside the lock
+void ExchangeBase::publishChanges(ChangeSet changes) const {
+    if (changes.empty()) {
+        return;
+    }
+    Metrics::instance().counter("deds_pool_changes_total", labels(), "Pool values changed by update cycles")
+            .inc(changes.changes.size());
+
+    // Counted as in flight before the lock is released, an unsubscribe from here on waits for them
+    std::vector<std::shared_ptr<Subscription> > targets;
+    {
+        std::lock_guard lock(subscribersMutex);
+        targets = subscribers;
+        for (const auto &target: targets) {
+            target->deliveries++;
+        }
+    }
+
+    if (changes.timestamp == 0) {
+        changes.timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+    const auto shared = std::make_shared<const ChangeSet>(std::move(changes));
+    size_t next = 0;
+    const auto finish = [this](Subscription &target) {
+        std::lock_guard lock(subscribersMutex);
+        target.deliveries--;
+        deliveriesDone.notify_all();
+    };
+    try {
+        for (; next < targets.size(); next++) {
+            Subscription &target = *targets[next];
+            const void *outer = std::exchange(deliveringTo, &target);
+            try {
+                target.callback(shared);
+            } catch (...) {
+                deliveringTo = outer;
+                throw;
+            }
+            deliveringTo = outer;
+            finish(target);
+        }
+    } catch (...) {
+        // The throwing callback and the ones not reached are released too
+        for (; next < targets.size(); next++) finish(*targets[next]);
+        throw;
+    }
+}
@@ -1,41 +1,185 @@
 #ifndef EXCHANGE_BASE_H
 #define EXCHANGE_BASE_H
 
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <optional>
 #include <memory>
+#include <mutex>
 #include <nlohmann/json.hpp>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 
 
+#include "ChainConfig.h"
+#include "ChangeSet.h"
 #include "Pool.h"
+#include "RefreshScheduler.h"
+#include "SwapPool.h"
 #include "Token.h"
+#include "TokenRegistry.h"
+#include "../utils/Arena.h"
+#include "../utils/ConcurrencyBudget.h"
 #include "../utils/Web3Client.h"
 
 using string = std::string;
 template<typename T>
 using vector = std::vector<T>;
 
+// A log emitted by one of an exchange's pools, as eth_getLogs returns it; pool is its key in pools
+struct PoolLog {
+    std::string pool;
+    nlohmann::json log;
+};
+
 // Abstract base class for all exchange implementations
 class ExchangeBase {
 public:
-    ExchangeBase(std::shared_ptr<Web3Client> web3Client, std::string exchangeName);
+    ExchangeBase(std::shared_ptr<Web3Client> web3Client, std::string exchangeName, ChainConfig chainConfig = {});
 
     virtual ~ExchangeBase() = default;
 
-    // Abstract method for exchange-specific implementation
+    // Abstract method for exchange-specific implementation. Throws when the cycle fails, the last published
+    // state stays in place
     virtual void updatePools() =0;
 
-    void addToken(const string &address);
+    // Register a token once across all exchanges and return its id, safe to call concurrently
+    TokenId addToken(const string &address);
+
+    // Copy of a registered token, std::nullopt if unknown
+    static std::optional<Token> getToken(const string &address, const string &chain = "");
+
+    using ChangeCallback = std::function<void(const ChangeSetPtr &)>;
+
+    // Called on the updating thread after each cycle that changed anything, returns an id for unsubscribe
+    size_t subscribe(ChangeCallback callback);
+
+    // Push change sets into a bounded queue, a full queue drops the set and counts it
+    size_t subscribe(std::shared_ptr<ChangeQueue> queue);
+
+    // Returns once no delivery to the subscriber is running, so its owner can be destroyed right after. From
+    // inside the subscriber's own callback it only waits for deliveries on other threads
+    void unsubscribe(size_t id);
+
+    // Block the last published state is current at, 0 before the first cycle. With tiering, the oldest block any
+    // pool is known current at
+    [[nodiscard]] uint64_t stateBlock() const;
+
+    // Publish how many blocks the state trails head, called by whoever polls the head between cycles
+    void recordStaleness(uint64_t head) const;
+
+    // Share of the update pool for this exchange's subtasks, usually its chain's; unlimited when unset
+    void setBudget(std::shared_ptr<ConcurrencyBudget> concurrencyBudget);
+
+    // Pricing models of the pools in the current snapshot for the router, none unless the adapter supports it
+    [[nodiscard]] virtual std::vector<std::shared_ptr<const SwapPool> > swapPools() const { return {}; }
+
+    // Event signatures (topic0) whose logs applyLogs understands, none unless the adapter supports events
+    [[nodiscard]] virtual std::vector<std::string> eventTopics() const { return {}; }
+
+    // Apply pool logs, ordered by block and log index, to the current snapshot and publish the result as the
+    // state at block. Returns the logs that were applied
+    virtual size_t applyLogs(const std::vector<PoolLog> & /*logs*/, uint64_t /*block*/) { return 0; }
+
+    // Replace the state with an RPC read at block, the block the replaced state is valid at, and return the values
+    // where they differ and both states know them. Adapters that cannot read at a given block re-read at the head
+    // and return std::nullopt
+    virtual std::optional<std::vector<PoolChange> > reconcile(uint64_t /*block*/) {
+        updatePools();
+        return std::nullopt;
+    }
+
+    // Publish an empty state at block 0, the starting point of a replay from the pools' creation
+    virtual void clearState() {}
 
     std::string name;
-    static std::unordered_map<std::string, Token> tokens;
-    std::unordered_map<std::string, std::unique_ptr<Pool> > pools;
+    ChainConfig chain;
+    // Pools by address, owned by poolArena
+    std::unordered_map<std::string, Pool *> pools;
+
+    // Which pools each cycle refreshes, starts with the chain's policy
+    RefreshScheduler refreshScheduler;
+
+    // Pools per eth_getLogs address filter, for the scan of the pools tiering skips and adapter log scans
+    size_t logPoolsPerCall = 1000;
 
 protected:
     std::shared_ptr<Web3Client> web3;
+    Arena<Pool> poolArena;
+    Arena<Contract> contractArena;
 
     static std::optional<int> getLocalIndex(const Token &token, const Pool &pool);
+
+    // Exchange label, with the chain when set
+    [[nodiscard]] MetricLabels labels(MetricLabels extra = {}) const;
+
+    // Run a subtask of the update cycle on the current pool within the budget, inline outside a pool
+    template<typename F>
+    auto submitTask(F &&task) -> std::future<std::invoke_result_t<std::decay_t<F> > > {
+        ThreadPool *pool = ThreadPool::current();
+        if (!pool) return ConcurrencyBudget::runInline(std::forward<F>(task));
+        if (budget) return budget->submit(*pool, std::forward<F>(task));
+        return pool->submit(std::forward<F>(task));
+    }
+
+    // Duration histogram for one stage of this exchange's update cycle
+    Histogram &stageHistogram(const std::string &stage) const;
+
+    // Record the outcome of a completed update cycle
+    void recordCycle(size_t poolsRefreshed, uint64_t stateBlock) const;
+
+    void recordCycleError() const;
+
+    // Pools the scheduler wants refreshed at this block, every pool without tiering. With tiering, the skipped
+    // pools' eventTopics logs since they were last known current are fetched first, and the pools they name are
+    // touched and refreshed this cycle too
+    [[nodiscard]] std::vector<std::string> poolsDue(uint64_t block);
+
+    // Record pools read at block and return the block the state as a whole is current at, the oldest of any pool
+    uint64_t recordReads(const std::vector<std::string> &read, uint64_t block);
+
+    // Same with every pool read at block
+    uint64_t recordReads(uint64_t block);
+
+    // Feed a cycle's refreshed and changed pools back to the scheduler and publish the tier sizes
+    void recordRefresh(const std::vector<std::string> &refreshed, const std::unordered_set<std::string> &changed,
+                       uint64_t block);
+
+    // Adapters skip diffing entirely while nobody listens
+    [[nodiscard]] bool hasSubscribers() const;
+
+    // Deliver a non-empty change set to every subscriber
+    void publishChanges(ChangeSet changes) const;
+
+private:
+    struct Subscription {
+        size_t id;
+        ChangeCallback callback;
+        // Deliveries started and not finished, under subscribersMutex
+        size_t deliveries = 0;
+    };
+
+    mutable std::mutex subscribersMutex;
+    mutable std::condition_variable deliveriesDone;
+    std::vector<std::shared_ptr<Subscription> > subscribers;
+    size_t nextSubscriberId = 1;
+    std::atomic<size_t> subscriberCount{0};
+    std::shared_ptr<ConcurrencyBudget> budget;
+
+    // Touch the skipped pools with logs since the oldest of their current blocks, the others are current at block
+    void scanSkippedPools(const std::vector<std::string> &skipped, uint64_t block);
+    mutable std::atomic<uint64_t> lastStateBlock{0};
+    // Block each pool is known current at: its last read, or a later scan that found no logs for it. Pools without
+    // an entry are current at baselineBlock, the last block every pool was, where 0 is never
+    std::unordered_map<std::string, uint64_t> currentBlocks;
+    uint64_t baselineBlock = 0;
+
+    // 0 while the pool was never read
+    [[nodiscard]] uint64_t currentBlock(const std::string &address) const;
+    // Set from cycles and from head polls
+    Gauge &staleness;
 };
 
 #endif // EXCHANGE_BASE_H
@@ -0,0 +1,46 @@
+#ifndef MID_PRICE_H
+#define MID_PRICE_H
+
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#include "ChangeSet.h"
+#include "Pool.h"
+
+// Mid-price math and the seqlock writer shared by PriceTable and SharedStatePublisher, so the in-process table
+// and the shared-memory records always agree on a pool's price
+namespace midprice {
+    // 10^(decimals0 - decimals1), turns a raw token1/token0 ratio into whole tokens; 1 for a pool without two tokens
+    inline double decimalsAdjust(const Pool &pool) {
+        if (pool.tokenCount() < 2) return 1;
+        return std::pow(10.0, pool.token(0).decimals - pool.token(1).decimals);
+    }
+
+    // Raw token1/token0 ratio of a Reserves or SqrtPrice change, NaN when a side is empty
+    inline double ratioOf(const PoolChange &change) {
+        static const double Q96 = std::ldexp(1.0, 96);
+        if (change.kind == PoolChange::Kind::Reserves) {
+            return change.after[0] > 0 && change.after[1] > 0
+                       ? change.after[1].get_d() / change.after[0].get_d()
+                       : std::numeric_limits<double>::quiet_NaN();
+        }
+        if (change.after[0] <= 0) return std::numeric_limits<double>::quiet_NaN();
+        const double sqrtPrice = change.after[0].get_d() / Q96;
+        return sqrtPrice * sqrtPrice;
+    }
+
+    // Seqlock write: odd sequence while the stores run, readers retry until it is even and unchanged.
+    // The stores must be relaxed atomic stores; one writer at a time
+    template<typename Stores>
+    void seqlockWrite(std::atomic<uint32_t> &sequence, Stores &&stores) {
+        const uint32_t current = sequence.load(std::memory_order_relaxed);
+        sequence.store(current + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        stores();
+        sequence.store(current + 2, std::memory_order_release);
+    }
+}
+
+#endif //MID_PRICE_H
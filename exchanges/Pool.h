@@ -1,21 +1,35 @@
 #ifndef POOL_H
 #define POOL_H
 
+#include <array>
 #include <string>
-#include <vector>
-#include <memory>
 #include <gmpxx.h>
 #include "../utils/Contract.h"
-#include "Token.h"
+#include "TokenRegistry.h"
 
 // Pool structure containing tokens, contract, and exchange information
+// Pools and their contracts live in the owning exchange's arenas, tokens are ids into the TokenRegistry
 struct Pool {
     std::string address;
     std::string exchange;
     mpf_class fee;
 
-    std::vector<std::unique_ptr<Token> > tokens;
-    std::unique_ptr<Contract> poolContract;
+    std::array<TokenId, 2> tokens{NoToken, NoToken};
+    Contract *poolContract = nullptr;
+
+    // Shared record of the i-th token
+    [[nodiscard]] const Token &token(const size_t i) const {
+        return TokenRegistry::instance().get(tokens[i]);
+    }
+
+    // Number of tokens set
+    [[nodiscard]] size_t tokenCount() const {
+        size_t count = 0;
+        for (const TokenId id: tokens) {
+            if (id != NoToken) count++;
+        }
+        return count;
+    }
 };
 
 #endif
@@ -0,0 +1,116 @@
+#include "PriceTable.h"
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+#include "MidPrice.h"
+
+// Constructor: Index pools and precompute decimal scale factors once
+PriceTable::PriceTable(const ExchangeBase &exchange)
+    : slots{std::make_unique<Slot[]>(exchange.pools.size())} {
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    for (const auto &[address, pool]: exchange.pools) {
+        const size_t index = poolAddresses.size();
+        poolAddresses.push_back(address);
+        poolIndex.emplace(address, index);
+
+        Slot &slot = slots[index];
+        slot.decimalsAdjust = midprice::decimalsAdjust(*pool);
+        for (int direction = 0; direction < 2; direction++) {
+            slot.price[direction].store(nan, std::memory_order_relaxed);
+            slot.logPrice[direction].store(nan, std::memory_order_relaxed);
+        }
+    }
+}
+
+// Destructor: Stop receiving change sets
+PriceTable::~PriceTable() {
+    for (const auto &[exchange, id]: subscriptions) {
+        exchange->unsubscribe(id);
+    }
+}
+
+// Write both directions of a slot in one seqlock write
+void PriceTable::write(Slot &slot, const double price, const uint64_t block) {
+    const double logPrice = std::log(price);
+    midprice::seqlockWrite(slot.sequence, [&] {
+        slot.price[0].store(price, std::memory_order_relaxed);
+        slot.price[1].store(1.0 / price, std::memory_order_relaxed);
+        slot.logPrice[0].store(logPrice, std::memory_order_relaxed);
+        slot.logPrice[1].store(-logPrice, std::memory_order_relaxed);
+        slot.block.store(block, std::memory_order_relaxed);
+    });
+}
+
+// Recompute only the pools named in the changes
+void PriceTable::apply(const std::vector<PoolChange> &changes, const uint64_t block) {
+    std::lock_guard lock(writeMutex);
+    size_t count = 0;
+
+    for (const PoolChange &change: changes) {
+        if (change.kind != PoolChange::Kind::Reserves && change.kind != PoolChange::Kind::SqrtPrice) continue;
+
+        const auto it = poolIndex.find(change.pool);
+        if (it == poolIndex.end()) continue;
+        Slot &slot = slots[it->second];
+        if (block < slot.block.load(std::memory_order_relaxed)) continue;
+
+        write(slot, midprice::ratioOf(change) * slot.decimalsAdjust, block);
+        count++;
+    }
+    touched.store(count, std::memory_order_relaxed);
+}
+
+// Apply a change set at its block
+void PriceTable::apply(const ChangeSet &changes) {
+    apply(changes.changes, changes.block);
+}
+
+// Look up a pool's slot
+std::optional<size_t> PriceTable::indexOf(const std::string &pool) const {
+    if (const auto it = poolIndex.find(pool); it != poolIndex.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+// Seqlock read: retry while a write is in progress or happened during the read
+PriceQuote PriceTable::quote(const size_t index, const int direction) const {
+    if (index >= poolAddresses.size() || (direction != 0 && direction != 1)) {
+        throw std::out_of_range{"PriceTable: no slot " + std::to_string(index) + "/" + std::to_string(direction)};
+    }
+    const Slot &slot = slots[index];
+    PriceQuote quote;
+    uint32_t before;
+    uint32_t after;
+    do {
+        before = slot.sequence.load(std::memory_order_acquire);
+        quote.price = slot.price[direction].load(std::memory_order_relaxed);
+        quote.logPrice = slot.logPrice[direction].load(std::memory_order_relaxed);
+        quote.block = slot.block.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = slot.sequence.load(std::memory_order_relaxed);
+    } while (before != after || (before & 1) != 0);
+    return quote;
+}
+
+// Price only
+double PriceTable::price(const size_t index, const int direction) const {
+    return quote(index, direction).price;
+}
+
+// Number of pools
+size_t PriceTable::size() const {
+    return poolAddresses.size();
+}
+
+// Pool address of a slot
+const std::string &PriceTable::poolAt(const size_t index) const {
+    return poolAddresses.at(index);
+}
+
+// Pools recomputed by the last apply
+size_t PriceTable::lastTouched() const {
+    return touched.load(std::memory_order_relaxed);
+}
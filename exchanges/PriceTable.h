@@ -0,0 +1,89 @@
+#ifndef PRICE_TABLE_H
+#define PRICE_TABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "ChangeSet.h"
+#include "ExchangeBase.h"
+
+// Decimal-adjusted mid price of one pool in one direction
+struct PriceQuote {
+    double price = 0;
+    double logPrice = 0;
+    uint64_t block = 0;
+};
+
+// Flat per-exchange table of mid prices for every pool in both directions
+// Direction 0 is token1 per token0, direction 1 its inverse. Fed incrementally by change sets:
+// only pools touched by a cycle are recomputed. Each slot is a seqlock, so lookups from any thread
+// are O(1), allocation-free and never see a half-written slot
+class PriceTable {
+public:
+    // One slot per pool of the exchange, scale factors from the pools' token decimals
+    explicit PriceTable(const ExchangeBase &exchange);
+
+    // Unsubscribes from every attached exchange
+    ~PriceTable();
+
+    PriceTable(const PriceTable &) = delete;
+
+    PriceTable &operator=(const PriceTable &) = delete;
+
+    // Recompute pools touched by the changes, older than the slot's block are ignored
+    void apply(const std::vector<PoolChange> &changes, uint64_t block);
+
+    void apply(const ChangeSet &changes);
+
+    // Follow the exchange's change sets, seeded from its current snapshot
+    // Subscribing first means a cycle racing the seed is never lost, the block check drops the older one
+    template<typename Exchange>
+    void attach(Exchange &exchange) {
+        const size_t id = exchange.subscribe([this](const ChangeSetPtr &changes) { apply(*changes); });
+        subscriptions.emplace_back(&exchange, id);
+        const auto current = exchange.snapshot();
+        apply(Exchange::diffStates({}, *current), current.block());
+    }
+
+    [[nodiscard]] std::optional<size_t> indexOf(const std::string &pool) const;
+
+    // Consistent read of one slot; price is NaN until the pool has been priced or if a side is empty
+    [[nodiscard]] PriceQuote quote(size_t index, int direction = 0) const;
+
+    [[nodiscard]] double price(size_t index, int direction = 0) const;
+
+    [[nodiscard]] size_t size() const;
+
+    [[nodiscard]] const std::string &poolAt(size_t index) const;
+
+    // Pools recomputed by the last apply
+    [[nodiscard]] size_t lastTouched() const;
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint32_t> sequence{0};
+        std::atomic<double> price[2];
+        std::atomic<double> logPrice[2];
+        std::atomic<uint64_t> block{0};
+        // 10^(decimals0 - decimals1), fixed at construction
+        double decimalsAdjust = 1;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    std::vector<std::string> poolAddresses;
+    std::unordered_map<std::string, size_t> poolIndex;
+    std::atomic<size_t> touched{0};
+    std::vector<std::pair<ExchangeBase *, size_t> > subscriptions;
+    // Serializes writers (cycle callbacks and seeding), readers never take it
+    std::mutex writeMutex;
+
+    void write(Slot &slot, double price, uint64_t block);
+};
+
+#endif //PRICE_TABLE_H
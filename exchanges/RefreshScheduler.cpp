@@ -0,0 +1,108 @@
+#include "RefreshScheduler.h"
+
+#include <algorithm>
+#include <functional>
+#include <ranges>
+
+// Constructor: Store the policy, pools are tracked from their first refresh
+RefreshScheduler::RefreshScheduler(const TierPolicy policy) : tierPolicy{policy} {
+}
+
+// Select the pools due at this block
+std::vector<std::string> RefreshScheduler::due(const std::vector<std::string> &pools, const uint64_t block) {
+    std::lock_guard lock(mutex);
+    if (!tierPolicy.enabled) {
+        return pools;
+    }
+
+    std::vector<std::string> selected;
+    for (const std::string &pool: pools) {
+        const auto it = entries.find(pool);
+        if (it == entries.end() || it->second.touched || it->second.tier == RefreshTier::Hot ||
+            block >= it->second.nextDue) {
+            selected.push_back(pool);
+        }
+    }
+    return selected;
+}
+
+// Re-tier refreshed pools from their last change and schedule their next refresh
+void RefreshScheduler::recordRefresh(const std::vector<std::string> &refreshed,
+                                     const std::unordered_set<std::string> &changed, const uint64_t block) {
+    std::lock_guard lock(mutex);
+    if (!tierPolicy.enabled) {
+        return;
+    }
+
+    for (const std::string &pool: refreshed) {
+        const auto [it, inserted] = entries.try_emplace(pool);
+        Entry &entry = it->second;
+        entry.touched = false;
+        // The first read counts as a change, new pools start hot
+        if (inserted || changed.contains(pool)) {
+            entry.lastChange = block;
+        }
+
+        const uint64_t age = block - std::min(entry.lastChange, block);
+        const RefreshTier tier = age < tierPolicy.hotBlocks ? RefreshTier::Hot
+                                 : age < tierPolicy.warmBlocks ? RefreshTier::Warm
+                                 : RefreshTier::Cold;
+        const uint64_t interval = tier == RefreshTier::Warm ? tierPolicy.warmInterval : tierPolicy.coldInterval;
+        if (tier == RefreshTier::Hot) {
+            entry.nextDue = 0;
+        } else if (interval == 0) {
+            entry.nextDue = 0;
+        } else if (tier != entry.tier) {
+            // Entering the tier: a per-pool phase within the interval spreads the tier's refreshes over blocks
+            entry.nextDue = block + 1 + std::hash<std::string>{}(pool) % interval;
+        } else {
+            entry.nextDue = block + interval;
+        }
+        entry.tier = tier;
+    }
+}
+
+// Flag pools for the next cycle
+void RefreshScheduler::touch(const std::vector<std::string> &pools) {
+    std::lock_guard lock(mutex);
+    for (const std::string &pool: pools) {
+        if (const auto it = entries.find(pool); it != entries.end()) {
+            it->second.touched = true;
+        }
+    }
+}
+
+// Get a pool's current tier
+RefreshTier RefreshScheduler::tier(const std::string &pool) const {
+    std::lock_guard lock(mutex);
+    const auto it = entries.find(pool);
+    return it == entries.end() ? RefreshTier::Hot : it->second.tier;
+}
+
+// Count tracked pools per tier
+std::array<size_t, 3> RefreshScheduler::tierCounts() const {
+    std::lock_guard lock(mutex);
+    std::array<size_t, 3> counts{};
+    for (const Entry &entry: entries | std::views::values) {
+        counts[static_cast<size_t>(entry.tier)]++;
+    }
+    return counts;
+}
+
+// Get the tiering settings
+TierPolicy RefreshScheduler::policy() const {
+    std::lock_guard lock(mutex);
+    return tierPolicy;
+}
+
+// Replace the tiering settings
+void RefreshScheduler::setPolicy(const TierPolicy policy) {
+    std::lock_guard lock(mutex);
+    tierPolicy = policy;
+}
+
+// Check whether pools are tiered at all
+bool RefreshScheduler::enabled() const {
+    std::lock_guard lock(mutex);
+    return tierPolicy.enabled;
+}
@@ -0,0 +1,85 @@
+#ifndef REFRESH_SCHEDULER_H
+#define REFRESH_SCHEDULER_H
+
+#include <array>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+// How often a pool is refreshed, from how recently its state last changed
+enum class RefreshTier { Hot, Warm, Cold };
+
+// Tiering settings. Disabled, every pool is refreshed every cycle
+struct TierPolicy {
+    bool enabled = false;
+    // A pool that changed within the last hotBlocks blocks is hot, within warmBlocks warm, otherwise cold
+    uint64_t hotBlocks = 10;
+    uint64_t warmBlocks = 1000;
+    // Blocks between refreshes of warm and cold pools, hot pools refresh every cycle. 0 refreshes the tier every
+    // cycle too; a touched pool is refreshed in the next cycle whatever its tier
+    uint64_t warmInterval = 5;
+    uint64_t coldInterval = 100;
+
+    // An object enables tiering, missing fields keep their defaults
+    static TierPolicy fromJson(const nlohmann::json &config) {
+        TierPolicy policy;
+        policy.enabled = config.value("enabled", true);
+        policy.hotBlocks = config.value("hotBlocks", policy.hotBlocks);
+        policy.warmBlocks = config.value("warmBlocks", policy.warmBlocks);
+        policy.warmInterval = config.value("warmInterval", policy.warmInterval);
+        policy.coldInterval = config.value("coldInterval", policy.coldInterval);
+        return policy;
+    }
+};
+
+// Picks the pools an update cycle refreshes. New pools start hot; every refresh re-tiers a pool from the
+// block of its last observed change, so a cold pool that moves is hot again after its next refresh.
+// Warm and cold refreshes are staggered by address so they don't all land on the same block
+class RefreshScheduler {
+public:
+    explicit RefreshScheduler(TierPolicy policy = {});
+
+    // Pools to refresh at this block: new, hot, touched, and warm or cold ones whose interval has passed.
+    // All of them, in order, when tiering is disabled
+    std::vector<std::string> due(const std::vector<std::string> &pools, uint64_t block);
+
+    // Record a completed refresh and which of the refreshed pools changed
+    void recordRefresh(const std::vector<std::string> &refreshed, const std::unordered_set<std::string> &changed,
+                       uint64_t block);
+
+    // Refresh these pools in the next cycle whatever their tier. Called with the pools named by logs, from the
+    // scan of skipped pools in ExchangeBase::poolsDue, the UniswapV3 liquidity event scan and the EventEngine
+    void touch(const std::vector<std::string> &pools);
+
+    // Hot for pools never refreshed
+    [[nodiscard]] RefreshTier tier(const std::string &pool) const;
+
+    // Pools per tier, indexed by RefreshTier
+    [[nodiscard]] std::array<size_t, 3> tierCounts() const;
+
+    [[nodiscard]] TierPolicy policy() const;
+
+    // Takes effect from each pool's next refresh
+    void setPolicy(TierPolicy tierPolicy);
+
+    [[nodiscard]] bool enabled() const;
+
+private:
+    struct Entry {
+        RefreshTier tier = RefreshTier::Hot;
+        uint64_t lastChange = 0;
+        // First block the pool is due again, unused while hot
+        uint64_t nextDue = 0;
+        bool touched = false;
+    };
+
+    mutable std::mutex mutex;
+    TierPolicy tierPolicy;
+    std::unordered_map<std::string, Entry> entries;
+};
+
+#endif //REFRESH_SCHEDULER_H
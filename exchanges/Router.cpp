@@ -0,0 +1,238 @@
+#include "Router.h"
+
+#include <algorithm>
+#include <future>
+#include <numeric>
+#include <ranges>
+
+// Constructor: Start with an empty graph
+Router::Router(const RouterOptions routerOptions) : options{routerOptions} {
+    graph.publish({}, 0);
+}
+
+// Collect every exchange's models into one graph
+void Router::rebuild(const std::vector<ExchangeBase *> &exchanges) {
+    std::vector<std::shared_ptr<const SwapPool> > pools;
+    for (const ExchangeBase *exchange: exchanges) {
+        std::ranges::move(exchange->swapPools(), std::back_inserter(pools));
+    }
+    build(std::move(pools));
+}
+
+// Index tokens densely and add an edge per pool and direction
+void Router::build(std::vector<std::shared_ptr<const SwapPool> > pools) {
+    Graph next;
+    uint64_t block = 0;
+    const auto indexOf = [&next](const TokenId token) {
+        const auto [it, inserted] = next.tokenIndex.try_emplace(token, static_cast<uint32_t>(next.edges.size()));
+        if (inserted) next.edges.emplace_back();
+        return it->second;
+    };
+
+    for (auto &pool: pools) {
+        if (!pool || pool->tokens[0] == NoToken || pool->tokens[1] == NoToken || pool->tokens[0] == pool->tokens[1]) {
+            continue;
+        }
+        const auto index = static_cast<uint32_t>(next.pools.size());
+        const uint32_t token0 = indexOf(pool->tokens[0]);
+        const uint32_t token1 = indexOf(pool->tokens[1]);
+        next.edges[token0].push_back({index, token1, true, pool->spotRate(true)});
+        next.edges[token1].push_back({index, token0, false, pool->spotRate(false)});
+        block = std::max(block, pool->block);
+        next.pools.push_back(std::move(pool));
+    }
+    graph.publish(std::move(next), block);
+}
+
+// Count the pools in the current graph
+size_t Router::poolCount() const {
+    return graph.read()->pools.size();
+}
+
+// Swap through each hop in turn
+double Router::pathOutput(const Graph &current, const std::vector<Edge> &edges, double amountIn) {
+    for (const Edge &edge: edges) {
+        amountIn = current.pools[edge.pool]->amountOut(amountIn, edge.zeroForOne);
+    }
+    return amountIn;
+}
+
+// Depth-first over simple paths, keeping the best candidatePaths that reach the output token
+std::vector<Router::Path> Router::search(const Graph &current, const Query &query,
+                                         const std::span<const Edge> firstEdges, size_t &evaluated) const {
+    const size_t tokens = current.edges.size();
+    std::vector<Path> best;
+    std::vector<Edge> stack;
+    std::vector<char> visited(tokens, 0);
+    visited[query.from] = 1;
+    // Output of the worst kept path once candidatePaths are kept, a branch must beat it
+    double threshold = 0;
+
+    const auto keep = [&](const double amountOut) {
+        if (best.size() < options.candidatePaths) {
+            best.push_back({stack, amountOut});
+        } else if (const auto worst = std::ranges::min_element(best, {}, &Path::amountOut);
+            amountOut > worst->amountOut) {
+            *worst = {stack, amountOut};
+        }
+        if (best.size() == options.candidatePaths) {
+            threshold = std::ranges::min(best, {}, &Path::amountOut).amountOut;
+        }
+    };
+
+    const auto visit = [&](auto &self, const std::span<const Edge> edges, const double amount) -> void {
+        const size_t hopsLeft = options.maxHops - stack.size() - 1;
+        for (const Edge &edge: edges) {
+            if (visited[edge.to]) continue;
+            const double bound = amount * edge.rate * query.reach[hopsLeft * tokens + edge.to];
+            if (bound <= threshold) continue;
+            const double out = current.pools[edge.pool]->amountOut(amount, edge.zeroForOne);
+            if (out <= threshold) continue;
+            stack.push_back(edge);
+            if (edge.to == query.to) {
+                evaluated++;
+                keep(out);
+            } else {
+                // Only edges into the output are left for the last hop, skip scanning the whole adjacency
+                const std::span<const Edge> finals(query.finalEdges.data() + query.finalBegin[edge.to],
+                                                   query.finalEdges.data() + query.finalBegin[edge.to + 1]);
+                const auto next = hopsLeft == 1 ? finals : std::span<const Edge>(current.edges[edge.to]);
+                visited[edge.to] = 1;
+                self(self, next, out);
+                visited[edge.to] = 0;
+            }
+            stack.pop_back();
+        }
+    };
+    if (options.maxHops > 0 && options.candidatePaths > 0) {
+        visit(visit, firstEdges, query.amountIn);
+    }
+    return best;
+}
+
+// Search the paths, keep pool-disjoint ones and allocate the amount between them
+RouteQuote Router::quote(const TokenId tokenIn, const TokenId tokenOut, const double amountIn) const {
+    const auto current = graph.read();
+    RouteQuote result;
+    result.amountIn = amountIn;
+    result.block = current.block();
+
+    const auto fromIt = current->tokenIndex.find(tokenIn);
+    const auto toIt = current->tokenIndex.find(tokenOut);
+    if (fromIt == current->tokenIndex.end() || toIt == current->tokenIndex.end() || tokenIn == tokenOut ||
+        amountIn <= 0) {
+        return result;
+    }
+    Query query{fromIt->second, toIt->second, amountIn};
+    const size_t tokens = current->edges.size();
+
+    // Spot rate products into the output, relaxed one hop at a time
+    query.reach.assign(std::max<size_t>(options.maxHops, 1) * tokens, 0);
+    query.reach[query.to] = 1;
+    for (size_t hops = 1; hops < options.maxHops; hops++) {
+        const double *previous = &query.reach[(hops - 1) * tokens];
+        double *reach = &query.reach[hops * tokens];
+        for (size_t token = 0; token < tokens; token++) {
+            double best = previous[token];
+            for (const Edge &edge: current->edges[token]) {
+                best = std::max(best, edge.rate * previous[edge.to]);
+            }
+            reach[token] = best;
+        }
+    }
+
+    // The output's edges reversed and bucketed by their other token
+    const std::vector<Edge> &intoOutput = current->edges[query.to];
+    query.finalBegin.assign(tokens + 1, 0);
+    for (const Edge &edge: intoOutput) query.finalBegin[edge.to + 1]++;
+    for (size_t token = 0; token < tokens; token++) query.finalBegin[token + 1] += query.finalBegin[token];
+    query.finalEdges.resize(intoOutput.size());
+    std::vector<uint32_t> fill(query.finalBegin.begin(), query.finalBegin.end() - 1);
+    for (const Edge &edge: intoOutput) {
+        query.finalEdges[fill[edge.to]++] = {
+            edge.pool, query.to, !edge.zeroForOne, current->pools[edge.pool]->spotRate(!edge.zeroForOne)
+        };
+    }
+
+    // Deal the first hops round-robin over the pool's threads, the caller searches the first share itself
+    const std::vector<Edge> &firstEdges = current->edges[query.from];
+    const size_t threads = options.threadPool ? options.threadPool->size() : 1;
+    const size_t shares = std::max<size_t>(std::min(threads, firstEdges.size()), 1);
+    std::vector<std::vector<Edge> > shareEdges(shares);
+    for (size_t i = 0; i < firstEdges.size(); i++) {
+        shareEdges[i % shares].push_back(firstEdges[i]);
+    }
+    std::vector<size_t> evaluated(shares, 0);
+    std::vector<std::future<std::vector<Path> > > futures;
+    for (size_t share = 1; share < shares; share++) {
+        futures.push_back(options.threadPool->submit([&, share] {
+            return search(*current, query, shareEdges[share], evaluated[share]);
+        }));
+    }
+    std::vector<Path> candidates = search(*current, query, shareEdges[0], evaluated[0]);
+    for (auto &future: futures) {
+        std::ranges::move(options.threadPool->await(future), std::back_inserter(candidates));
+    }
+    for (const size_t count: evaluated) {
+        result.pathsEvaluated += count;
+    }
+    if (candidates.empty()) {
+        return result;
+    }
+    // Each share kept its own best, the overall best are the same as a single search's
+    std::ranges::sort(candidates, std::greater{}, &Path::amountOut);
+    candidates.resize(std::min(candidates.size(), options.candidatePaths));
+
+    // Greedy pool-disjoint selection from the best down, so every split prices independently
+    std::vector<const Path *> selected;
+    std::vector<char> used(current->pools.size(), 0);
+    for (const Path &path: candidates) {
+        if (selected.size() >= std::max<size_t>(options.maxSplits, 1)) break;
+        if (std::ranges::any_of(path.edges, [&used](const Edge &edge) { return used[edge.pool] != 0; })) continue;
+        for (const Edge &edge: path.edges) used[edge.pool] = 1;
+        selected.push_back(&path);
+    }
+
+    // Outputs are concave in the input, so stepping the best marginal path is optimal at this granularity
+    const size_t steps = std::max<size_t>(options.splitSteps, 1);
+    const double step = amountIn / static_cast<double>(steps);
+    std::vector<double> allocated(selected.size(), 0);
+    std::vector<double> output(selected.size(), 0);
+    std::vector<double> nextOutput(selected.size());
+    for (size_t i = 0; i < selected.size(); i++) {
+        nextOutput[i] = pathOutput(*current, selected[i]->edges, step);
+    }
+    for (size_t s = 0; s < steps; s++) {
+        size_t bestPath = 0;
+        for (size_t i = 1; i < selected.size(); i++) {
+            if (nextOutput[i] - output[i] > nextOutput[bestPath] - output[bestPath]) bestPath = i;
+        }
+        allocated[bestPath] += step;
+        output[bestPath] = pathOutput(*current, selected[bestPath]->edges, allocated[bestPath]);
+        nextOutput[bestPath] = pathOutput(*current, selected[bestPath]->edges, allocated[bestPath] + step);
+    }
+
+    // Never worse than sending everything down the best single path
+    const double total = std::accumulate(output.begin(), output.end(), 0.0);
+    if (total < candidates.front().amountOut) {
+        std::ranges::fill(allocated, 0.0);
+        allocated[0] = amountIn;
+        std::ranges::fill(output, 0.0);
+        output[0] = candidates.front().amountOut;
+    }
+
+    for (size_t i = 0; i < selected.size(); i++) {
+        if (allocated[i] <= 0) continue;
+        RouteSplit split;
+        split.amountIn = allocated[i];
+        split.amountOut = output[i];
+        for (const Edge &edge: selected[i]->edges) {
+            const SwapPool &pool = *current->pools[edge.pool];
+            split.hops.push_back({current->pools[edge.pool], edge.zeroForOne, pool.tokens[edge.zeroForOne ? 0 : 1],
+                                  pool.tokens[edge.zeroForOne ? 1 : 0]});
+        }
+        result.amountOut += split.amountOut;
+        result.splits.push_back(std::move(split));
+    }
+    return result;
+}
@@ -0,0 +1,121 @@
+#ifndef ROUTER_H
+#define ROUTER_H
+
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+#include "ExchangeBase.h"
+#include "SwapPool.h"
+#include "../utils/Snapshot.h"
+#include "../utils/ThreadPool.h"
+
+// Search and split settings
+struct RouterOptions {
+    // Longest path considered, in pools
+    size_t maxHops = 3;
+    // Best full-amount paths kept as split candidates
+    size_t candidatePaths = 16;
+    // Paths one trade is spread over; they never share a pool, so their outputs are independent
+    size_t maxSplits = 4;
+    // Increments the amount is allocated in, each to the path with the best marginal output
+    size_t splitSteps = 20;
+    // Pool the first hops are fanned out over; searched on the calling thread when unset
+    ThreadPool *threadPool = nullptr;
+};
+
+// One swap of a route
+struct RouteHop {
+    std::shared_ptr<const SwapPool> pool;
+    bool zeroForOne = true;
+    TokenId tokenIn = NoToken;
+    TokenId tokenOut = NoToken;
+};
+
+// Part of the trade sent down one path
+struct RouteSplit {
+    std::vector<RouteHop> hops;
+    double amountIn = 0;
+    double amountOut = 0;
+};
+
+// Best found execution of a trade, amountOut 0 and no splits when the tokens are not connected
+struct RouteQuote {
+    double amountIn = 0;
+    double amountOut = 0;
+    std::vector<RouteSplit> splits;
+    // Paths priced during the search
+    size_t pathsEvaluated = 0;
+    // Newest snapshot block among the graph's pools
+    uint64_t block = 0;
+};
+
+// Multi-hop, split-route optimizer over the pricing models of every attached exchange.
+// A depth-first search from the input token carries the running amount along each path, so shared prefixes are
+// priced once; it is branch and bound on spot rates, exact since every pool's output is concave.
+// The best paths are then filtered to pool-disjoint ones and the trade is split between them greedily.
+// Queries read an immutable graph snapshot and may run concurrently with each other and with rebuild
+class Router {
+public:
+    explicit Router(RouterOptions routerOptions = {});
+
+    // Rebuild the graph from the exchanges' current snapshots
+    void rebuild(const std::vector<ExchangeBase *> &exchanges);
+
+    // Replace the graph with these pools
+    void build(std::vector<std::shared_ptr<const SwapPool> > pools);
+
+    // Best split route for an exact input amount in raw units
+    [[nodiscard]] RouteQuote quote(TokenId tokenIn, TokenId tokenOut, double amountIn) const;
+
+    [[nodiscard]] size_t poolCount() const;
+
+    RouterOptions options;
+
+private:
+    struct Edge {
+        uint32_t pool;
+        uint32_t to;
+        bool zeroForOne;
+        // The pool's spotRate in this direction
+        double rate;
+    };
+
+    // Pools with dense token indices and an adjacency list in both swap directions
+    struct Graph {
+        std::vector<std::shared_ptr<const SwapPool> > pools;
+        std::unordered_map<TokenId, uint32_t> tokenIndex;
+        std::vector<std::vector<Edge> > edges;
+    };
+
+    struct Path {
+        std::vector<Edge> edges;
+        double amountOut = 0;
+    };
+
+    // Per-query search state shared by every share of the first hops
+    struct Query {
+        uint32_t from = 0;
+        uint32_t to = 0;
+        double amountIn = 0;
+        // Best product of spot rates from each token to the output within h hops at [h * tokens + token],
+        // 0 when unreachable. Bounds the output of any continuation, so the search skips branches that
+        // cannot beat the worst path it keeps
+        std::vector<double> reach;
+        // Edges into the output grouped by source token, token t's at [finalBegin[t], finalBegin[t + 1])
+        std::vector<Edge> finalEdges;
+        std::vector<uint32_t> finalBegin;
+    };
+
+    SnapshotCell<Graph> graph;
+
+    // Best paths whose first hop is one of firstEdges, by output for the full amount
+    std::vector<Path> search(const Graph &current, const Query &query, std::span<const Edge> firstEdges,
+                             size_t &evaluated) const;
+
+    static double pathOutput(const Graph &current, const std::vector<Edge> &edges, double amountIn);
+};
+
+#endif //ROUTER_H
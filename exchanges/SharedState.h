@@ -0,0 +1,89 @@
+#ifndef SHARED_STATE_H
+#define SHARED_STATE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Fixed layout of the POSIX shared-memory segment SharedStatePublisher writes and SharedStateReader maps
+// (see README "Shared-Memory State"). Native byte order, for processes on the same host:
+//   header:    magic, layout, pool and exchange counts, liveness, then one entry per exchange
+//   directory: one PoolEntry per pool, written before the magic and never changed afterwards
+//   records:   one 64-byte aligned PoolRecord per pool, in directory order, each guarded by its own seqlock
+// Every mutable field is a lock-free atomic, so readers in other processes never see torn words; the sequence
+// tells them whether the words they read belong to the same write
+namespace sharedstate {
+    // "DEDSSHM1", stored last by the publisher so a reader never maps a half-initialized segment
+    constexpr uint64_t Magic = 0x314d485353444544;
+    constexpr uint32_t LayoutVersion = 1;
+    constexpr size_t MaxExchanges = 8;
+    constexpr size_t NameSize = 24;
+    constexpr size_t AddressSize = 43;
+
+    enum class SegmentState : uint32_t { Live = 1, Closed = 2 };
+
+    struct ExchangeEntry {
+        char name[NameSize];
+        // Block of the exchange's last applied change set
+        std::atomic<uint64_t> block;
+    };
+
+    struct Header {
+        std::atomic<uint64_t> magic;
+        uint32_t layoutVersion;
+        uint32_t recordSize;
+        uint32_t poolCount;
+        uint32_t exchangeCount;
+        // Closed once the publisher shuts down; a restarted publisher creates a new segment under the same name
+        std::atomic<uint32_t> state;
+        uint32_t writerPid;
+        // Unix milliseconds of the last write, for staleness checks when a publisher dies without closing
+        std::atomic<int64_t> publishedAt;
+        std::atomic<uint64_t> changeSets;
+        uint8_t reserved[16];
+        ExchangeEntry exchanges[MaxExchanges];
+    };
+
+    // NUL-padded lowercase address, index into the header's exchanges and the tokens' decimals
+    struct PoolEntry {
+        char address[AddressSize];
+        uint8_t exchange;
+        uint8_t decimals[2];
+        uint8_t reserved[2];
+    };
+
+    // Integers are little-endian 64-bit limbs, least significant first; zero where the pool type has no such value
+    // price is decimal-adjusted token1 per token0 and its inverse, NaN until priced or if a side is empty
+    struct alignas(64) PoolRecord {
+        // Odd while the publisher is writing the record
+        std::atomic<uint32_t> sequence;
+        uint32_t reserved;
+        std::atomic<uint64_t> block;
+        std::atomic<uint64_t> reserve0[2];
+        std::atomic<uint64_t> reserve1[2];
+        std::atomic<uint64_t> sqrtPriceX96[3];
+        // In-range liquidity of a V3 pool
+        std::atomic<uint64_t> liquidity[2];
+        std::atomic<double> price[2];
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<double>::is_always_lock_free &&
+                  std::atomic<uint32_t>::is_always_lock_free, "Shared atomics must be address-free");
+    static_assert(sizeof(ExchangeEntry) == 32 && sizeof(Header) == 64 + MaxExchanges * sizeof(ExchangeEntry));
+    static_assert(sizeof(PoolEntry) == 48 && sizeof(PoolRecord) == 128);
+
+    constexpr size_t directoryOffset() {
+        return sizeof(Header);
+    }
+
+    // Records start on a cache line after the directory
+    constexpr size_t recordsOffset(const size_t poolCount) {
+        return (directoryOffset() + poolCount * sizeof(PoolEntry) + 63) / 64 * 64;
+    }
+
+    constexpr size_t segmentSize(const size_t poolCount) {
+        return recordsOffset(poolCount) + poolCount * sizeof(PoolRecord);
+    }
+}
+
+#endif //SHARED_STATE_H
@@ -0,0 +1,200 @@
+#include "SharedStatePublisher.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <limits>
+#include <new>
+#include <optional>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "MidPrice.h"
+
+using namespace sharedstate;
+
+// POSIX names start with a slash
+static std::string segmentName(const std::string &name) {
+    return name.starts_with('/') ? name : "/" + name;
+}
+
+// Little-endian 64-bit limbs of a non-negative value that fits them
+template<size_t N>
+static std::array<uint64_t, N> limbsOf(const mpz_class &value) {
+    std::array<uint64_t, N> limbs{};
+    if (value < 0 || mpz_sizeinbase(value.get_mpz_t(), 2) > 64 * N) {
+        throw std::out_of_range{"SharedStatePublisher: " + value.get_str() + " does not fit the record"};
+    }
+    mpz_export(limbs.data(), nullptr, -1, sizeof(uint64_t), 0, 0, value.get_mpz_t());
+    return limbs;
+}
+
+template<size_t N>
+static void store(std::atomic<uint64_t> (&target)[N], const std::array<uint64_t, N> &limbs) {
+    for (size_t i = 0; i < N; i++) target[i].store(limbs[i], std::memory_order_relaxed);
+}
+
+// Constructor: Create and size the segment, then write the directory and set the magic last
+SharedStatePublisher::SharedStatePublisher(const std::string &name, const std::vector<const ExchangeBase *> &exchanges,
+                                           SharedStateOptions sharedOptions)
+    : segment(segmentName(name)), options(sharedOptions) {
+    if (exchanges.size() > MaxExchanges) {
+        throw std::invalid_argument{"SharedStatePublisher: at most " + std::to_string(MaxExchanges) + " exchanges"};
+    }
+    size_t poolCount = 0;
+    for (const ExchangeBase *exchange: exchanges) poolCount += exchange->pools.size();
+
+    shm_unlink(segment.c_str());
+    const int fd = shm_open(segment.c_str(), O_CREAT | O_EXCL | O_RDWR, options.mode);
+    if (fd < 0) {
+        throw std::runtime_error{"SharedStatePublisher: cannot create " + segment + ": " + std::strerror(errno)};
+    }
+    mappedSize = segmentSize(poolCount);
+    if (ftruncate(fd, static_cast<off_t>(mappedSize)) != 0) {
+        close(fd);
+        shm_unlink(segment.c_str());
+        throw std::runtime_error{"SharedStatePublisher: cannot size " + segment + ": " + std::strerror(errno)};
+    }
+    mapping = mmap(nullptr, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        shm_unlink(segment.c_str());
+        throw std::runtime_error{"SharedStatePublisher: cannot map " + segment + ": " + std::strerror(errno)};
+    }
+
+    auto *base = static_cast<uint8_t *>(mapping);
+    header = new(base) Header{};
+    auto *directory = reinterpret_cast<PoolEntry *>(base + directoryOffset());
+    records = reinterpret_cast<PoolRecord *>(base + recordsOffset(poolCount));
+
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    size_t index = 0;
+    for (size_t e = 0; e < exchanges.size(); e++) {
+        const ExchangeBase &exchange = *exchanges[e];
+        exchange.name.copy(header->exchanges[e].name, NameSize - 1);
+        exchangeIndex.emplace(exchange.name, e);
+        auto &poolRecords = recordIndex.emplace_back();
+
+        for (const auto &[address, pool]: exchange.pools) {
+            PoolEntry &entry = directory[index];
+            std::string lower = address;
+            std::ranges::transform(lower, lower.begin(), [](const unsigned char c) { return std::tolower(c); });
+            lower.copy(entry.address, AddressSize - 1);
+            entry.exchange = static_cast<uint8_t>(e);
+
+            if (pool->tokenCount() >= 2) {
+                entry.decimals[0] = static_cast<uint8_t>(pool->token(0).decimals);
+                entry.decimals[1] = static_cast<uint8_t>(pool->token(1).decimals);
+            }
+            decimalsAdjust.push_back(midprice::decimalsAdjust(*pool));
+
+            PoolRecord *record = new(&records[index]) PoolRecord{};
+            record->price[0].store(nan, std::memory_order_relaxed);
+            record->price[1].store(nan, std::memory_order_relaxed);
+            poolRecords.emplace(address, index);
+            index++;
+        }
+    }
+
+    header->layoutVersion = LayoutVersion;
+    header->recordSize = sizeof(PoolRecord);
+    header->poolCount = static_cast<uint32_t>(poolCount);
+    header->exchangeCount = static_cast<uint32_t>(exchanges.size());
+    header->writerPid = static_cast<uint32_t>(getpid());
+    header->state.store(static_cast<uint32_t>(SegmentState::Live), std::memory_order_relaxed);
+    header->magic.store(Magic, std::memory_order_release);
+}
+
+// Destructor: Stop receiving change sets, then tell readers this segment is done
+SharedStatePublisher::~SharedStatePublisher() {
+    for (const auto &[exchange, id]: subscriptions) {
+        exchange->unsubscribe(id);
+    }
+    header->state.store(static_cast<uint32_t>(SegmentState::Closed), std::memory_order_release);
+    munmap(mapping, mappedSize);
+    if (options.unlinkOnClose) {
+        shm_unlink(segment.c_str());
+    }
+}
+
+// Group the changes by record and rewrite each touched record in one seqlock write
+void SharedStatePublisher::apply(const ChangeSet &changes) {
+    std::lock_guard lock(writeMutex);
+    const auto exchange = exchangeIndex.find(changes.exchange);
+    if (exchange == exchangeIndex.end()) return;
+    const auto &poolRecords = recordIndex[exchange->second];
+
+    touched.clear();
+    for (const PoolChange &change: changes.changes) {
+        if (change.kind == PoolChange::Kind::TickLiquidity) continue;
+        if (const auto it = poolRecords.find(change.pool); it != poolRecords.end()) {
+            touched.emplace_back(it->second, &change);
+        }
+    }
+    std::ranges::stable_sort(touched, {}, &std::pair<size_t, const PoolChange *>::first);
+
+    for (size_t first = 0, last = 0; first < touched.size(); first = last) {
+        const size_t index = touched[first].first;
+        while (last < touched.size() && touched[last].first == index) last++;
+        PoolRecord &record = records[index];
+        if (changes.block < record.block.load(std::memory_order_relaxed)) continue;
+
+        // Convert first, so a value that does not fit throws before the record is opened
+        std::optional<std::array<uint64_t, 2> > reserve0, reserve1, liquidity;
+        std::optional<std::array<uint64_t, 3> > sqrtPriceX96;
+        // Raw token1/token0 ratio, NaN when a side is empty; unset when only the liquidity changed
+        std::optional<double> ratio;
+        for (size_t i = first; i < last; i++) {
+            const PoolChange &change = *touched[i].second;
+            if (change.kind == PoolChange::Kind::Reserves) {
+                reserve0 = limbsOf<2>(change.after[0]);
+                reserve1 = limbsOf<2>(change.after[1]);
+                ratio = midprice::ratioOf(change);
+            } else if (change.kind == PoolChange::Kind::SqrtPrice) {
+                sqrtPriceX96 = limbsOf<3>(change.after[0]);
+                ratio = midprice::ratioOf(change);
+            } else {
+                liquidity = limbsOf<2>(change.after[0]);
+            }
+        }
+
+        midprice::seqlockWrite(record.sequence, [&] {
+            if (reserve0) store(record.reserve0, *reserve0);
+            if (reserve1) store(record.reserve1, *reserve1);
+            if (sqrtPriceX96) store(record.sqrtPriceX96, *sqrtPriceX96);
+            if (liquidity) store(record.liquidity, *liquidity);
+            if (ratio) {
+                const double price = *ratio * decimalsAdjust[index];
+                record.price[0].store(price, std::memory_order_relaxed);
+                record.price[1].store(1.0 / price, std::memory_order_relaxed);
+            }
+            record.block.store(changes.block, std::memory_order_relaxed);
+        });
+        written.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    auto &block = header->exchanges[exchange->second].block;
+    if (changes.block > block.load(std::memory_order_relaxed)) {
+        block.store(changes.block, std::memory_order_release);
+    }
+    header->publishedAt.store(std::chrono::duration_cast<std::chrono::milliseconds>(
+                                  std::chrono::system_clock::now().time_since_epoch()).count(),
+                              std::memory_order_relaxed);
+    header->changeSets.fetch_add(1, std::memory_order_release);
+}
+
+// Segment name as passed to shm_open
+const std::string &SharedStatePublisher::name() const {
+    return segment;
+}
+
+// Records rewritten so far
+uint64_t SharedStatePublisher::recordsWritten() const {
+    return written.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,79 @@
+#ifndef SHARED_STATE_PUBLISHER_H
+#define SHARED_STATE_PUBLISHER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "ChangeSet.h"
+#include "ExchangeBase.h"
+#include "SharedState.h"
+
+struct SharedStateOptions {
+    // Remove the name when the publisher closes; mapped readers keep their view and see it closed
+    bool unlinkOnClose = true;
+    // Segment permissions, readable by the owner's group for strategy processes under another user
+    unsigned int mode = 0640;
+};
+
+// Publishes the exchanges' pool state into a POSIX shared-memory segment for other processes on the host.
+// One record per pool of the exchanges at construction, fed by change sets like PriceTable: only touched pools
+// are rewritten, each under its own seqlock, so readers (SharedStateReader) never wait on the publisher
+class SharedStatePublisher {
+public:
+    // Creates the segment, replacing any segment of that name
+    SharedStatePublisher(const std::string &name, const std::vector<const ExchangeBase *> &exchanges,
+                         SharedStateOptions options = {});
+
+    // Unsubscribes, marks the segment closed and unmaps it
+    ~SharedStatePublisher();
+
+    SharedStatePublisher(const SharedStatePublisher &) = delete;
+
+    SharedStatePublisher &operator=(const SharedStatePublisher &) = delete;
+
+    // Rewrite the pools the changes touch, older than a record's block are ignored
+    void apply(const ChangeSet &changes);
+
+    // Follow the exchange's change sets, seeded from its current snapshot; the exchange must be one of those
+    // the segment was created for
+    template<typename Exchange>
+    void attach(Exchange &exchange) {
+        const size_t id = exchange.subscribe([this](const ChangeSetPtr &changes) { apply(*changes); });
+        subscriptions.emplace_back(&exchange, id);
+        const auto current = exchange.snapshot();
+        ChangeSet seed;
+        seed.exchange = exchange.name;
+        seed.block = current.block();
+        seed.changes = Exchange::diffStates({}, *current);
+        apply(seed);
+    }
+
+    [[nodiscard]] const std::string &name() const;
+
+    // Records rewritten so far
+    [[nodiscard]] uint64_t recordsWritten() const;
+
+private:
+    std::string segment;
+    SharedStateOptions options;
+    void *mapping = nullptr;
+    size_t mappedSize = 0;
+    sharedstate::Header *header = nullptr;
+    sharedstate::PoolRecord *records = nullptr;
+    // Exchange name to its header entry, and per exchange the pool address to its record
+    std::unordered_map<std::string, size_t> exchangeIndex;
+    std::vector<std::unordered_map<std::string, size_t> > recordIndex;
+    std::vector<double> decimalsAdjust;
+    std::vector<std::pair<ExchangeBase *, size_t> > subscriptions;
+    std::atomic<uint64_t> written{0};
+    // Serializes writers, readers never take it
+    std::mutex writeMutex;
+    std::vector<std::pair<size_t, const PoolChange *> > touched;
+};
+
+#endif //SHARED_STATE_PUBLISHER_H
@@ -0,0 +1,158 @@
+#include "SharedStateReader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace sharedstate;
+
+static std::string lowercase(const std::string_view address) {
+    std::string lower(address);
+    std::ranges::transform(lower, lower.begin(), [](const unsigned char c) { return std::tolower(c); });
+    return lower;
+}
+
+// POSIX names start with a slash
+static std::string segmentName(const std::string &name) {
+    return name.starts_with('/') ? name : "/" + name;
+}
+
+// Constructor: Map the segment read-only and index its directory, which never changes once the magic is set
+SharedStateReader::SharedStateReader(const std::string &name) {
+    const int fd = shm_open(segmentName(name).c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+        throw std::runtime_error{"SharedStateReader: cannot open " + name + ": " + std::strerror(errno)};
+    }
+    struct stat info{};
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+        close(fd);
+        throw std::runtime_error{"SharedStateReader: " + name + " is not initialized"};
+    }
+    mappedSize = static_cast<size_t>(info.st_size);
+    mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw std::runtime_error{"SharedStateReader: cannot map " + name + ": " + std::strerror(errno)};
+    }
+
+    header = static_cast<const Header *>(mapping);
+    if (header->magic.load(std::memory_order_acquire) != Magic || header->layoutVersion != LayoutVersion ||
+        header->recordSize != sizeof(PoolRecord) || header->exchangeCount > MaxExchanges ||
+        mappedSize < segmentSize(header->poolCount)) {
+        munmap(mapping, mappedSize);
+        mapping = nullptr;
+        throw std::runtime_error{"SharedStateReader: " + name + " is not initialized or has another layout"};
+    }
+    const auto *base = static_cast<const uint8_t *>(mapping);
+    directory = reinterpret_cast<const PoolEntry *>(base + directoryOffset());
+    records = reinterpret_cast<const PoolRecord *>(base + recordsOffset(header->poolCount));
+
+    for (uint32_t i = 0; i < header->exchangeCount; i++) {
+        exchangeNames.emplace_back(header->exchanges[i].name, strnlen(header->exchanges[i].name, NameSize));
+    }
+    for (uint32_t i = 0; i < header->poolCount; i++) {
+        poolIndex.emplace(poolAt(i), i);
+    }
+}
+
+// Destructor: Unmap, the segment stays for other readers
+SharedStateReader::~SharedStateReader() {
+    if (mapping != nullptr) {
+        munmap(mapping, mappedSize);
+    }
+}
+
+// Number of pool records
+size_t SharedStateReader::size() const {
+    return header->poolCount;
+}
+
+// Look up a pool's record
+std::optional<size_t> SharedStateReader::indexOf(const std::string_view address) const {
+    if (const auto it = poolIndex.find(lowercase(address)); it != poolIndex.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+// Pool address of a record
+std::string SharedStateReader::poolAt(const size_t index) const {
+    record(index);
+    return {directory[index].address, strnlen(directory[index].address, AddressSize)};
+}
+
+// Exchange of a record
+const std::string &SharedStateReader::exchangeOf(const size_t index) const {
+    record(index);
+    return exchangeNames.at(directory[index].exchange);
+}
+
+// Token decimals of a record
+std::array<int, 2> SharedStateReader::decimals(const size_t index) const {
+    record(index);
+    return {directory[index].decimals[0], directory[index].decimals[1]};
+}
+
+// Bounds-checked record
+const PoolRecord &SharedStateReader::record(const size_t index) const {
+    if (index >= header->poolCount) {
+        throw std::out_of_range{"SharedStateReader: no record " + std::to_string(index)};
+    }
+    return records[index];
+}
+
+// Seqlock read: retry while a write is in progress or happened during the read
+SharedPool SharedStateReader::read(const size_t index) const {
+    const PoolRecord &source = record(index);
+    const auto copy = [](const auto &from, auto &to) {
+        for (size_t i = 0; i < to.size(); i++) to[i] = from[i].load(std::memory_order_relaxed);
+    };
+    SharedPool pool;
+    uint32_t after;
+    do {
+        pool.sequence = source.sequence.load(std::memory_order_acquire);
+        pool.block = source.block.load(std::memory_order_relaxed);
+        copy(source.reserve0, pool.reserve0);
+        copy(source.reserve1, pool.reserve1);
+        copy(source.sqrtPriceX96, pool.sqrtPriceX96);
+        copy(source.liquidity, pool.liquidity);
+        copy(source.price, pool.price);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        after = source.sequence.load(std::memory_order_relaxed);
+    } while (pool.sequence != after || (pool.sequence & 1) != 0);
+    return pool;
+}
+
+// Sequence only
+uint32_t SharedStateReader::sequence(const size_t index) const {
+    return record(index).sequence.load(std::memory_order_acquire);
+}
+
+// Exchange names in header order
+const std::vector<std::string> &SharedStateReader::exchanges() const {
+    return exchangeNames;
+}
+
+// Block of an exchange's last change set
+uint64_t SharedStateReader::block(const std::string &exchange) const {
+    const auto it = std::ranges::find(exchangeNames, exchange);
+    if (it == exchangeNames.end()) return 0;
+    return header->exchanges[it - exchangeNames.begin()].block.load(std::memory_order_acquire);
+}
+
+// Whether the publisher still writes this segment
+bool SharedStateReader::live() const {
+    return header->state.load(std::memory_order_acquire) == static_cast<uint32_t>(SegmentState::Live);
+}
+
+// Last write time
+int64_t SharedStateReader::publishedAt() const {
+    return header->publishedAt.load(std::memory_order_relaxed);
+}
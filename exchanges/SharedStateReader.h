@@ -0,0 +1,91 @@
+#ifndef SHARED_STATE_READER_H
+#define SHARED_STATE_READER_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "SharedState.h"
+
+// Consistent copy of one pool record; integers are little-endian 64-bit limbs, least significant first
+struct SharedPool {
+    uint64_t block = 0;
+    std::array<uint64_t, 2> reserve0{};
+    std::array<uint64_t, 2> reserve1{};
+    std::array<uint64_t, 3> sqrtPriceX96{};
+    std::array<uint64_t, 2> liquidity{};
+    // Decimal-adjusted token1 per token0 and its inverse
+    std::array<double, 2> price{};
+    // Record sequence the copy was taken at, changes with every write
+    uint32_t sequence = 0;
+};
+
+// Read-only mapping of a segment published by SharedStatePublisher, for processes that do not link deds_core.
+// Reads are lock-free and never block the publisher: a read that overlaps a write is retried
+class SharedStateReader {
+public:
+    // Maps the segment; throws if it does not exist, is not initialized yet or has another layout
+    explicit SharedStateReader(const std::string &name);
+
+    ~SharedStateReader();
+
+    SharedStateReader(const SharedStateReader &) = delete;
+
+    SharedStateReader &operator=(const SharedStateReader &) = delete;
+
+    [[nodiscard]] size_t size() const;
+
+    // Pool by address, case-insensitive
+    [[nodiscard]] std::optional<size_t> indexOf(std::string_view address) const;
+
+    [[nodiscard]] std::string poolAt(size_t index) const;
+
+    // Exchange name of a pool and its tokens' decimals
+    [[nodiscard]] const std::string &exchangeOf(size_t index) const;
+
+    [[nodiscard]] std::array<int, 2> decimals(size_t index) const;
+
+    // Seqlock read of one record
+    [[nodiscard]] SharedPool read(size_t index) const;
+
+    // Current sequence of a record without copying it, for cheap change polling
+    [[nodiscard]] uint32_t sequence(size_t index) const;
+
+    [[nodiscard]] const std::vector<std::string> &exchanges() const;
+
+    // Block of the exchange's last change set, 0 for an unknown exchange
+    [[nodiscard]] uint64_t block(const std::string &exchange) const;
+
+    // False once the publisher has closed the segment, reopen by name to follow its successor
+    [[nodiscard]] bool live() const;
+
+    // Unix milliseconds of the publisher's last write
+    [[nodiscard]] int64_t publishedAt() const;
+
+    // Limbs as a double, for quick arithmetic on exact values
+    template<size_t N>
+    static double toDouble(const std::array<uint64_t, N> &limbs) {
+        double value = 0;
+        for (size_t i = N; i-- > 0;) {
+            value = value * 18446744073709551616.0 + static_cast<double>(limbs[i]);
+        }
+        return value;
+    }
+
+private:
+    void *mapping = nullptr;
+    size_t mappedSize = 0;
+    const sharedstate::Header *header = nullptr;
+    const sharedstate::PoolEntry *directory = nullptr;
+    const sharedstate::PoolRecord *records = nullptr;
+    std::vector<std::string> exchangeNames;
+    std::unordered_map<std::string, size_t> poolIndex;
+
+    const sharedstate::PoolRecord &record(size_t index) const;
+};
+
+#endif //SHARED_STATE_READER_H
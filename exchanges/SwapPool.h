@@ -0,0 +1,30 @@
+#ifndef SWAP_POOL_H
+#define SWAP_POOL_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+#include "TokenRegistry.h"
+
+// Immutable pricing model of one pool, built from an adapter snapshot for the router.
+// Amounts are raw token units in double precision: the pool's exact-input formula, not a mid-price estimate
+class SwapPool {
+public:
+    virtual ~SwapPool() = default;
+
+    // Output for an exact input of tokens[0] (zeroForOne) or tokens[1], 0 for a non-positive input
+    [[nodiscard]] virtual double amountOut(double amountIn, bool zeroForOne) const = 0;
+
+    // Output per unit of input for an infinitesimal trade after the fee. Outputs are concave, so
+    // amountOut(x) <= x * spotRate for every x
+    [[nodiscard]] virtual double spotRate(bool zeroForOne) const = 0;
+
+    std::string address;
+    std::string exchange;
+    std::array<TokenId, 2> tokens{NoToken, NoToken};
+    // Block of the snapshot the model was built from
+    uint64_t block = 0;
+};
+
+#endif //SWAP_POOL_H
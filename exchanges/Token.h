@@ -12,8 +12,10 @@ struct Token {
     std::string name;
     int decimals;
     int tokenGlobalIndice;
+    // Chain the address lives on, empty for a single-chain process
+    std::string chain;
 
-    void ERC20sync(const std::shared_ptr<Web3Client> &web3);
+    void ERC20sync(const std::shared_ptr<Web3Client> &web3, const std::string &abiDir = "../abis");
 };
 
 #endif // TOKEN_H
@@ -0,0 +1,52 @@
+#include "TokenRegistry.h"
+
+#include <mutex>
+#include <stdexcept>
+
+// Get process-wide registry
+TokenRegistry &TokenRegistry::instance() {
+    static TokenRegistry registry;
+    return registry;
+}
+
+// Register a token once, the id doubles as its global index
+TokenId TokenRegistry::insert(Token token) {
+    std::unique_lock lock(mutex);
+    auto &chainIds = ids[token.chain];
+    if (const auto it = chainIds.find(token.address); it != chainIds.end()) {
+        return it->second;
+    }
+    const auto id = static_cast<TokenId>(records.size());
+    token.tokenGlobalIndice = static_cast<int>(id);
+    const Token &record = records.emplace_back(std::move(token));
+    chainIds.emplace(record.address, id);
+    return id;
+}
+
+// Look up a token id by chain and address
+std::optional<TokenId> TokenRegistry::find(const std::string &address, const std::string &chain) const {
+    std::shared_lock lock(mutex);
+    const auto chainIds = ids.find(chain);
+    if (chainIds == ids.end()) {
+        return std::nullopt;
+    }
+    if (const auto it = chainIds->second.find(address); it != chainIds->second.end()) {
+        return it->second;
+    }
+    return std::nullopt;
+}
+
+// Get a token record by id
+const Token &TokenRegistry::get(const TokenId id) const {
+    std::shared_lock lock(mutex);
+    if (id >= records.size()) {
+        throw std::out_of_range{"TokenRegistry: unknown token id " + std::to_string(id)};
+    }
+    return records[id];
+}
+
+// Number of registered tokens
+size_t TokenRegistry::size() const {
+    std::shared_lock lock(mutex);
+    return records.size();
+}
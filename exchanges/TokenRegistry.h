@@ -0,0 +1,41 @@
+#ifndef TOKEN_REGISTRY_H
+#define TOKEN_REGISTRY_H
+
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "Token.h"
+
+using TokenId = uint32_t;
+
+// Unset token slot of a pool
+constexpr TokenId NoToken = UINT32_MAX;
+
+// Process-wide token records shared by every exchange, each (chain, address) stored once and referenced by id.
+// Ids are unique across chains. Records are never moved or removed, so references returned by get stay valid
+class TokenRegistry {
+public:
+    static TokenRegistry &instance();
+
+    // Id of the token's chain and address, registering the token if it is new
+    TokenId insert(Token token);
+
+    [[nodiscard]] std::optional<TokenId> find(const std::string &address, const std::string &chain = "") const;
+
+    [[nodiscard]] const Token &get(TokenId id) const;
+
+    [[nodiscard]] size_t size() const;
+
+private:
+    mutable std::shared_mutex mutex;
+    std::deque<Token> records;
+    // Per chain, keys view the addresses stored in records
+    std::unordered_map<std::string, std::unordered_map<std::string_view, TokenId> > ids;
+};
+
+#endif //TOKEN_REGISTRY_H
@@ -0,0 +1,94 @@
+#include "UpdateOrchestrator.h"
+
+#include <chrono>
+#include <iostream>
+
+// Constructor: Share one client across every adapter
+UpdateOrchestrator::UpdateOrchestrator(std::shared_ptr<Web3Client> web3Client, const size_t threadCount)
+    : web3{std::move(web3Client)}, ownedPool{std::make_unique<ThreadPool>(threadCount)}, threadPool{ownedPool.get()},
+      cycleTime{
+          Metrics::instance().histogram("deds_orchestrator_cycle_seconds", web3->labels(),
+                                        "Wall time of one orchestrated update cycle")
+      } {
+}
+
+// Constructor: Share one client across every adapter and a pool across orchestrators
+UpdateOrchestrator::UpdateOrchestrator(std::shared_ptr<Web3Client> web3Client, ThreadPool &sharedPool,
+                                       std::shared_ptr<ConcurrencyBudget> budget)
+    : web3{std::move(web3Client)}, threadPool{&sharedPool}, budget{std::move(budget)}, cycleTime{
+          Metrics::instance().histogram("deds_orchestrator_cycle_seconds", web3->labels(),
+                                        "Wall time of one orchestrated update cycle")
+      } {
+}
+
+// Take ownership of an already constructed adapter
+void UpdateOrchestrator::addExchange(std::unique_ptr<ExchangeBase> exchange) {
+    exchange->setBudget(budget);
+    std::lock_guard lock(exchangesMutex);
+    exchanges.push_back(std::move(exchange));
+}
+
+// Await queued adapter constructions
+void UpdateOrchestrator::waitLoaded() {
+    std::exception_ptr error;
+    for (auto &future: loading) {
+        try {
+            future.get();
+        } catch (...) {
+            if (!error) error = std::current_exception();
+        }
+    }
+    loading.clear();
+    std::erase(exchanges, nullptr);
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+// Run all adapters' cycles as pool tasks, total time tracks the slowest adapter rather than the sum
+CycleReport UpdateOrchestrator::runCycle() {
+    waitLoaded();
+
+    CycleReport report;
+    const auto start = std::chrono::steady_clock::now();
+
+    std::vector<std::future<double> > cycles;
+    for (auto &exchange: exchanges) {
+        cycles.push_back(submit([&exchange] {
+            const auto exchangeStart = std::chrono::steady_clock::now();
+            exchange->updatePools();
+            return std::chrono::duration<double>(std::chrono::steady_clock::now() - exchangeStart).count();
+        }));
+    }
+
+    for (size_t i = 0; i < cycles.size(); i++) {
+        double seconds = 0;
+        try {
+            seconds = cycles[i].get();
+        } catch (const std::exception &e) {
+            report.failures++;
+            std::cerr << "Update cycle failed for " << exchanges[i]->name << ": " << e.what() << std::endl;
+        }
+        report.exchangeSeconds.emplace_back(exchanges[i]->name, seconds);
+    }
+
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    cycleTime.observe(report.seconds);
+    return report;
+}
+
+// Get adapters once loading has finished
+const std::vector<std::unique_ptr<ExchangeBase> > &UpdateOrchestrator::getExchanges() {
+    waitLoaded();
+    return exchanges;
+}
+
+// Get shared client
+std::shared_ptr<Web3Client> UpdateOrchestrator::getWeb3Client() const {
+    return web3;
+}
+
+// Get thread pool, e.g. for post-processing tasks between cycles
+ThreadPool &UpdateOrchestrator::getThreadPool() {
+    return *threadPool;
+}
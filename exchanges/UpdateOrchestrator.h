@@ -0,0 +1,86 @@
+#ifndef UPDATE_ORCHESTRATOR_H
+#define UPDATE_ORCHESTRATOR_H
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "ExchangeBase.h"
+#include "../utils/ConcurrencyBudget.h"
+#include "../utils/ThreadPool.h"
+#include "../utils/Web3Client.h"
+
+// Timing of one orchestrated cycle
+struct CycleReport {
+    double seconds = 0;
+    // Wall time of each exchange's updatePools, in registration order
+    std::vector<std::pair<std::string, double> > exchangeSeconds;
+    size_t failures = 0;
+};
+
+// Owns a set of exchange adapters sharing one Web3Client and runs their update cycles concurrently
+// on a work-stealing thread pool. Adapters can fan out further through ThreadPool::current()
+class UpdateOrchestrator {
+public:
+    explicit UpdateOrchestrator(std::shared_ptr<Web3Client> web3Client,
+                                size_t threadCount = std::thread::hardware_concurrency());
+
+    // Run on a pool shared with other orchestrators, e.g. one per chain. Loading, cycles and adapter
+    // fan-out hold at most budget's limit of its threads; null for no limit
+    UpdateOrchestrator(std::shared_ptr<Web3Client> web3Client, ThreadPool &sharedPool,
+                       std::shared_ptr<ConcurrencyBudget> budget);
+
+    // Construct an adapter on the pool as Exchange(web3, args...), adapters load concurrently
+    // but keep their registration order
+    template<typename Exchange, typename... Args>
+    void addExchange(Args... args) {
+        size_t slot;
+        {
+            std::lock_guard lock(exchangesMutex);
+            slot = exchanges.size();
+            exchanges.emplace_back();
+        }
+        loading.push_back(submit([this, slot, args...] {
+            auto exchange = std::make_unique<Exchange>(web3, args...);
+            exchange->setBudget(budget);
+            std::lock_guard lock(exchangesMutex);
+            exchanges[slot] = std::move(exchange);
+        }));
+    }
+
+    void addExchange(std::unique_ptr<ExchangeBase> exchange);
+
+    // Block until every queued adapter is constructed, rethrows the first construction error
+    // after dropping the adapters that failed
+    void waitLoaded();
+
+    // Run one updatePools cycle of every adapter concurrently
+    CycleReport runCycle();
+
+    [[nodiscard]] const std::vector<std::unique_ptr<ExchangeBase> > &getExchanges();
+
+    [[nodiscard]] std::shared_ptr<Web3Client> getWeb3Client() const;
+
+    ThreadPool &getThreadPool();
+
+private:
+    std::shared_ptr<Web3Client> web3;
+    std::mutex exchangesMutex;
+    std::vector<std::unique_ptr<ExchangeBase> > exchanges;
+    std::vector<std::future<void> > loading;
+    std::unique_ptr<ThreadPool> ownedPool;
+    ThreadPool *threadPool;
+    std::shared_ptr<ConcurrencyBudget> budget;
+    Histogram &cycleTime;
+
+    // Queue a task on the pool within the budget
+    template<typename F>
+    auto submit(F &&task) {
+        return budget ? budget->submit(*threadPool, std::forward<F>(task)) : threadPool->submit(std::forward<F>(task));
+    }
+};
+
+#endif //UPDATE_ORCHESTRATOR_H
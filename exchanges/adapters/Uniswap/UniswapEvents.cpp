@@ -0,0 +1,64 @@
+#include "UniswapEvents.h"
+
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include "UniswapStorage.h"
+
+namespace uniswapEvents {
+    // Data word i, as a storage word so uniswapStorage::field can cut it
+    static std::string dataWord(const nlohmann::json &log, const size_t index) {
+        const std::string &data = log.at("data").get_ref<const std::string &>();
+        if (data.size() < 2 + 64 * (index + 1)) {
+            throw std::runtime_error{"Log data too short: " + data};
+        }
+        return "0x" + data.substr(2 + 64 * index, 64);
+    }
+
+    // Topics are indexed by position, an empty array has no event signature
+    std::string topic0(const nlohmann::json &log) {
+        const auto topics = log.find("topics");
+        if (topics == log.end() || topics->empty()) return {};
+        return (*topics)[0].get<std::string>();
+    }
+
+    // Ticks from topics 2 and 3, the block from its hex quantity, the amount from the first uint128 of the data
+    std::optional<LiquidityEvent> decodeLiquidity(const nlohmann::json &log) {
+        const std::string topic = topic0(log);
+        if (topic != MintTopic && topic != BurnTopic) return std::nullopt;
+        const nlohmann::json &topics = log.at("topics");
+        if (topics.size() != 4) return std::nullopt;
+        LiquidityEvent event;
+        event.pool = log.at("address").get<std::string>();
+        std::ranges::transform(event.pool, event.pool.begin(), [](const unsigned char c) { return std::tolower(c); });
+        event.block = std::stoull(log.at("blockNumber").get<std::string>(), nullptr, 16);
+        event.tickLower = static_cast<int>(uniswapStorage::field(topics[2].get<std::string>(), 0, 24, true).get_si());
+        event.tickUpper = static_cast<int>(uniswapStorage::field(topics[3].get<std::string>(), 0, 24, true).get_si());
+        // Mint data starts with the sender address, Burn data with the amount
+        event.amount = uniswapStorage::field(dataWord(log, topic == MintTopic ? 1 : 0), 0, 128);
+        if (topic == BurnTopic) event.amount = -event.amount;
+        return event;
+    }
+
+    // Swap data is amount0, amount1, sqrtPriceX96, liquidity, tick; Initialize data is sqrtPriceX96, tick
+    std::optional<PriceEvent> decodePrice(const nlohmann::json &log) {
+        const std::string topic = topic0(log);
+        if (topic == SwapTopic) {
+            return PriceEvent{uniswapStorage::field(dataWord(log, 2), 0, 160),
+                              uniswapStorage::field(dataWord(log, 3), 0, 128),
+                              static_cast<int>(uniswapStorage::field(dataWord(log, 4), 0, 24, true).get_si())};
+        }
+        if (topic == InitializeTopic) {
+            return PriceEvent{uniswapStorage::field(dataWord(log, 0), 0, 160), 0,
+                              static_cast<int>(uniswapStorage::field(dataWord(log, 1), 0, 24, true).get_si())};
+        }
+        return std::nullopt;
+    }
+
+    // Sync data is reserve0, reserve1
+    std::optional<std::array<mpz_class, 2> > decodeSync(const nlohmann::json &log) {
+        if (topic0(log) != SyncTopic) return std::nullopt;
+        return std::array<mpz_class, 2>{uniswapStorage::field(dataWord(log, 0), 0, 112),
+                                        uniswapStorage::field(dataWord(log, 1), 0, 112)};
+    }
+}
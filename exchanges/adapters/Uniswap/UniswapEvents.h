@@ -0,0 +1,58 @@
+#ifndef UNISWAP_EVENTS_H
+#define UNISWAP_EVENTS_H
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <gmpxx.h>
+#include <nlohmann/json.hpp>
+
+// Uniswap pool events as returned by eth_getLogs. Topics are 32-byte "0x"-prefixed hex strings, indexed int24
+// ticks are sign-extended to a full topic, data is the non-indexed arguments as ABI words
+namespace uniswapEvents {
+    // keccak256("Sync(uint112,uint112)"), UniswapV2Pair
+    constexpr std::string_view SyncTopic = "0x1c411e9a96e071241c2f21f7726b17ae89e3cab4c78be50e062b03a9fffbbad1";
+    // keccak256("Initialize(uint160,int24)")
+    constexpr std::string_view InitializeTopic =
+            "0x98636036cb66a9c19a37435efc1e90142190214e8abeb821bdba3f2990dd4c95";
+    // keccak256("Swap(address,address,int256,int256,uint160,uint128,int24)")
+    constexpr std::string_view SwapTopic = "0xc42079f94a6350d7e6235f29174924f928cc2ac818eb64fed8004e115fbcca67";
+    // keccak256("Mint(address,address,int24,int24,uint128,uint256,uint256)")
+    constexpr std::string_view MintTopic = "0x7a53080ba414158be7ec69b987b5fb7d07dee101fe85488f0853ae16239d0bde";
+    // keccak256("Burn(address,int24,int24,uint128,uint256,uint256)")
+    constexpr std::string_view BurnTopic = "0x0c396cd989a39f4459b5fa1aed6a9a8dcdbc45908acfd67e028cd568da98982c";
+
+    // A V3 position's liquidity changed between tickLower and tickUpper
+    struct LiquidityEvent {
+        // Lowercase, as logs carry it
+        std::string pool;
+        uint64_t block = 0;
+        int tickLower = 0;
+        int tickUpper = 0;
+        // Liquidity added, negative for a Burn
+        mpz_class amount;
+    };
+
+    // V3 price after a Swap, or the starting price of an Initialize with zero liquidity
+    struct PriceEvent {
+        mpz_class sqrtPriceX96;
+        mpz_class liquidity;
+        int tick = 0;
+    };
+
+    // First topic of a log, empty when it has none
+    std::string topic0(const nlohmann::json &log);
+
+    // Mint or Burn log, std::nullopt for any other event. Both index owner, tickLower, tickUpper
+    std::optional<LiquidityEvent> decodeLiquidity(const nlohmann::json &log);
+
+    // Swap or Initialize log
+    std::optional<PriceEvent> decodePrice(const nlohmann::json &log);
+
+    // Reserves after a V2 Sync log
+    std::optional<std::array<mpz_class, 2> > decodeSync(const nlohmann::json &log);
+}
+
+#endif //UNISWAP_EVENTS_H
@@ -0,0 +1,64 @@
+#include "UniswapStorage.h"
+
+#include <stdexcept>
+
+#include "../../../utils/AbiCodec.h"
+#include "../../../utils/Web3Client.h"
+
+namespace uniswapStorage {
+    // Slot number as a full word
+    std::string slotHex(const uint64_t slot) {
+        std::string word(abi::WordChars, '0');
+        abi::writeLow64(word.data(), slot, '0');
+        return "0x" + word;
+    }
+
+    // Hash the padded key and slot words
+    std::string mappingSlot(const int64_t key, const uint64_t slot) {
+        std::string preimage(2 * abi::WordChars, '0');
+        abi::Int<64>::encode(preimage.data(), key);
+        abi::writeLow64(preimage.data() + abi::WordChars, slot, '0');
+
+        std::string bytes(abi::WordChars, '\0');
+        for (size_t i = 0; i < bytes.size(); i++) {
+            bytes[i] = static_cast<char>(abi::hexNibble(preimage[2 * i]) << 4 | abi::hexNibble(preimage[2 * i + 1]));
+        }
+        return Web3Client::bytesToHex(Web3Client::keccak256(bytes));
+    }
+
+    // Cut a nibble-aligned field out of the word, nodes may return it without leading zeros
+    mpz_class field(const std::string &word, const unsigned offset, const unsigned width, const bool isSigned) {
+        if (offset % 4 != 0 || width % 4 != 0 || offset + width > 256) {
+            throw std::invalid_argument{"uniswapStorage::field: unaligned field"};
+        }
+        const std::string_view hex = std::string_view(word).starts_with("0x") ? std::string_view(word).substr(2) : word;
+        if (hex.size() > abi::WordChars) {
+            throw std::runtime_error{"Storage word longer than 32 bytes: " + word};
+        }
+        const std::string padded = std::string(abi::WordChars - hex.size(), '0') + std::string(hex);
+
+        const std::string digits = padded.substr(abi::WordChars - (offset + width) / 4, width / 4);
+        mpz_class value(digits, 16);
+        if (isSigned && abi::hexNibble(digits[0]) >= 8) {
+            mpz_class modulus;
+            mpz_ui_pow_ui(modulus.get_mpz_t(), 2, width);
+            value -= modulus;
+        }
+        return value;
+    }
+
+    // reserve0 and reserve1 from the packed reserves slot
+    std::array<mpz_class, 2> decodeV2Reserves(const std::string &word) {
+        return {field(word, 0, 112), field(word, 112, 112)};
+    }
+
+    // sqrtPriceX96 and tick from slot0
+    V3Slot0 decodeV3Slot0(const std::string &word) {
+        return {field(word, 0, 160), static_cast<int>(field(word, 160, 24, true).get_si())};
+    }
+
+    // Liquidity pair from a tick entry's first slot
+    std::array<mpz_class, 2> decodeV3TickLiquidity(const std::string &word) {
+        return {field(word, 128, 128, true), field(word, 0, 128)};
+    }
+}
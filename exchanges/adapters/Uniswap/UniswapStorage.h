@@ -0,0 +1,43 @@
+#ifndef UNISWAP_STORAGE_H
+#define UNISWAP_STORAGE_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <gmpxx.h>
+
+// Storage layout of the Uniswap pool contracts, for reading state with eth_getStorageAt instead of eth_call.
+// Slots are 32-byte "0x"-prefixed hex strings, words are eth_getStorageAt results. Packed fields start at the
+// low-order end of a word, in declaration order
+namespace uniswapStorage {
+    // UniswapV2Pair: reserve0 (uint112), reserve1 (uint112), blockTimestampLast (uint32)
+    constexpr uint64_t V2ReservesSlot = 8;
+
+    // UniswapV3Pool: slot0 = sqrtPriceX96 (uint160), tick (int24), observation fields, feeProtocol, unlocked
+    constexpr uint64_t V3Slot0Slot = 0;
+    constexpr uint64_t V3LiquiditySlot = 4;
+    // mapping(int24 => Tick.Info), an entry's first slot packs liquidityGross (uint128) and liquidityNet (int128)
+    constexpr uint64_t V3TicksSlot = 5;
+
+    std::string slotHex(uint64_t slot);
+
+    // keccak256(key . slot) for a signed mapping key, sign-extended to 32 bytes like Solidity does
+    std::string mappingSlot(int64_t key, uint64_t slot);
+
+    // Bits [offset, offset + width) of a word, sign-extended from the top bit when isSigned
+    mpz_class field(const std::string &word, unsigned offset, unsigned width, bool isSigned = false);
+
+    std::array<mpz_class, 2> decodeV2Reserves(const std::string &word);
+
+    struct V3Slot0 {
+        mpz_class sqrtPriceX96;
+        int tick = 0;
+    };
+
+    V3Slot0 decodeV3Slot0(const std::string &word);
+
+    // {liquidityNet, liquidityGross}, the order of Tick::liquidity
+    std::array<mpz_class, 2> decodeV3TickLiquidity(const std::string &word);
+}
+
+#endif //UNISWAP_STORAGE_H
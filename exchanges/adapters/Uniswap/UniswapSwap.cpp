@@ -0,0 +1,19 @@
+#include "UniswapSwap.h"
+
+#include <utility>
+
+// Constructor: Price from a snapshot's curve
+UniswapSwapPool::UniswapSwapPool(std::shared_ptr<const DepthCurve> depth) : depth{std::move(depth)} {
+}
+
+// Output along the curve, capped at the end of the known range
+double UniswapSwapPool::amountOut(const double amountIn, const bool zeroForOne) const {
+    return depth->amountOut(amountIn, zeroForOne);
+}
+
+// Current price in the swap direction after the fee
+double UniswapSwapPool::spotRate(const bool zeroForOne) const {
+    if (depth->sqrtPrice <= 0) return 0;
+    const double price = depth->sqrtPrice * depth->sqrtPrice;
+    return (1 - depth->feeRate) * (zeroForOne ? price : 1 / price);
+}
@@ -0,0 +1,24 @@
+#ifndef UNISWAP_SWAP_H
+#define UNISWAP_SWAP_H
+
+#include <memory>
+
+#include "../../DepthCurve.h"
+#include "../../SwapPool.h"
+
+// V2 or V3 pool priced from the depth curve of the snapshot it was built from: one constant product segment for a
+// pair, one segment per initialized tick for a V3 pool. The curve is shared with the snapshot, not copied.
+// Only the fetched tick window is known: a V3 swap stops at its edge and input beyond that is not filled
+class UniswapSwapPool final : public SwapPool {
+public:
+    explicit UniswapSwapPool(std::shared_ptr<const DepthCurve> depth);
+
+    [[nodiscard]] double amountOut(double amountIn, bool zeroForOne) const override;
+
+    // From the current price, whatever the liquidity: a swap only moves the price against the trader
+    [[nodiscard]] double spotRate(bool zeroForOne) const override;
+
+    std::shared_ptr<const DepthCurve> depth;
+};
+
+#endif //UNISWAP_SWAP_H
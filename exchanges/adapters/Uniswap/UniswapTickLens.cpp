@@ -0,0 +1,87 @@
+#include "UniswapTickLens.h"
+
+#include <stdexcept>
+#include <string>
+
+namespace uniswapTickLens {
+    // Memory: 0x00 calldata of the pool calls, 0x40 their return data, 0x140.. variables (out, i, pool, spacing,
+    // c, maxC, cached word position, bitmap word, count position, pools base, n, range, tick, count),
+    // 0x300 the returned array. c walks the compressed ticks (tick / spacing) of the window, the bitmap word is
+    // fetched once per 256 of them. Any failed or short pool call reverts the whole call. Each line is one step
+    // at the code offset it starts with, jumps target those offsets
+    const std::string_view Bytecode =
+        "0x"
+        "61034061014052" // 0000 out = first result word
+        "6004356004018061026052" // 0007 base = 4 + pools offset
+        "3561028052" // 0012 n = pools.length
+        "6024356102a052" // 0017 range = tickRange
+        "600061016052" // 001e i = 0
+        "5b6102805161016051101561023357" // 0024 pools: while i < n
+        "6101605160051b61026051016020013561018052" // 0033 pool = pools[i]
+        "633850c7bd60e01b6000526040604060046000610180515afa156102555760403d106102" // 0047 slot0()
+        "5557"
+        "6040516101405152" // 006d out[0] = sqrtPriceX96
+        "606051806102c0526101405160200152" // 0075 out[1] = tick
+        "631a68650260e01b6000526020604060046000610180515afa156102555760203d106102" // 0085 liquidity()
+        "5557"
+        "6040516101405160400152" // 00ab out[2] = liquidity
+        "63d0c93a7c60e01b6000526020604060046000610180515afa156102555760203d106102" // 00b6 tickSpacing()
+        "5557"
+        "604051806101a0526101405160600152" // 00dc out[3] = spacing
+        "61014051806080016102405260a00161014052" // 00ec countPos = out + 4 words, out += 5 words
+        "6101a0516102c051056101a0516102c05107600090129003" // 00ff compressed = tick / spacing, rounded down
+        "806102a051016101e052" // 0117 maxC = compressed + range
+        "6102a05190036101c052" // 0121 c = compressed - range
+        "600160801b6102005260006102e052" // 012b no bitmap word cached, count = 0
+        "5b6101e0516101c0511361021a57" // 013a ticks: while c <= maxC
+        "6101c05160081d80610200511461018f57" // 0148 wordPos = c >> 8
+        "8061020052635339c29660e01b600052806004526020604060246000610180515afa1561" // 0159 tickBitmap(wordPos)
+        "02555760203d106102555760405161022052"
+        "5b506101c05160ff16" // 018f bit = c & 0xff
+        "61022051901c6001161561020a57" // 0198 skip unset bits
+        "6101a0516101c05102" // 01a6 tick = c * spacing
+        "63f30dba9360e01b600052806004526040604060246000610180515afa15610255576040" // 01af ticks(tick)
+        "3d1061025557"
+        "610140515260605161014051602001526040516101405160400152" // 01d9 out[0..2] = tick, liquidityNet, liquidityGross
+        "61014051606001610140526102e0516001016102e052" // 01f4 out += 3 words, count += 1
+        "5b6101c0516001016101c05261013a56" // 020a c += 1
+        "5b6102e0516102405152610160516001016101605261002456" // 021a out[countPos] = count, i += 1
+        "5b602061030052610340610140510360051c610320526103006101405103610300f3" // 0233 return abi.encode(words)
+        "5b600080fd"; // 0255 revert when a pool call fails or returns short data
+
+    // Built once, the same object goes with every lens call
+    const nlohmann::json &stateOverride() {
+        static const nlohmann::json overrides = {{std::string(Address), {{"code", std::string(Bytecode)}}}};
+        return overrides;
+    }
+
+    // Walk the flat word stream pool by pool
+    std::vector<PoolState> decode(const nlohmann::json &words, const size_t poolCount) {
+        size_t next = 0;
+        const auto take = [&words, &next]() {
+            if (next >= words.size()) {
+                throw std::runtime_error{"Tick lens result truncated at word " + std::to_string(next)};
+            }
+            return mpz_class(words[next++].get<std::string>(), 10);
+        };
+
+        std::vector<PoolState> states(poolCount);
+        for (PoolState &state: states) {
+            state.sqrtPriceX96 = take();
+            state.tick = static_cast<int>(take().get_si());
+            state.liquidity = take();
+            state.tickSpacing = static_cast<int>(take().get_si());
+            const size_t count = take().get_ui();
+            for (size_t i = 0; i < count; i++) {
+                InitializedTick &tick = state.ticks.emplace_back();
+                tick.tick = static_cast<int>(take().get_si());
+                tick.liquidityNet = take();
+                tick.liquidityGross = take();
+            }
+        }
+        if (next != words.size()) {
+            throw std::runtime_error{"Tick lens result has " + std::to_string(words.size() - next) + " extra words"};
+        }
+        return states;
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef UNISWAP_TICK_LENS_H
+#define UNISWAP_TICK_LENS_H
+
+#include <string_view>
+#include <vector>
+#include <gmpxx.h>
+#include <nlohmann/json.hpp>
+
+// Read-only contract run through eth_call with its code placed by a state override, nothing is deployed.
+// getPoolStates(address[] pools, int24 tickRange) returns (int256[] words), per pool in request order:
+// sqrtPriceX96, tick, liquidity, tickSpacing, count, then count x (tick, liquidityNet, liquidityGross) for the
+// initialized ticks, found through the tickBitmap, within tickRange spacings of the current one
+namespace uniswapTickLens {
+    // Holds no code on any chain
+    constexpr std::string_view Address = "0x00000000000000000000000000000000000de1e5";
+
+    // Hand-assembled runtime code, listed in UniswapTickLens.cpp
+    extern const std::string_view Bytecode;
+
+    // eth_call state override object placing Bytecode at Address
+    const nlohmann::json &stateOverride();
+
+    struct InitializedTick {
+        int tick = 0;
+        mpz_class liquidityNet;
+        mpz_class liquidityGross;
+    };
+
+    struct PoolState {
+        mpz_class sqrtPriceX96;
+        int tick = 0;
+        mpz_class liquidity;
+        int tickSpacing = 0;
+        std::vector<InitializedTick> ticks;
+    };
+
+    // Split decoded words (decimal strings) into poolCount states, throws on a truncated or overlong stream
+    std::vector<PoolState> decode(const nlohmann::json &words, size_t poolCount);
+}
+
+#endif //UNISWAP_TICK_LENS_H
@@ -1,9 +1,12 @@
 #include "UniswapV2.h"
 
-#include <iostream>
 #include <utility>
 #include "../../../utils/Utils.h"
 #include "../../../utils/Contract.h"
+#include "UniswapEvents.h"
+#include "UniswapStorage.h"
+#include "UniswapSwap.h"
+#include "abi/UniswapV2Pair.h"
 
 using json = nlohmann::json;
 using string = std::string;
@@ -11,64 +14,233 @@ template<typename T>
 using vector = std::vector<T>;
 
 // Constructor: Initialize UniswapV2 exchange with pools and token data
-UniswapV2::UniswapV2(std::shared_ptr<Web3Client> web3Client)
-    : ExchangeBase(std::move(web3Client), "UniswapV2") {
+UniswapV2::UniswapV2(std::shared_ptr<Web3Client> web3Client, ChainConfig chainConfig)
+    : ExchangeBase(std::move(web3Client), "UniswapV2", std::move(chainConfig)), stateRead{chain.stateRead} {
     defaultFee = 0.997;
-    pools = Utils::initPools("../data/uniswapV2.txt");
+    pools = Utils::initPools(chain.dataDir + "/uniswapV2.txt", poolArena);
 
+    // Tag the initial reserves with the head observed before reading them
+    const uint64_t stateBlock = pools.empty() ? 0 : web3->getBlockNumber();
+    UniswapV2State initial;
     for (auto &pool: pools | std::views::values) {
         pool->exchange = name;
         pool->fee = defaultFee;
 
-        pool->poolContract = std::make_unique<Contract>(
-            Contract(pool->address, "../abis/uniswap_v2_pair.json"));
+        pool->poolContract = contractArena.create(pool->address, chain.abiDir + "/uniswap_v2_pair.json");
 
         string token0Adress = web3->call(*pool->poolContract, "token0")[""];
         string token1Adress = web3->call(*pool->poolContract, "token1")[""];
-        addToken(token0Adress);
-        addToken(token1Adress);
-        Token token0 = tokens[token0Adress];
-        Token token1 = tokens[token1Adress];
-
-        pool->tokens.push_back(std::make_unique<Token>(token0));
-        pool->tokens.push_back(std::make_unique<Token>(token1));
+        pool->tokens = {addToken(token0Adress), addToken(token1Adress)};
 
         json reserves = web3->call(*pool->poolContract, "getReserves");
         mpz_class reserve0(reserves["_reserve0"].get<string>());
         mpz_class reserve1(reserves["_reserve1"].get<string>());
 
-        poolsReserves[pool->address] = {reserve0, reserve1};
+        initial.pools[pool->address] = makePool({reserve0, reserve1}, *pool);
     }
+    state.publish(std::move(initial), recordReads(stateBlock));
 }
 
 // Update pool reserves using multicall for efficiency
 void UniswapV2::updatePools() {
+    ScopedTimer cycleTimer(stageHistogram("total"));
     try {
-        std::vector<CallRequest> callRequests;
-        std::vector<std::string> poolAddresses;
+        // Observe the head first so cached "latest" responses from the previous block are dropped
+        const uint64_t stateBlock = web3->getBlockNumber();
 
-        for (const auto &[address, pool]: pools) {
-            callRequests.push_back({*pool->poolContract, "getReserves", json::array()});
-            poolAddresses.push_back(address);
+        if (pools.empty()) {
+            recordCycle(0, stateBlock);
+            return;
+        }
+        // Pools the refresh tiers want this block, every pool without tiering
+        const std::vector<std::string> poolAddresses = poolsDue(stateBlock);
+        std::vector<std::array<mpz_class, 2> > read = readReserves(poolAddresses, "latest");
+
+        // Pools left out this cycle, and read ones whose reserves did not move, keep their published entry
+        const auto previous = state.read();
+        UniswapV2State next = poolAddresses.size() < pools.size() ? *previous : UniswapV2State{};
+        std::unordered_set<std::string> changed;
+        {
+            ScopedTimer decodeTimer(stageHistogram("depth"));
+            for (size_t i = 0; i < poolAddresses.size(); i++) {
+                const std::string &address = poolAddresses[i];
+                const auto before = previous->pools.find(address);
+                if (before != previous->pools.end() && before->second->reserves == read[i]) {
+                    next.pools[address] = before->second;
+                    continue;
+                }
+                changed.insert(address);
+                next.pools[address] = makePool(std::move(read[i]), *pools.at(address));
+            }
         }
+        recordRefresh(poolAddresses, changed, stateBlock);
+        // Pairs the tiers skipped hold the snapshot back to the block they are known current at
+        const uint64_t currentBlock = recordReads(poolAddresses, stateBlock);
+        publish(*previous, std::move(next), currentBlock);
+
+        recordCycle(poolAddresses.size(), currentBlock);
+    } catch (...) {
+        // The caller decides what a failed cycle means, the orchestrator counts and logs it
+        recordCycleError();
+        throw;
+    }
+}
 
-        if (callRequests.empty()) {
-            return;
+// getReserves calls or reads of the reserves slot at blockTag, decoded in the order of the addresses
+std::vector<std::array<mpz_class, 2> > UniswapV2::readReserves(const std::vector<std::string> &addresses,
+                                                               const std::string &blockTag) {
+    if (addresses.empty()) return {};
+
+    // getReserves calldata, or the reserves slot, is identical for every pair, encode it once
+    using GetReserves = abi::UniswapV2Pair::calls::getReserves;
+    const bool fromStorage = stateRead == StateRead::Storage;
+    const std::string request = fromStorage ? uniswapStorage::slotHex(uniswapStorage::V2ReservesSlot)
+                                            : GetReserves::encode();
+    std::vector<std::pair<std::string, std::string> > calls;
+    for (const auto &address: addresses) {
+        calls.emplace_back(address, request);
+    }
+
+    std::vector<std::string> results;
+    {
+        ScopedTimer timer(stageHistogram("reserves"));
+        results = fromStorage ? web3->getStorageAtBatch(calls, blockTag) : web3->multicallRaw(calls, blockTag);
+    }
+
+    ScopedTimer decodeTimer(stageHistogram("decode"));
+    std::vector<std::array<mpz_class, 2> > reserves;
+    reserves.reserve(results.size());
+    for (const std::string &result: results) {
+        if (fromStorage) {
+            reserves.push_back(uniswapStorage::decodeV2Reserves(result));
+        } else {
+            GetReserves::Result decoded = GetReserves::decode(result);
+            reserves.push_back({std::move(decoded._reserve0), std::move(decoded._reserve1)});
         }
+    }
+    return reserves;
+}
 
-        json results = web3->multicall(callRequests);
+// Diff against the snapshot being replaced, only when someone listens
+void UniswapV2::publish(const UniswapV2State &previous, UniswapV2State next, const uint64_t block) {
+    ChangeSet changes;
+    if (hasSubscribers()) {
+        changes.changes = diffStates(previous, next);
+    }
+    state.publish(std::move(next), block);
+    changes.exchange = name;
+    changes.block = block;
+    changes.version = state.version();
+    publishChanges(std::move(changes));
+}
 
-        for (size_t i = 0; i < poolAddresses.size(); i++) {
-            const auto &address = poolAddresses[i];
+// The pair's only state-changing event
+std::vector<std::string> UniswapV2::eventTopics() const {
+    return {std::string(uniswapEvents::SyncTopic)};
+}
 
-            json reserves = results["getReserves"][i];
+// Share the snapshot's pairs, then replace every synced pair with its last reserves and a new curve
+size_t UniswapV2::applyLogs(const std::vector<PoolLog> &logs, const uint64_t block) {
+    ScopedTimer timer(stageHistogram("events"));
+    const auto previous = state.read();
+    std::unordered_map<std::string, std::array<mpz_class, 2> > synced;
+    size_t applied = 0;
+    for (const PoolLog &poolLog: logs) {
+        auto reserves = uniswapEvents::decodeSync(poolLog.log);
+        if (!reserves || !pools.contains(poolLog.pool)) continue;
+        synced[poolLog.pool] = std::move(*reserves);
+        applied++;
+    }
+    UniswapV2State next = *previous;
+    for (auto &[address, reserves]: synced) {
+        next.pools[address] = makePool(std::move(reserves), *pools.at(address));
+    }
+    publish(*previous, std::move(next), recordReads(block));
+    recordCycle(synced.size(), block);
+    return applied;
+}
+
+// Read every pair at the block the state is at, so the comparison holds however far the head has moved. The diff
+// is limited to the pairs the replaced state had reserves for
+std::optional<std::vector<PoolChange> > UniswapV2::reconcile(const uint64_t block) {
+    try {
+        const auto local = state.read();
+        std::vector<std::string> addresses;
+        for (const auto &address: pools | std::views::keys) addresses.push_back(address);
+        std::vector<std::array<mpz_class, 2> > read = readReserves(addresses, Web3Client::blockTag(block));
+
+        UniswapV2State fresh;
+        UniswapV2State compared;
+        for (size_t i = 0; i < addresses.size(); i++) {
+            const std::string &address = addresses[i];
+            const auto before = local->pools.find(address);
+            auto &entry = fresh.pools[address];
+            entry = before != local->pools.end() && before->second->reserves == read[i]
+                        ? before->second
+                        : makePool(std::move(read[i]), *pools.at(address));
+            if (before != local->pools.end()) compared.pools.emplace(address, entry);
+        }
+        publish(*local, std::move(fresh), recordReads(block));
+        recordCycle(addresses.size(), block);
+        return diffStates(*local, compared);
+    } catch (...) {
+        recordCycleError();
+        throw;
+    }
+}
+
+// Forget every pair's reserves
+void UniswapV2::clearState() {
+    state.publish({}, 0);
+}
 
-            mpz_class reserve0(reserves["_reserve0"].get<std::string>());
-            mpz_class reserve1(reserves["_reserve1"].get<std::string>());
+// One constant product segment, the pool's fee multiplier turned into the fee rate
+std::shared_ptr<const UniswapV2Pool> UniswapV2::makePool(std::array<mpz_class, 2> reserves, const Pool &pool) {
+    auto depth = std::make_shared<const DepthCurve>(
+        DepthCurve::constantProduct(reserves[0].get_d(), reserves[1].get_d(), 1 - pool.fee.get_d()));
+    return std::make_shared<const UniswapV2Pool>(UniswapV2Pool{std::move(reserves), std::move(depth)});
+}
+
+// Pin the current snapshot
+SnapshotCell<UniswapV2State>::View UniswapV2::snapshot() const {
+    return state.read();
+}
+
+// Build a model per pool from one pinned snapshot
+std::vector<std::shared_ptr<const SwapPool> > UniswapV2::swapPools() const {
+    const auto current = snapshot();
+    std::vector<std::shared_ptr<const SwapPool> > models;
+    models.reserve(current->pools.size());
+    for (const auto &[address, pair]: current->pools) {
+        const auto it = pools.find(address);
+        if (it == pools.end() || !pair->depth || pair->reserves[0] == 0 || pair->reserves[1] == 0) continue;
+        auto model = std::make_shared<UniswapSwapPool>(pair->depth);
+        model->address = address;
+        model->exchange = name;
+        model->tokens = it->second->tokens;
+        model->block = current.block();
+        models.push_back(std::move(model));
+    }
+    return models;
+}
 
-            poolsReserves[address] = {reserve0, reserve1};
+// Compare reserves pool by pool, pairs both states share are equal without looking
+std::vector<PoolChange> UniswapV2::diffStates(const UniswapV2State &before, const UniswapV2State &after) {
+    std::vector<PoolChange> changes;
+    const std::array<mpz_class, 2> zero{0, 0};
+
+    for (const auto &[address, pair]: after.pools) {
+        const auto it = before.pools.find(address);
+        if (it != before.pools.end() && it->second == pair) continue;
+        const auto &previous = it == before.pools.end() ? zero : it->second->reserves;
+        if (previous != pair->reserves) {
+            changes.push_back({address, PoolChange::Kind::Reserves, 0, previous, pair->reserves});
+        }
+    }
+    for (const auto &[address, pair]: before.pools) {
+        if (!after.pools.contains(address)) {
+            changes.push_back({address, PoolChange::Kind::Reserves, 0, pair->reserves, zero});
         }
-    } catch (const std::exception &e) {
-        std::cerr << "Error updating Uniswap V2 pools: " << e.what() << std::endl;
     }
+    return changes;
 }
@@ -1,7 +1,9 @@
 #ifndef UNISWAP_V2_H
 #define UNISWAP_V2_H
 
+#include "../../DepthCurve.h"
 #include "../../ExchangeBase.h"
+#include "../../../utils/Snapshot.h"
 #include <memory>
 #include <gmpxx.h>
 #include <nlohmann/json.hpp>
@@ -9,18 +11,64 @@
 template<typename T>
 using vector = std::vector<T>;
 
+// One pair's reserves and the depth curve built from them, immutable once published
+struct UniswapV2Pool {
+    std::array<mpz_class, 2> reserves;
+    std::shared_ptr<const DepthCurve> depth;
+};
+
+// State published by one UniswapV2 update cycle
+struct UniswapV2State {
+    // Per pair. A new snapshot copies these pointers and replaces only the pairs whose reserves changed, the rest
+    // are shared with the previous one
+    std::unordered_map<std::string, std::shared_ptr<const UniswapV2Pool> > pools;
+};
+
 // UniswapV2 exchange implementation with constant product AMM
 class UniswapV2 final : public ExchangeBase {
 public:
-    explicit UniswapV2(std::shared_ptr<Web3Client> web3Client);
+    // Pools from the chain's uniswapV2.txt
+    explicit UniswapV2(std::shared_ptr<Web3Client> web3Client, ChainConfig chainConfig = {});
 
     void updatePools() override;
 
+    // Reserves that differ between two states, pools missing on one side count as zero reserves
+    static std::vector<PoolChange> diffStates(const UniswapV2State &before, const UniswapV2State &after);
+
+    // Consistent, block-tagged view of the last published reserves, safe from any thread
+    [[nodiscard]] SnapshotCell<UniswapV2State>::View snapshot() const;
+
+    // Constant product models of the snapshot's pools with non-empty reserves, over their depth curves
+    [[nodiscard]] std::vector<std::shared_ptr<const SwapPool> > swapPools() const override;
+
+    // Sync
+    [[nodiscard]] std::vector<std::string> eventTopics() const override;
 
-    std::unordered_map<std::string, std::array<mpz_class, 2> > poolsReserves;
+    // Sync logs set the reserves, the last one per pool wins
+    size_t applyLogs(const std::vector<PoolLog> &logs, uint64_t block) override;
+
+    // Read every pair at block and publish the read; returns the reserves of the pairs the replaced state held
+    // that the read disagrees with
+    std::optional<std::vector<PoolChange> > reconcile(uint64_t block) override;
+
+    void clearState() override;
+
+    SnapshotCell<UniswapV2State> state;
+
+    // getReserves calls, or reads of the packed reserves slot; starts as the chain's setting
+    StateRead stateRead;
 
 private:
     mpf_class defaultFee;
+
+    // Entry for a pair's reserves with its depth curve
+    static std::shared_ptr<const UniswapV2Pool> makePool(std::array<mpz_class, 2> reserves, const Pool &pool);
+
+    std::vector<std::array<mpz_class, 2> > readReserves(const std::vector<std::string> &addresses,
+                                                        const std::string &blockTag);
+
+    // Notify subscribers of the changes from previous when any listen, then publish next at block
+    void publish(const UniswapV2State &previous, UniswapV2State next, uint64_t block);
 };
 
 
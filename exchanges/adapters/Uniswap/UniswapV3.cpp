@@ -1,11 +1,21 @@
 #include "UniswapV3.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <sstream>
+#include <unordered_set>
 #include <utility>
 #include <gmpxx.h>
 
 #include "../../../utils/Utils.h"
 #include "../../../utils/Contract.h"
+#include "../../../utils/Metrics.h"
+#include "../../../utils/ThreadPool.h"
+#include "UniswapEvents.h"
+#include "UniswapStorage.h"
+#include "UniswapSwap.h"
+#include "UniswapTickLens.h"
 
 using json = nlohmann::json;
 using string = std::string;
@@ -13,156 +23,691 @@ template<typename T>
 using vector = std::vector<T>;
 
 // Constructor: Initialize UniswapV3 exchange with pools and token data
-UniswapV3::UniswapV3(std::shared_ptr<Web3Client> web3Client,int tickRange)
-    : ExchangeBase(std::move(web3Client), "UniswapV3"), tickRange(tickRange) {
-    pools = Utils::initPools("../data/uniswapV3.txt");
+UniswapV3::UniswapV3(std::shared_ptr<Web3Client> web3Client, int tickRange, ChainConfig chainConfig)
+    : ExchangeBase(std::move(web3Client), "UniswapV3", std::move(chainConfig)), tickRange(tickRange),
+      stateRead{chain.stateRead}, slidingTicks{chain.slidingTicks} {
+    pools = Utils::initPools(chain.dataDir + "/uniswapV3.txt", poolArena);
+    lensContract = contractArena.create(std::string(uniswapTickLens::Address),
+                                        chain.abiDir + "/uniswap_v3_tick_lens.json");
     for (auto &pool: pools | std::views::values) {
-        pool->poolContract = std::make_unique<Contract>(Contract(pool->address,
-                                                                 "../abis/uniswap_v3_pool.json"));
+        pool->poolContract = contractArena.create(pool->address, chain.abiDir + "/uniswap_v3_pool.json");
         pool->exchange = name;
         pool->fee = stod(web3->call(*pool->poolContract, "fee")[""].get<string>()) / 1e6;
 
         string token0Adress = web3->call(*pool->poolContract, "token0")[""];
         string token1Adress = web3->call(*pool->poolContract, "token1")[""];
-        addToken(token0Adress);
-        addToken(token1Adress);
-        Token token0 = tokens[token0Adress];
-        Token token1 = tokens[token1Adress];
-        pool->tokens.push_back(std::make_unique<Token>(token0));
-        pool->tokens.push_back(std::make_unique<Token>(token1));
+        pool->tokens = {addToken(token0Adress), addToken(token1Adress)};
     }
 }
 
 // Update pools with tick data using batch multicall
 void UniswapV3::updatePools() {
+    ScopedTimer cycleTimer(stageHistogram("total"));
     try {
-        // STAGE 1: Batch slot0 calls for all pools
-        std::vector<CallRequest> slot0Calls;
-        std::vector<std::string> poolAddresses;
+        // Observe the head first so cached "latest" responses from the previous block are dropped
+        const uint64_t stateBlock = web3->getBlockNumber();
 
-        for (const auto &[address, pool]: pools) {
-            slot0Calls.push_back({*pool->poolContract, "slot0", json::array()});
-            poolAddresses.push_back(address);
+        if (pools.empty()) {
+            recordCycle(0, stateBlock);
+            return;
         }
 
-        if (slot0Calls.empty()) return;
+        // Mint/Burn logs first: the pools they name are refreshed this cycle whatever their tier
+        if (slidingTicks && stateRead != StateRead::Lens) {
+            scanLiquidityEvents(stateBlock);
+        }
 
-        json slot0Results = web3->multicall(slot0Calls);
+        // Pools the refresh tiers want this block, every pool without tiering
+        const std::vector<std::string> due = poolsDue(stateBlock);
+        const auto previous = state.read();
+        PoolReads fresh;
+        if (stateRead == StateRead::Lens) {
+            // Lens reads return whole windows and scan no logs
+            slidingPools.clear();
+            if (!due.empty()) fresh = readLens(due, "latest");
+        } else if (!due.empty()) {
+            fresh = readPools(due, *previous, "latest");
+        }
 
-        // STAGE 2: Prepare tick calls based on slot0 data
-        std::vector<CallRequest> tickCalls;
-        std::map<int, std::pair<std::string, int> > tickCallToPool;
-        int tickCallIndex = 0;
+        // Changed pools get a new entry and depth curve and count towards the refresh tiers. Unchanged ones, and
+        // the pools left out this cycle, keep their published entry
+        UniswapV3State next = due.size() < pools.size() ? *previous : UniswapV3State{};
+        std::unordered_set<std::string> changed;
+        std::vector<std::string> read;
+        {
+            ScopedTimer timer(stageHistogram("depth"));
+            for (const auto &address: due) {
+                const auto it = fresh.find(address);
+                if (it == fresh.end()) continue;
+                read.push_back(address);
+                const auto before = previous->pools.find(address);
+                if (before != previous->pools.end() && !poolChanged(*before->second, it->second)) {
+                    next.pools[address] = before->second;
+                    continue;
+                }
+                changed.insert(address);
+                next.pools[address] = makePool(address, std::move(it->second));
+            }
+        }
+        recordRefresh(due, changed, stateBlock);
 
-        for (size_t i = 0; i < poolAddresses.size(); i++) {
-            const auto &address = poolAddresses[i];
-            auto &pool = *pools[address];
-            json slot0Data = slot0Results["slot0"][i];
+        // Publish, readers switch to the new snapshot atomically. Pools the tiers skipped hold it back to the
+        // block they are known current at
+        const uint64_t currentBlock = recordReads(read, stateBlock);
+        publish(*previous, std::move(next), currentBlock);
 
-            int currentTick = std::stoi(slot0Data["tick"].get<std::string>());
+        recordCycle(due.size(), currentBlock);
+    } catch (...) {
+        // Windows read this cycle may not have been published
+        slidingPools.clear();
+        recordCycleError();
+        throw;
+    }
+}
 
-            poolSqrtPriceX96[address] = slot0Data["sqrtPriceX96"].get<std::string>();
+// Diff against the snapshot being replaced, only when someone listens
+void UniswapV3::publish(const UniswapV3State &previous, UniswapV3State next, const uint64_t block) {
+    ChangeSet changes;
+    if (hasSubscribers()) {
+        changes.changes = diffStates(previous, next);
+    }
+    state.publish(std::move(next), block);
+    changes.exchange = name;
+    changes.block = block;
+    changes.version = state.version();
+    publishChanges(std::move(changes));
+}
 
-            // Get tickSpacing for this pool
-            int tickSpacing;
-            if (pool.fee == 0.0001) tickSpacing = 1;
-            else if (pool.fee == 0.0005) tickSpacing = 10;
-            else if (pool.fee == 0.003) tickSpacing = 60;
-            else if (pool.fee == 0.01) tickSpacing = 200;
-            else {
-                std::cerr << "Unknown fee tier: " << pool.fee << " for pool " << address << std::endl;
-                tickSpacing = 60;
+// Every pool event that changes what the adapter holds
+std::vector<std::string> UniswapV3::eventTopics() const {
+    return {std::string(uniswapEvents::InitializeTopic), std::string(uniswapEvents::SwapTopic),
+            std::string(uniswapEvents::MintTopic), std::string(uniswapEvents::BurnTopic)};
+}
+
+// Share the snapshot's pools, apply the events in order to working copies of the pools they name, then publish
+// those with new depth curves
+size_t UniswapV3::applyLogs(const std::vector<PoolLog> &logs, const uint64_t block) {
+    ScopedTimer timer(stageHistogram("events"));
+    const auto previous = state.read();
+    PoolReads touched;
+    size_t applied = 0;
+
+    // A pool's working copy, taken from the snapshot on first use
+    const auto working = [&](const std::string &address) -> UniswapV3Pool * {
+        if (const auto it = touched.find(address); it != touched.end()) return &it->second;
+        const auto published = previous->pools.find(address);
+        if (published == previous->pools.end()) return nullptr;
+        return &touched.emplace(address, *published->second).first->second;
+    };
+
+    // Liquidity delta at one end of a position; a tick whose gross liquidity reaches zero is uninitialized
+    const auto moveTick = [](UniswapV3Pool &pool, const int tick, const mpz_class &net, const mpz_class &gross) {
+        if (!pool.tickWindow || tick < pool.tickWindow->first || tick > pool.tickWindow->second) return;
+        const auto it = pool.ticks.try_emplace(tick, Tick{{mpf_class(0, TickPrecision),
+                                                           mpf_class(0, TickPrecision)}}).first;
+        it->second.liquidity[0] += mpf_class(net, TickPrecision);
+        it->second.liquidity[1] += mpf_class(gross, TickPrecision);
+        if (it->second.liquidity[1] == 0) pool.ticks.erase(it);
+    };
+
+    for (const PoolLog &poolLog: logs) {
+        const std::string &address = poolLog.pool;
+        if (!pools.contains(address)) continue;
+        if (const auto price = uniswapEvents::decodePrice(poolLog.log)) {
+            UniswapV3Pool *pool = working(address);
+            if (!pool) pool = &touched[address];
+            pool->sqrtPriceX96 = price->sqrtPriceX96.get_str();
+            pool->liquidity = price->liquidity.get_str();
+            pool->tick = price->tick;
+            // A new pool has no initialized ticks, so from here on its whole range is known
+            if (uniswapEvents::topic0(poolLog.log) == uniswapEvents::InitializeTopic) {
+                pool->tickWindow = {-887272, 887272};
+                pool->ticks.clear();
+            }
+        } else if (const auto event = uniswapEvents::decodeLiquidity(poolLog.log)) {
+            // Nothing is known of a pool without a price yet
+            if (UniswapV3Pool *pool = working(address)) {
+                moveTick(*pool, event->tickLower, event->amount, event->amount);
+                moveTick(*pool, event->tickUpper, -event->amount, event->amount);
+                if (event->tickLower <= pool->tick && pool->tick < event->tickUpper) {
+                    const mpz_class liquidity = mpz_class(pool->liquidity) + event->amount;
+                    pool->liquidity = liquidity.get_str();
+                }
             }
+        } else {
+            continue;
+        }
+        applied++;
+    }
 
-            // Align current tick to tick spacing boundary
-            int alignedTick;
-            if (currentTick >= 0) {
-                alignedTick = (currentTick / tickSpacing) * tickSpacing;
-            } else {
-                alignedTick = ((currentTick - tickSpacing + 1) / tickSpacing) * tickSpacing;
+    UniswapV3State next = *previous;
+    for (auto &[address, pool]: touched) {
+        next.pools[address] = makePool(address, std::move(pool));
+    }
+    publish(*previous, std::move(next), recordReads(block));
+    recordCycle(touched.size(), block);
+    return applied;
+}
+
+// Read whole windows at the block the state is at, so the comparison holds however far the head has moved
+std::optional<std::vector<PoolChange> > UniswapV3::reconcile(const uint64_t block) {
+    ScopedTimer cycleTimer(stageHistogram("total"));
+    try {
+        const auto local = state.read();
+        std::vector<std::string> addresses;
+        for (const auto &address: pools | std::views::keys) addresses.push_back(address);
+        const std::string blockTag = Web3Client::blockTag(block);
+        PoolReads read = stateRead == StateRead::Lens ? readLens(addresses, blockTag)
+                                                      : readPools(addresses, {}, blockTag);
+        // The next cycle reads whole windows again rather than slide from ones read at an older block
+        slidingPools.clear();
+        UniswapV3State fresh;
+        for (auto &[address, pool]: read) {
+            const auto before = local->pools.find(address);
+            fresh.pools[address] = before != local->pools.end() && !poolChanged(*before->second, pool)
+                                       ? before->second
+                                       : makePool(address, std::move(pool));
+        }
+
+        std::vector<PoolChange> drift = compareRead(*local, fresh);
+        publish(*local, std::move(fresh), recordReads(block));
+        recordCycle(addresses.size(), block);
+        return drift;
+    } catch (...) {
+        recordCycleError();
+        throw;
+    }
+}
+
+// Restrict both states to the pools the replaced one priced and to the ticks inside both windows, then diff
+std::vector<PoolChange> UniswapV3::compareRead(const UniswapV3State &local, const UniswapV3State &fresh) {
+    UniswapV3State before, after;
+    for (const auto &[address, localPool]: local.pools) {
+        const auto freshPool = fresh.pools.find(address);
+        if (freshPool == fresh.pools.end()) continue;
+        UniswapV3Pool kept{localPool->sqrtPriceX96, localPool->tick, localPool->liquidity, {}, {}, nullptr};
+        UniswapV3Pool read{freshPool->second->sqrtPriceX96, freshPool->second->tick, freshPool->second->liquidity,
+                           {}, {}, nullptr};
+
+        const auto &localWindow = localPool->tickWindow;
+        const auto &freshWindow = freshPool->second->tickWindow;
+        if (localWindow && freshWindow) {
+            const std::pair common{std::max(localWindow->first, freshWindow->first),
+                                   std::min(localWindow->second, freshWindow->second)};
+            read.tickWindow = common;
+            const auto copyTicks = [&common](const UniswapV3Pool &from, UniswapV3Pool &to) {
+                for (const auto &[tick, data]: from.ticks) {
+                    if (tick >= common.first && tick <= common.second) to.ticks.emplace(tick, data);
+                }
+            };
+            copyTicks(*localPool, kept);
+            copyTicks(*freshPool->second, read);
+        }
+        before.pools[address] = std::make_shared<const UniswapV3Pool>(std::move(kept));
+        after.pools[address] = std::make_shared<const UniswapV3Pool>(std::move(read));
+    }
+    return diffStates(before, after);
+}
+
+// Forget every pool, and the windows the sliding reads would build on
+void UniswapV3::clearState() {
+    slidingPools.clear();
+    touchedTicks.clear();
+    state.publish({}, 0);
+}
+
+// Read slot0 and the ticks around it per pool, through calls or storage slots. Sliding pools read only the ticks
+// their window gained and the ones liquidity events touched, and keep the rest from the previous snapshot
+UniswapV3::PoolReads UniswapV3::readPools(const std::vector<std::string> &poolAddresses,
+                                          const UniswapV3State &previous, const std::string &blockTag) {
+    const bool fromStorage = stateRead == StateRead::Storage;
+    if (!slidingTicks) {
+        slidingPools.clear();
+    }
+    if (poolAddresses.empty()) return {};
+
+    // STAGE 1: Batch slot0 and liquidity calls, or slot 0 and 4 reads, for the pools
+    std::vector<int> currentTicks;
+    std::vector<std::string> sqrtPrices;
+    std::vector<std::string> liquidities;
+    {
+        ScopedTimer timer(stageHistogram("slot0"));
+        if (fromStorage) {
+            std::vector<std::pair<std::string, std::string> > slots;
+            for (const auto &address: poolAddresses) {
+                slots.emplace_back(address, uniswapStorage::slotHex(uniswapStorage::V3Slot0Slot));
+                slots.emplace_back(address, uniswapStorage::slotHex(uniswapStorage::V3LiquiditySlot));
+            }
+            const std::vector<std::string> words = web3->getStorageAtBatch(slots, blockTag);
+            for (size_t i = 0; i < words.size(); i += 2) {
+                const uniswapStorage::V3Slot0 slot0 = uniswapStorage::decodeV3Slot0(words[i]);
+                currentTicks.push_back(slot0.tick);
+                sqrtPrices.push_back(slot0.sqrtPriceX96.get_str());
+                liquidities.push_back(uniswapStorage::field(words[i + 1], 0, 128).get_str());
             }
+        } else {
+            std::vector<CallRequest> slot0Calls;
+            for (const auto &address: poolAddresses) {
+                slot0Calls.push_back({*pools[address]->poolContract, "slot0", json::array()});
+                slot0Calls.push_back({*pools[address]->poolContract, "liquidity", json::array()});
+            }
+            const json slot0Results = web3->multicall(slot0Calls, blockTag);
+            for (const auto &slot0Data: slot0Results["slot0"]) {
+                currentTicks.push_back(std::stoi(slot0Data["tick"].get<std::string>()));
+                sqrtPrices.push_back(slot0Data["sqrtPriceX96"].get<std::string>());
+            }
+            for (const auto &liquidityData: slot0Results["liquidity"]) {
+                liquidities.push_back(liquidityData[""].get<std::string>());
+            }
+        }
+    }
+
+    PoolReads next;
+
+    // STAGE 2: Prepare tick calls (or tick mapping slots) based on slot0 data
+    std::vector<CallRequest> tickCalls;
+    std::vector<std::pair<std::string, std::string> > tickSlots;
+    std::vector<std::pair<std::string, int> > tickCallToPool;
+    std::unordered_map<std::string, std::unordered_map<int, Tick> > keptTicks;
+
+    for (size_t i = 0; i < poolAddresses.size(); i++) {
+        const auto &address = poolAddresses[i];
+        auto &pool = *pools[address];
+
+        int currentTick = currentTicks[i];
+
+        UniswapV3Pool &read = next[address];
+        read.sqrtPriceX96 = sqrtPrices[i];
+        read.tick = currentTick;
+        read.liquidity = liquidities[i];
+
+        // Get tickSpacing for this pool
+        int tickSpacing;
+        if (pool.fee == 0.0001) tickSpacing = 1;
+        else if (pool.fee == 0.0005) tickSpacing = 10;
+        else if (pool.fee == 0.003) tickSpacing = 60;
+        else if (pool.fee == 0.01) tickSpacing = 200;
+        else {
+            std::cerr << "Unknown fee tier: " << pool.fee << " for pool " << address << std::endl;
+            tickSpacing = 60;
+        }
 
-            // Calculate range around current price
-            int minTick = std::max(-887272, alignedTick - tickRange * tickSpacing);
-            int maxTick = std::min(887272, alignedTick + tickRange * tickSpacing);
+        // Align current tick to tick spacing boundary
+        int alignedTick;
+        if (currentTick >= 0) {
+            alignedTick = (currentTick / tickSpacing) * tickSpacing;
+        } else {
+            alignedTick = ((currentTick - tickSpacing + 1) / tickSpacing) * tickSpacing;
+        }
+
+        // Calculate range around current price
+        int minTick = std::max(-887272, alignedTick - tickRange * tickSpacing);
+        int maxTick = std::min(887272, alignedTick + tickRange * tickSpacing);
+
+        read.tickWindow = {minTick, maxTick};
 
-            // Generate tick calls
-            for (int tick = minTick; tick <= maxTick; tick += tickSpacing) {
+        // A window on the same spacing grid as the published one only needs the ticks it gained and the touched
+        // ones; untouched ticks it still covers are kept
+        std::pair<int, int> known{1, 0};
+        const auto published = previous.pools.find(address);
+        if (slidingPools.contains(address) && published != previous.pools.end() && published->second->tickWindow &&
+            (published->second->tickWindow->first - minTick) % tickSpacing == 0) {
+            known = *published->second->tickWindow;
+        }
+        const auto touched = touchedTicks.find(address);
+        const auto keep = [&](const int tick) {
+            return tick >= known.first && tick <= known.second &&
+                   (touched == touchedTicks.end() || !touched->second.contains(tick));
+        };
+        if (known.first <= known.second) {
+            for (const auto &[tick, data]: published->second->ticks) {
+                if (tick >= minTick && tick <= maxTick && keep(tick)) keptTicks[address].emplace(tick, data);
+            }
+        }
+
+        // Generate tick calls
+        for (int tick = minTick; tick <= maxTick; tick += tickSpacing) {
+            if (keep(tick)) continue;
+            if (fromStorage) {
+                tickSlots.emplace_back(address, uniswapStorage::mappingSlot(tick, uniswapStorage::V3TicksSlot));
+            } else {
                 tickCalls.push_back({*pool.poolContract, "ticks", json::array({tick})});
-                tickCallToPool[tickCallIndex++] = {address, tick};
             }
+            tickCallToPool.emplace_back(address, tick);
         }
+    }
 
-        if (tickCalls.empty()) return;
-
-        // STAGE 3: Execute tick multicall
-        json tickResults = web3->multicall(tickCalls);
-
-        // STAGE 4: Process results and update pools
-        for (const auto &address: pools | std::views::keys) {
-            std::unordered_map<int, Tick> poolTicks;
-
-            for (int i = 0; i < tickCallIndex; i++) {
-                auto [poolAddr, tick] = tickCallToPool[i];
-                if (poolAddr == address) {
-                    json tickData = tickResults["ticks"][i];
-
-                    if (tickData.is_null() || tickData.empty()) continue;
-
-                    try {
-                        std::string liquidityNetStr = tickData["liquidityNet"].get<std::string>();
-                        std::string liquidityGrossStr = tickData["liquidityGross"].get<std::string>();
-
-                        if (liquidityNetStr == "0x0" && liquidityGrossStr == "0x0") continue;
-
-                        mpf_class liquidityNetValue = 0;
-                        mpf_class liquidityGrossValue = 0;
-
-                        // Remove "0x" prefix
-                        if (liquidityNetStr.substr(0, 2) == "0x") {
-                            liquidityNetStr = liquidityNetStr.substr(2);
-                        }
-                        if (liquidityGrossStr.substr(0, 2) == "0x") {
-                            liquidityGrossStr = liquidityGrossStr.substr(2);
-                        }
-
-                        // Handle negative values for liquidityNet
-                        bool isNegative = false;
-                        if (!liquidityNetStr.empty() && liquidityNetStr[0] == '-') {
-                            isNegative = true;
-                            liquidityNetStr = liquidityNetStr.substr(1);
-                        }
-
-                        // Convert hex strings using GMP
-                        try {
-                            mpz_class netValueMpz;
-                            netValueMpz.set_str(liquidityNetStr, 16);
-                            liquidityNetValue = mpf_class(netValueMpz);
-                            if (isNegative) liquidityNetValue = -liquidityNetValue;
-
-                            mpz_class grossValueMpz;
-                            grossValueMpz.set_str(liquidityGrossStr, 16);
-                            liquidityGrossValue = mpf_class(grossValueMpz);
-                        } catch (const std::exception &e) {
-                            std::cerr << "Error converting liquidity values: " << e.what() << std::endl;
-                        }
-
-                        // Create and store Tick
-                        Tick tickObj;
-                        tickObj.liquidity[0] = liquidityNetValue;
-                        tickObj.liquidity[1] = liquidityGrossValue;
-                        poolTicks[tick] = tickObj;
-                    } catch (const std::exception &e) {
-                        std::cerr << "Error processing tick " << tick << " for pool " << poolAddr << ": " << e.what() <<
-                                std::endl;
-                        continue;
-                    }
-                }
+    // STAGE 3: Fetch and decode tick batches. Run from an orchestrator worker, each batch is a task,
+    // so decoding one batch overlaps the network wait of the others
+    using TicksByPool = std::unordered_map<std::string, std::unordered_map<int, Tick> >;
+    const auto fetchBatch = [&](const size_t begin, const size_t end) {
+        const std::vector<std::pair<std::string, int> > batchToPool(tickCallToPool.begin() + begin,
+                                                                     tickCallToPool.begin() + end);
+        if (fromStorage) {
+            const std::vector<std::pair<std::string, std::string> > slots(tickSlots.begin() + begin,
+                                                                         tickSlots.begin() + end);
+            std::vector<std::string> words;
+            {
+                ScopedTimer timer(stageHistogram("ticks"));
+                words = web3->getStorageAtBatch(slots, blockTag);
             }
+            ScopedTimer decodeTimer(stageHistogram("decode"));
+            return processTickWords(words, batchToPool);
+        }
+        std::vector<CallRequest> batch(tickCalls.begin() + begin, tickCalls.begin() + end);
+        json tickResults;
+        {
+            ScopedTimer timer(stageHistogram("ticks"));
+            tickResults = web3->multicall(batch, blockTag);
+        }
+        ScopedTimer decodeTimer(stageHistogram("decode"));
+        return processTickResults(tickResults, batchToPool);
+    };
+
+    TicksByPool decodedTicks;
+    const auto merge = [&decodedTicks](TicksByPool batchTicks) {
+        for (auto &[address, ticks]: batchTicks) {
+            decodedTicks[address].merge(ticks);
+        }
+    };
+
+    const size_t batchSize = std::max<size_t>(tickBatchSize, 1);
+    ThreadPool *threadPool = ThreadPool::current();
+    std::vector<std::future<TicksByPool> > pending;
+    for (size_t begin = 0; begin < tickCallToPool.size(); begin += batchSize) {
+        const size_t end = std::min(begin + batchSize, tickCallToPool.size());
+        if (threadPool) {
+            pending.push_back(submitTask([&fetchBatch, begin, end] { return fetchBatch(begin, end); }));
+        } else {
+            merge(fetchBatch(begin, end));
+        }
+    }
+    // Await every batch before rethrowing, the tasks reference this frame
+    std::exception_ptr batchError;
+    for (auto &future: pending) {
+        try {
+            merge(threadPool->await(future));
+        } catch (...) {
+            if (!batchError) batchError = std::current_exception();
+        }
+    }
+    if (batchError) {
+        std::rethrow_exception(batchError);
+    }
+
+    Metrics::instance().counter("deds_v3_ticks_read_total", labels(), "Tick words or calls read by UniswapV3")
+            .inc(tickCallToPool.size());
+
+    for (const auto &address: poolAddresses) {
+        auto &ticks = next[address].ticks;
+        ticks = std::move(decodedTicks[address]);
+        ticks.merge(keptTicks[address]);
+        touchedTicks.erase(address);
+        if (slidingTicks) slidingPools.insert(address);
+    }
+    return next;
+}
+
+// eth_getLogs over the sliding pools' addresses, logPoolsPerCall per request
+void UniswapV3::scanLiquidityEvents(const uint64_t block) {
+    if (block <= logsBlock || slidingPools.empty()) {
+        // A head behind the scanned block is a reorg, the windows may hold ticks from the dropped blocks
+        if (block < logsBlock) slidingPools.clear();
+        logsBlock = block;
+        return;
+    }
 
-            poolsReserves[address] = poolTicks;
+    std::unordered_map<std::string, std::string> byLowercase;
+    std::vector<std::string> addresses;
+    for (const auto &address: slidingPools) {
+        std::string lower = address;
+        std::ranges::transform(lower, lower.begin(), [](const unsigned char c) { return std::tolower(c); });
+        byLowercase.emplace(lower, address);
+        addresses.push_back(std::move(lower));
+    }
+    const auto hexQuantity = [](const uint64_t value) {
+        std::ostringstream out;
+        out << "0x" << std::hex << value;
+        return out.str();
+    };
+
+    try {
+        ScopedTimer timer(stageHistogram("logs"));
+        std::vector<std::string> moved;
+        const size_t perCall = std::max<size_t>(logPoolsPerCall, 1);
+        for (size_t begin = 0; begin < addresses.size(); begin += perCall) {
+            const size_t end = std::min(begin + perCall, addresses.size());
+            const json filter = {
+                {"fromBlock", hexQuantity(logsBlock + 1)}, {"toBlock", hexQuantity(block)},
+                {"address", std::vector<std::string>(addresses.begin() + static_cast<std::ptrdiff_t>(begin),
+                                                     addresses.begin() + static_cast<std::ptrdiff_t>(end))},
+                {"topics", json::array({json::array({std::string(uniswapEvents::MintTopic),
+                                                     std::string(uniswapEvents::BurnTopic)})})}
+            };
+            for (const json &log: web3->sendRpcRequest("eth_getLogs", json::array({filter}))) {
+                const auto event = uniswapEvents::decodeLiquidity(log);
+                if (!event) continue;
+                const auto pool = byLowercase.find(event->pool);
+                if (pool == byLowercase.end()) continue;
+                touchedTicks[pool->second].insert({event->tickLower, event->tickUpper});
+                moved.push_back(pool->second);
+            }
         }
+        refreshScheduler.touch(moved);
     } catch (const std::exception &e) {
-        std::cerr << "Error in updatePools batch operation: " << e.what() << std::endl;
+        std::cerr << "Error fetching liquidity events, re-reading tick windows: " << e.what() << std::endl;
+        slidingPools.clear();
+    }
+    logsBlock = block;
+}
+
+// Read the pools through the tick lens, lensPoolsPerCall pools per eth_call
+UniswapV3::PoolReads UniswapV3::readLens(const std::vector<std::string> &poolAddresses, const std::string &blockTag) {
+    const size_t perCall = std::max<size_t>(lensPoolsPerCall, 1);
+    std::vector<std::pair<std::string, std::string> > calls;
+    for (size_t begin = 0; begin < poolAddresses.size(); begin += perCall) {
+        const size_t end = std::min(begin + perCall, poolAddresses.size());
+        const json group = std::vector<std::string>(poolAddresses.begin() + static_cast<std::ptrdiff_t>(begin),
+                                                    poolAddresses.begin() + static_cast<std::ptrdiff_t>(end));
+        calls.emplace_back(lensContract->address,
+                           lensContract->encodeFunction("getPoolStates", json::array({group, tickRange})));
+    }
+
+    std::vector<std::string> results;
+    {
+        ScopedTimer timer(stageHistogram("lens"));
+        results = web3->multicallRawOverride(calls, uniswapTickLens::stateOverride(), blockTag);
+    }
+
+    ScopedTimer decodeTimer(stageHistogram("decode"));
+    PoolReads next;
+    for (size_t call = 0; call < results.size(); call++) {
+        const size_t begin = call * perCall;
+        const size_t count = std::min(perCall, poolAddresses.size() - begin);
+        const json words = lensContract->decodeResponse(results[call], "getPoolStates")["words"];
+        std::vector<uniswapTickLens::PoolState> states = uniswapTickLens::decode(words, count);
+
+        for (size_t i = 0; i < count; i++) {
+            const std::string &address = poolAddresses[begin + i];
+            const uniswapTickLens::PoolState &poolState = states[i];
+            UniswapV3Pool &read = next[address];
+            read.sqrtPriceX96 = poolState.sqrtPriceX96.get_str();
+            read.tick = poolState.tick;
+            read.liquidity = poolState.liquidity.get_str();
+
+            // Same window as the per-tick path, from the pool's own tick spacing
+            const int spacing = poolState.tickSpacing;
+            if (spacing <= 0) {
+                throw std::runtime_error{"Tick lens returned spacing " + std::to_string(spacing) + " for " + address};
+            }
+            const int compressed = poolState.tick / spacing - (poolState.tick % spacing < 0 ? 1 : 0);
+            read.tickWindow = {std::max(-887272, (compressed - tickRange) * spacing),
+                               std::min(887272, (compressed + tickRange) * spacing)};
+
+            for (const uniswapTickLens::InitializedTick &tick: poolState.ticks) {
+                read.ticks.emplace(tick.tick, Tick{{mpf_class(tick.liquidityNet, TickPrecision),
+                                               mpf_class(tick.liquidityGross, TickPrecision)}});
+            }
+        }
+    }
+    return next;
+}
+
+// Compare one pool's price, liquidity, window and ticks
+bool UniswapV3::poolChanged(const UniswapV3Pool &before, const UniswapV3Pool &after) {
+    if (before.sqrtPriceX96 != after.sqrtPriceX96 || before.tick != after.tick || before.liquidity != after.liquidity ||
+        before.tickWindow != after.tickWindow || before.ticks.size() != after.ticks.size()) {
+        return true;
+    }
+    for (const auto &[tick, value]: after.ticks) {
+        const auto it = before.ticks.find(tick);
+        if (it == before.ticks.end() || it->second.liquidity != value.liquidity) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Convert the pool's exact state to doubles once, ticks sorted for the walk
+std::shared_ptr<const UniswapV3Pool> UniswapV3::makePool(const std::string &address, UniswapV3Pool pool) const {
+    std::vector<std::pair<int, double> > ticks;
+    ticks.reserve(pool.ticks.size());
+    for (const auto &[index, data]: pool.ticks) {
+        ticks.emplace_back(index, data.liquidity[0].get_d());
     }
+    std::ranges::sort(ticks);
+    pool.depth = std::make_shared<const DepthCurve>(DepthCurve::concentrated(
+        std::ldexp(mpz_class(pool.sqrtPriceX96).get_d(), -96), pool.tick, mpz_class(pool.liquidity).get_d(), ticks,
+        pool.tickWindow.value_or(std::pair{0, 0}), pools.at(address)->fee.get_d()));
+    return std::make_shared<const UniswapV3Pool>(std::move(pool));
+}
+
+// Pin the current snapshot
+SnapshotCell<UniswapV3State>::View UniswapV3::snapshot() const {
+    return state.read();
+}
+
+// Build a model per pool from one pinned snapshot
+std::vector<std::shared_ptr<const SwapPool> > UniswapV3::swapPools() const {
+    const auto current = snapshot();
+    std::vector<std::shared_ptr<const SwapPool> > models;
+    models.reserve(current->pools.size());
+    for (const auto &[address, pool]: current->pools) {
+        const auto it = pools.find(address);
+        if (it == pools.end() || !pool->depth || !pool->tickWindow || pool->depth->sqrtPrice <= 0) continue;
+        auto model = std::make_shared<UniswapSwapPool>(pool->depth);
+        model->address = address;
+        model->exchange = name;
+        model->tokens = it->second->tokens;
+        model->block = current.block();
+        models.push_back(std::move(model));
+    }
+    return models;
+}
+
+// Compare sqrtPrice per pool, then tick liquidity per (pool, tick) over the union of both tick sets. Pools both
+// states share are equal without looking
+std::vector<PoolChange> UniswapV3::diffStates(const UniswapV3State &before, const UniswapV3State &after) {
+    std::vector<PoolChange> changes;
+    const mpz_class zero = 0;
+    const UniswapV3Pool missing;
+
+    const auto compare = [&](const std::string &address, const UniswapV3Pool &previousPool,
+                             const UniswapV3Pool &currentPool) {
+        const mpz_class previousPrice(previousPool.sqrtPriceX96, 10);
+        const mpz_class currentPrice(currentPool.sqrtPriceX96, 10);
+        if (previousPrice != currentPrice) {
+            changes.push_back({address, PoolChange::Kind::SqrtPrice, 0, {previousPrice, mpz_class(previousPool.tick)},
+                               {currentPrice, mpz_class(currentPool.tick)}});
+        }
+        const mpz_class previousLiquidity(previousPool.liquidity, 10);
+        const mpz_class currentLiquidity(currentPool.liquidity, 10);
+        if (previousLiquidity != currentLiquidity) {
+            changes.push_back({address, PoolChange::Kind::Liquidity, 0, {previousLiquidity, zero},
+                               {currentLiquidity, zero}});
+        }
+
+        const auto liquidityOf = [&zero](const std::unordered_map<int, Tick> &ticks, const int tick) {
+            const auto it = ticks.find(tick);
+            if (it == ticks.end()) return std::array<mpz_class, 2>{zero, zero};
+            return std::array<mpz_class, 2>{mpz_class(it->second.liquidity[0]), mpz_class(it->second.liquidity[1])};
+        };
+        const auto compareTick = [&](const int tick) {
+            std::array<mpz_class, 2> previous = liquidityOf(previousPool.ticks, tick);
+            std::array<mpz_class, 2> current = liquidityOf(currentPool.ticks, tick);
+            if (previous != current) {
+                changes.push_back({address, PoolChange::Kind::TickLiquidity, tick, previous, current});
+            }
+        };
+        for (const int tick: currentPool.ticks | std::views::keys) compareTick(tick);
+        const auto &window = currentPool.tickWindow;
+        for (const int tick: previousPool.ticks | std::views::keys) {
+            const bool inWindow = window && tick >= window->first && tick <= window->second;
+            if (!currentPool.ticks.contains(tick) && inWindow) compareTick(tick);
+        }
+    };
+
+    for (const auto &[address, pool]: after.pools) {
+        const auto it = before.pools.find(address);
+        if (it == before.pools.end()) {
+            compare(address, missing, *pool);
+        } else if (it->second != pool) {
+            compare(address, *it->second, *pool);
+        }
+    }
+    for (const auto &[address, pool]: before.pools) {
+        if (!after.pools.contains(address)) compare(address, *pool, missing);
+    }
+    return changes;
+}
+
+// Decode tick mapping words, grouped by pool, skipping uninitialized ticks
+std::unordered_map<std::string, std::unordered_map<int, Tick> > UniswapV3::processTickWords(
+    const std::vector<std::string> &words, const std::vector<std::pair<std::string, int> > &tickCallToPool) {
+    std::unordered_map<std::string, std::unordered_map<int, Tick> > result;
+
+    for (size_t i = 0; i < tickCallToPool.size(); i++) {
+        const auto &[poolAddr, tick] = tickCallToPool[i];
+        const auto [liquidityNet, liquidityGross] = uniswapStorage::decodeV3TickLiquidity(words[i]);
+        if (liquidityNet == 0 && liquidityGross == 0) continue;
+
+        result[poolAddr].emplace(tick, Tick{{mpf_class(liquidityNet, TickPrecision),
+                                             mpf_class(liquidityGross, TickPrecision)}});
+    }
+
+    return result;
+}
+
+// Decode tick sub-call results, grouped by pool, skipping uninitialized ticks
+std::unordered_map<std::string, std::unordered_map<int, Tick> > UniswapV3::processTickResults(
+    const json &tickResults, const std::vector<std::pair<std::string, int> > &tickCallToPool) {
+    std::unordered_map<std::string, std::unordered_map<int, Tick> > result;
+
+    for (size_t i = 0; i < tickCallToPool.size(); i++) {
+        const auto &[poolAddr, tick] = tickCallToPool[i];
+        json tickData = tickResults["ticks"][i];
+
+        if (tickData.is_null() || tickData.empty()) continue;
+
+        try {
+            // Contract::decodeInt/decodeUint return decimal strings, an uninitialized tick decodes to zeros
+            const std::string liquidityNetStr = tickData["liquidityNet"].get<std::string>();
+            const std::string liquidityGrossStr = tickData["liquidityGross"].get<std::string>();
+
+            if (liquidityNetStr == "0" && liquidityGrossStr == "0") continue;
+
+            // liquidityGross is a uint128, keep enough precision to hold it exactly. Construct in place:
+            // assigning into a default mpf_class would round to its 64-bit precision
+            mpf_class liquidityNetValue(mpz_class(liquidityNetStr, 10), TickPrecision);
+            mpf_class liquidityGrossValue(mpz_class(liquidityGrossStr, 10), TickPrecision);
+
+            result[poolAddr].emplace(tick, Tick{{liquidityNetValue, liquidityGrossValue}});
+        } catch (const std::exception &e) {
+            std::cerr << "Error processing tick " << tick << " for pool " << poolAddr << ": " << e.what() <<
+                    std::endl;
+            continue;
+        }
+    }
+
+    return result;
 }
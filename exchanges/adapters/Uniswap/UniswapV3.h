@@ -1,34 +1,149 @@
 #ifndef UNISWAP_V3_H
 #define UNISWAP_V3_H
 
+#include "../../DepthCurve.h"
 #include "../../ExchangeBase.h"
+#include "../../../utils/Snapshot.h"
 #include <memory>
+#include <optional>
+#include <unordered_set>
 
 #include <nlohmann/json.hpp>
 
 template<typename T>
 using vector = std::vector<T>;
 
-// Tick structure for UniswapV3 concentrated liquidity
+// Tick structure for UniswapV3 concentrated liquidity: liquidity[0] is liquidityNet, liquidity[1] liquidityGross
 struct Tick {
     std::array<mpf_class, 2> liquidity;
 };
 
+// Bits of mpf precision for tick liquidity, enough for an exact uint128
+constexpr mp_bitcnt_t TickPrecision = 160;
+
+// One pool's slot0, in-range liquidity and ticks with the depth curve built from them, immutable once published
+struct UniswapV3Pool {
+    // slot0 sqrtPriceX96, decimal string
+    std::string sqrtPriceX96{"0"};
+
+    // slot0 tick
+    int tick = 0;
+
+    // In-range liquidity, decimal string
+    std::string liquidity{"0"};
+
+    // Inclusive [minTick, maxTick] range fetched, ticks outside it are unknown rather than empty; none until read
+    std::optional<std::pair<int, int> > tickWindow;
+
+    // Initialized ticks inside the window
+    std::unordered_map<int, Tick> ticks;
+
+    std::shared_ptr<const DepthCurve> depth;
+};
+
+// State published by one UniswapV3 update cycle
+struct UniswapV3State {
+    // Per pool. A new snapshot copies these pointers and replaces only the pools that changed, the rest are shared
+    // with the previous one
+    std::unordered_map<std::string, std::shared_ptr<const UniswapV3Pool> > pools;
+};
+
 // UniswapV3 exchange implementation with concentrated liquidity
 class UniswapV3 : public ExchangeBase {
 public:
-    explicit UniswapV3(std::shared_ptr<Web3Client> web3Client, int tickRange);
+    // Pools from the chain's uniswapV3.txt
+    explicit UniswapV3(std::shared_ptr<Web3Client> web3Client, int tickRange, ChainConfig chainConfig = {});
 
     // Implement abstract methods
     void updatePools() override;
 
-    std::unordered_map<std::string, std::unordered_map<int, Tick> > poolsReserves;
+    // Decode ticks(int24) results, tickCallToPool maps each sub-call to its (pool, tick)
+    static std::unordered_map<std::string, std::unordered_map<int, Tick> > processTickResults(
+        const json &tickResults, const std::vector<std::pair<std::string, int> > &tickCallToPool);
+
+    // Same for storage words of the ticks mapping, one per (pool, tick)
+    static std::unordered_map<std::string, std::unordered_map<int, Tick> > processTickWords(
+        const std::vector<std::string> &words, const std::vector<std::pair<std::string, int> > &tickCallToPool);
+
+    // sqrtPrice, in-range liquidity and tick liquidity that differ between two states, missing values count as zero
+    // A tick that left the fetched window is not reported as removed
+    static std::vector<PoolChange> diffStates(const UniswapV3State &before, const UniswapV3State &after);
+
+    // Whether a pool's price, liquidity, tick window or tick liquidity differs, for the refresh tiers
+    static bool poolChanged(const UniswapV3Pool &before, const UniswapV3Pool &after);
+
+    // Consistent, block-tagged view of the last published ticks and prices, safe from any thread
+    [[nodiscard]] SnapshotCell<UniswapV3State>::View snapshot() const;
+
+    // Models of the snapshot's pools with a price over their depth curves, limited to their fetched tick windows
+    [[nodiscard]] std::vector<std::shared_ptr<const SwapPool> > swapPools() const override;
+
+    // Initialize, Swap, Mint and Burn
+    [[nodiscard]] std::vector<std::string> eventTopics() const override;
+
+    // Swap sets the price, tick and in-range liquidity; Mint and Burn move the liquidity of their two ticks when
+    // inside the known window, and the in-range liquidity when the position spans the current tick. Initialize
+    // starts a pool with every tick known
+    size_t applyLogs(const std::vector<PoolLog> &logs, uint64_t block) override;
 
-    // Store slot0 data for each pool
-    std::unordered_map<std::string, std::string> poolSqrtPriceX96;
+    // Read every pool at block and publish the read; returns the prices, in-range liquidity and the ticks both
+    // windows cover that the read disagrees with
+    std::optional<std::vector<PoolChange> > reconcile(uint64_t block) override;
+
+    void clearState() override;
+
+    SnapshotCell<UniswapV3State> state;
 
     int tickRange;
 
+    // Tick sub-calls per JSON-RPC batch; on a thread pool, batches are fetched and decoded concurrently
+    size_t tickBatchSize = 500;
+
+    // Pools per tick lens call, all lens calls of a cycle go out as one batch
+    size_t lensPoolsPerCall = 100;
+
+    // slot0/ticks calls, reads of slot 0 and the ticks mapping, or the tick lens; starts as the chain's setting
+    StateRead stateRead;
+
+    // Slide each pool's tick window instead of re-reading it: only ticks entering the window and ticks named by
+    // Mint/Burn logs since the last cycle are read. Call and Storage reads only; starts as the chain's setting
+    bool slidingTicks;
+
+private:
+    // The tick lens ABI at its override address
+    Contract *lensContract = nullptr;
+
+    // Last block whose Mint/Burn logs were scanned
+    uint64_t logsBlock = 0;
+
+    // Pools whose published window is complete up to logsBlock once touchedTicks are re-read; the rest read
+    // their whole window next time
+    std::unordered_set<std::string> slidingPools;
+
+    // Ticks named by liquidity events per pool, kept until the pool's next read
+    std::unordered_map<std::string, std::unordered_set<int> > touchedTicks;
+
+    // Pools as read, before they get a depth curve and are published
+    using PoolReads = std::unordered_map<std::string, UniswapV3Pool>;
+
+    // Reads at blockTag
+    PoolReads readPools(const std::vector<std::string> &poolAddresses, const UniswapV3State &previous,
+                        const std::string &blockTag);
+
+    // Collect the Mint/Burn ticks of the sliding pools from logsBlock up to block and touch their pools in the
+    // refresh scheduler. A failed scan or a head behind logsBlock drops every pool back to a full read
+    void scanLiquidityEvents(uint64_t block);
+
+    PoolReads readLens(const std::vector<std::string> &poolAddresses, const std::string &blockTag);
+
+    // The part of a reconciling read both states describe, diffed
+    static std::vector<PoolChange> compareRead(const UniswapV3State &local, const UniswapV3State &fresh);
+
+    // Notify subscribers of the changes from previous when any listen, then publish next at block
+    void publish(const UniswapV3State &previous, UniswapV3State next, uint64_t block);
+
+    // Entry for a pool as read or as logs left it, with its depth curve
+    std::shared_ptr<const UniswapV3Pool> makePool(const std::string &address, UniswapV3Pool pool) const;
 };
 
 #endif // UNISWAP_V3_H
@@ -1,22 +1,2643 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <iomanip>
 #include <iostream>
+#include <map>
 #include <string>
 #include <memory>
+#include <mutex>
+#include <ranges>
+#include <set>
+#include <sstream>
+#include <thread>
 #include <gmpxx.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <unistd.h>
 
 
 #include "utils/Web3Client.h"
 #include "utils/Contract.h"
+#include "utils/Keccak.h"
+#include "utils/Snapshot.h"
+#include "utils/Arena.h"
+#include "abi/Erc20.h"
+#include "abi/UniswapV3Pool.h"
 #include "exchanges/adapters/Uniswap/UniswapV2.h"
 #include "exchanges/adapters/Uniswap/UniswapV3.h"
+#include "exchanges/adapters/Uniswap/UniswapEvents.h"
+#include "exchanges/adapters/Uniswap/UniswapStorage.h"
+#include "exchanges/adapters/Uniswap/UniswapSwap.h"
+#include "exchanges/adapters/Uniswap/UniswapTickLens.h"
+#include "exchanges/UpdateOrchestrator.h"
+#include "exchanges/PriceTable.h"
+#include "exchanges/TokenRegistry.h"
+#include "exchanges/ColumnarWriter.h"
+#include "exchanges/Backfill.h"
+#include "exchanges/BlockDriver.h"
+#include "exchanges/ChainSet.h"
+#include "exchanges/Router.h"
+#include "exchanges/DepthCurve.h"
+#include "exchanges/EventEngine.h"
+#include "exchanges/SharedStatePublisher.h"
+#include "exchanges/SharedStateReader.h"
+#include "testing/StandInChain.h"
+#include "utils/HttpServer.h"
+#include "utils/HttpTransport.h"
+#include "utils/RpcReplayServer.h"
 
 using json = nlohmann::json;
 
+// Endpoint and optional recording file shared by all tests, set from the command line
+static std::string rpcUrl{"https://arb1.arbitrum.io/rpc"};
+static std::string recordPath;
+
+// Create a client for the configured endpoint, recording traffic if requested
+std::shared_ptr<Web3Client> makeClient() {
+    auto web3 = std::make_shared<Web3Client>(rpcUrl);
+    if (!recordPath.empty()) {
+        web3->startRecording(recordPath);
+    }
+    return web3;
+}
+
+// Test Keccak-256 against known answers, offline
+bool testKeccak() {
+    std::cout << "=== Testing Keccak-256 ===\n";
+
+    try {
+        const std::vector<std::pair<std::string, std::string> > knownAnswers{
+            {"", "0xc5d2460186f7233c927e7db2dcc703c0e500b653ca82273b7bfad8045d85a470"},
+            {"abc", "0x4e03657aea45a94fc7d47ba826c8d667c0d1e6e33a64a036ec44f58fa12d6c45"},
+            {std::string(135, 'a'), "0x34367dc248bbd832f4e3e69dfaac2f92638bd0bbd18f2912ba4ef454919cf446"},
+            {std::string(136, 'a'), "0xa6c4d403279fe3e0af03729caada8374b5ca54d8065329a3ebcaeb4b60aa386e"},
+            {std::string(137, 'a'), "0xd869f639c7046b4929fc92a4d988a8b22c55fbadb802c0c66ebcd484f1915f39"},
+        };
+
+        std::vector<std::string_view> inputs;
+        for (const auto &[input, expected]: knownAnswers) {
+            const std::string digest = Web3Client::bytesToHex(Web3Client::keccak256(input));
+            if (digest != expected) {
+                throw std::runtime_error{"Digest mismatch for input of length " + std::to_string(input.size())};
+            }
+            inputs.emplace_back(input);
+        }
+
+        if (Web3Client::bytesToHex(Web3Client::keccak256("transfer(address,uint256)").substr(0, 4)) != "0xa9059cbb") {
+            throw std::runtime_error{"Selector mismatch for transfer(address,uint256)"};
+        }
+
+        // Batch results must match single hashes, including full SIMD groups and scalar leftovers
+        for (int i = 0; i < 9; i++) {
+            inputs.emplace_back(knownAnswers[i % knownAnswers.size()].first);
+        }
+        std::vector<uint8_t> digests(inputs.size() * Keccak::DigestSize);
+        Keccak::hashBatch(inputs.data(), inputs.size(), digests.data());
+        for (size_t i = 0; i < inputs.size(); i++) {
+            if (!std::equal(digests.begin() + i * Keccak::DigestSize, digests.begin() + (i + 1) * Keccak::DigestSize,
+                            Keccak::hash(inputs[i]).begin())) {
+                throw std::runtime_error{"Batch digest mismatch at index " + std::to_string(i)};
+            }
+        }
+
+        std::cout << "Keccak-256 tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "Keccak-256 test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// ABI word for a small number
+static std::string wordOf(const uint64_t value) {
+    std::stringstream word;
+    word << std::hex << std::setfill('0') << std::setw(64) << value;
+    return word.str();
+}
+
+// Test generated ABI bindings against the runtime Contract codec, offline
+bool testAbiBindings() {
+    std::cout << "=== Testing generated ABI bindings ===\n";
+
+    try {
+        namespace pool = abi::UniswapV3Pool::calls;
+        namespace erc20 = abi::Erc20::calls;
+
+        Contract v3Pool("0xC6962004f452bE9203591991D15f6b388e09E8D0", "../abis/uniswap_v3_pool.json");
+        Contract token("0xaf88d065e77c8cC2239327C5EDb3A432268e5831", "../abis/erc20.json");
+
+        // Contracts built from equivalent paths to one file share one parsed ABI
+        const size_t parsed = AbiRegistry::instance().size();
+        for (const std::string path: {"../abis/./uniswap_v3_pool.json", "../abis/../abis/uniswap_v3_pool.json"}) {
+            const Contract otherPool("0x641C00A822e8b671738d32a431a4Fb6074E5c79d", path);
+            if (otherPool.abi != v3Pool.abi || AbiRegistry::instance().size() != parsed) {
+                throw std::runtime_error{"ABI parsed twice through " + path};
+            }
+        }
+
+        // Every precomputed selector is the start of its signature's Keccak hash
+        for (const ContractAbi *contractAbi: {v3Pool.abi, token.abi}) {
+            for (const AbiFunction &function: contractAbi->functions | std::views::values) {
+                const std::string hash = Web3Client::bytesToHex(Web3Client::keccak256(function.signature));
+                if (function.selector != hash.substr(2, 8)) {
+                    throw std::runtime_error{"Selector of " + function.signature + " is not its hash"};
+                }
+            }
+        }
+        if (v3Pool.function("ticks").signature != "ticks(int24)" || v3Pool.function("ticks").selector != "f30dba93") {
+            throw std::runtime_error{"Wrong ticks signature or selector"};
+        }
+
+        // Calldata must match the runtime encoder byte for byte, including negative ints and addresses
+        for (const int tick: {-887270, -197688, -1, 0, 60, 887270}) {
+            if (pool::ticks::encode(tick) != v3Pool.encodeFunction("ticks", json::array({tick}))) {
+                throw std::runtime_error{"ticks calldata mismatch for tick " + std::to_string(tick)};
+            }
+        }
+        const std::string owner = "0x489ee077994b6658eafa855c308275ead8097c4a";
+        if (erc20::balanceOf::encode(owner) != token.encodeFunction("balanceOf", json::array({owner}))) {
+            throw std::runtime_error{"balanceOf calldata mismatch"};
+        }
+        if (pool::slot0::selector != 0x3850c7bd || erc20::decimals::encode() != "0x313ce567") {
+            throw std::runtime_error{"Selector mismatch"};
+        }
+
+        // Fixed-offset decode must agree with the runtime decoder
+        const std::string slot0Response = "0x"
+                "0000000000000000000000000000000000000000000411f6ad2b7b0a4cf4a7ad"
+                "fffffffffffffffffffffffffffffffffffffffffffffffffffffffffffcfbc8"
+                "000000000000000000000000000000000000000000000000000000000000002a"
+                "000000000000000000000000000000000000000000000000000000000000012c"
+                "000000000000000000000000000000000000000000000000000000000000012c"
+                "0000000000000000000000000000000000000000000000000000000000000000"
+                "0000000000000000000000000000000000000000000000000000000000000001";
+        const pool::slot0::Result slot0 = pool::slot0::decode(slot0Response);
+        const json expected = v3Pool.decodeResponse(slot0Response, "slot0");
+        if (slot0.sqrtPriceX96.get_str() != expected["sqrtPriceX96"].get<std::string>() ||
+            std::to_string(slot0.tick) != expected["tick"].get<std::string>() ||
+            std::to_string(slot0.observationCardinality) != expected["observationCardinality"].get<std::string>() ||
+            !slot0.unlocked) {
+            throw std::runtime_error{"slot0 decode mismatch"};
+        }
+
+        const std::string symbolResponse = "0x"
+                "0000000000000000000000000000000000000000000000000000000000000020"
+                "0000000000000000000000000000000000000000000000000000000000000004"
+                "5553444300000000000000000000000000000000000000000000000000000000";
+        if (erc20::symbol::decode(symbolResponse) != "USDC") {
+            throw std::runtime_error{"symbol decode mismatch"};
+        }
+
+        // Tails and lengths pointing past the response, or large enough to wrap, throw before reading there
+        const std::string huge = "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff";
+        for (const std::string &hostile: {
+                 "0x" + wordOf(0x20), "0x" + wordOf(0x40) + wordOf(4), "0x" + huge,
+                 "0x" + wordOf(0x20) + huge, "0x" + wordOf(0x20) + wordOf(0x7fffffffffffffff),
+                 "0x" + wordOf(0x20) + wordOf(33) + std::string(64, '0')
+             }) {
+            bool refused = false;
+            try {
+                erc20::symbol::decode(hostile);
+            } catch (const std::runtime_error &) {
+                refused = true;
+            }
+            if (!refused) {
+                throw std::runtime_error{"Malformed symbol response decoded: " + hostile};
+            }
+        }
+        if (!erc20::symbol::decode("0x" + wordOf(0x20) + wordOf(0)).empty()) {
+            throw std::runtime_error{"Empty symbol not decoded"};
+        }
+
+        std::cout << "Generated ABI binding tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "Generated ABI binding test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Test snapshot publication under concurrent readers, offline
+bool testSnapshots() {
+    std::cout << "=== Testing Snapshot publication ===\n";
+
+    try {
+        // Every element equals the snapshot's block, a torn or freed read breaks that
+        SnapshotCell<std::vector<uint64_t> > cell;
+        std::atomic<bool> done{false};
+        std::atomic<uint64_t> reads{0};
+        std::atomic<bool> torn{false};
+
+        std::vector<std::thread> readers;
+        for (int r = 0; r < 4; r++) {
+            readers.emplace_back([&] {
+                uint64_t lastVersion = 0;
+                while (!done.load()) {
+                    const auto view = cell.read();
+                    for (const uint64_t value: *view) {
+                        if (value != view.block()) torn = true;
+                    }
+                    if (view.version() < lastVersion) torn = true;
+                    lastVersion = view.version();
+                    reads.fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+
+        for (uint64_t block = 1; block <= 2000; block++) {
+            cell.publish(std::vector<uint64_t>(256, block), block);
+        }
+        done = true;
+        for (auto &reader: readers) reader.join();
+
+        if (torn) {
+            throw std::runtime_error{"Reader saw an inconsistent snapshot"};
+        }
+        if (cell.version() != 2000 || cell.read().block() != 2000) {
+            throw std::runtime_error{"Unexpected final snapshot version"};
+        }
+        EpochDomain::instance().reclaim();
+        std::cout << reads.load() << " consistent reads, " << EpochDomain::instance().pendingRetired()
+                << " snapshots pending reclamation\n";
+
+        std::cout << "Snapshot publication tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "Snapshot publication test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Test change set diffs, delivery and tick decoding, offline
+bool testChangeSets() {
+    std::cout << "=== Testing change sets ===\n";
+
+    try {
+        // V2: one pool moved, one unchanged, one new
+        const auto pair = [](const long reserve0, const long reserve1) {
+            return std::make_shared<const UniswapV2Pool>(UniswapV2Pool{{mpz_class(reserve0), mpz_class(reserve1)}});
+        };
+        UniswapV2State v2Before;
+        v2Before.pools["0xa"] = pair(100, 200);
+        v2Before.pools["0xb"] = pair(5, 6);
+        UniswapV2State v2After = v2Before;
+        v2After.pools["0xa"] = pair(101, 199);
+        v2After.pools["0xc"] = pair(1, 1);
+        const auto v2Changes = UniswapV2::diffStates(v2Before, v2After);
+        if (v2Changes.size() != 2) {
+            throw std::runtime_error{"Expected 2 V2 changes, got " + std::to_string(v2Changes.size())};
+        }
+
+        // Tick results are decimal strings; uint128 liquidity must survive exactly
+        const std::string maxUint128 = "340282366920938463463374607431768211455";
+        const json tickResults = {
+            {
+                "ticks", json::array({
+                    {{"liquidityNet", "-123456789"}, {"liquidityGross", maxUint128}},
+                    {{"liquidityNet", "0"}, {"liquidityGross", "0"}},
+                })
+            }
+        };
+        auto decoded = UniswapV3::processTickResults(tickResults, {{"0xp", -60}, {"0xp", 0}});
+        if (decoded["0xp"].size() != 1 || mpz_class(decoded["0xp"][-60].liquidity[1]).get_str() != maxUint128 ||
+            mpz_class(decoded["0xp"][-60].liquidity[0]) != -123456789) {
+            throw std::runtime_error{"Tick liquidity decoded incorrectly"};
+        }
+
+        // V3: price move, one tick emptied inside the window, one tick left the window (not a change)
+        UniswapV3Pool poolBefore;
+        poolBefore.sqrtPriceX96 = "79228162514264337593543950336";
+        poolBefore.tickWindow = {-120, 120};
+        poolBefore.ticks = std::move(decoded["0xp"]);
+        poolBefore.ticks.emplace(-120, Tick{{mpf_class(5, TickPrecision), mpf_class(5, TickPrecision)}});
+        UniswapV3Pool poolAfter;
+        poolAfter.sqrtPriceX96 = "79228162514264337593543950337";
+        poolAfter.tickWindow = {-60, 180};
+        UniswapV3State v3Before;
+        v3Before.pools["0xp"] = std::make_shared<const UniswapV3Pool>(std::move(poolBefore));
+        UniswapV3State v3After;
+        v3After.pools["0xp"] = std::make_shared<const UniswapV3Pool>(std::move(poolAfter));
+        const auto v3Changes = UniswapV3::diffStates(v3Before, v3After);
+        if (v3Changes.size() != 2) {
+            throw std::runtime_error{"Expected 2 V3 changes, got " + std::to_string(v3Changes.size())};
+        }
+
+        // Bounded queue: concurrent producers, every item arrives once, a full queue rejects
+        ChangeQueue queue(1024);
+        std::vector<std::thread> producers;
+        for (int p = 0; p < 4; p++) {
+            producers.emplace_back([&queue, p] {
+                for (int i = 0; i < 200; i++) {
+                    auto changes = std::make_shared<ChangeSet>();
+                    changes->version = static_cast<uint64_t>(p * 1000 + i);
+                    while (!queue.tryPush(changes)) {
+                    }
+                }
+            });
+        }
+        for (auto &producer: producers) producer.join();
+        std::set<uint64_t> seen;
+        while (auto item = queue.tryPop()) seen.insert((*item)->version);
+        if (seen.size() != 800) {
+            throw std::runtime_error{"Queue lost or duplicated items"};
+        }
+        ChangeQueue tiny(2);
+        if (!tiny.tryPush(nullptr) || !tiny.tryPush(nullptr) || tiny.tryPush(nullptr)) {
+            throw std::runtime_error{"Full queue accepted an item"};
+        }
+
+        std::cout << v2Changes.size() << " V2 and " << v3Changes.size() << " V3 changes detected\n";
+        std::cout << "Change set tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "Change set test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Exchange with hand-made pools for offline tests
+class StaticExchange final : public ExchangeBase {
+public:
+    StaticExchange() : ExchangeBase(nullptr, "Static") {
+    }
+
+    void updatePools() override {
+    }
+
+    void addPool(const std::string &address, const Token &token0, const Token &token1) {
+        Pool *pool = poolArena.create();
+        pool->address = address;
+        pool->tokens = {TokenRegistry::instance().insert(token0), TokenRegistry::instance().insert(token1)};
+        pools[address] = pool;
+    }
+
+    // Deliver a change set to the subscribers as a cycle would
+    void emit(ChangeSet changes) const {
+        publishChanges(std::move(changes));
+    }
+};
+
+// Owner of a subscription that unsubscribes on destruction, like PriceTable; its callback is slow
+struct SlowListener {
+    ExchangeBase &exchange;
+    std::atomic<bool> &entered;
+    std::atomic<bool> &finished;
+    size_t delivered = 0;
+    size_t id = 0;
+
+    SlowListener(ExchangeBase &exchange, std::atomic<bool> &entered, std::atomic<bool> &finished)
+        : exchange(exchange), entered(entered), finished(finished) {
+        id = exchange.subscribe([this](const ChangeSetPtr &) {
+            this->entered = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            delivered++;
+            this->finished = true;
+        });
+    }
+
+    ~SlowListener() {
+        exchange.unsubscribe(id);
+    }
+};
+
+// Test decimal-adjusted prices from reserves and sqrtPriceX96, offline
+bool testPriceTable() {
+    std::cout << "=== Testing price table ===\n";
+
+    try {
+        const Token weth{"0xweth", "WETH", "Wrapped Ether", 18, 0};
+        const Token usdc{"0xusdc", "USDC", "USD Coin", 6, 1};
+        StaticExchange exchange;
+        exchange.addPool("0xv2", weth, usdc);
+        exchange.addPool("0xv3", weth, weth);
+
+        if (exchange.pools["0xv2"]->tokens[0] != exchange.pools["0xv3"]->tokens[1] ||
+            exchange.pools["0xv2"]->token(1).symbol != "USDC") {
+            throw std::runtime_error{"Pools should share token records"};
+        }
+
+        PriceTable prices(exchange);
+        const size_t v2 = *prices.indexOf("0xv2");
+        const size_t v3 = *prices.indexOf("0xv3");
+        if (!std::isnan(prices.price(v2))) {
+            throw std::runtime_error{"Unpriced pool should be NaN"};
+        }
+
+        // 10 WETH against 25000 USDC, and sqrtPriceX96 = 2^96 for a 1:1 pool
+        mpz_class q96;
+        mpz_ui_pow_ui(q96.get_mpz_t(), 2, 96);
+        prices.apply({
+                         {"0xv2", PoolChange::Kind::Reserves, 0, {}, {mpz_class("10000000000000000000"), mpz_class(25000000000)}},
+                         {"0xv3", PoolChange::Kind::SqrtPrice, 0, {}, {q96, 0}},
+                     }, 100);
+
+        if (std::abs(prices.price(v2) - 2500.0) > 1e-9 || std::abs(prices.price(v2, 1) - 1.0 / 2500.0) > 1e-15 ||
+            std::abs(prices.price(v3) - 1.0) > 1e-12 || std::abs(prices.quote(v2).logPrice - std::log(2500.0)) > 1e-12) {
+            throw std::runtime_error{"Unexpected price"};
+        }
+
+        // Only touched pools are recomputed, stale blocks are ignored
+        prices.apply({{"0xv2", PoolChange::Kind::Reserves, 0, {}, {mpz_class(1), mpz_class(1)}}}, 99);
+        if (prices.lastTouched() != 0 || prices.quote(v2).block != 100) {
+            throw std::runtime_error{"Stale change applied"};
+        }
+
+        // A subscriber destroyed while a cycle is delivering to it: unsubscribe returns after the callback
+        std::atomic<bool> entered{false}, finished{false};
+        auto listener = std::make_unique<SlowListener>(exchange, entered, finished);
+        ChangeSet changes;
+        changes.exchange = exchange.name;
+        changes.block = 101;
+        changes.changes = {{"0xv2", PoolChange::Kind::Reserves, 0, {}, {mpz_class(2), mpz_class(2)}}};
+        std::thread cycle([&exchange, &changes] { exchange.emit(changes); });
+        while (!entered) std::this_thread::yield();
+        listener.reset();
+        const bool waited = finished;
+        cycle.join();
+        if (!waited) {
+            throw std::runtime_error{"Unsubscribe returned while a delivery was running"};
+        }
+
+        // Unsubscribing from inside the own callback does not wait on itself
+        size_t self = 0;
+        size_t calls = 0;
+        self = exchange.subscribe([&exchange, &self, &calls](const ChangeSetPtr &) {
+            calls++;
+            exchange.unsubscribe(self);
+        });
+        exchange.emit(changes);
+        exchange.emit(changes);
+        if (calls != 1) {
+            throw std::runtime_error{"Self unsubscribe did not take effect"};
+        }
+
+        std::cout << "Price table tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "Price table test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Test column file round trip through the background writer, offline
+bool testColumnarExport() {
+    std::cout << "=== Testing columnar export ===\n";
+
+    const std::string path = (std::filesystem::temp_directory_path() / "deds_columnar_test.dcol").string();
+    try {
+        const mpz_class maxUint128("340282366920938463463374607431768211455");
+        ColumnarOptions options;
+#ifdef DEDS_HAVE_ZLIB
+        options.compress = true;
+#endif
+        {
+            ColumnarWriter writer(path, options);
+            auto v2 = std::make_shared<ChangeSet>();
+            v2->exchange = "UniswapV2";
+            v2->block = 100;
+            v2->timestamp = 1700000000000;
+            v2->changes.push_back({"0xa", PoolChange::Kind::Reserves, 0, {}, {mpz_class(7), maxUint128}});
+            v2->changes.push_back({"0xb", PoolChange::Kind::Reserves, 0, {}, {mpz_class(1), mpz_class(2)}});
+            auto v3 = std::make_shared<ChangeSet>();
+            v3->exchange = "UniswapV3";
+            v3->block = 101;
+            // Price with the current tick, then in-range liquidity, as a V3 cycle reports them
+            UniswapV3State v3State;
+            v3State.pools["0xa"] = std::make_shared<const UniswapV3Pool>(
+                UniswapV3Pool{"79228162514264337593543950336", -887220, maxUint128.get_str(), {}, {}, nullptr});
+            v3->changes = UniswapV3::diffStates({}, v3State);
+            v3->changes.push_back({"0xp", PoolChange::Kind::TickLiquidity, -887220, {}, {mpz_class(-123456789), maxUint128}});
+            if (!writer.append(v2) || !writer.append(v3)) {
+                throw std::runtime_error{"Writer dropped a change set"};
+            }
+            writer.flush();
+            if (writer.rowsWritten() != 5 || writer.rowGroupsWritten() != 2) {
+                throw std::runtime_error{"Unexpected row count"};
+            }
+        }
+
+        const columnar::File file = columnar::read(path);
+        std::filesystem::remove(path);
+        if (file.pools != std::vector<std::string>{"0xa", "0xb", "0xp"} || file.rowGroups.size() != 2) {
+            throw std::runtime_error{"Unexpected pool dictionary or row groups"};
+        }
+        const columnar::RowGroup &v2 = file.rowGroups[0];
+        const columnar::RowGroup &v3 = file.rowGroups[1];
+        if (v2.exchange != "UniswapV2" || v2.rows() != 2 || v2.block[1] != 100 || v2.timestamp[0] != 1700000000000 ||
+            columnar::fromWord(v2.reserve1[0], false) != maxUint128 || columnar::fromWord(v2.reserve0[1], false) != 1) {
+            throw std::runtime_error{"V2 row group mismatch"};
+        }
+        if (v3.pool != std::vector<uint32_t>{0, 0, 2} || v3.tick[2] != -887220 || v3.tick[0] != 0 ||
+            columnar::fromWord(v3.liquidityNet[2], true) != -123456789 ||
+            columnar::fromWord(v3.liquidityGross[2], false) != maxUint128 ||
+            columnar::fromWord(v3.sqrtPriceX96[0], false) != mpz_class("79228162514264337593543950336") ||
+            v3.currentTick[0] != -887220 || columnar::fromWord(v3.liquidity[1], false) != maxUint128) {
+            throw std::runtime_error{"V3 row group mismatch"};
+        }
+
+        // A write cut short by the file size limit fails the writer for good and leaves complete row groups only
+        {
+            rlimit previous{};
+            getrlimit(RLIMIT_FSIZE, &previous);
+            const auto previousHandler = std::signal(SIGXFSZ, SIG_IGN);
+            rlimit limited = previous;
+            limited.rlim_cur = 4096;
+            setrlimit(RLIMIT_FSIZE, &limited);
+            bool failed = false;
+            try {
+                ColumnarWriter writer(path);
+                auto small = std::make_shared<ChangeSet>();
+                small->exchange = "UniswapV2";
+                small->changes.push_back({"0xa", PoolChange::Kind::Reserves, 0, {}, {mpz_class(1), mpz_class(2)}});
+                auto large = std::make_shared<ChangeSet>();
+                large->exchange = "UniswapV2";
+                for (int i = 0; i < 64; i++) {
+                    large->changes.push_back({"0xl" + std::to_string(i), PoolChange::Kind::Reserves, 0, {},
+                                              {mpz_class(i), mpz_class(i)}});
+                }
+                writer.append(small);
+                writer.flush();
+                const uint64_t good = writer.bytesWritten();
+                writer.append(large);
+                try {
+                    writer.flush();
+                } catch (const std::exception &) {
+                    failed = writer.bytesWritten() == good && std::filesystem::file_size(path) == good;
+                }
+                try {
+                    writer.append(small);
+                    failed = false;
+                } catch (const std::exception &) {
+                }
+            } catch (...) {
+                failed = false;
+            }
+            setrlimit(RLIMIT_FSIZE, &previous);
+            std::signal(SIGXFSZ, previousHandler);
+            if (!failed) {
+                throw std::runtime_error{"Failed write was not reported or not cut back"};
+            }
+            const columnar::File cut = columnar::read(path);
+            std::filesystem::remove(path);
+            if (cut.pools != std::vector<std::string>{"0xa"} || cut.rowGroups.size() != 1) {
+                throw std::runtime_error{"File after a failed write is not its complete row groups"};
+            }
+        }
+
+        // Appending cuts a tail that ends early, but refuses a file corrupt before its end
+        {
+            std::vector<uint64_t> ends;
+            {
+                ColumnarWriter writer(path, options);
+                for (int i = 0; i < 3; i++) {
+                    auto changes = std::make_shared<ChangeSet>();
+                    changes->exchange = "UniswapV2";
+                    changes->changes.push_back({"0x" + std::to_string(i), PoolChange::Kind::Reserves, 0, {},
+                                                {mpz_class(i), maxUint128}});
+                    writer.append(changes);
+                    writer.flush();
+                    ends.push_back(writer.bytesWritten());
+                }
+            }
+            std::filesystem::resize_file(path, ends[2] - 5);
+            ColumnarOptions appending = options;
+            appending.append = true;
+            {
+                ColumnarWriter writer(path, appending);
+            }
+            if (std::filesystem::file_size(path) != ends[1] || columnar::read(path).rowGroups.size() != 2) {
+                throw std::runtime_error{"Truncated tail not cut at the last complete row group"};
+            }
+
+            // One flipped byte in the first row group's magic
+            {
+                std::fstream stream(path, std::ios::binary | std::ios::in | std::ios::out);
+                stream.seekp(16);
+                stream.put('X');
+            }
+            bool refused = false;
+            try {
+                ColumnarWriter writer(path, appending);
+            } catch (const std::runtime_error &) {
+                refused = true;
+            }
+            if (!refused || std::filesystem::file_size(path) != ends[1]) {
+                throw std::runtime_error{"Append cut a corrupt file instead of refusing it"};
+            }
+            std::filesystem::remove(path);
+        }
+
+        std::cout << "Columnar export tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        std::filesystem::remove(path);
+        std::cerr << "Columnar export test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Test backfill against an in-process archive node: block-derived state, a failing block, resume, offline
+bool testBackfill() {
+    std::cout << "=== Testing backfill ===\n";
+
+    const auto directory = std::filesystem::temp_directory_path();
+    BackfillOptions options;
+    options.fromBlock = 100;
+    options.toBlock = 111;
+    options.step = 1;
+    options.concurrency = 3;
+    options.batchSize = 2;
+    options.retries = 0;
+    options.checkpointEvery = 2;
+    options.storePath = (directory / "deds_backfill_test.dcol").string();
+    options.checkpointPath = (directory / "deds_backfill_test.json").string();
+    std::filesystem::remove(options.storePath);
+    std::filesystem::remove(options.checkpointPath);
+
+    // Reserves are (block, 2 x block), sqrtPrice 1000 x block, tick block and liquidity block + 7; block 105 fails
+    // while set, and the header of block 108 fails as many times as headerFailures says
+    std::atomic<bool> failing{true};
+    std::atomic<int> headerFailures{0};
+    HttpServer archive(0, [&failing, &headerFailures](const HttpRequest &request) {
+        const json body = json::parse(request.body);
+        if (!body.is_array()) {
+            const uint64_t block = std::stoull(body["params"][0].get<std::string>(), nullptr, 16);
+            if (block == 108 && headerFailures.fetch_sub(1) > 0) {
+                return HttpResponse{503, "application/json", "{}"};
+            }
+            std::stringstream timestamp;
+            timestamp << "0x" << std::hex << 1700000000 + block * 12;
+            return HttpResponse{200, "application/json", json{{"jsonrpc", "2.0"}, {"id", body["id"]},
+                                                              {"result", {{"timestamp", timestamp.str()}}}}.dump()};
+        }
+        json responses = json::array();
+        for (const auto &call: body) {
+            const uint64_t block = std::stoull(call["params"][1].get<std::string>(), nullptr, 16);
+            if (block == 105 && failing) {
+                return HttpResponse{500, "application/json", "{}"};
+            }
+            const std::string selector = call["params"][0]["data"].get<std::string>().substr(2, 8);
+            std::string result = "0x";
+            if (selector == "0902f1ac") result += wordOf(block) + wordOf(2 * block) + wordOf(0);
+            else if (selector == "3850c7bd") result += wordOf(1000 * block) + wordOf(block) + std::string(5 * 64, '0');
+            else if (selector == "1a686502") result += wordOf(block + 7);
+            responses.push_back({{"jsonrpc", "2.0"}, {"id", call["id"]}, {"result", result}});
+        }
+        return HttpResponse{200, "application/json", responses.dump()};
+    });
+    archive.start();
+
+    try {
+        auto web3 = std::make_shared<Web3Client>("http://127.0.0.1:" + std::to_string(archive.port()));
+        web3->setCacheEnabled(false);
+        BackfillEngine engine(web3);
+        engine.addPools("UniswapV2", BackfillKind::UniswapV2, {"0x02", "0x01", "0x03"});
+        engine.addPools("UniswapV3", BackfillKind::UniswapV3, {"0x10"});
+
+        // First run stops at block 105 with blocks 100..103 checkpointed
+        bool failed = false;
+        try {
+            engine.run(options);
+        } catch (const std::exception &) {
+            failed = true;
+        }
+        if (!failed) {
+            throw std::runtime_error{"Failing block did not stop the run"};
+        }
+
+        // A block header the node drops once is retried like a call batch
+        failing = false;
+        headerFailures = 1;
+        options.retries = 1;
+        const Counter &retried = Metrics::instance().counter("deds_backfill_retries_total", {}, "");
+        const uint64_t retriedBefore = retried.value();
+        const BackfillReport report = engine.run(options);
+        if (report.resumedFrom != 104 || report.blocks != 8 || report.emptyCalls != 0) {
+            throw std::runtime_error{"Unexpected resume: from " + std::to_string(report.resumedFrom) + ", " +
+                                     std::to_string(report.blocks) + " blocks"};
+        }
+        if (retried.value() != retriedBefore + 1) {
+            throw std::runtime_error{"Dropped block header was not retried"};
+        }
+
+        // Every block exactly once per exchange, in order, with block-derived values
+        const columnar::File file = columnar::read(options.storePath);
+        if (file.rowGroups.size() != 24) {
+            throw std::runtime_error{"Expected 24 row groups, got " + std::to_string(file.rowGroups.size())};
+        }
+        for (size_t i = 0; i < file.rowGroups.size(); i++) {
+            const columnar::RowGroup &group = file.rowGroups[i];
+            const uint64_t block = 100 + i / 2;
+            if (group.block[0] != block || group.timestamp[0] != static_cast<int64_t>(1700000000 + block * 12) * 1000) {
+                throw std::runtime_error{"Row group " + std::to_string(i) + " out of order"};
+            }
+            if (group.exchange == "UniswapV2") {
+                if (group.rows() != 3 || file.pools[group.pool[0]] != "0x01" ||
+                    columnar::fromWord(group.reserve1[2], false) != 2 * block) {
+                    throw std::runtime_error{"Bad V2 row group at block " + std::to_string(block)};
+                }
+            } else if (group.rows() != 2 || columnar::fromWord(group.sqrtPriceX96[0], false) != 1000 * block ||
+                       group.currentTick[0] != static_cast<int32_t>(block) ||
+                       columnar::fromWord(group.liquidity[1], false) != block + 7) {
+                throw std::runtime_error{"Bad V3 row group at block " + std::to_string(block)};
+            }
+        }
+
+        archive.stop();
+        std::filesystem::remove(options.storePath);
+        std::filesystem::remove(options.checkpointPath);
+        std::cout << "Resumed at block " << report.resumedFrom << ", " << report.calls << " calls\n";
+        std::cout << "Backfill tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        archive.stop();
+        std::cerr << "Backfill test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Exchange whose cycle takes a fixed time and reads the node's head, tracks overlapping cycles
+class SlowExchange final : public ExchangeBase {
+public:
+    SlowExchange(std::shared_ptr<Web3Client> web3Client, const std::chrono::milliseconds cycleTime)
+        : ExchangeBase(std::move(web3Client), "Slow"), cycleTime{cycleTime} {
+    }
+
+    void updatePools() override {
+        const int running = ++inCycle;
+        maxInCycle = std::max(maxInCycle.load(), running);
+        const uint64_t stateBlock = web3->getBlockNumber();
+        std::this_thread::sleep_for(cycleTime);
+        recordCycle(0, stateBlock);
+        --inCycle;
+    }
+
+    std::chrono::milliseconds cycleTime;
+    std::atomic<int> inCycle{0};
+    std::atomic<int> maxInCycle{0};
+};
+
+// Test head-driven cycles against a node producing blocks faster than a cycle runs, offline
+bool testBlockDriver() {
+    std::cout << "=== Testing block driver ===\n";
+
+    std::atomic<uint64_t> head{1000};
+    HttpServer node(0, [&head](const HttpRequest &request) {
+        const json body = json::parse(request.body);
+        std::stringstream result;
+        result << "0x" << std::hex << head.load();
+        return HttpResponse{200, "application/json",
+                            json{{"jsonrpc", "2.0"}, {"id", body["id"]}, {"result", result.str()}}.dump()};
+    });
+    node.start();
+
+    try {
+        auto web3 = std::make_shared<Web3Client>("http://127.0.0.1:" + std::to_string(node.port()));
+        UpdateOrchestrator orchestrator(web3, 2);
+        auto exchange = std::make_unique<SlowExchange>(web3, std::chrono::milliseconds(40));
+        SlowExchange &slow = *exchange;
+        orchestrator.addExchange(std::move(exchange));
+
+        // A block every 10 ms against 40 ms cycles: most heads have to be skipped
+        constexpr uint64_t lastHead = 1030;
+        std::thread producer([&head] {
+            while (head < lastHead) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                ++head;
+            }
+        });
+
+        BlockDriver driver(orchestrator, {.pollInterval = std::chrono::milliseconds(5)});
+        std::vector<DrivenCycle> cycles;
+        driver.onCycle([&](const DrivenCycle &cycle) {
+            cycles.push_back(cycle);
+            if (cycle.stateBlock >= lastHead) driver.stop();
+        });
+        driver.run();
+        producer.join();
+
+        if (slow.maxInCycle != 1) {
+            throw std::runtime_error{"Cycles overlapped"};
+        }
+        uint64_t skipped = 0;
+        for (size_t i = 1; i < cycles.size(); i++) {
+            if (cycles[i].head <= cycles[i - 1].head || cycles[i].headToStateSeconds <= 0) {
+                throw std::runtime_error{"Cycle " + std::to_string(i) + " did not start at a newer head"};
+            }
+            skipped += cycles[i].skipped;
+        }
+        if (cycles.size() >= lastHead - 1000 || skipped == 0 || skipped != driver.cyclesSkipped()) {
+            throw std::runtime_error{"Expected skipped heads, got " + std::to_string(cycles.size()) + " cycles and " +
+                                     std::to_string(skipped) + " skipped"};
+        }
+        if (cycles.back().blocksBehind != 0) {
+            throw std::runtime_error{"Final state should be at the head"};
+        }
+        std::cout << cycles.size() << " cycles for " << lastHead - 1000 << " heads, " << skipped << " skipped\n";
+
+        // Cadence mode: 50 ms cycles on a 20 ms cadence drop the ticks they overrun
+        slow.cycleTime = std::chrono::milliseconds(50);
+        BlockDriver cadence(orchestrator, {.pollInterval = std::chrono::milliseconds(5),
+                                           .cadence = std::chrono::milliseconds(20), .maxCycles = 3});
+        const auto start = std::chrono::steady_clock::now();
+        cadence.run();
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (cadence.cyclesRun() != 3 || cadence.cyclesSkipped() < 2 || seconds > 1.0) {
+            throw std::runtime_error{"Cadence ticks were queued instead of skipped"};
+        }
+
+        // Heads polled while no cycle completes age the published state
+        BlockDriver polling(orchestrator, {.pollInterval = std::chrono::milliseconds(5), .maxCycles = 1});
+        double staleness = 0;
+        polling.onCycle([&](const DrivenCycle &cycle) {
+            head = cycle.stateBlock + 10;
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            staleness = Metrics::instance().gauge("deds_state_staleness_blocks", {{"exchange", "Slow"}}).value();
+        });
+        polling.run();
+        if (staleness != 10) {
+            throw std::runtime_error{"Staleness between cycles is " + std::to_string(staleness) + " blocks"};
+        }
+
+        node.stop();
+        std::cout << "Block driver tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        node.stop();
+        std::cerr << "Block driver test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Exchange whose cycle fans out subtasks that only wait, like RPC batches, and tracks how many overlap
+class FanOutExchange final : public ExchangeBase {
+public:
+    FanOutExchange(std::shared_ptr<Web3Client> web3Client, ChainConfig chainConfig, const size_t tasks,
+                   const std::chrono::milliseconds taskTime)
+        : ExchangeBase(std::move(web3Client), "FanOut", std::move(chainConfig)), tasks{tasks}, taskTime{taskTime} {
+    }
+
+    void updatePools() override {
+        std::vector<std::future<void> > pending;
+        for (size_t i = 0; i < tasks; i++) {
+            pending.push_back(submitTask([this] {
+                const int running = ++inTask;
+                maxInTask = std::max(maxInTask.load(), running);
+                std::this_thread::sleep_for(taskTime);
+                --inTask;
+            }));
+        }
+        for (auto &future: pending) {
+            ThreadPool::current()->await(future);
+        }
+    }
+
+    size_t tasks;
+    std::chrono::milliseconds taskTime;
+    std::atomic<int> inTask{0};
+    std::atomic<int> maxInTask{0};
+};
+
+// Exchange whose construction takes a fixed time, like an adapter reading its pool list
+class SlowLoadingExchange final : public ExchangeBase {
+public:
+    SlowLoadingExchange(std::shared_ptr<Web3Client> web3Client, const std::chrono::milliseconds loadTime)
+        : ExchangeBase(std::move(web3Client), "SlowLoading") {
+        std::this_thread::sleep_for(loadTime);
+    }
+
+    void updatePools() override {
+    }
+};
+
+// Test two chains on one pool: budgets, chain-scoped tokens and metrics, offline
+bool testChainSet() {
+    std::cout << "=== Testing chain set ===\n";
+
+    try {
+        ChainSet chains(4);
+        UpdateOrchestrator &slow = chains.addChain({.name = "slow", .rpcUrl = "http://127.0.0.1:1", .concurrency = 1});
+        UpdateOrchestrator &fast = chains.addChain({.name = "fast", .rpcUrl = "http://127.0.0.1:1", .concurrency = 2});
+        auto slowExchange = std::make_unique<FanOutExchange>(slow.getWeb3Client(), chains.config("slow"), 8,
+                                                             std::chrono::milliseconds(50));
+        auto fastExchange = std::make_unique<FanOutExchange>(fast.getWeb3Client(), chains.config("fast"), 4,
+                                                             std::chrono::milliseconds(5));
+        FanOutExchange &slowFanOut = *slowExchange;
+        FanOutExchange &fastFanOut = *fastExchange;
+        slow.addExchange(std::move(slowExchange));
+        fast.addExchange(std::move(fastExchange));
+
+        // Unbudgeted, the slow chain's 8 waits would hold all 4 threads and queue the fast chain behind them
+        std::thread slowCycle([&slow] { slow.runCycle(); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        const CycleReport fastReport = fast.runCycle();
+        slowCycle.join();
+
+        if (slowFanOut.maxInTask != 1 || fastFanOut.maxInTask > 2) {
+            throw std::runtime_error{"Budget exceeded: slow " + std::to_string(slowFanOut.maxInTask) + ", fast " +
+                                     std::to_string(fastFanOut.maxInTask)};
+        }
+        if (fastReport.seconds > 0.2) {
+            throw std::runtime_error{"Fast chain waited on the slow one: " + std::to_string(fastReport.seconds) + " s"};
+        }
+        std::cout << "Fast cycle " << fastReport.seconds << " s next to a 400 ms slow cycle\n";
+
+        // Same address on two chains is two tokens
+        TokenRegistry &registry = TokenRegistry::instance();
+        const TokenId onSlow = registry.insert({"0xchainset", "A", "A", 18, 0, "slow"});
+        const TokenId onFast = registry.insert({"0xchainset", "B", "B", 6, 0, "fast"});
+        if (onSlow == onFast || registry.find("0xchainset", "fast") != onFast || registry.find("0xchainset")) {
+            throw std::runtime_error{"Tokens are not scoped by chain"};
+        }
+
+        const std::string metrics = Metrics::instance().renderPrometheus();
+        if (metrics.find("deds_orchestrator_cycle_seconds_count{chain=\"fast\"}") == std::string::npos) {
+            throw std::runtime_error{"Missing per-chain cycle metrics"};
+        }
+
+        // stop() while run() waits for adapters to load returns at once, and run() starts no driver
+        ChainSet loading(2);
+        loading.addChain({.name = "loading", .rpcUrl = "http://127.0.0.1:1"})
+                .addExchange<SlowLoadingExchange>(std::chrono::milliseconds(300));
+        std::thread runner([&loading] { loading.run({}); });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const auto stopStart = std::chrono::steady_clock::now();
+        loading.stop();
+        const auto stopTime = std::chrono::steady_clock::now() - stopStart;
+        runner.join();
+        if (stopTime > std::chrono::milliseconds(100)) {
+            throw std::runtime_error{"stop() waited for adapters to load"};
+        }
+
+        // A misspelled state read is an error, not a silent eth_call
+        bool rejected = false;
+        try {
+            ChainConfig::fromJson({{"name", "typo"}, {"stateRead", "storge"}});
+        } catch (const std::invalid_argument &) {
+            rejected = true;
+        }
+        if (!rejected || ChainConfig::fromJson({{"stateRead", "lens"}}).stateRead != StateRead::Lens) {
+            throw std::runtime_error{"Unexpected stateRead parsing"};
+        }
+
+        std::cout << "Chain set tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "Chain set test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Test the state read paths: storage layout decoding, then eth_call, storage slots and the tick lens against a node
+// serving one pool state, offline
+bool testStateReads() {
+    std::cout << "=== Testing state reads ===\n";
+
+    const auto pow2 = [](const unsigned bits) {
+        mpz_class value;
+        mpz_ui_pow_ui(value.get_mpz_t(), 2, bits);
+        return value;
+    };
+    const auto twos = [&pow2](const mpz_class &value, const unsigned bits) {
+        return value < 0 ? mpz_class(value + pow2(bits)) : value;
+    };
+    const auto wordHex = [](const mpz_class &value) {
+        const std::string hex = value.get_str(16);
+        return std::string(64 - hex.size(), '0') + hex;
+    };
+
+    // One V2 pair and one 0.3% V3 pool below tick 0, with edge-of-range reserves and liquidityNet. Tick 600 is
+    // initialized but outside the window of 5 spacings around the current tick
+    const std::string pair = "0x00000000000000000000000000000000000000a1";
+    const std::string pool = "0x00000000000000000000000000000000000000b1";
+    const std::string token0 = "0x00000000000000000000000000000000000000c0";
+    const std::string token1 = "0x00000000000000000000000000000000000000c1";
+    const mpz_class reserve0 = pow2(112) - 1, reserve1 = 123456789, timestamp = 1700000000;
+    const mpz_class sqrtPriceX96("4295128739000000000000000000"), liquidity("123456789012345678");
+    constexpr int currentTick = -125, tickSpacing = 60;
+    const std::map<int, std::pair<mpz_class, mpz_class> > ticks{
+        {-480, {3, 10}}, {-180, {-pow2(127), pow2(127)}}, {60, {mpz_class("700000000000000000000"),
+                                                                 mpz_class("700000000000000000000")}},
+        {600, {1, 1}}
+    };
+
+    std::map<std::string, int> tickSlots;
+    for (int tick = -600; tick <= 600; tick += 60) {
+        tickSlots[uniswapStorage::mappingSlot(tick, uniswapStorage::V3TicksSlot)] = tick;
+    }
+
+    // Emulates the tick lens: pool words, then the initialized ticks within range spacings of the current one
+    const auto lensWords = [&](const std::string &data) {
+        const int range = static_cast<int32_t>(std::stoul(data.substr(2 + 8 + 64 + 56, 8), nullptr, 16));
+        const size_t poolCount = std::stoul(data.substr(2 + 8 + 128, 64), nullptr, 16);
+        std::vector<mpz_class> words;
+        for (size_t i = 0; i < poolCount; i++) {
+            const int compressed = (currentTick - tickSpacing + 1) / tickSpacing;
+            std::vector<mpz_class> found;
+            for (const auto &[tick, liquidities]: ticks) {
+                if (tick >= (compressed - range) * tickSpacing && tick <= (compressed + range) * tickSpacing) {
+                    found.insert(found.end(), {tick, liquidities.first, liquidities.second});
+                }
+            }
+            words.insert(words.end(), {sqrtPriceX96, currentTick, liquidity, tickSpacing, found.size() / 3});
+            words.insert(words.end(), found.begin(), found.end());
+        }
+        std::string result = "0x" + wordOf(0x20) + wordOf(words.size());
+        for (const mpz_class &word: words) result += wordHex(twos(word, 256));
+        return result;
+    };
+
+    std::atomic<int> ethCalls{0}, tickCalls{0}, lensCalls{0};
+    const auto answer = [&](const json &call) -> json {
+        const std::string method = call["method"];
+        if (method == "eth_blockNumber") return "0x10";
+        if (method == "eth_getStorageAt") {
+            const std::string slot = call["params"][1];
+            if (slot == uniswapStorage::slotHex(uniswapStorage::V2ReservesSlot)) {
+                return "0x" + mpz_class((timestamp << 224) + (reserve1 << 112) + reserve0).get_str(16);
+            }
+            if (slot == uniswapStorage::slotHex(uniswapStorage::V3Slot0Slot)) {
+                return "0x" + wordHex((mpz_class(1) << 240) + (twos(currentTick, 24) << 160) + sqrtPriceX96);
+            }
+            if (slot == uniswapStorage::slotHex(uniswapStorage::V3LiquiditySlot)) return "0x" + liquidity.get_str(16);
+            const auto tick = tickSlots.find(slot);
+            if (tick == tickSlots.end() || !ticks.contains(tick->second)) return "0x0";
+            const auto &[net, gross] = ticks.at(tick->second);
+            return "0x" + wordHex((twos(net, 128) << 128) + gross);
+        }
+        ++ethCalls;
+        const std::string data = call["params"][0]["data"];
+        if (call["params"][0]["to"] == uniswapTickLens::Address) {
+            // getPoolStates(address[],int24), with the lens code passed along
+            if (data.substr(2, 8) != "67007300" || call["params"].size() != 3 ||
+                call["params"][2] != uniswapTickLens::stateOverride()) {
+                return "0x";
+            }
+            ++lensCalls;
+            return lensWords(data);
+        }
+        const std::string selector = data.substr(2, 8);
+        if (selector == "0dfe1681") return "0x" + std::string(24, '0') + token0.substr(2);
+        if (selector == "d21220a7") return "0x" + std::string(24, '0') + token1.substr(2);
+        if (selector == "ddca3f43") return "0x" + wordOf(3000);
+        if (selector == "0902f1ac") return "0x" + wordHex(reserve0) + wordHex(reserve1) + wordHex(timestamp);
+        if (selector == "1a686502") return "0x" + wordHex(liquidity);
+        if (selector == "3850c7bd") {
+            return "0x" + wordHex(sqrtPriceX96) + wordHex(twos(currentTick, 256)) + std::string(4 * 64, '0') +
+                   wordOf(1);
+        }
+        ++tickCalls;
+        const int tick = static_cast<int32_t>(std::stoul(data.substr(data.size() - 8), nullptr, 16));
+        const auto [net, gross] = ticks.contains(tick) ? ticks.at(tick) : std::pair<mpz_class, mpz_class>{0, 0};
+        return "0x" + wordHex(gross) + wordHex(twos(net, 256)) + std::string(6 * 64, '0');
+    };
+    StandInChain chain("storage", answer);
+    chain.start();
+
+    try {
+        // keccak256(0 . 0), the first entry of a mapping in slot 0
+        if (uniswapStorage::mappingSlot(0, 0) !=
+            "0xad3228b676f7d3cd4284a5443f17f1962b36e491b30a40b2405849e597ba5fb5") {
+            throw std::runtime_error{"Wrong mapping slot"};
+        }
+        const auto [net, gross] = uniswapStorage::decodeV3TickLiquidity("0x" + wordHex((twos(-5, 128) << 128) + 9));
+        if (net != -5 || gross != 9 || uniswapStorage::decodeV3Slot0("0x" + wordHex(twos(-1, 24) << 160)).tick != -1) {
+            throw std::runtime_error{"Wrong signed field decoding"};
+        }
+
+        chain.writePools("uniswapV2.txt", {pair});
+        chain.writePools("uniswapV3.txt", {pool});
+        chain.addToken(token0, 18);
+        chain.addToken(token1, 6);
+
+        // Same state through eth_call, eth_getStorageAt and the tick lens
+        std::vector<UniswapV2State> v2States;
+        std::vector<UniswapV3State> v3States;
+        for (const StateRead stateRead: {StateRead::Call, StateRead::Storage, StateRead::Lens}) {
+            ChainConfig config = chain.config();
+            config.stateRead = stateRead;
+            auto web3 = chain.client();
+            UniswapV2 v2(web3, config);
+            UniswapV3 v3(web3, 5, config);
+            const int callsBefore = ethCalls, tickCallsBefore = tickCalls, lensCallsBefore = lensCalls;
+            v2.updatePools();
+            v3.updatePools();
+            if (stateRead == StateRead::Storage && ethCalls != callsBefore) {
+                throw std::runtime_error{"Storage mode issued eth_call"};
+            }
+            if (stateRead == StateRead::Lens && (tickCalls != tickCallsBefore || lensCalls != lensCallsBefore + 1)) {
+                throw std::runtime_error{"Lens mode should replace the tick calls with one lens call"};
+            }
+            v2States.push_back(*v2.snapshot());
+            v3States.push_back(*v3.snapshot());
+
+            // The router's models come from the same snapshots
+            const auto v2Models = v2.swapPools();
+            const auto v3Models = v3.swapPools();
+            const auto *v3Model = v3Models.size() == 1 ? dynamic_cast<const UniswapSwapPool *>(v3Models[0].get())
+                                                       : nullptr;
+            if (v2Models.size() != 1 || v2Models[0]->amountOut(1000, true) <= 0 || !v3Model ||
+                v3Model->depth != v3.snapshot()->pools.at(pool)->depth || v3Model->amountOut(1e15, false) <= 0) {
+                throw std::runtime_error{"Swap models do not match the snapshots"};
+            }
+            // A breakpoint per initialized tick in the window, plus the current price and the edge on each side
+            if (v3Model->depth->sides[0].size() + v3Model->depth->sides[1].size() != ticks.size() - 1 + 4) {
+                throw std::runtime_error{"Depth curve does not cover the window's ticks"};
+            }
+        }
+
+        for (const UniswapV2State &state: v2States) {
+            if (state.pools.at(pair)->reserves != std::array{reserve0, reserve1}) {
+                throw std::runtime_error{"Wrong V2 reserves"};
+            }
+        }
+        for (const UniswapV3State &state: v3States) {
+            const UniswapV3Pool &read = *state.pools.at(pool);
+            const auto &poolTicks = read.ticks;
+            if (read.sqrtPriceX96 != sqrtPriceX96.get_str() || poolTicks.size() != ticks.size() - 1 ||
+                read.liquidity != liquidity.get_str() || read.tick != currentTick ||
+                read.tickWindow != std::pair{-480, 120}) {
+                throw std::runtime_error{"Wrong V3 slot0 or tick window"};
+            }
+            for (const auto &[tick, expected]: ticks) {
+                if (tick > 120) continue;
+                if (poolTicks.at(tick).liquidity[0] != mpf_class(expected.first, TickPrecision) ||
+                    poolTicks.at(tick).liquidity[1] != mpf_class(expected.second, TickPrecision)) {
+                    throw std::runtime_error{"Wrong liquidity at tick " + std::to_string(tick)};
+                }
+            }
+        }
+
+        std::cout << "eth_call, storage and lens reads agree on " << ticks.size() - 1 << " ticks and the reserves\n";
+        std::cout << "State read tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "State read test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Test the HTTP transport against the local server: h2c multiplexing, gzip responses, the HTTP/1.1 fallback
+bool testTransport() {
+    std::cout << "=== Testing HTTP Transport ===\n";
+
+    // A slow node answering eth_call batches with zero words, big enough to be compressed
+    HttpServer node(0, [](const HttpRequest &request) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        json responses = json::array();
+        for (const auto &call: json::parse(request.body)) {
+            responses.push_back({{"jsonrpc", "2.0"}, {"id", call["id"]}, {"result", "0x" + std::string(256, '0')}});
+        }
+        return HttpResponse{200, "application/json", responses.dump()};
+    });
+    try {
+        node.start();
+        const std::string url = "http://127.0.0.1:" + std::to_string(node.port());
+        const std::vector calls(10, std::pair<std::string, std::string>{"0x" + std::string(40, '1'), "0x3850c7bd"});
+        const std::string batch = Web3Client::buildCallBatch(calls, "latest", 1).dump();
+
+        // Eight concurrent posts over h2c: one connection, streams served side by side
+        HttpTransport multiplexed(url, {HttpVersion::Http2PriorKnowledge, true});
+        const bool h2c = multiplexed.options().httpVersion == HttpVersion::Http2PriorKnowledge;
+        std::vector<TransportResponse> responses(8);
+        std::vector<std::exception_ptr> errors(responses.size());
+        const auto start = std::chrono::steady_clock::now();
+        std::vector<std::thread> clients;
+        for (size_t i = 0; i < responses.size(); i++) {
+            clients.emplace_back([&, i] {
+                try {
+                    responses[i] = multiplexed.post(batch);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+        for (auto &client: clients) {
+            client.join();
+        }
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        long connections = 0;
+        for (size_t i = 0; i < responses.size(); i++) {
+            if (errors[i]) {
+                std::rethrow_exception(errors[i]);
+            }
+            const TransportResponse &response = responses[i];
+            connections += response.newConnections;
+            if (response.status != 200 || response.http2 != h2c || json::parse(response.body).size() != 10) {
+                throw std::runtime_error{"Bad response"};
+            }
+            if (response.wireBytes >= response.body.size()) {
+                throw std::runtime_error{"Response was not compressed"};
+            }
+        }
+        if (elapsed > std::chrono::milliseconds(300)) {
+            throw std::runtime_error{"Concurrent posts did not overlap"};
+        }
+        if (h2c && connections != 1) {
+            throw std::runtime_error{"h2c posts opened " + std::to_string(connections) + " connections"};
+        }
+        std::cout << "8 " << (h2c ? "h2c" : "HTTP/1.1 fallback") << " posts on " << connections << " connection(s) in "
+                << std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() << " ms, "
+                << responses[0].wireBytes << " of " << responses[0].body.size() << " bytes on the wire\n";
+
+        // Plain HTTP/1.1 without compression, through the client
+        const auto web3 = std::make_shared<Web3Client>(url, "transport", TransportOptions{HttpVersion::Http1, false});
+        const std::vector<std::string> results = web3->multicallRaw({calls.begin(), calls.begin() + 3});
+        if (results.size() != 3 || results[0] != "0x" + std::string(256, '0')) {
+            throw std::runtime_error{"Bad HTTP/1.1 results"};
+        }
+        const MetricLabels labels = web3->labels();
+        if (Metrics::instance().counter("deds_rpc_wire_bytes_in_total", labels).value() !=
+            Metrics::instance().counter("deds_rpc_bytes_in_total", labels).value()) {
+            throw std::runtime_error{"Identity response should be as big on the wire as decoded"};
+        }
+
+        // Malformed and oversized bodies are refused, and the server keeps serving
+        const auto exchange = [port = node.port()](const std::string &head) {
+            const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(port);
+            ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+            std::string reply;
+            if (::connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0 &&
+                ::send(fd, head.data(), head.size(), MSG_NOSIGNAL) == static_cast<ssize_t>(head.size())) {
+                char chunk[4096];
+                for (ssize_t n; (n = ::recv(fd, chunk, sizeof(chunk), 0)) > 0;) {
+                    reply.append(chunk, static_cast<size_t>(n));
+                }
+            }
+            ::close(fd);
+            return reply.substr(0, reply.find("\r\n"));
+        };
+        for (const auto &[length, status]: std::vector<std::pair<std::string, std::string> >{
+                 {"abc", "400"}, {"12abc", "400"}, {"-1", "400"}, {"", "400"}, {"1000000000000", "413"},
+                 {"99999999999999999999999", "413"}
+             }) {
+            const std::string line = exchange("POST / HTTP/1.1\r\nContent-Length: " + length + "\r\n\r\n");
+            if (line.find(" " + status + " ") == std::string::npos) {
+                throw std::runtime_error{"Content-Length '" + length + "' answered '" + line + "'"};
+            }
+        }
+        if (exchange("GET / HTTP/1.1\r\nX: " + std::string(HttpServer::MaxHeader, 'x')).find(" 431 ") ==
+            std::string::npos) {
+            throw std::runtime_error{"Unbounded request head accepted"};
+        }
+        if (web3->multicallRaw({calls.front()}).size() != 1) {
+            throw std::runtime_error{"Server stopped serving after bad requests"};
+        }
+
+        node.stop();
+        std::cout << "HTTP transport tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        node.stop();
+        std::cerr << "HTTP transport test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Test the eth_call cache: LRU eviction, invalidation on a new head, coalescing of identical calls in flight and
+// release of the entries of a failed batch, offline
+bool testCallCache() {
+    std::cout << "=== Testing call cache ===\n";
+
+    // Slow enough that every client thread joins the first one's request
+    std::mutex nodeMutex;
+    std::map<std::string, int> wireCalls;
+    StandInChain chain("cache", [&](const json &call) -> json {
+        if (call["method"] == "eth_blockNumber") return "0x10";
+        const std::string data = call["params"][0]["data"];
+        {
+            std::lock_guard lock(nodeMutex);
+            wireCalls[data]++;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        if (data == "0xbad0") throw std::runtime_error{"execution reverted"};
+        return "0x" + wordOf(data.size());
+    });
+    const auto callsOf = [&](const std::string &data) {
+        std::lock_guard lock(nodeMutex);
+        return wireCalls[data];
+    };
+
+    try {
+        // Pinned entries: the least recently used goes first once over capacity
+        CallCache cache(2);
+        const auto store = [&cache](const std::string &key) {
+            const CallCache::Lookup lookup = cache.acquire(key, true);
+            if (lookup.kind != CallCache::Lookup::Kind::Owner) throw std::runtime_error{key + " should be a miss"};
+            cache.fulfill(key, true, lookup.generation, key + "-value");
+        };
+        store("a");
+        store("b");
+        if (cache.acquire("a", true).value != "a-value") throw std::runtime_error{"Stored entry missed"};
+        store("c");
+        if (cache.stats().evictions != 1 || cache.acquire("a", true).kind != CallCache::Lookup::Kind::Hit ||
+            cache.acquire("c", true).kind != CallCache::Lookup::Kind::Hit) {
+            throw std::runtime_error{"Wrong entry evicted"};
+        }
+        store("b");
+
+        // Latest entries: dropped at the next head, and a response that raced with the head is served but not kept
+        cache.setMaxLatestAge(std::chrono::hours(1));
+        const CallCache::Lookup first = cache.acquire("l", false);
+        cache.fulfill("l", false, first.generation, "old");
+        if (cache.acquire("l", false).value != "old") throw std::runtime_error{"Latest entry missed"};
+        cache.advanceHead(11);
+        const CallCache::Lookup raced = cache.acquire("l", false);
+        if (raced.kind != CallCache::Lookup::Kind::Owner || cache.stats().invalidations != 1) {
+            throw std::runtime_error{"Latest entry kept past a new head"};
+        }
+        cache.advanceHead(12);
+        cache.fulfill("l", false, raced.generation, "stale");
+        if (cache.acquire("l", false).kind != CallCache::Lookup::Kind::Owner || cache.stats().latestEntries != 0) {
+            throw std::runtime_error{"Response from an older head was cached"};
+        }
+
+        // Coalescing: the second caller waits on the owner's response, a failure reaches it too
+        const CallCache::Lookup owner = cache.acquire("p", true);
+        const CallCache::Lookup waiter = cache.acquire("p", true);
+        if (owner.kind != CallCache::Lookup::Kind::Owner || waiter.kind != CallCache::Lookup::Kind::Pending) {
+            throw std::runtime_error{"Identical lookup not coalesced"};
+        }
+        cache.fail("p", std::make_exception_ptr(std::runtime_error{"node down"}));
+        bool failed = false;
+        try {
+            waiter.pending.get();
+        } catch (const std::runtime_error &) {
+            failed = true;
+        }
+        if (!failed || cache.acquire("p", true).kind != CallCache::Lookup::Kind::Owner) {
+            throw std::runtime_error{"Failure not propagated or entry left in flight"};
+        }
+
+        // Four threads asking the same pinned call put it on the wire once
+        chain.start();
+        auto web3 = chain.client();
+        const std::pair<std::string, std::string> call{"0x" + std::string(40, '1'), "0x3850c7bd"};
+        std::vector<std::string> results(4);
+        std::vector<std::thread> clients;
+        for (size_t i = 0; i < results.size(); i++) {
+            clients.emplace_back([&, i] { results[i] = web3->multicallRaw({call}, "0x10")[0]; });
+        }
+        for (auto &client: clients) client.join();
+        if (callsOf(call.second) != 1 || std::ranges::count(results, results[0]) != 4 ||
+            web3->getCacheStats().coalesced + web3->getCacheStats().hits != 3) {
+            throw std::runtime_error{std::to_string(callsOf(call.second)) + " requests for one coalesced call"};
+        }
+
+        // A failed batch releases its unanswered entries: the same call is fetched again rather than waited on
+        const std::pair<std::string, std::string> good{call.first, "0x0de0"}, bad{call.first, "0xbad0"};
+        failed = false;
+        try {
+            web3->multicallRaw({bad, good}, "0x10");
+        } catch (const std::runtime_error &) {
+            failed = true;
+        }
+        auto retry = std::async(std::launch::async, [&] { return web3->multicallRaw({good}, "0x10"); });
+        if (!failed || retry.wait_for(std::chrono::seconds(5)) != std::future_status::ready ||
+            retry.get()[0] != "0x" + wordOf(6) || callsOf(good.second) != 2) {
+            throw std::runtime_error{"Entry of a failed batch left pending"};
+        }
+
+        std::cout << "4 concurrent identical calls sent once, failed batch entries released\n";
+        std::cout << "Call cache tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "Call cache test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Test the metrics exposition: Prometheus text and JSON of each metric type, label escaping, and the client's
+// per-kind error and per-method latency series, offline
+bool testMetrics() {
+    std::cout << "=== Testing metrics exposition ===\n";
+
+    StandInChain chain("metrics", [](const json &call) -> json {
+        if (call["method"] == "eth_blockNumber") return "0x1";
+        throw std::runtime_error{"execution reverted"};
+    });
+    try {
+        Metrics &metrics = Metrics::instance();
+        metrics.counter("deds_test_requests_total", {{"path", "a\"b\\c\nd"}}, "Test counter").inc(3);
+        metrics.gauge("deds_test_level", {}, "Test gauge").set(2.5);
+        Histogram &histogram = metrics.histogram("deds_test_seconds", {{"stage", "x"}}, "Test histogram", {0.1, 1});
+        for (const double value: {0.05, 0.5, 0.7, 5.0}) histogram.observe(value);
+
+        const std::string text = metrics.renderPrometheus();
+        for (const std::string expected: {
+                 "# HELP deds_test_requests_total Test counter\n# TYPE deds_test_requests_total counter\n"
+                 "deds_test_requests_total{path=\"a\\\"b\\\\c\\nd\"} 3\n",
+                 "# TYPE deds_test_level gauge\ndeds_test_level 2.5\n",
+                 "# TYPE deds_test_seconds histogram\ndeds_test_seconds_bucket{stage=\"x\",le=\"0.1\"} 1\n"
+                 "deds_test_seconds_bucket{stage=\"x\",le=\"1\"} 3\ndeds_test_seconds_bucket{stage=\"x\",le=\"+Inf\"} 4\n"
+                 "deds_test_seconds_sum{stage=\"x\"} 6.25\ndeds_test_seconds_count{stage=\"x\"} 4\n"
+             }) {
+            if (text.find(expected) == std::string::npos) {
+                throw std::runtime_error{"Missing from the exposition:\n" + expected};
+            }
+        }
+        const json rendered = metrics.renderJson();
+        const json &series = rendered.at("deds_test_seconds").at("series").at(0);
+        if (rendered.at("deds_test_requests_total").at("series").at(0).at("labels").at("path") != "a\"b\\c\nd" ||
+            rendered.at("deds_test_level").at("type") != "gauge" || series.at("count") != 4 ||
+            series.at("buckets") != json::array({1, 2, 1})) {
+            throw std::runtime_error{"Wrong JSON rendering"};
+        }
+
+        // A client's error kinds are registered up front, its method latencies on first use
+        chain.start();
+        const auto web3 = chain.client();
+        const MetricLabels rpcErrors{{"chain", "metrics"}, {"kind", "rpc"}};
+        if (metrics.renderPrometheus().find("deds_rpc_errors_total{chain=\"metrics\",kind=\"parse\"} 0\n") ==
+            std::string::npos) {
+            throw std::runtime_error{"Error series not registered with the client"};
+        }
+        for (int i = 0; i < 2; i++) {
+            try {
+                web3->sendRpcRequest("eth_call", json::array({{{"to", "0x" + std::string(40, '1')}}, "latest"}));
+            } catch (const std::runtime_error &) {
+            }
+        }
+        web3->getBlockNumber();
+        const Histogram &latency = metrics.histogram("deds_rpc_request_seconds",
+                                                     {{"chain", "metrics"}, {"method", "eth_call"}});
+        if (metrics.counter("deds_rpc_errors_total", rpcErrors).value() != 2 || latency.count() != 2) {
+            throw std::runtime_error{"Client errors or latencies not counted"};
+        }
+
+        // An adapter without pools still completes cycles
+        chain.writePools("uniswapV2.txt", {});
+        UniswapV2 empty(web3, chain.config());
+        empty.updatePools();
+        if (metrics.counter("deds_update_cycles_total", {{"chain", "metrics"}, {"exchange", empty.name}}).value() != 1) {
+            throw std::runtime_error{"Cycle without pools not recorded"};
+        }
+
+        std::cout << "Metrics exposition tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "Metrics exposition test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Test refresh tiers: scheduler decisions, then a tiered V2 adapter against a node where one pair of four moves
+bool testRefreshTiers() {
+    std::cout << "=== Testing refresh tiers ===\n";
+
+    const std::vector<std::string> pairs{
+        "0x00000000000000000000000000000000000000d0", "0x00000000000000000000000000000000000000d1",
+        "0x00000000000000000000000000000000000000d2", "0x00000000000000000000000000000000000000d3"
+    };
+    std::atomic<uint64_t> head{100};
+    std::atomic<int> reserveCalls{0};
+    // Block of a single trade on the second pair, 0 until it happens; log queries fail while logsDown is set
+    std::atomic<uint64_t> tradedAt{0};
+    std::atomic<bool> logsDown{false};
+    const auto answer = [&](const json &call) -> json {
+        if (call["method"] == "eth_blockNumber") {
+            std::stringstream hex;
+            hex << "0x" << std::hex << head.load();
+            return hex.str();
+        }
+        if (call["method"] == "eth_getLogs") {
+            if (logsDown) throw std::runtime_error{"logs unavailable"};
+            const json &filter = call["params"][0];
+            const uint64_t from = std::stoull(filter["fromBlock"].get<std::string>(), nullptr, 16);
+            const uint64_t to = std::stoull(filter["toBlock"].get<std::string>(), nullptr, 16);
+            const auto &addresses = filter["address"];
+            json logs = json::array();
+            if (tradedAt >= from && tradedAt <= to && std::ranges::find(addresses, json(pairs[1])) != addresses.end()) {
+                logs.push_back({{"address", pairs[1]}, {"topics", {std::string(uniswapEvents::SyncTopic)}},
+                                {"data", "0x" + wordOf(8) + wordOf(8)}});
+            }
+            return logs;
+        }
+        const std::string data = call["params"][0]["data"];
+        const std::string selector = data.substr(2, 8);
+        if (selector == "0dfe1681") return "0x" + wordOf(0xe0);
+        if (selector == "d21220a7") return "0x" + wordOf(0xe1);
+        ++reserveCalls;
+        // The first pair trades every block, the second once
+        const std::string to = call["params"][0]["to"];
+        const uint64_t reserve = to == pairs[0] ? head.load() : to == pairs[1] && tradedAt != 0 ? 8 : 7;
+        return "0x" + wordOf(reserve) + wordOf(reserve) + wordOf(0);
+    };
+    StandInChain chain("tiers", answer);
+
+    try {
+        // Hot for 2 blocks after a change, warm for 6 and refreshed every 2, then cold and in effect only refreshed
+        // when touched
+        const TierPolicy policy{.enabled = true, .hotBlocks = 2, .warmBlocks = 6, .warmInterval = 2,
+                                .coldInterval = 1000000000};
+        RefreshScheduler scheduler(policy);
+        const std::vector<std::string> names{"a", "b"};
+        if (scheduler.due(names, 1).size() != 2) throw std::runtime_error{"New pools should be due"};
+        scheduler.recordRefresh(names, {}, 1);
+        for (uint64_t block = 2; block < 20; block++) {
+            const std::vector<std::string> due = scheduler.due(names, block);
+            if (std::ranges::find(due, "a") == due.end()) throw std::runtime_error{"Changing pool skipped"};
+            scheduler.recordRefresh(due, {"a"}, block);
+        }
+        if (scheduler.tier("a") != RefreshTier::Hot || scheduler.tier("b") != RefreshTier::Cold ||
+            scheduler.due(names, 20) != std::vector<std::string>{"a"}) {
+            throw std::runtime_error{"Wrong tiers after 20 blocks"};
+        }
+        scheduler.touch({"b"});
+        if (scheduler.due(names, 21).size() != 2) throw std::runtime_error{"Touched pool not due"};
+        scheduler.recordRefresh(names, {"b"}, 21);
+        if (scheduler.tier("b") != RefreshTier::Hot) throw std::runtime_error{"Changed cold pool not promoted"};
+
+        // An interval of 0 refreshes the tier every cycle
+        RefreshScheduler everyCycle({.enabled = true, .hotBlocks = 1, .warmBlocks = 1, .coldInterval = 0});
+        everyCycle.recordRefresh(names, {}, 1);
+        for (uint64_t block = 2; block < 6; block++) {
+            if (everyCycle.due(names, block).size() != 2) throw std::runtime_error{"Cold pool with interval 0 skipped"};
+            everyCycle.recordRefresh(names, {}, block);
+        }
+        if (everyCycle.tier("b") != RefreshTier::Cold) throw std::runtime_error{"Idle pool not cold"};
+
+        chain.start();
+        chain.writePools("uniswapV2.txt", pairs);
+        chain.addToken("0x" + std::string(38, '0') + "e0", 18);
+        chain.addToken("0x" + std::string(38, '0') + "e1", 18);
+
+        ChainConfig config = chain.config();
+        config.refresh = policy;
+        auto web3 = chain.client();
+        UniswapV2 v2(web3, config);
+        constexpr int Cycles = 30;
+        const int callsBefore = reserveCalls;
+        for (int cycle = 0; cycle < Cycles; cycle++) {
+            head++;
+            const auto before = v2.snapshot();
+            v2.updatePools();
+            const auto after = v2.snapshot();
+            if (after->pools.at(pairs[0])->reserves[0] != head.load() || after->pools.at(pairs[3])->reserves[0] != 7) {
+                throw std::runtime_error{"Wrong reserves at block " + std::to_string(head.load())};
+            }
+            // Only the moving pair gets a new entry and depth curve, the others are shared with the last snapshot
+            if (cycle > 0 && (after->pools.at(pairs[0]) == before->pools.at(pairs[0]) ||
+                              after->pools.at(pairs[3]) != before->pools.at(pairs[3]) ||
+                              after->pools.at(pairs[2]) != before->pools.at(pairs[2]))) {
+                throw std::runtime_error{"Pool entries rebuilt for the wrong pairs"};
+            }
+        }
+        const int tieredCalls = reserveCalls - callsBefore;
+        if (tieredCalls >= Cycles * 2 || v2.refreshScheduler.tierCounts() != std::array<size_t, 3>{1, 0, 3}) {
+            throw std::runtime_error{"Tiering made " + std::to_string(tieredCalls) + " reserve calls"};
+        }
+
+        // Logs touched a cold pair: it is read in the next cycle, and only it joins the hot one
+        v2.refreshScheduler.touch({pairs[2]});
+        const int touchedBefore = reserveCalls;
+        head++;
+        v2.updatePools();
+        if (reserveCalls - touchedBefore != 2) throw std::runtime_error{"Touched pair not refreshed alone"};
+        // Skipped pairs whose logs show no trade are current at the head
+        if (v2.snapshot().block() != head || v2.stateBlock() != head) {
+            throw std::runtime_error{"Quiet skipped pairs held the state block back"};
+        }
+
+        // A Sync log on a cold pair gets it read in the same cycle
+        head++;
+        tradedAt = head.load();
+        const int tradedBefore = reserveCalls;
+        v2.updatePools();
+        if (reserveCalls - tradedBefore != 2 || v2.snapshot()->pools.at(pairs[1])->reserves[0] != 8) {
+            throw std::runtime_error{"Cold pair with a Sync log not refreshed"};
+        }
+
+        // Without logs the skipped pairs age, and the state block and staleness show it
+        const uint64_t lastScanned = head;
+        logsDown = true;
+        head += 5;
+        v2.updatePools();
+        const double staleness = Metrics::instance().gauge("deds_state_staleness_blocks",
+                                                           {{"chain", "tiers"}, {"exchange", v2.name}}).value();
+        if (v2.snapshot().block() != lastScanned || v2.stateBlock() != lastScanned || staleness != 5) {
+            throw std::runtime_error{"Unscanned skipped pairs not reported as stale"};
+        }
+        logsDown = false;
+        head++;
+        v2.updatePools();
+        if (v2.stateBlock() != head) throw std::runtime_error{"State block not back at the head after a scan"};
+
+        std::cout << tieredCalls << " reserve calls over " << Cycles << " blocks of " << pairs.size()
+                << " pairs instead of " << Cycles * pairs.size() << "\n";
+        std::cout << "Refresh tier tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "Refresh tier test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Swap models and the split router on a hand-built graph: direct V2 and V3 pools plus a two-hop detour
+bool testRouter() {
+    std::cout << "=== Testing router ===\n";
+
+    try {
+        constexpr TokenId A = 900001, B = 900002, C = 900003;
+        const auto v2Pool = [](const std::string &address, const TokenId token0, const TokenId token1,
+                               const double reserve0, const double reserve1) {
+            auto pool = std::make_shared<UniswapSwapPool>(
+                std::make_shared<const DepthCurve>(DepthCurve::constantProduct(reserve0, reserve1, 0.003)));
+            pool->address = address;
+            pool->exchange = "UniswapV2";
+            pool->tokens = {token0, token1};
+            return pool;
+        };
+        // 0.3% pool at tick 0 with liquidity 1e6 in range, over a window of 100 spacings
+        const auto v3Pool = [](const std::string &address, const std::vector<std::pair<int, double> > &ticks) {
+            auto pool = std::make_shared<UniswapSwapPool>(std::make_shared<const DepthCurve>(
+                DepthCurve::concentrated(1, 0, 1e6, ticks, {-6000, 6000}, 0.003)));
+            pool->address = address;
+            pool->exchange = "UniswapV3";
+            pool->tokens = {A, B};
+            return pool;
+        };
+
+        // One range of liquidity L trades like a V2 pool with reserves L / sqrtPrice and L * sqrtPrice
+        const auto v3 = v3Pool("v3", {{-6000, 1e6}, {6000, -1e6}});
+        const double edgePrice = DepthCurve::sqrtPriceAt(-6000);
+        const auto virtualPool = v2Pool("virtual", A, B, 1e6, 1e6);
+        if (v3->spotRate(true) != 0.997 || v3->spotRate(false) != 0.997 ||
+            std::abs(v2Pool("ac", A, C, 1e6, 2e6)->spotRate(true) - 0.997 * 2) > 1e-12) {
+            throw std::runtime_error{"Spot rates not the price after the fee"};
+        }
+        for (const double amount: {1e2, 1e4, 1e5}) {
+            for (const bool zeroForOne: {true, false}) {
+                const double expected = virtualPool->amountOut(amount, zeroForOne);
+                if (std::abs(v3->amountOut(amount, zeroForOne) - expected) > expected * 1e-9) {
+                    throw std::runtime_error{"V3 range does not match constant product at " + std::to_string(amount)};
+                }
+            }
+        }
+        // Selling past the window stops at its edge
+        if (std::abs(v3->amountOut(1e9, true) - 1e6 * (1 - edgePrice)) > 1e-3) {
+            throw std::runtime_error{"V3 swap did not stop at the window edge"};
+        }
+        // Crossing a tick that removes half the liquidity costs output
+        const auto thinner = v3Pool("thinner", {{-6000, 5e5}, {-600, 5e5}, {6000, -1e6}});
+        if (thinner->amountOut(1e5, true) >= v3->amountOut(1e5, true) ||
+            thinner->amountOut(1e3, true) != v3->amountOut(1e3, true)) {
+            throw std::runtime_error{"V3 tick crossing priced wrong"};
+        }
+
+        const auto ab = v2Pool("ab", A, B, 1e6, 1e6);
+        const auto ac = v2Pool("ac", A, C, 1e6, 2e6);
+        const auto cb = v2Pool("cb", C, B, 2e6, 1e6);
+        Router router({.maxHops = 1});
+        router.build({ab, v3, ac, cb});
+        const double amount = 5e4;
+        const RouteQuote direct = router.quote(A, B, amount);
+        if (direct.splits.empty() || std::ranges::any_of(direct.splits, [](const RouteSplit &split) {
+            return split.hops.size() != 1;
+        })) {
+            throw std::runtime_error{"One-hop routing returned no or longer paths"};
+        }
+
+        router.options.maxHops = 3;
+        const RouteQuote split = router.quote(A, B, amount);
+        const double single = std::max({
+            ab->amountOut(amount, true), v3->amountOut(amount, true), cb->amountOut(ac->amountOut(amount, true), true)
+        });
+        double allocated = 0;
+        for (const RouteSplit &part: split.splits) allocated += part.amountIn;
+        if (split.splits.size() != 3 || split.amountOut <= direct.amountOut || split.amountOut <= single ||
+            std::abs(allocated - amount) > 1e-6) {
+            throw std::runtime_error{"Split route not better than direct: " + std::to_string(split.amountOut)};
+        }
+        if (!std::ranges::any_of(split.splits, [](const RouteSplit &part) {
+            return part.hops.size() == 2 && part.hops[0].tokenOut == C && part.hops[1].tokenIn == C;
+        })) {
+            throw std::runtime_error{"Two-hop detour not used"};
+        }
+        if (router.quote(B, A, amount).splits.size() != 3 || router.quote(A, 900004, amount).amountOut != 0) {
+            throw std::runtime_error{"Reverse or unknown-token routing wrong"};
+        }
+
+        // Fanning the first hops out over a pool finds the same route
+        ThreadPool pool(4);
+        router.options.threadPool = &pool;
+        const RouteQuote parallel = router.quote(A, B, amount);
+        if (parallel.amountOut != split.amountOut || parallel.splits.size() != split.splits.size()) {
+            throw std::runtime_error{"Parallel search differs"};
+        }
+
+        std::cout << split.pathsEvaluated << " paths, " << split.splits.size() << " splits: " << split.amountOut
+                << " out vs " << direct.amountOut << " over direct pools only\n";
+        std::cout << "Router tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "Router test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Depth curves against a swap over explicit ranges and constant product, and their inverse queries
+bool testDepthCurves() {
+    std::cout << "=== Testing depth curves ===\n";
+
+    try {
+        // Three overlapping positions around tick 0 with a gap above
+        const double sqrtPrice = DepthCurve::sqrtPriceAt(130) * 0.99999;
+        const std::pair window{-2400, 2400};
+        const std::vector<std::pair<int, double> > ticks{
+            {-1200, 1e6}, {-600, 1e6}, {-300, 1e6}, {300, -2e6}, {900, -1e6}, {1500, 1e6}, {2100, -1e6}
+        };
+        const DepthCurve curve = DepthCurve::concentrated(sqrtPrice, 129, 3e6, ticks, window, 0.003);
+
+        // Reference swap: the liquidity of each range the price crosses, listed by hand, at the constant liquidity
+        // closed form. Token0 in moves 1/sqrtPrice up by x / L, token1 in moves sqrtPrice up by y / L
+        const auto reference = [&](const double amountIn, const bool zeroForOne) {
+            const std::vector<std::pair<int, double> > ranges = zeroForOne
+                ? std::vector<std::pair<int, double> >{{-300, 3e6}, {-600, 2e6}, {-1200, 1e6}, {-2400, 0}}
+                : std::vector<std::pair<int, double> >{{300, 3e6}, {900, 1e6}, {1500, 0}, {2100, 1e6}, {2400, 0}};
+            double remaining = amountIn * 0.997, price = sqrtPrice, out = 0;
+            for (const auto &[end, liquidity]: ranges) {
+                const double target = DepthCurve::sqrtPriceAt(end);
+                const double needed = zeroForOne ? liquidity * (1 / target - 1 / price) : liquidity * (target - price);
+                const double next = remaining >= needed ? target
+                                    : zeroForOne ? 1 / (1 / price + remaining / liquidity)
+                                    : price + remaining / liquidity;
+                out += zeroForOne ? liquidity * (price - next) : liquidity * (1 / price - 1 / next);
+                if (remaining < needed) break;
+                remaining -= needed;
+                price = target;
+            }
+            return out;
+        };
+        for (const bool zeroForOne: {true, false}) {
+            for (double amount = 1; amount < 1e8; amount *= 3.7) {
+                const double expected = reference(amount, zeroForOne);
+                if (std::abs(curve.amountOut(amount, zeroForOne) - expected) > expected * 1e-9 + 1e-9) {
+                    throw std::runtime_error{"Curve output differs from the reference at " + std::to_string(amount)};
+                }
+                // The largest input for an impact moves the price by exactly that much, within the range
+                const double impact = curve.priceImpact(amount, zeroForOne);
+                if (amount < curve.capacity(zeroForOne) &&
+                    std::abs(curve.maxInput(impact, zeroForOne) - amount) > amount * 1e-9) {
+                    throw std::runtime_error{"maxInput does not invert priceImpact at " + std::to_string(amount)};
+                }
+            }
+            if (!std::isfinite(curve.capacity(zeroForOne)) ||
+                curve.amountOut(curve.capacity(zeroForOne) * 2, zeroForOne) !=
+                curve.sides[zeroForOne ? 0 : 1].back().amountOut) {
+                throw std::runtime_error{"Curve not capped at the window edge"};
+            }
+        }
+
+        // Constant product: 1% impact selling token0 takes x (1 / sqrt(0.99) - 1) before the fee
+        const DepthCurve v2 = DepthCurve::constantProduct(1e6, 4e6, 0.003);
+        const double onePercent = v2.maxInput(0.01, true);
+        if (std::abs(onePercent * 0.997 - 1e6 * (1 / std::sqrt(0.99) - 1)) > 1e-6 ||
+            std::abs(v2.priceImpact(onePercent, true) - 0.01) > 1e-12 ||
+            std::abs(v2.amountOut(1e4, false) - 1e4 * 0.997 * 1e6 / (4e6 + 1e4 * 0.997)) > 1e-9 ||
+            std::isfinite(v2.capacity(false))) {
+            throw std::runtime_error{"Constant product curve wrong"};
+        }
+
+        std::cout << "1% depth: " << onePercent << " token0 on a 1e6 x 4e6 pair, " << curve.maxInput(0.01, true)
+                << " on the V3 pool over " << curve.sides[0].size() << " breakpoints\n";
+        std::cout << "Depth curve tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "Depth curve test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Sliding tick windows in storage mode: edge ticks as the price moves, Mint/Burn ticks from eth_getLogs, and a full
+// re-read when the logs fail
+bool testSlidingTicks() {
+    std::cout << "=== Testing sliding tick windows ===\n";
+
+    const auto twos = [](const mpz_class &value, const unsigned bits) {
+        mpz_class modulus;
+        mpz_ui_pow_ui(modulus.get_mpz_t(), 2, bits);
+        return value < 0 ? mpz_class(value + modulus) : value;
+    };
+    const auto wordHex = [](const mpz_class &value) {
+        const std::string hex = value.get_str(16);
+        return std::string(64 - hex.size(), '0') + hex;
+    };
+    const auto hexOf = [](const uint64_t value) {
+        std::stringstream hex;
+        hex << "0x" << std::hex << value;
+        return hex.str();
+    };
+
+    // Checksummed in the pool file, lowercase in the logs
+    const std::string pool = "0x00000000000000000000000000000000000000B2";
+    std::atomic<uint64_t> head{0x100};
+    std::atomic<int> currentTick{-125};
+    std::atomic<bool> failLogs{false};
+    std::atomic<int> tickReads{0};
+    std::mutex nodeMutex;
+    std::map<int, std::pair<mpz_class, mpz_class> > ticks{
+        {-480, {3, 10}}, {-180, {-5, 5}}, {60, {7, 7}}, {180, {2, 2}}
+    };
+    json logs = json::array();
+    std::string fromBlock;
+
+    std::map<std::string, int> tickSlots;
+    for (int tick = -1200; tick <= 1200; tick += 60) {
+        tickSlots[uniswapStorage::mappingSlot(tick, uniswapStorage::V3TicksSlot)] = tick;
+    }
+    const auto answer = [&](const json &call) -> json {
+        const std::string method = call["method"];
+        if (method == "eth_blockNumber") return hexOf(head);
+        std::lock_guard lock(nodeMutex);
+        if (method == "eth_getLogs") {
+            if (failLogs) throw std::runtime_error{"busy"};
+            fromBlock = call["params"][0]["fromBlock"];
+            return logs;
+        }
+        if (method == "eth_getStorageAt") {
+            const std::string slot = call["params"][1];
+            if (slot == uniswapStorage::slotHex(uniswapStorage::V3Slot0Slot)) {
+                const mpz_class sqrtPriceX96(DepthCurve::sqrtPriceAt(currentTick) * 0x1p96);
+                return "0x" + wordHex((mpz_class(1) << 240) + (twos(currentTick.load(), 24) << 160) + sqrtPriceX96);
+            }
+            if (slot == uniswapStorage::slotHex(uniswapStorage::V3LiquiditySlot)) return "0x" + wordOf(1000000);
+            ++tickReads;
+            const auto tick = tickSlots.find(slot);
+            if (tick == tickSlots.end() || !ticks.contains(tick->second)) return "0x0";
+            const auto &[net, gross] = ticks.at(tick->second);
+            return "0x" + wordHex((twos(net, 128) << 128) + gross);
+        }
+        const std::string selector = call["params"][0]["data"].get<std::string>().substr(2, 8);
+        if (selector == "0dfe1681") return "0x" + wordOf(0xf0);
+        if (selector == "d21220a7") return "0x" + wordOf(0xf1);
+        return "0x" + wordOf(3000);
+    };
+    StandInChain chain("sliding", answer);
+
+    try {
+        if (Web3Client::bytesToHex(Web3Client::keccak256(
+                "Mint(address,address,int24,int24,uint128,uint256,uint256)")) != uniswapEvents::MintTopic ||
+            Web3Client::bytesToHex(Web3Client::keccak256("Burn(address,int24,int24,uint128,uint256,uint256)")) !=
+            uniswapEvents::BurnTopic) {
+            throw std::runtime_error{"Wrong Mint/Burn topics"};
+        }
+
+        chain.start();
+        chain.writePools("uniswapV3.txt", {pool});
+        chain.addToken("0x" + std::string(38, '0') + "f0", 18);
+        chain.addToken("0x" + std::string(38, '0') + "f1", 18);
+        ChainConfig config = chain.config();
+        config.stateRead = StateRead::Storage;
+        config.slidingTicks = true;
+        auto web3 = chain.client();
+        UniswapV3 v3(web3, 5, config);
+
+        // Reads per cycle: the whole window, nothing while the price stands still, one edge tick for one spacing
+        std::vector<int> reads;
+        const auto cycle = [&] {
+            const int before = tickReads;
+            head++;
+            v3.updatePools();
+            reads.push_back(tickReads - before);
+        };
+        cycle();
+        const auto settled = v3.snapshot()->pools.at(pool);
+        cycle();
+        if (v3.snapshot()->pools.at(pool) != settled) {
+            throw std::runtime_error{"An unchanged pool was copied into the next snapshot"};
+        }
+        currentTick = -65;
+        cycle();
+        if (fromBlock != hexOf(head) || v3.snapshot()->pools.at(pool)->ticks.contains(-480)) {
+            throw std::runtime_error{"Logs scanned from " + fromBlock + " or the left tick kept"};
+        }
+
+        // A Mint initializes -300 and adds to 60, a Burn empties -180; only those and its upper tick are re-read
+        {
+            std::lock_guard lock(nodeMutex);
+            ticks[-300] = {4, 4};
+            ticks[60] = {11, 11};
+            ticks.erase(-180);
+            const auto liquidityLog = [&](const std::string_view topic, const int lower, const int upper) {
+                return json{
+                    {"address", "0x00000000000000000000000000000000000000b2"}, {"blockNumber", hexOf(head + 1)},
+                    {"topics", {topic, "0x" + std::string(64, '0'), "0x" + wordHex(twos(lower, 256)),
+                                "0x" + wordHex(twos(upper, 256))}},
+                    {"data", "0x" + std::string(64, '0') + wordOf(1) + std::string(128, '0')}
+                };
+            };
+            logs = {
+                liquidityLog(uniswapEvents::MintTopic, -300, 60), liquidityLog(uniswapEvents::BurnTopic, -180, 120)
+            };
+        }
+        cycle();
+        {
+            std::lock_guard lock(nodeMutex);
+            logs = json::array();
+        }
+        failLogs = true;
+        cycle();
+        if (reads != std::vector<int>{11, 0, 1, 4, 11}) {
+            throw std::runtime_error{"Unexpected tick reads per cycle"};
+        }
+
+        // Same state as a full read
+        config.slidingTicks = false;
+        UniswapV3 full(web3, 5, config);
+        full.updatePools();
+        const auto &slid = v3.snapshot()->pools.at(pool)->ticks;
+        const auto &expected = full.snapshot()->pools.at(pool)->ticks;
+        if (slid.size() != expected.size() || slid.size() != 3 ||
+            v3.snapshot()->pools.at(pool)->tickWindow != full.snapshot()->pools.at(pool)->tickWindow) {
+            throw std::runtime_error{"Sliding window differs from a full read"};
+        }
+        for (const auto &[tick, data]: expected) {
+            if (!slid.contains(tick) || slid.at(tick).liquidity != data.liquidity) {
+                throw std::runtime_error{"Wrong liquidity at tick " + std::to_string(tick)};
+            }
+        }
+
+        // Tiered, the idle pool goes cold and is skipped until a Mint names it, then that cycle reads it
+        failLogs = false;
+        v3.refreshScheduler.setPolicy({.enabled = true, .hotBlocks = 1, .warmBlocks = 2, .warmInterval = 1000000000,
+                                       .coldInterval = 1000000000});
+        reads.clear();
+        cycle();
+        cycle();
+        cycle();
+        {
+            std::lock_guard lock(nodeMutex);
+            ticks[60] = {12, 12};
+            logs = {{
+                {"address", "0x00000000000000000000000000000000000000b2"}, {"blockNumber", hexOf(head + 1)},
+                {"topics", {uniswapEvents::MintTopic, "0x" + std::string(64, '0'), "0x" + wordHex(twos(-300, 256)),
+                            "0x" + wordHex(twos(60, 256))}},
+                {"data", "0x" + std::string(64, '0') + wordOf(1) + std::string(128, '0')}
+            }};
+        }
+        cycle();
+        if (reads[2] != 0 || reads[3] == 0 || v3.snapshot()->pools.at(pool)->ticks.at(60).liquidity[1] != 12) {
+            throw std::runtime_error{"Mint did not refresh the cold pool"};
+        }
+
+        std::cout << "Tick reads per cycle: 11 full, 0 idle, 1 after a one-spacing move, 4 after a Mint and a Burn\n";
+        std::cout << "Sliding tick window tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "Sliding tick window test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Event-sourced state against a simulated chain: catch-up from logs, reconciliation and drift, and a replay of
+// the downloaded stream from the pools' creation
+bool testEventEngine() {
+    std::cout << "=== Testing event engine ===\n";
+
+    const auto twos = [](const mpz_class &value, const unsigned bits) {
+        mpz_class modulus;
+        mpz_ui_pow_ui(modulus.get_mpz_t(), 2, bits);
+        return value < 0 ? mpz_class(value + modulus) : value;
+    };
+    const auto wordHex = [](const mpz_class &value) {
+        const std::string hex = value.get_str(16);
+        return std::string(64 - hex.size(), '0') + hex;
+    };
+    const auto hexOf = [](const uint64_t value) {
+        std::stringstream hex;
+        hex << "0x" << std::hex << value;
+        return hex.str();
+    };
+    const auto sqrtPriceOf = [](const int tick) { return mpz_class(DepthCurve::sqrtPriceAt(tick) * 0x1p96); };
+
+    // The chain: one V2 pair and one V3 pool whose storage always matches the logs emitted so far, and a pair and
+    // a pool next to them that never emit any
+    const std::string pair = "0x00000000000000000000000000000000000000A3";
+    const std::string pool = "0x00000000000000000000000000000000000000B3";
+    const std::string quietPair = "0x00000000000000000000000000000000000000A4";
+    const std::string quietPool = "0x00000000000000000000000000000000000000B4";
+    std::mutex chainMutex;
+    uint64_t head = 90;
+    uint64_t logIndex = 0;
+    std::array<mpz_class, 2> reserves{0, 0};
+    // Reserves as of each block that synced, for reads at a past block
+    std::map<uint64_t, std::array<mpz_class, 2> > reserveHistory;
+    // The next head poll moves the chain one block on, with a Sync
+    bool advanceOnHead = false;
+    int currentTick = 0;
+    std::vector<std::tuple<int, int, mpz_class> > positions;
+    std::vector<json> chainLogs;
+
+    const auto tickLiquidity = [&] {
+        std::map<int, std::pair<mpz_class, mpz_class> > ticks;
+        for (const auto &[lower, upper, amount]: positions) {
+            ticks[lower].first += amount;
+            ticks[lower].second += amount;
+            ticks[upper].first -= amount;
+            ticks[upper].second += amount;
+        }
+        std::erase_if(ticks, [](const auto &entry) { return entry.second.second == 0; });
+        return ticks;
+    };
+    const auto activeLiquidity = [&] {
+        mpz_class active = 0;
+        for (const auto &[lower, upper, amount]: positions) {
+            if (lower <= currentTick && currentTick < upper) active += amount;
+        }
+        return active;
+    };
+    const auto emit = [&](const std::string &address, const std::string_view topic,
+                          const std::vector<mpz_class> &indexed, const std::vector<mpz_class> &data) {
+        json topics = json::array({std::string(topic)});
+        for (const mpz_class &value: indexed) topics.push_back("0x" + wordHex(twos(value, 256)));
+        std::string words = "0x";
+        for (const mpz_class &word: data) words += wordHex(twos(word, 256));
+        std::string lower = address;
+        std::ranges::transform(lower, lower.begin(), [](const unsigned char c) { return std::tolower(c); });
+        chainLogs.push_back({
+            {"address", lower}, {"blockNumber", hexOf(head)}, {"logIndex", hexOf(logIndex++)}, {"topics", topics},
+            {"data", words}, {"removed", false}
+        });
+    };
+    const auto nextBlock = [&] {
+        head++;
+        logIndex = 0;
+    };
+    const auto sync = [&](const mpz_class &reserve0, const mpz_class &reserve1) {
+        reserves = {reserve0, reserve1};
+        reserveHistory[head] = reserves;
+        emit(pair, uniswapEvents::SyncTopic, {}, {reserve0, reserve1});
+    };
+    const auto swap = [&](const int tick) {
+        currentTick = tick;
+        emit(pool, uniswapEvents::SwapTopic, {1, 2}, {-5, 7, sqrtPriceOf(tick), activeLiquidity(), tick});
+    };
+    const auto mint = [&](const int lower, const int upper, const mpz_class &amount) {
+        positions.emplace_back(lower, upper, amount);
+        emit(pool, uniswapEvents::MintTopic, {1, lower, upper}, {1, amount, 3, 4});
+    };
+    const auto burn = [&](const int lower, const int upper, const mpz_class &amount) {
+        positions.emplace_back(lower, upper, -amount);
+        emit(pool, uniswapEvents::BurnTopic, {1, lower, upper}, {amount, 3, 4});
+    };
+
+    std::map<std::string, int> tickSlots;
+    for (int tick = -1200; tick <= 1200; tick += 60) {
+        tickSlots[uniswapStorage::mappingSlot(tick, uniswapStorage::V3TicksSlot)] = tick;
+    }
+    const auto answer = [&](const json &call) -> json {
+        std::lock_guard lock(chainMutex);
+        const std::string method = call["method"];
+        if (method == "eth_blockNumber") {
+            const std::string polled = hexOf(head);
+            if (advanceOnHead) {
+                advanceOnHead = false;
+                nextBlock();
+                sync(reserves[0] + 3, reserves[1] - 5);
+            }
+            return polled;
+        }
+        if (method == "eth_getLogs") {
+            const json &filter = call["params"][0];
+            const uint64_t from = std::stoull(filter["fromBlock"].get<std::string>(), nullptr, 16);
+            const uint64_t to = std::stoull(filter["toBlock"].get<std::string>(), nullptr, 16);
+            json logs = json::array();
+            for (const json &log: chainLogs) {
+                const uint64_t block = std::stoull(log["blockNumber"].get<std::string>(), nullptr, 16);
+                const bool watched = std::ranges::find(filter["address"], log["address"]) != filter["address"].end();
+                if (block >= from && block <= to && watched) logs.push_back(log);
+            }
+            return logs;
+        }
+        if (method == "eth_getStorageAt") {
+            const std::string slot = call["params"][1];
+            if (call["params"][0] == quietPair) return "0x" + wordHex((mpz_class(7) << 112) + 5);
+            if (call["params"][0] == quietPool) {
+                if (slot != uniswapStorage::slotHex(uniswapStorage::V3Slot0Slot)) return "0x0";
+                return "0x" + wordHex((mpz_class(1) << 240) + sqrtPriceOf(0));
+            }
+            if (call["params"][0] == pair) {
+                const std::string tag = call["params"][2];
+                const uint64_t block = tag == "latest" ? head : std::stoull(tag, nullptr, 16);
+                const auto synced = reserveHistory.upper_bound(block);
+                const auto &at = block >= head || synced == reserveHistory.begin() ? reserves
+                                                                                   : std::prev(synced)->second;
+                return "0x" + wordHex((at[1] << 112) + at[0]);
+            }
+            if (slot == uniswapStorage::slotHex(uniswapStorage::V3Slot0Slot)) {
+                const mpz_class slot0 = (mpz_class(1) << 240) + (twos(currentTick, 24) << 160) + sqrtPriceOf(currentTick);
+                return "0x" + wordHex(slot0);
+            }
+            if (slot == uniswapStorage::slotHex(uniswapStorage::V3LiquiditySlot)) {
+                return "0x" + wordHex(activeLiquidity());
+            }
+            const auto tick = tickSlots.find(slot);
+            const auto ticks = tickLiquidity();
+            if (tick == tickSlots.end() || !ticks.contains(tick->second)) return "0x0";
+            const auto &[net, gross] = ticks.at(tick->second);
+            return "0x" + wordHex((twos(net, 128) << 128) + gross);
+        }
+        const std::string selector = call["params"][0]["data"].get<std::string>().substr(2, 8);
+        if (selector == "0dfe1681") return "0x" + wordOf(0xa0);
+        if (selector == "d21220a7") return "0x" + wordOf(0xa1);
+        if (selector == "0902f1ac") return "0x" + wordHex(reserves[0]) + wordHex(reserves[1]) + wordOf(0);
+        return "0x" + wordOf(3000);
+    };
+    StandInChain chain("events", answer);
+
+    try {
+        for (const auto &[signature, topic]: std::vector<std::pair<std::string, std::string_view> >{
+                 {"Sync(uint112,uint112)", uniswapEvents::SyncTopic},
+                 {"Initialize(uint160,int24)", uniswapEvents::InitializeTopic},
+                 {"Swap(address,address,int256,int256,uint160,uint128,int24)", uniswapEvents::SwapTopic}
+             }) {
+            if (Web3Client::bytesToHex(Web3Client::keccak256(signature)) != topic) {
+                throw std::runtime_error{"Wrong topic for " + signature};
+            }
+        }
+
+        // Creation: blocks 90 to 92 initialize the pool, add two positions and sync the pair
+        emit(pool, uniswapEvents::InitializeTopic, {}, {sqrtPriceOf(-65), -65});
+        currentTick = -65;
+        nextBlock();
+        mint(-600, 600, 1000000);
+        mint(-120, 180, 500000);
+        nextBlock();
+        sync(1000, 2000);
+        for (int block = 93; block <= 100; block++) nextBlock();
+
+        chain.start();
+        chain.writePools("uniswapV2.txt", {pair, quietPair});
+        chain.writePools("uniswapV3.txt", {pool, quietPool});
+        chain.addToken("0x" + std::string(38, '0') + "a0", 18);
+        chain.addToken("0x" + std::string(38, '0') + "a1", 18);
+        ChainConfig config = chain.config();
+        config.stateRead = StateRead::Storage;
+        auto web3 = chain.client();
+        web3->setCacheEnabled(false);
+        UniswapV2 v2(web3, config);
+        UniswapV3 v3(web3, 5, config);
+        EventEngine engine(web3, {&v2, &v3}, {.reconcileInterval = 0, .maxBlockRange = 4});
+
+        // Block 100 is read over RPC, then ten blocks of trading and a Mint and a Burn arrive as logs. The pair is
+        // tiered cold meanwhile, the logs touch it so the next RPC read refreshes it
+        v2.refreshScheduler.setPolicy({.enabled = true, .hotBlocks = 1, .warmBlocks = 2, .warmInterval = 1000000000,
+                                       .coldInterval = 1000000000});
+        if (engine.update() != 100) throw std::runtime_error{"Initial read not at the head"};
+        const auto quietEntries = std::make_pair(v2.snapshot()->pools.at(quietPair), v3.snapshot()->pools.at(quietPool));
+        v2.refreshScheduler.recordRefresh({pair}, {}, 102);
+        if (!v2.refreshScheduler.due({pair}, 103).empty()) throw std::runtime_error{"Pair not tiered cold"};
+        {
+            std::lock_guard lock(chainMutex);
+            for (const int tick: {10, 130, 200, -250, -310, -100, 50, 170, -30, -45}) {
+                nextBlock();
+                sync(reserves[0] + 10, reserves[1] - 19);
+                if (head == 104) mint(-300, 60, 700000);
+                swap(tick);
+                if (head == 107) burn(-120, 180, 200000);
+            }
+        }
+        if (engine.update() != 110 || v2.snapshot().block() != 110 || v3.snapshot().block() != 110) {
+            throw std::runtime_error{"Events not applied up to the head"};
+        }
+        const auto live = v3.snapshot();
+        if (v2.snapshot()->pools.at(pair)->reserves != reserves || live->pools.at(pool)->tick != currentTick ||
+            live->pools.at(pool)->sqrtPriceX96 != sqrtPriceOf(currentTick).get_str() ||
+            live->pools.at(pool)->liquidity != activeLiquidity().get_str()) {
+            throw std::runtime_error{"Event state differs from the chain"};
+        }
+        if (v2.refreshScheduler.due({pair}, 111).size() != 1) throw std::runtime_error{"Applied logs did not touch"};
+        // Every batch replaced the pools its logs named and shared the quiet ones
+        if (v2.snapshot()->pools.at(quietPair) != quietEntries.first ||
+            live->pools.at(quietPool) != quietEntries.second) {
+            throw std::runtime_error{"A pool without logs was copied into an applied snapshot"};
+        }
+        v2.refreshScheduler.setPolicy({});
+        const auto expectedTicks = tickLiquidity();
+        for (const auto &[tick, data]: live->pools.at(pool)->ticks) {
+            if (!expectedTicks.contains(tick) ||
+                data.liquidity[0] != mpf_class(expectedTicks.at(tick).first, TickPrecision) ||
+                data.liquidity[1] != mpf_class(expectedTicks.at(tick).second, TickPrecision)) {
+                throw std::runtime_error{"Wrong event liquidity at tick " + std::to_string(tick)};
+            }
+        }
+
+        // Everything since creation, replayed without the node into fresh adapters, block by block and in steps
+        const std::string streamPath = (chain.dataDir() / "logs.jsonl").string();
+        if (engine.download(90, 110, streamPath) != chainLogs.size()) {
+            throw std::runtime_error{"Downloaded stream incomplete"};
+        }
+        UniswapV2 replayV2(web3, config);
+        UniswapV3 replayV3(web3, 5, config);
+        EventEngine replayer(web3, {&replayV2, &replayV3});
+        std::vector<UniswapV3State> replayed;
+        for (const uint64_t step: {1, 4}) {
+            replayer.reset();
+            replayer.options.replayStep = step;
+            size_t steps = 0;
+            const size_t applied = replayer.replay(streamPath, [&steps](uint64_t) { steps++; });
+            if (applied != chainLogs.size() || steps != (step == 1 ? 13 : 4) || replayer.block() != 110) {
+                throw std::runtime_error{"Replay applied " + std::to_string(applied) + " logs in " +
+                                         std::to_string(steps) + " steps"};
+            }
+            replayed.push_back(*replayV3.snapshot());
+            const auto &ticks = replayed.back().pools.at(pool)->ticks;
+            if (replayV2.snapshot()->pools.at(pair)->reserves != reserves || ticks.size() != expectedTicks.size() ||
+                replayed.back().pools.at(pool)->liquidity != activeLiquidity().get_str()) {
+                throw std::runtime_error{"Replayed state differs from the chain"};
+            }
+            for (const auto &[tick, expected]: expectedTicks) {
+                if (ticks.at(tick).liquidity[0] != mpf_class(expected.first, TickPrecision)) {
+                    throw std::runtime_error{"Wrong replayed liquidity at tick " + std::to_string(tick)};
+                }
+            }
+        }
+        if (replayed[0].pools.at(pool)->sqrtPriceX96 != replayed[1].pools.at(pool)->sqrtPriceX96 ||
+            replayed[0].pools.at(pool)->liquidity != replayed[1].pools.at(pool)->liquidity) {
+            throw std::runtime_error{"Replay steps disagree"};
+        }
+
+        // Consistent state reconciles clean; reserves changed behind the logs' back are found and replaced
+        if (engine.reconcile() != 0) throw std::runtime_error{"Drift reported on a consistent state"};
+        {
+            std::lock_guard lock(chainMutex);
+            reserves[0] += 1;
+            reserveHistory[head] = reserves;
+        }
+        if (engine.reconcile() != 1 || v2.snapshot()->pools.at(pair)->reserves != reserves) {
+            throw std::runtime_error{"Drift not detected or not repaired"};
+        }
+
+        // The head moves on right after the engine polls it: the read is still at the engine's block and compared
+        const Counter &skipped = Metrics::instance().counter("deds_event_reconcile_skipped_total", web3->labels(), "");
+        const uint64_t skippedBefore = skipped.value();
+        uint64_t engineBlock;
+        std::array<mpz_class, 2> atEngineBlock;
+        {
+            std::lock_guard lock(chainMutex);
+            engineBlock = head;
+            atEngineBlock = reserves;
+            advanceOnHead = true;
+        }
+        if (engine.reconcile() != 0 || skipped.value() != skippedBefore || v2.snapshot().block() != engineBlock ||
+            v3.snapshot().block() != engineBlock || v2.snapshot()->pools.at(pair)->reserves != atEngineBlock) {
+            throw std::runtime_error{"Reconciliation did not read at the engine's block"};
+        }
+        if (engine.update() != engineBlock + 1 || v2.snapshot()->pools.at(pair)->reserves != reserves) {
+            throw std::runtime_error{"Sync after the reconciled block not applied"};
+        }
+
+        std::cout << chainLogs.size() << " logs rebuilt both pools exactly, live and replayed, drift caught\n";
+        std::cout << "Event engine tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "Event engine test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Test shared-memory publication against a second mapping, offline
+bool testSharedState() {
+    std::cout << "=== Testing shared-memory state ===\n";
+
+    const std::string name = "/deds_test_" + std::to_string(getpid());
+    try {
+        const Token weth{"0xweth", "WETH", "Wrapped Ether", 18, 0};
+        const Token usdc{"0xusdc", "USDC", "USD Coin", 6, 1};
+        StaticExchange exchange;
+        exchange.addPool("0xV2", weth, usdc);
+        exchange.addPool("0xv3", weth, weth);
+
+        auto publisher = std::make_unique<SharedStatePublisher>(name, std::vector<const ExchangeBase *>{&exchange});
+        SharedStateReader reader(name);
+        const auto v2 = reader.indexOf("0xv2");
+        const auto v3 = reader.indexOf("0xV3");
+        if (reader.size() != 2 || !v2 || !v3 || reader.exchangeOf(*v2) != "Static" ||
+            reader.decimals(*v2) != std::array{18, 6} || !std::isnan(reader.read(*v2).price[0])) {
+            throw std::runtime_error{"Unexpected directory"};
+        }
+
+        // 10 WETH against 25000 USDC; sqrtPriceX96 = 2^96 and the largest uint128 liquidity span limbs
+        mpz_class q96;
+        mpz_ui_pow_ui(q96.get_mpz_t(), 2, 96);
+        const mpz_class maxUint128("340282366920938463463374607431768211455");
+        ChangeSet changes;
+        changes.exchange = "Static";
+        changes.block = 100;
+        changes.changes = {
+            {"0xV2", PoolChange::Kind::Reserves, 0, {}, {mpz_class("10000000000000000000"), mpz_class(25000000000)}},
+            {"0xv3", PoolChange::Kind::SqrtPrice, 0, {}, {q96, 0}},
+            {"0xv3", PoolChange::Kind::TickLiquidity, 60, {}, {1, 1}},
+            {"0xv3", PoolChange::Kind::Liquidity, 0, {}, {maxUint128, 0}},
+        };
+        publisher->apply(changes);
+
+        const SharedPool pair = reader.read(*v2);
+        const SharedPool pool = reader.read(*v3);
+        if (pair.block != 100 || pair.reserve0 != std::array<uint64_t, 2>{10000000000000000000ull, 0} ||
+            pair.reserve1[0] != 25000000000 || std::abs(pair.price[0] - 2500.0) > 1e-9 ||
+            pool.sqrtPriceX96 != std::array<uint64_t, 3>{0, 1ull << 32, 0} ||
+            pool.liquidity != std::array<uint64_t, 2>{~0ull, ~0ull} || std::abs(pool.price[1] - 1.0) > 1e-12 ||
+            reader.block("Static") != 100 || publisher->recordsWritten() != 2) {
+            throw std::runtime_error{"Unexpected record"};
+        }
+
+        // Older change sets are ignored
+        changes.block = 99;
+        changes.changes = {{"0xV2", PoolChange::Kind::Reserves, 0, {}, {mpz_class(1), mpz_class(1)}}};
+        publisher->apply(changes);
+        if (reader.read(*v2).reserve0[0] != 10000000000000000000ull) {
+            throw std::runtime_error{"Stale change applied"};
+        }
+
+        // A writer rewriting reserve1 = 3 * reserve0 = 3 * block must never be seen half done
+        std::atomic<bool> done{false};
+        std::thread writer([&] {
+            for (uint64_t block = 101; block <= 100000; block++) {
+                ChangeSet next;
+                next.exchange = "Static";
+                next.block = block;
+                next.changes = {{"0xV2", PoolChange::Kind::Reserves, 0, {}, {mpz_class(block), mpz_class(3 * block)}}};
+                publisher->apply(next);
+            }
+            done = true;
+        });
+        size_t reads = 0;
+        while (!done) {
+            const SharedPool read = reader.read(*v2);
+            if (read.block >= 101 && (read.reserve0[0] != read.block || read.reserve1[0] != 3 * read.block)) {
+                writer.join();
+                throw std::runtime_error{"Torn read at block " + std::to_string(read.block)};
+            }
+            reads++;
+        }
+        writer.join();
+
+        publisher.reset();
+        if (reader.live()) {
+            throw std::runtime_error{"Closed segment still live"};
+        }
+        try {
+            SharedStateReader gone(name);
+            throw std::logic_error{"Unlinked segment opened"};
+        } catch (const std::runtime_error &) {
+        }
+
+        std::cout << reads << " consistent reads while 99900 change sets were published\n";
+        std::cout << "Shared-memory state tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        shm_unlink(name.c_str());
+        std::cerr << "Shared-memory state test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Test the orchestrator offline: nested fan-out on a small pool, adapter cycles side by side, and a failing
+// adapter counted in the cycle report while the others complete
+bool testOrchestratorCycles() {
+    std::cout << "=== Testing orchestrator cycles ===\n";
+
+    const std::string pair = "0x00000000000000000000000000000000000000a4";
+    std::atomic<bool> down{false};
+    StandInChain chain("orchestrator", [&](const json &call) -> json {
+        if (call["method"] == "eth_blockNumber") return "0x20";
+        const std::string selector = call["params"][0]["data"].get<std::string>().substr(2, 8);
+        if (selector == "0dfe1681") return "0x" + wordOf(0xe0);
+        if (selector == "d21220a7") return "0x" + wordOf(0xe1);
+        if (down) throw std::runtime_error{"node unavailable"};
+        return "0x" + wordOf(5) + wordOf(7) + wordOf(0);
+    });
+    try {
+        chain.start();
+        chain.writePools("uniswapV2.txt", {pair});
+        chain.addToken("0x" + std::string(38, '0') + "e0", 18);
+        chain.addToken("0x" + std::string(38, '0') + "e1", 18);
+        // Every cycle reaches the node, the head never moves
+        const auto web3 = chain.client();
+        web3->setCacheEnabled(false);
+        UpdateOrchestrator orchestrator(web3, 2);
+
+        // Two workers, each outer task awaiting its own subtasks: waits run queued work instead of blocking
+        std::vector<std::future<int> > outer;
+        for (int task = 0; task < 4; task++) {
+            outer.push_back(orchestrator.getThreadPool().submit([] {
+                ThreadPool &pool = *ThreadPool::current();
+                std::vector<std::future<int> > inner;
+                for (int i = 0; i < 32; i++) inner.push_back(pool.submit([i] { return i; }));
+                int sum = 0;
+                for (auto &future: inner) sum += pool.await(future);
+                return sum;
+            }));
+        }
+        for (auto &future: outer) {
+            if (future.get() != 32 * 31 / 2) throw std::runtime_error{"Thread pool returned a wrong result"};
+        }
+
+        orchestrator.addExchange(std::make_unique<FanOutExchange>(web3, chain.config(), 2,
+                                                                  std::chrono::milliseconds(100)));
+        orchestrator.addExchange<UniswapV2>(chain.config());
+        orchestrator.waitLoaded();
+
+        // Waiting subtasks of one adapter and the other adapter's cycle share the two workers
+        CycleReport report = orchestrator.runCycle();
+        if (report.failures != 0 || report.exchangeSeconds.size() != 2) {
+            throw std::runtime_error{"Clean cycle reported " + std::to_string(report.failures) + " failures"};
+        }
+
+        const MetricLabels v2Labels{{"chain", "orchestrator"}, {"exchange", "UniswapV2"}};
+        Counter &errors = Metrics::instance().counter("deds_update_errors_total", v2Labels);
+        down = true;
+        report = orchestrator.runCycle();
+        if (report.failures != 1 || errors.value() != 1 || orchestrator.getExchanges()[1]->stateBlock() != 0x20) {
+            throw std::runtime_error{"Failed adapter cycle not counted"};
+        }
+        down = false;
+        if (orchestrator.runCycle().failures != 0) throw std::runtime_error{"Adapter did not recover"};
+
+        std::cout << "Nested fan-out on 2 workers, failed V2 cycle reported, state kept\n";
+        std::cout << "Orchestrator cycle tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "Orchestrator cycle test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Test a recording replayed by the stand-in node, offline: batches split by id, answers in recorded order, pinned
+// block tags, batch limits and misses
+bool testRpcReplay() {
+    std::cout << "=== Testing RPC record and replay ===\n";
+
+    const std::string path = (std::filesystem::temp_directory_path() / "deds_replay_test.jsonl").string();
+    try {
+        std::filesystem::remove(path);
+        const std::string pool = "0x00000000000000000000000000000000000000C3";
+        const auto call = [](const int id, const std::string &method, const json &params) {
+            return json{{"jsonrpc", "2.0"}, {"id", id}, {"method", method}, {"params", params}};
+        };
+        {
+            RpcRecorder recorder(path);
+            // Answered out of order, the third call not at all
+            recorder.record(json::array({
+                                call(1, "eth_getStorageAt", {pool, "0x0", "latest"}),
+                                call(2, "eth_getStorageAt", {pool, "0x1", "latest"}),
+                                call(3, "eth_getBalance", {pool, "latest"})
+                            }),
+                            json::array({{{"id", 2}, {"result", "0x22"}}, {{"id", 1}, {"result", "0x11"}}}));
+            for (const std::string head: {"0x64", "0x65", "0x66"}) {
+                recorder.record(call(7, "eth_blockNumber", json::array()), {{"id", 7}, {"result", head}});
+            }
+            recorder.record(call(8, "eth_call", {{{"to", pool}, {"data", "0x"}}, "latest"}),
+                            {{"id", 8}, {"error", {{"code", 3}, {"message", "execution reverted"}}}});
+            if (recorder.recorded() != 6) throw std::runtime_error{"Recorded " + std::to_string(recorder.recorded())};
+        }
+
+        std::vector<json> lines;
+        std::ifstream file(path);
+        for (std::string line; std::getline(file, line);) lines.push_back(json::parse(line));
+        if (lines.size() != 6 || lines[0]["params"][1] != "0x0" || lines[0]["result"] != "0x11" ||
+            lines[1]["params"][1] != "0x1" || lines[1]["result"] != "0x22" || lines[5]["error"]["code"] != 3) {
+            throw std::runtime_error{"Batch not split into one line per call by id"};
+        }
+
+        RpcReplayServer node(path, {.maxBatchSize = 2});
+        node.start();
+        if (node.entries() != 4) throw std::runtime_error{"Loaded " + std::to_string(node.entries()) + " requests"};
+
+        // Over HTTP the repeated request follows the recording, then sticks to its last answer
+        Web3Client web3(node.url());
+        for (const uint64_t expected: {100, 101, 102, 102}) {
+            if (web3.getBlockNumber() != expected) throw std::runtime_error{"Block numbers not replayed in order"};
+        }
+
+        // A pinned block tag and another address case find the "latest" recording
+        std::string lower = pool;
+        std::ranges::transform(lower, lower.begin(), [](const unsigned char c) { return std::tolower(c); });
+        if (node.handle(call(9, "eth_getStorageAt", {lower, "0x1", Web3Client::blockTag(500)}))["result"] != "0x22") {
+            throw std::runtime_error{"Pinned block tag did not fall back to latest"};
+        }
+        if (node.handle(call(10, "eth_call", {{{"to", pool}, {"data", "0x"}}, "latest"}))["error"]["code"] != 3) {
+            throw std::runtime_error{"Recorded error not replayed"};
+        }
+
+        const json rejected = node.handle(json::array({
+            call(11, "eth_blockNumber", json::array()), call(12, "eth_blockNumber", json::array()),
+            call(13, "eth_blockNumber", json::array())
+        }));
+        if (!rejected.is_object() || rejected["error"]["code"] != -32005) {
+            throw std::runtime_error{"Oversized batch not rejected: " + rejected.dump()};
+        }
+        const json unanswered = node.handle(call(14, "eth_getBalance", {pool, "latest"}));
+        if (unanswered["error"]["code"] != -32000 || unanswered["id"] != 14) {
+            throw std::runtime_error{"Unrecorded request answered: " + unanswered.dump()};
+        }
+        const RpcReplayServer::Stats stats = node.stats();
+        if (stats.rejectedBatches != 1 || stats.misses != 1 || stats.httpRequests != 4) {
+            throw std::runtime_error{"Wrong replay stats"};
+        }
+        node.stop();
+        std::filesystem::remove(path);
+
+        std::cout << "Batch split by id, order then last answer kept, latest fallback, limit and miss errors\n";
+        std::cout << "RPC record and replay tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        std::filesystem::remove(path);
+        std::cerr << "RPC record and replay test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
+// Test the arena's object lifetimes across chunks and the token registry's ids and references, offline
+bool testArenaAndTokens() {
+    std::cout << "=== Testing arena and token registry ===\n";
+
+    try {
+        // Chunks of 16, 16, 32, 32 and 32 objects for 100; every object destroyed once, last created first
+        struct Counted {
+            int value;
+            std::vector<int> *destroyed;
+
+            ~Counted() {
+                destroyed->push_back(value);
+            }
+        };
+        for (const int count: {0, 16, 100}) {
+            std::vector<int> destroyed;
+            std::vector<Counted *> created;
+            {
+                Arena<Counted, 32> arena;
+                for (int i = 0; i < count; i++) created.push_back(arena.create(i, &destroyed));
+                for (int i = 0; i < count; i++) {
+                    if (created[i]->value != i) throw std::runtime_error{"Object moved by a later chunk"};
+                }
+                const size_t chunked = count == 100 ? 128 : count == 16 ? 16 : 0;
+                if (arena.size() != static_cast<size_t>(count) || arena.reservedBytes() != chunked * sizeof(Counted)) {
+                    throw std::runtime_error{"Wrong arena size or chunks for " + std::to_string(count)};
+                }
+            }
+            std::vector<int> expected(count);
+            for (int i = 0; i < count; i++) expected[i] = count - 1 - i;
+            if (destroyed != expected) {
+                throw std::runtime_error{"Destroyed " + std::to_string(destroyed.size()) + " of " +
+                                         std::to_string(count) + " objects, or out of order"};
+            }
+        }
+
+        // One id per chain and address, a repeat returns it without a new record
+        TokenRegistry &registry = TokenRegistry::instance();
+        const TokenId first = registry.insert({"0xregistry", "R", "R", 18, 0, "one"});
+        const size_t registered = registry.size();
+        const TokenId repeat = registry.insert({"0xregistry", "Other", "Other", 6, 0, "one"});
+        const TokenId otherChain = registry.insert({"0xregistry", "R", "R", 18, 0, "two"});
+        if (repeat != first || otherChain == first || registry.size() != registered + 1 ||
+            registry.get(repeat).symbol != "R" || registry.get(otherChain).chain != "two") {
+            throw std::runtime_error{"Wrong ids for repeated or cross-chain tokens"};
+        }
+
+        // References from get survive any number of later inserts
+        const Token &held = registry.get(first);
+        for (int i = 0; i < 5000; i++) registry.insert({"0xregistry" + std::to_string(i), "F", "F", 18, 0, "one"});
+        if (&registry.get(first) != &held || held.address != "0xregistry" ||
+            held.tokenGlobalIndice != static_cast<int>(first)) {
+            throw std::runtime_error{"Token record moved by later inserts"};
+        }
+        bool unknown = false;
+        try {
+            registry.get(static_cast<TokenId>(registry.size()));
+        } catch (const std::out_of_range &) {
+            unknown = true;
+        }
+        if (!unknown) throw std::runtime_error{"Unknown token id returned a record"};
+
+        std::cout << "Arena and token registry tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "Arena and token registry test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
 // Test Web3Client and Contract functionality
 bool testWeb3ClientContract() {
     std::cout << "=== Testing Web3Client + Contract ===\n";
 
     try {
-        auto web3 = std::make_shared<Web3Client>();
+        auto web3 = makeClient();
 
         auto blockNumber = web3->sendRpcRequest("eth_blockNumber");
         std::cout << "Latest block: " << blockNumber.get<std::string>() << "\n";
@@ -64,12 +2685,18 @@ bool testUniswapV2() {
     std::cout << "=== Testing Uniswap V2 ===\n";
 
     try {
-        auto web3 = std::make_shared<Web3Client>();
+        auto web3 = makeClient();
         UniswapV2 uniV2(web3);
 
         uniV2.updatePools();
         std::cout << "Loaded " << uniV2.pools.size() << " V2 pools\n";
 
+        const auto v2State = uniV2.snapshot();
+        std::cout << "Snapshot version " << v2State.version() << " at block " << v2State.block() << "\n";
+
+        PriceTable prices(uniV2);
+        prices.attach(uniV2);
+
         if (!uniV2.pools.empty()) {
             // Sample first 3 pools
             int count = 0;
@@ -77,30 +2704,16 @@ bool testUniswapV2() {
                 if (count >= 3) break;
 
                 std::cout << "Pool " << (count + 1) << ": " << poolAddress.substr(0, 10) << "...\n";
-                if (pool->tokens.size() >= 2) {
-                    std::cout << "  Pair: " << pool->tokens[0]->symbol << "/" << pool->tokens[1]->symbol << "\n";
+                if (pool->tokenCount() >= 2) {
+                    std::cout << "  Pair: " << pool->token(0).symbol << "/" << pool->token(1).symbol << "\n";
                     std::cout << "  Fee: " << pool->fee << "\n";
 
-                    // Calculate price from reserves
-                    auto reservesIt = uniV2.poolsReserves.find(poolAddress);
-                    if (reservesIt != uniV2.poolsReserves.end() && reservesIt->second.size() >= 2) {
-                        mpf_class reserve0(reservesIt->second[0]);
-                        mpf_class reserve1(reservesIt->second[1]);
-
-                        // Decimal adjustment
-                        mpf_class divisor0 = 1;
-                        mpf_class divisor1 = 1;
-                        for (int i = 0; i < pool->tokens[0]->decimals; i++) divisor0 *= 10;
-                        for (int i = 0; i < pool->tokens[1]->decimals; i++) divisor1 *= 10;
-
-                        mpf_class adjustedReserve0 = reserve0 / divisor0;
-                        mpf_class adjustedReserve1 = reserve1 / divisor1;
-
-                        if (adjustedReserve0 > 0) {
-                            mpf_class price = adjustedReserve1 / adjustedReserve0;
-                            std::cout << "  Price: " << price << " " << pool->tokens[1]->symbol
-                                    << " per " << pool->tokens[0]->symbol << "\n";
-                        }
+                    // Decimal-adjusted price from the incrementally maintained table
+                    const auto index = prices.indexOf(poolAddress);
+                    const PriceQuote quote = prices.quote(*index);
+                    if (!std::isnan(quote.price)) {
+                        std::cout << "  Price: " << quote.price << " " << pool->token(1).symbol
+                                << " per " << pool->token(0).symbol << " (block " << quote.block << ")\n";
                     } else {
                         std::cout << "  Price: No reserve data\n";
                     }
@@ -108,7 +2721,7 @@ bool testUniswapV2() {
                 count++;
             }
 
-            std::cout << "Pools with reserves: " << uniV2.poolsReserves.size() << "\n";
+            std::cout << "Pools with reserves: " << v2State->pools.size() << "\n";
         }
 
         std::cout << "Uniswap V2 tests passed\n\n";
@@ -124,12 +2737,15 @@ bool testUniswapV3() {
     std::cout << "=== Testing Uniswap V3 ===\n";
 
     try {
-        auto web3 = std::make_shared<Web3Client>();
+        auto web3 = makeClient();
         UniswapV3 uniV3(web3,5); // Using a tick range of 5 around current tick for testing
 
         uniV3.updatePools();
         std::cout << "Loaded " << uniV3.pools.size() << " V3 pools\n";
 
+        const auto v3State = uniV3.snapshot();
+        std::cout << "Snapshot version " << v3State.version() << " at block " << v3State.block() << "\n";
+
         if (!uniV3.pools.empty()) {
             // Sample first 3 pools
             int count = 0;
@@ -141,22 +2757,15 @@ bool testUniswapV3() {
                 std::cout << "  Fee: " << pool->fee << "\n";
 
                 // Token pair info
-                if (pool->tokens.size() >= 2) {
-                    std::cout << "  Pair: " << pool->tokens[0]->symbol << "/" << pool->tokens[1]->symbol << "\n";
+                if (pool->tokenCount() >= 2) {
+                    std::cout << "  Pair: " << pool->token(0).symbol << "/" << pool->token(1).symbol << "\n";
                 }
 
                 // Tick data
-                auto poolReservesIt = uniV3.poolsReserves.find(poolAddress);
-                if (poolReservesIt != uniV3.poolsReserves.end() && !poolReservesIt->second.empty()) {
-                    std::cout << "  Ticks: " << poolReservesIt->second.size() << "\n";
-
-                    // Display sqrt price data
-                    auto sqrtPriceIt = uniV3.poolSqrtPriceX96.find(poolAddress);
-                    if (sqrtPriceIt != uniV3.poolSqrtPriceX96.end()) {
-                        std::cout << "  SqrtPrice96: " << sqrtPriceIt->second << "\n";
-                    } else {
-                        std::cout << "  SqrtPrice96: Not available\n";
-                    }
+                auto poolStateIt = v3State->pools.find(poolAddress);
+                if (poolStateIt != v3State->pools.end() && !poolStateIt->second->ticks.empty()) {
+                    std::cout << "  Ticks: " << poolStateIt->second->ticks.size() << "\n";
+                    std::cout << "  SqrtPrice96: " << poolStateIt->second->sqrtPriceX96 << "\n";
                 } else {
                     std::cout << "  Ticks: 0\n";
                 }
@@ -164,10 +2773,7 @@ bool testUniswapV3() {
             }
 
             // Pool statistics
-            std::cout << "Pools with tick data: " << uniV3.poolsReserves.size() << "\n";
-            if (!uniV3.poolSqrtPriceX96.empty()) {
-                std::cout << "Pools with sqrt price data: " << uniV3.poolSqrtPriceX96.size() << "\n";
-            }
+            std::cout << "Pools with tick data: " << v3State->pools.size() << "\n";
         }
 
         std::cout << "Uniswap V3 tests passed\n\n";
@@ -178,9 +2784,129 @@ bool testUniswapV3() {
     }
 }
 
+// Test concurrent update cycles of V2 and V3 sharing one client
+bool testOrchestrator() {
+    std::cout << "=== Testing Update Orchestrator ===\n";
+
+    try {
+        UpdateOrchestrator orchestrator(makeClient(), 4);
+
+        // Nested fan-out: tasks awaiting their own subtasks must not deadlock the pool
+        auto outer = orchestrator.getThreadPool().submit([] {
+            ThreadPool &pool = *ThreadPool::current();
+            std::vector<std::future<int> > inner;
+            for (int i = 0; i < 64; i++) {
+                inner.push_back(pool.submit([i] { return i; }));
+            }
+            int sum = 0;
+            for (auto &future: inner) sum += pool.await(future);
+            return sum;
+        });
+        if (outer.get() != 64 * 63 / 2) {
+            throw std::runtime_error{"Thread pool returned a wrong result"};
+        }
+
+        orchestrator.addExchange<UniswapV2>();
+        orchestrator.addExchange<UniswapV3>(5);
+        orchestrator.waitLoaded();
+
+        for (int cycle = 0; cycle < 2; cycle++) {
+            CycleReport report = orchestrator.runCycle();
+            double sum = 0;
+            for (const auto &[name, seconds]: report.exchangeSeconds) {
+                std::cout << "  " << name << ": " << seconds << " s\n";
+                sum += seconds;
+            }
+            std::cout << "Cycle " << cycle + 1 << ": " << report.seconds << " s (sequential sum " << sum << " s)\n";
+            if (report.failures != 0) {
+                throw std::runtime_error{std::to_string(report.failures) + " adapter cycles failed"};
+            }
+        }
+
+        std::cout << "Update Orchestrator tests passed\n\n";
+        return true;
+    } catch (const std::exception &e) {
+        std::cerr << "Update Orchestrator test failed: " << e.what() << "\n\n";
+        return false;
+    }
+}
+
 // Main function - run all tests
-int main() {
+// Usage: DEDS [--rpc URL] [--record FILE], e.g. --rpc http://127.0.0.1:8545 against DEDSReplayNode
+int main(int argc, char *argv[]) {
+    for (int i = 1; i + 1 < argc; i += 2) {
+        const std::string arg = argv[i];
+        if (arg == "--rpc") rpcUrl = argv[i + 1];
+        else if (arg == "--record") recordPath = argv[i + 1];
+    }
+
     int passed = 0;
+    if (testKeccak()) {
+        passed++;
+    }
+    if (testAbiBindings()) {
+        passed++;
+    }
+    if (testSnapshots()) {
+        passed++;
+    }
+    if (testChangeSets()) {
+        passed++;
+    }
+    if (testPriceTable()) {
+        passed++;
+    }
+    if (testColumnarExport()) {
+        passed++;
+    }
+    if (testBackfill()) {
+        passed++;
+    }
+    if (testBlockDriver()) {
+        passed++;
+    }
+    if (testChainSet()) {
+        passed++;
+    }
+    if (testStateReads()) {
+        passed++;
+    }
+    if (testTransport()) {
+        passed++;
+    }
+    if (testCallCache()) {
+        passed++;
+    }
+    if (testMetrics()) {
+        passed++;
+    }
+    if (testRefreshTiers()) {
+        passed++;
+    }
+    if (testRouter()) {
+        passed++;
+    }
+    if (testDepthCurves()) {
+        passed++;
+    }
+    if (testSlidingTicks()) {
+        passed++;
+    }
+    if (testEventEngine()) {
+        passed++;
+    }
+    if (testSharedState()) {
+        passed++;
+    }
+    if (testOrchestratorCycles()) {
+        passed++;
+    }
+    if (testRpcReplay()) {
+        passed++;
+    }
+    if (testArenaAndTokens()) {
+        passed++;
+    }
     if (testWeb3ClientContract()) {
         passed++;
     }
@@ -190,6 +2916,9 @@ int main() {
     if (testUniswapV3()) {
         passed++;
     }
+    if (testOrchestrator()) {
+        passed++;
+    }
 
     return passed;
 }
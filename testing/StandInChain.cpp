@@ -0,0 +1,81 @@
+#include "StandInChain.h"
+
+#include <fstream>
+#include <unistd.h>
+
+#include "../exchanges/TokenRegistry.h"
+
+// Constructor: Fresh data directory per process, so concurrent test runs do not share pool lists
+StandInChain::StandInChain(std::string name, Answer answer)
+    : name(std::move(name)),
+      directory(std::filesystem::temp_directory_path() /
+                ("deds_" + this->name + "_" + std::to_string(getpid()))),
+      answer(std::move(answer)),
+      server(0, [this](const HttpRequest &request) { return serve(request); }) {
+    std::filesystem::remove_all(directory);
+    std::filesystem::create_directories(directory);
+}
+
+// Destructor: Stop answering before the answer function's captures go away
+StandInChain::~StandInChain() {
+    server.stop();
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+}
+
+// Start listening
+void StandInChain::start() {
+    server.start();
+}
+
+// Stop listening
+void StandInChain::stop() {
+    server.stop();
+}
+
+// Get URL to hand to Web3Client
+std::string StandInChain::url() const {
+    return "http://127.0.0.1:" + std::to_string(server.port());
+}
+
+// Get the data directory holding the pool lists
+const std::filesystem::path &StandInChain::dataDir() const {
+    return directory;
+}
+
+// Write one pool list
+void StandInChain::writePools(const std::string &file, const std::vector<std::string> &pools) const {
+    std::ofstream poolFile(directory / file);
+    for (const std::string &pool: pools) poolFile << pool << "\n";
+}
+
+// Register a token under the chain name
+void StandInChain::addToken(const std::string &address, const int decimals, const std::string &symbol) const {
+    TokenRegistry::instance().insert({address, symbol, symbol, decimals, 0, name});
+}
+
+// Config for adapters on this chain
+ChainConfig StandInChain::config() const {
+    return ChainConfig{.name = name, .dataDir = directory.string()};
+}
+
+// Client of the node
+std::shared_ptr<Web3Client> StandInChain::client() const {
+    return std::make_shared<Web3Client>(url(), name);
+}
+
+// Answer a call or a batch of calls
+HttpResponse StandInChain::serve(const HttpRequest &request) const {
+    const json body = json::parse(request.body);
+    const auto respond = [this](const json &call) {
+        try {
+            return json{{"jsonrpc", "2.0"}, {"id", call["id"]}, {"result", answer(call)}};
+        } catch (const std::exception &e) {
+            return json{{"jsonrpc", "2.0"}, {"id", call["id"]}, {"error", {{"code", -32000}, {"message", e.what()}}}};
+        }
+    };
+    if (!body.is_array()) return {200, "application/json", respond(body).dump()};
+    json responses = json::array();
+    for (const auto &call: body) responses.push_back(respond(call));
+    return {200, "application/json", responses.dump()};
+}
@@ -0,0 +1,65 @@
+#ifndef STAND_IN_CHAIN_H
+#define STAND_IN_CHAIN_H
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "../exchanges/ChainConfig.h"
+#include "../utils/HttpServer.h"
+#include "../utils/Web3Client.h"
+
+using json = nlohmann::json;
+
+// A simulated chain for offline tests and benchmarks: a local JSON-RPC node answering each call from a function,
+// and a temporary data directory with the adapters' pool lists. Batches are answered call by call; a call the
+// function throws on gets a JSON-RPC error with the exception's message
+class StandInChain {
+public:
+    // Result of one JSON-RPC call object
+    using Answer = std::function<json(const json &call)>;
+
+    // Creates an empty data directory named after the chain, the node is opened by start()
+    StandInChain(std::string name, Answer answer);
+
+    // Stops the node and removes the data directory
+    ~StandInChain();
+
+    StandInChain(const StandInChain &) = delete;
+
+    StandInChain &operator=(const StandInChain &) = delete;
+
+    void start();
+
+    void stop();
+
+    [[nodiscard]] std::string url() const;
+
+    [[nodiscard]] const std::filesystem::path &dataDir() const;
+
+    // Write a pool list, uniswapV2.txt or uniswapV3.txt, one address per line
+    void writePools(const std::string &file, const std::vector<std::string> &pools) const;
+
+    // Register a token on this chain so the adapters skip its ERC20 calls
+    void addToken(const std::string &address, int decimals, const std::string &symbol = "T") const;
+
+    // Chain name and data directory, the rest default
+    [[nodiscard]] ChainConfig config() const;
+
+    // Client of the node, labelled with the chain name
+    [[nodiscard]] std::shared_ptr<Web3Client> client() const;
+
+private:
+    std::string name;
+    std::filesystem::path directory;
+    Answer answer;
+    HttpServer server;
+
+    HttpResponse serve(const HttpRequest &request) const;
+};
+
+#endif //STAND_IN_CHAIN_H
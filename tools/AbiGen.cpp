@@ -0,0 +1,259 @@
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "../utils/Keccak.h"
+
+using json = nlohmann::json;
+
+// One ABI parameter mapped onto a codec tag from utils/AbiCodec.h
+struct GenParam {
+    std::string name;
+    std::string type;
+    std::string codec;
+    bool dynamic = false;
+};
+
+static const std::set<std::string> cppKeywords = {
+    "alignas", "alignof", "and", "asm", "auto", "bool", "break", "case", "catch", "char", "class", "const",
+    "constexpr", "continue", "decltype", "default", "delete", "do", "double", "else", "enum", "explicit", "export",
+    "extern", "false", "float", "for", "friend", "goto", "if", "inline", "int", "long", "mutable", "namespace",
+    "new", "noexcept", "not", "nullptr", "operator", "or", "private", "protected", "public", "register", "return",
+    "short", "signed", "sizeof", "static", "struct", "switch", "template", "this", "throw", "true", "try",
+    "typedef", "typeid", "typename", "union", "unsigned", "using", "virtual", "void", "volatile", "while", "xor"
+};
+
+// Make an ABI name usable as a C++ identifier
+static std::string identifier(const std::string &name, const std::string &fallback) {
+    std::string id = name.empty() ? fallback : name;
+    for (char &c: id) {
+        if (!std::isalnum(static_cast<unsigned char>(c)) && c != '_') c = '_';
+    }
+    if (std::isdigit(static_cast<unsigned char>(id[0])) || cppKeywords.contains(id)) id += '_';
+    return id;
+}
+
+// Map a Solidity type to its codec tag, empty when the static codec cannot handle it
+static std::string codecFor(const std::string &type, bool &dynamic) {
+    dynamic = false;
+    if (type.find('[') != std::string::npos || type.starts_with("tuple")) return "";
+    if (type == "address") return "Address";
+    if (type == "bool") return "Bool";
+    if (type == "string") {
+        dynamic = true;
+        return "String";
+    }
+    if (type == "bytes") {
+        dynamic = true;
+        return "Bytes";
+    }
+    if (type.starts_with("bytes")) return "FixedBytes<" + type.substr(5) + ">";
+    if (type.starts_with("uint")) return "Uint<" + (type.size() > 4 ? type.substr(4) : "256") + ">";
+    if (type.starts_with("int")) return "Int<" + (type.size() > 3 ? type.substr(3) : "256") + ">";
+    return "";
+}
+
+// C++ parameter type for an encoder argument
+static std::string argumentType(const GenParam &param) {
+    if (param.codec == "Address" || param.codec.starts_with("FixedBytes")) return "const std::string_view";
+    if (param.codec == "Bool") return "const bool";
+    return "const abi::" + param.codec + "::Value &";
+}
+
+// Parse inputs or outputs, returns false if any parameter is unsupported
+static bool parseParams(const json &entries, const std::string &prefix, std::vector<GenParam> &params) {
+    for (size_t i = 0; i < entries.size(); i++) {
+        GenParam param;
+        param.type = entries[i]["type"].get<std::string>();
+        param.name = identifier(entries[i].value("name", ""), prefix + std::to_string(i));
+        param.codec = codecFor(param.type, param.dynamic);
+        if (param.codec.empty()) return false;
+        params.push_back(param);
+    }
+    return true;
+}
+
+// Emit the call descriptor for one view function
+static void writeCall(std::ostream &out, const std::string &name, const std::string &signature,
+                      const std::vector<GenParam> &inputs, const std::vector<GenParam> &outputs) {
+    const Keccak::Digest digest = Keccak::hash(signature);
+    char selectorHex[9];
+    std::snprintf(selectorHex, sizeof(selectorHex), "%02x%02x%02x%02x", digest[0], digest[1], digest[2], digest[3]);
+
+    out << "        // " << signature << "\n";
+    out << "        struct " << name << " {\n";
+    out << "            static constexpr std::string_view signature = \"" << signature << "\";\n";
+    out << "            static constexpr uint32_t selector = 0x" << selectorHex << "u;\n";
+    out << "            static constexpr char selectorHex[9] = \"" << selectorHex << "\";\n";
+    out << "            static constexpr size_t argumentWords = " << inputs.size() << ";\n";
+    out << "            static constexpr size_t resultWords = " << outputs.size() << ";\n\n";
+
+    if (outputs.size() == 1) {
+        out << "            using Result = abi::" << outputs[0].codec << "::Value;\n\n";
+    } else {
+        out << "            struct Result {\n";
+        for (const auto &output: outputs) {
+            out << "                abi::" << output.codec << "::Value " << output.name << "{};\n";
+        }
+        out << "            };\n\n";
+    }
+
+    out << "            static std::string encode(";
+    for (size_t i = 0; i < inputs.size(); i++) {
+        out << (i ? ", " : "") << argumentType(inputs[i]) << " " << inputs[i].name;
+    }
+    out << ") {\n";
+    out << "                std::string data = abi::calldata(selectorHex, argumentWords);\n";
+    for (size_t i = 0; i < inputs.size(); i++) {
+        out << "                abi::" << inputs[i].codec << "::encode(abi::argumentSlot(data, " << i << "), "
+                << inputs[i].name << ");\n";
+    }
+    out << "                return data;\n";
+    out << "            }\n\n";
+
+    out << "            static Result decode(const std::string_view response) {\n";
+    out << "                const std::string_view body = abi::responseBody(response, resultWords);\n";
+    if (outputs.size() == 1) {
+        out << "                return abi::" << outputs[0].codec << "::decode(body, 0);\n";
+    } else {
+        out << "                Result result;\n";
+        for (size_t i = 0; i < outputs.size(); i++) {
+            out << "                result." << outputs[i].name << " = abi::" << outputs[i].codec
+                    << "::decode(body, " << i * 64 << ");\n";
+        }
+        out << "                return result;\n";
+    }
+    out << "            }\n";
+    out << "        };\n\n";
+}
+
+// Emit the Binding method forwarding to a call descriptor
+static void writeBindingMethod(std::ostream &out, const std::string &name, const std::vector<GenParam> &inputs) {
+    out << "        [[nodiscard]] calls::" << name << "::Result " << name << "(";
+    for (const auto &input: inputs) {
+        out << argumentType(input) << " " << input.name << ", ";
+    }
+    out << "const std::string &blockTag = \"latest\") const {\n";
+    out << "            return calls::" << name << "::decode(web3->callRaw(address, calls::" << name << "::encode(";
+    for (size_t i = 0; i < inputs.size(); i++) {
+        out << (i ? ", " : "") << inputs[i].name;
+    }
+    out << "), blockTag));\n";
+    out << "        }\n\n";
+}
+
+// Generate typed bindings for every view/pure function of an ABI
+static std::string generate(const json &abi, const std::string &contract, const std::string &source) {
+    std::ostringstream calls;
+    std::ostringstream methods;
+    std::set<std::string> seen;
+
+    for (const auto &entry: abi) {
+        if (entry.value("type", "") != "function") continue;
+        const std::string mutability = entry.value("stateMutability", entry.value("constant", false) ? "view" : "");
+        if (mutability != "view" && mutability != "pure") continue;
+
+        std::string signature = entry["name"].get<std::string>() + "(";
+        for (size_t i = 0; i < entry["inputs"].size(); i++) {
+            signature += (i ? "," : "") + entry["inputs"][i]["type"].get<std::string>();
+        }
+        signature += ")";
+
+        std::vector<GenParam> inputs;
+        std::vector<GenParam> outputs;
+        bool dynamicInput = false;
+        const bool supported = parseParams(entry["inputs"], "arg", inputs) &&
+                               parseParams(entry.value("outputs", json::array()), "out", outputs) && !outputs.empty();
+        for (const auto &input: inputs) dynamicInput |= input.dynamic;
+        if (!supported || dynamicInput) {
+            calls << "        // " << signature << " skipped: only static inputs and non-array outputs are supported\n\n";
+            continue;
+        }
+
+        // Overloads get a numeric suffix
+        const std::string base = identifier(entry["name"].get<std::string>(), "function");
+        std::string name = base;
+        for (int n = 2; seen.contains(name); n++) name = base + std::to_string(n);
+        seen.insert(name);
+
+        writeCall(calls, name, signature, inputs, outputs);
+        writeBindingMethod(methods, name, inputs);
+    }
+
+    std::string guard = "ABI_" + contract + "_H";
+    for (char &c: guard) c = static_cast<char>(std::toupper(static_cast<unsigned char>(c)));
+
+    std::ostringstream out;
+    out << "// Generated by deds_abigen from " << source << ", do not edit\n";
+    out << "#ifndef " << guard << "\n#define " << guard << "\n\n";
+    out << "#include <cstdint>\n#include <memory>\n#include <string>\n#include <string_view>\n#include <utility>\n\n";
+    out << "#include \"utils/AbiCodec.h\"\n#include \"utils/Web3Client.h\"\n\n";
+    out << "namespace abi::" << contract << " {\n";
+    out << "    // Call descriptors: constexpr selector, fixed-size calldata, fixed-offset decode\n";
+    out << "    namespace calls {\n" << calls.str();
+    out << "    }\n\n";
+    out << "    // View functions of one deployed contract, each one eth_call through Web3Client\n";
+    out << "    class Binding {\n";
+    out << "    public:\n";
+    out << "        Binding(std::shared_ptr<Web3Client> web3, std::string address)\n";
+    out << "            : web3{std::move(web3)}, address{std::move(address)} {\n";
+    out << "        }\n\n";
+    out << "        [[nodiscard]] const std::string &getAddress() const { return address; }\n\n";
+    out << methods.str();
+    out << "    private:\n";
+    out << "        std::shared_ptr<Web3Client> web3;\n";
+    out << "        std::string address;\n";
+    out << "    };\n";
+    out << "}\n\n";
+    out << "#endif //" << guard << "\n";
+    return out.str();
+}
+
+// Build-time generator: deds_abigen <abi.json> <ContractName> <output.h>
+int main(int argc, char *argv[]) {
+    if (argc != 4) {
+        std::cerr << "Usage: deds_abigen <abi.json> <ContractName> <output.h>\n";
+        return 1;
+    }
+
+    std::ifstream abiFile(argv[1]);
+    if (!abiFile.is_open()) {
+        std::cerr << "Failed to open ABI file: " << argv[1] << std::endl;
+        return 1;
+    }
+
+    try {
+        const json abi = json::parse(abiFile);
+        std::string source = argv[1];
+        if (const size_t slash = source.find_last_of('/'); slash != std::string::npos) {
+            const size_t parent = source.find_last_of('/', slash - 1);
+            source = source.substr(parent == std::string::npos ? 0 : parent + 1);
+        }
+        const std::string header = generate(abi, argv[2], source);
+
+        // Leave the file untouched when nothing changed so dependents are not rebuilt
+        std::ifstream existing(argv[3]);
+        if (existing.is_open()) {
+            std::stringstream current;
+            current << existing.rdbuf();
+            if (current.str() == header) return 0;
+        }
+
+        std::ofstream output(argv[3], std::ios::trunc);
+        if (!output.is_open()) {
+            std::cerr << "Failed to open output file: " << argv[3] << std::endl;
+            return 1;
+        }
+        output << header;
+    } catch (const std::exception &e) {
+        std::cerr << "Failed to generate bindings for " << argv[1] << ": " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,175 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../exchanges/BlockDriver.h"
+#include "../exchanges/ChainSet.h"
+#include "../exchanges/SharedStatePublisher.h"
+#include "../exchanges/UpdateOrchestrator.h"
+#include "../exchanges/adapters/Uniswap/UniswapV2.h"
+#include "../exchanges/adapters/Uniswap/UniswapV3.h"
+#include "../utils/HttpServer.h"
+#include "../utils/Metrics.h"
+#include "../utils/Utils.h"
+
+static std::atomic<bool> stopRequested{false};
+
+// Print command line usage
+static void printUsage() {
+    std::cerr << "Usage: DEDSDaemon [options]\n"
+            << "  --rpc URL          JSON-RPC endpoint (default https://arb1.arbitrum.io/rpc)\n"
+            << "  --chains FILE      JSON array of chains ({name, rpcUrl, dataDir, abiDir, concurrency, tickRange,\n"
+            << "                     stateRead: call|storage|lens, slidingTicks, http, compression,\n"
+            << "                     refresh})\n"
+            << "                     scraped side by side on one thread pool, replaces --rpc and --tick-range\n"
+            << "  --http VERSION     1.1, 2 (negotiated over TLS) or h2c (cleartext prior knowledge), default 2\n"
+            << "  --compression B    1 to accept gzip/br/zstd responses, 0 for identity (default 1)\n"
+            << "  --threads N        update thread pool size (default hardware concurrency)\n"
+            << "  --tick-range N     UniswapV3 ticks fetched on each side of the current tick (default 5)\n"
+            << "  --poll-ms N        head polling interval (default 250)\n"
+            << "  --cadence-ms N     run a cycle every N ms instead of once per new head\n"
+            << "  --cycles N         exit after N cycles\n"
+            << "  --metrics-port N   serve /metrics and /metrics.json on this port\n"
+            << "  --shm NAME         publish pool state to shared memory NAME, NAME_<chain> per chain\n"
+            << "  --quiet            no per-cycle log line\n";
+}
+
+// Run until the run function returns or SIGINT/SIGTERM, which calls stop
+static void runUntilSignal(const std::function<void()> &run, const std::function<void()> &stop) {
+    std::signal(SIGINT, [](int) { stopRequested = true; });
+    std::signal(SIGTERM, [](int) { stopRequested = true; });
+    std::atomic<bool> finished{false};
+    std::thread signals([&stop, &finished] {
+        while (!stopRequested && !finished) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+        stop();
+    });
+    run();
+    finished = true;
+    signals.join();
+}
+
+// Print one line per cycle, written at once as several chains log from their own threads
+static void logCycle(const DrivenCycle &cycle) {
+    std::ostringstream line;
+    line << (cycle.chain.empty() ? "" : cycle.chain + " ") << "head " << cycle.head << " state " << cycle.stateBlock
+            << " behind " << cycle.blocksBehind << " skipped " << cycle.skipped << " head-to-state "
+            << cycle.headToStateSeconds << " s" << (cycle.report.failures ? " (failures)" : "") << "\n";
+    std::cout << line.str() << std::flush;
+}
+
+// Publish an orchestrator's exchanges into a shared-memory segment, kept current by their change sets
+static std::unique_ptr<SharedStatePublisher> publishShared(const std::string &name, UpdateOrchestrator &orchestrator) {
+    std::vector<const ExchangeBase *> exchanges;
+    for (const auto &exchange: orchestrator.getExchanges()) {
+        exchanges.push_back(exchange.get());
+    }
+    auto publisher = std::make_unique<SharedStatePublisher>(name, exchanges);
+    for (const auto &exchange: orchestrator.getExchanges()) {
+        if (auto *v2 = dynamic_cast<UniswapV2 *>(exchange.get())) publisher->attach(*v2);
+        else if (auto *v3 = dynamic_cast<UniswapV3 *>(exchange.get())) publisher->attach(*v3);
+    }
+    std::cout << "Publishing " << exchanges.size() << " exchanges to shared memory " << publisher->name() << "\n";
+    return publisher;
+}
+
+// Long-running scraper: keeps the adapters loaded and refreshes them from new heads until SIGINT/SIGTERM
+int main(int argc, char *argv[]) {
+    std::string rpcUrl = "https://arb1.arbitrum.io/rpc";
+    std::string chainsPath;
+    size_t threads = std::thread::hardware_concurrency();
+    int tickRange = 5;
+    TransportOptions transport;
+    DriverOptions options;
+    uint16_t metricsPort = 0;
+    std::string shmName;
+    bool quiet = false;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "--quiet") {
+            quiet = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            printUsage();
+            return 1;
+        }
+        const std::string value = argv[++i];
+
+        if (arg == "--rpc") rpcUrl = value;
+        else if (arg == "--chains") chainsPath = value;
+        else if (arg == "--http") transport.httpVersion = parseHttpVersion(value);
+        else if (arg == "--compression") transport.compression = value != "0";
+        else if (arg == "--threads") threads = std::stoull(value);
+        else if (arg == "--tick-range") tickRange = std::stoi(value);
+        else if (arg == "--poll-ms") options.pollInterval = std::chrono::milliseconds(std::stoll(value));
+        else if (arg == "--cadence-ms") options.cadence = std::chrono::milliseconds(std::stoll(value));
+        else if (arg == "--cycles") options.maxCycles = std::stoull(value);
+        else if (arg == "--metrics-port") metricsPort = static_cast<uint16_t>(std::stoi(value));
+        else if (arg == "--shm") shmName = value;
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    try {
+        std::unique_ptr<HttpServer> metricsServer;
+        if (metricsPort != 0) {
+            metricsServer = Metrics::instance().serve(metricsPort);
+        }
+
+        if (!chainsPath.empty()) {
+            ChainSet chains(threads);
+            for (const auto &chain: json::parse(Utils::loadFile(chainsPath))) {
+                chains.addUniswapChain(ChainConfig::fromJson(chain));
+            }
+            std::vector<std::unique_ptr<SharedStatePublisher> > publishers;
+            for (const auto &name: chains.chainNames()) {
+                for (const auto &exchange: chains.chain(name).getExchanges()) {
+                    std::cout << name << " " << exchange->name << ": " << exchange->pools.size() << " pools\n";
+                }
+                if (!shmName.empty()) {
+                    publishers.push_back(publishShared(shmName + "_" + name, chains.chain(name)));
+                }
+            }
+            runUntilSignal([&] { chains.run(options, quiet ? BlockDriver::CycleCallback{} : logCycle); },
+                           [&] { chains.stop(); });
+            return 0;
+        }
+
+        UpdateOrchestrator orchestrator(std::make_shared<Web3Client>(rpcUrl, "", transport), threads);
+        orchestrator.addExchange<UniswapV2>();
+        orchestrator.addExchange<UniswapV3>(tickRange);
+        orchestrator.waitLoaded();
+        for (const auto &exchange: orchestrator.getExchanges()) {
+            std::cout << exchange->name << ": " << exchange->pools.size() << " pools\n";
+        }
+        std::unique_ptr<SharedStatePublisher> publisher;
+        if (!shmName.empty()) {
+            publisher = publishShared(shmName, orchestrator);
+        }
+
+        BlockDriver driver(orchestrator, options);
+        if (!quiet) {
+            driver.onCycle(logCycle);
+        }
+        runUntilSignal([&] { driver.run(); }, [&] { driver.stop(); });
+
+        std::cout << "Cycles: " << driver.cyclesRun() << ", skipped: " << driver.cyclesSkipped() << "\n";
+    } catch (const std::exception &e) {
+        std::cerr << "Daemon failed: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "../utils/RpcReplayServer.h"
+
+static std::atomic<bool> stopRequested{false};
+
+// Print command line usage
+static void printUsage() {
+    std::cerr << "Usage: DEDSReplayNode <recording.jsonl> [options]\n"
+            << "  --port N           listen port (default 8545)\n"
+            << "  --latency-ms N     fixed delay per HTTP request\n"
+            << "  --jitter-ms N      extra uniform delay in [0, N]\n"
+            << "  --max-batch N      reject batches larger than N\n"
+            << "  --error-rate P     JSON-RPC error probability per call\n"
+            << "  --http-error-rate P  HTTP 503 probability per request\n"
+            << "  --seed N           RNG seed for jitter and error injection\n";
+}
+
+// Stand-in JSON-RPC node replaying a Web3Client recording
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        printUsage();
+        return 1;
+    }
+
+    const std::string recordingPath = argv[1];
+    ReplayOptions options;
+    uint16_t port = 8545;
+
+    for (int i = 2; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            printUsage();
+            return 1;
+        }
+        const std::string value = argv[++i];
+
+        if (arg == "--port") port = static_cast<uint16_t>(std::stoi(value));
+        else if (arg == "--latency-ms") options.latency = std::chrono::microseconds(std::stoll(value) * 1000);
+        else if (arg == "--jitter-ms") options.jitter = std::chrono::microseconds(std::stoll(value) * 1000);
+        else if (arg == "--max-batch") options.maxBatchSize = std::stoull(value);
+        else if (arg == "--error-rate") options.errorRate = std::stod(value);
+        else if (arg == "--http-error-rate") options.httpErrorRate = std::stod(value);
+        else if (arg == "--seed") options.seed = std::stoull(value);
+        else {
+            printUsage();
+            return 1;
+        }
+    }
+
+    try {
+        RpcReplayServer server(recordingPath, options, port);
+        server.start();
+        std::cout << "Replaying " << server.entries() << " recorded requests on " << server.url() << "\n";
+
+        std::signal(SIGINT, [](int) { stopRequested = true; });
+        std::signal(SIGTERM, [](int) { stopRequested = true; });
+        while (!stopRequested) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+
+        server.stop();
+        const auto stats = server.stats();
+        std::cout << "HTTP requests: " << stats.httpRequests << ", calls: " << stats.calls
+                << ", misses: " << stats.misses << ", injected errors: " << stats.injectedErrors
+                << ", rejected batches: " << stats.rejectedBatches << "\n";
+    } catch (const std::exception &e) {
+        std::cerr << "Replay node failed: " << e.what() << "\n";
+        return 1;
+    }
+
+    return 0;
+}
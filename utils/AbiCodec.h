@@ -0,0 +1,242 @@
+#ifndef ABI_CODEC_H
+#define ABI_CODEC_H
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <gmpxx.h>
+
+// Static ABI word codecs used by the generated bindings in abi/*.h (see tools/AbiGen.cpp)
+// Each Solidity type maps to a tag with a C++ Value type, a 64-hex-char word encoder and a decoder
+// reading at a fixed offset of the response (offsets and data are in hex chars, without "0x")
+namespace abi {
+    constexpr size_t WordChars = 64;
+
+    inline uint8_t hexNibble(const char c) {
+        if (c >= '0' && c <= '9') return static_cast<uint8_t>(c - '0');
+        if (c >= 'a' && c <= 'f') return static_cast<uint8_t>(c - 'a' + 10);
+        if (c >= 'A' && c <= 'F') return static_cast<uint8_t>(c - 'A' + 10);
+        throw std::runtime_error{std::string("Invalid hex character: ") + c};
+    }
+
+    inline constexpr char HexDigits[] = "0123456789abcdef";
+
+    // Low 64 bits of a word
+    inline uint64_t readLow64(const std::string_view data, const size_t offset) {
+        uint64_t value = 0;
+        for (size_t i = offset + WordChars - 16; i < offset + WordChars; i++) {
+            value = value << 4 | hexNibble(data[i]);
+        }
+        return value;
+    }
+
+    inline void writeLow64(char *out, uint64_t value, const char fill) {
+        std::fill(out, out + WordChars - 16, fill);
+        for (int i = WordChars - 1; i >= static_cast<int>(WordChars - 16); i--) {
+            out[i] = HexDigits[value & 0xf];
+            value >>= 4;
+        }
+    }
+
+    inline mpz_class readBig(const std::string_view data, const size_t offset, const bool isSigned) {
+        mpz_class value;
+        const std::string word(data.substr(offset, WordChars));
+        value.set_str(word, 16);
+        if (isSigned && hexNibble(word[0]) >= 8) {
+            mpz_class modulus;
+            mpz_ui_pow_ui(modulus.get_mpz_t(), 2, 256);
+            value -= modulus;
+        }
+        return value;
+    }
+
+    inline void writeBig(char *out, mpz_class value) {
+        if (value < 0) {
+            mpz_class modulus;
+            mpz_ui_pow_ui(modulus.get_mpz_t(), 2, 256);
+            value += modulus;
+        }
+        const std::string hex = value.get_str(16);
+        if (hex.size() > WordChars) {
+            throw std::runtime_error{"Value does not fit in 256 bits"};
+        }
+        std::fill(out, out + WordChars - hex.size(), '0');
+        std::copy(hex.begin(), hex.end(), out + WordChars - hex.size());
+    }
+
+    // Tail of a dynamic value, checked to leave room for its length word before anything there is read
+    inline size_t readTail(const std::string_view data, const size_t offset) {
+        const uint64_t tailBytes = readLow64(data, offset);
+        if (data.size() < WordChars || tailBytes > (data.size() - WordChars) / 2) {
+            throw std::runtime_error{"Offset of a dynamic value past the end of the response"};
+        }
+        return static_cast<size_t>(tailBytes) * 2;
+    }
+
+    // Byte length of the dynamic value at tail, checked against what follows its length word
+    inline size_t readLength(const std::string_view data, const size_t tail) {
+        const uint64_t length = readLow64(data, tail);
+        if (length > (data.size() - tail - WordChars) / 2) {
+            throw std::runtime_error{"Length of a dynamic value past the end of the response"};
+        }
+        return static_cast<size_t>(length);
+    }
+
+    // Unsigned integers: uint64_t up to 64 bits, mpz_class above
+    template<int Bits, bool Small = (Bits <= 64)>
+    struct Uint;
+
+    template<int Bits>
+    struct Uint<Bits, true> {
+        using Value = uint64_t;
+        static constexpr bool dynamic = false;
+
+        static void encode(char *out, const Value value) { writeLow64(out, value, '0'); }
+
+        static Value decode(const std::string_view data, const size_t offset) { return readLow64(data, offset); }
+    };
+
+    template<int Bits>
+    struct Uint<Bits, false> {
+        using Value = mpz_class;
+        static constexpr bool dynamic = false;
+
+        static void encode(char *out, const Value &value) { writeBig(out, value); }
+
+        static Value decode(const std::string_view data, const size_t offset) { return readBig(data, offset, false); }
+    };
+
+    // Signed integers: int64_t up to 64 bits, mpz_class above, two's complement over 256 bits
+    template<int Bits, bool Small = (Bits <= 64)>
+    struct Int;
+
+    template<int Bits>
+    struct Int<Bits, true> {
+        using Value = int64_t;
+        static constexpr bool dynamic = false;
+
+        static void encode(char *out, const Value value) {
+            writeLow64(out, static_cast<uint64_t>(value), value < 0 ? 'f' : '0');
+        }
+
+        static Value decode(const std::string_view data, const size_t offset) {
+            return static_cast<int64_t>(readLow64(data, offset));
+        }
+    };
+
+    template<int Bits>
+    struct Int<Bits, false> {
+        using Value = mpz_class;
+        static constexpr bool dynamic = false;
+
+        static void encode(char *out, const Value &value) { writeBig(out, value); }
+
+        static Value decode(const std::string_view data, const size_t offset) { return readBig(data, offset, true); }
+    };
+
+    // Address as a "0x"-prefixed 40-hex-char string
+    struct Address {
+        using Value = std::string;
+        static constexpr bool dynamic = false;
+
+        static void encode(char *out, const std::string_view value) {
+            const std::string_view clean = value.starts_with("0x") ? value.substr(2) : value;
+            if (clean.size() != 40) {
+                throw std::runtime_error{"Invalid Ethereum address format: " + std::string(value)};
+            }
+            std::fill(out, out + 24, '0');
+            std::copy(clean.begin(), clean.end(), out + 24);
+        }
+
+        static Value decode(const std::string_view data, const size_t offset) {
+            return "0x" + std::string(data.substr(offset + 24, 40));
+        }
+    };
+
+    struct Bool {
+        using Value = bool;
+        static constexpr bool dynamic = false;
+
+        static void encode(char *out, const Value value) { writeLow64(out, value ? 1 : 0, '0'); }
+
+        static Value decode(const std::string_view data, const size_t offset) {
+            return data[offset + WordChars - 1] == '1';
+        }
+    };
+
+    // bytesN as a "0x"-prefixed hex string, left-aligned in the word
+    template<int Size>
+    struct FixedBytes {
+        using Value = std::string;
+        static constexpr bool dynamic = false;
+
+        static void encode(char *out, const std::string_view value) {
+            const std::string_view clean = value.starts_with("0x") ? value.substr(2) : value;
+            if (clean.size() > Size * 2) {
+                throw std::runtime_error{"Bytes value too long for bytes" + std::to_string(Size)};
+            }
+            std::copy(clean.begin(), clean.end(), out);
+            std::fill(out + clean.size(), out + WordChars, '0');
+        }
+
+        static Value decode(const std::string_view data, const size_t offset) {
+            return "0x" + std::string(data.substr(offset, Size * 2));
+        }
+    };
+
+    // Dynamic types are only decoded: the head word holds the offset of a length-prefixed tail
+    struct Bytes {
+        using Value = std::string;
+        static constexpr bool dynamic = true;
+
+        static Value decode(const std::string_view data, const size_t offset) {
+            const size_t tail = readTail(data, offset);
+            const size_t length = readLength(data, tail) * 2;
+            return "0x" + std::string(data.substr(tail + WordChars, length));
+        }
+    };
+
+    struct String {
+        using Value = std::string;
+        static constexpr bool dynamic = true;
+
+        static Value decode(const std::string_view data, const size_t offset) {
+            const size_t tail = readTail(data, offset);
+            const size_t length = readLength(data, tail);
+            std::string value(length, '\0');
+            for (size_t i = 0; i < length; i++) {
+                const size_t pos = tail + WordChars + i * 2;
+                value[i] = static_cast<char>(hexNibble(data[pos]) << 4 | hexNibble(data[pos + 1]));
+            }
+            return value;
+        }
+    };
+
+    // Strip "0x" and check the response holds at least the static head
+    inline std::string_view responseBody(const std::string_view response, const size_t headWords) {
+        const std::string_view body = response.starts_with("0x") ? response.substr(2) : response;
+        if (body.size() < headWords * WordChars) {
+            throw std::runtime_error{
+                "Response too short: " + std::to_string(body.size()) + " hex chars, expected at least " +
+                std::to_string(headWords * WordChars)
+            };
+        }
+        return body;
+    }
+
+    // Calldata prefix "0x" + selector, sized for the static arguments that follow
+    inline std::string calldata(const char (&selectorHex)[9], const size_t argumentWords) {
+        std::string data(2 + 8 + argumentWords * WordChars, '0');
+        data[1] = 'x';
+        std::copy(selectorHex, selectorHex + 8, data.begin() + 2);
+        return data;
+    }
+
+    inline char *argumentSlot(std::string &data, const size_t index) {
+        return data.data() + 10 + index * WordChars;
+    }
+}
+
+#endif //ABI_CODEC_H
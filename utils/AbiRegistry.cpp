@@ -0,0 +1,82 @@
+#include "AbiRegistry.h"
+
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include "Utils.h"
+#include "Web3Client.h"
+
+// Look up a function by name
+const AbiFunction &ContractAbi::function(const std::string &name) const {
+    const auto it = functions.find(name);
+    if (it == functions.end()) {
+        throw std::runtime_error{"Function not found in ABI: " + name};
+    }
+    return it->second;
+}
+
+// Get process-wide registry
+AbiRegistry &AbiRegistry::instance() {
+    static AbiRegistry registry;
+    return registry;
+}
+
+// Parse an ABI file and precompute signatures and selectors of its functions
+static std::unique_ptr<const ContractAbi> parseAbi(const std::string &path) {
+    auto abi = std::make_unique<ContractAbi>();
+    abi->path = path;
+    abi->definition = json::parse(Utils::loadFile(path));
+
+    for (const auto &func: abi->definition) {
+        if (!func.contains("type") || func["type"] != "function" || !func.contains("name")) continue;
+
+        AbiFunction function;
+        function.name = func["name"].get<std::string>();
+        function.signature = function.name + "(";
+        if (func.contains("inputs") && func["inputs"].is_array()) {
+            for (const auto &input: func["inputs"]) {
+                if (!input.contains("type")) continue;
+                if (!function.inputTypes.empty()) function.signature += ",";
+                function.inputTypes.push_back(input["type"].get<std::string>());
+                function.signature += function.inputTypes.back();
+            }
+        }
+        function.signature += ")";
+        const std::string hash = Web3Client::keccak256(function.signature);
+        function.selector = Web3Client::bytesToHex(hash.substr(0, 4)).substr(2, 8);
+        if (func.contains("outputs") && func["outputs"].is_array()) {
+            function.outputs = func["outputs"];
+        }
+
+        // Overloads keep the last definition, as lookups are by name only
+        abi->functions[function.name] = std::move(function);
+    }
+    return abi;
+}
+
+// Load once per file, concurrent first loads of the same file keep the first result
+const ContractAbi &AbiRegistry::load(const std::string &path) {
+    std::error_code error;
+    std::string key = std::filesystem::weakly_canonical(path, error).string();
+    if (error) {
+        key = path;
+    }
+
+    {
+        std::shared_lock lock(mutex);
+        if (const auto it = abis.find(key); it != abis.end()) {
+            return *it->second;
+        }
+    }
+
+    std::unique_ptr<const ContractAbi> parsed = parseAbi(path);
+    std::unique_lock lock(mutex);
+    auto [it, inserted] = abis.try_emplace(key, std::move(parsed));
+    return *it->second;
+}
+
+// Number of distinct ABI files loaded
+size_t AbiRegistry::size() const {
+    std::shared_lock lock(mutex);
+    return abis.size();
+}
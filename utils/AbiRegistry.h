@@ -0,0 +1,49 @@
+#ifndef ABI_REGISTRY_H
+#define ABI_REGISTRY_H
+
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+// One ABI function with everything encoding needs precomputed
+struct AbiFunction {
+    std::string name;
+    // Canonical signature, e.g. ticks(int24)
+    std::string signature;
+    // First 4 bytes of keccak256(signature) as 8 hex characters, no 0x
+    std::string selector;
+    std::vector<std::string> inputTypes;
+    json outputs;
+};
+
+// Parsed ABI file, shared by every Contract built from it
+struct ContractAbi {
+    std::string path;
+    json definition;
+    std::unordered_map<std::string, AbiFunction> functions;
+
+    // Throws if the ABI has no function with that name
+    [[nodiscard]] const AbiFunction &function(const std::string &name) const;
+};
+
+// Process-wide cache of parsed ABIs: each file is read and parsed once, entries live until exit
+class AbiRegistry {
+public:
+    static AbiRegistry &instance();
+
+    // Parsed ABI of the file, loading it on first use. Paths naming the same file share one entry
+    const ContractAbi &load(const std::string &path);
+
+    [[nodiscard]] size_t size() const;
+
+private:
+    mutable std::shared_mutex mutex;
+    std::unordered_map<std::string, std::unique_ptr<const ContractAbi> > abis;
+};
+
+#endif //ABI_REGISTRY_H
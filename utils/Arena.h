@@ -0,0 +1,79 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// Typed bump allocator: objects are constructed into contiguous chunks and live until the arena is destroyed.
+// Chunks start small and double up to MaxChunk objects, so a handful of pools costs little and 100k pools
+// are a few dozen allocations. Not thread-safe, adapters fill their arenas while loading
+template<typename T, size_t MaxChunk = 4096>
+class Arena {
+public:
+    Arena() = default;
+
+    Arena(const Arena &) = delete;
+
+    Arena &operator=(const Arena &) = delete;
+
+    // Destructor: Destroy objects in reverse creation order
+    ~Arena() {
+        for (size_t chunk = chunks.size(); chunk-- > 0;) {
+            const size_t count = chunk + 1 == chunks.size() ? used : chunks[chunk].capacity;
+            for (size_t i = count; i-- > 0;) {
+                std::destroy_at(chunks[chunk].at(i));
+            }
+        }
+    }
+
+    // Construct an object in place, the pointer stays valid for the arena's lifetime
+    template<typename... Args>
+    T *create(Args &&... args) {
+        if (chunks.empty() || used == chunks.back().capacity) {
+            const size_t capacity = std::min(MaxChunk, std::max<size_t>(16, objects));
+            chunks.push_back({std::make_unique<Storage[]>(capacity), capacity});
+            used = 0;
+        }
+        T *object = std::construct_at(chunks.back().at(used), std::forward<Args>(args)...);
+        used++;
+        objects++;
+        return object;
+    }
+
+    // Number of live objects
+    [[nodiscard]] size_t size() const {
+        return objects;
+    }
+
+    // Bytes held by the chunks, including unused tail capacity
+    [[nodiscard]] size_t reservedBytes() const {
+        size_t bytes = 0;
+        for (const auto &chunk: chunks) {
+            bytes += chunk.capacity * sizeof(T);
+        }
+        return bytes;
+    }
+
+private:
+    struct alignas(T) Storage {
+        std::byte bytes[sizeof(T)];
+    };
+
+    struct Chunk {
+        std::unique_ptr<Storage[]> storage;
+        size_t capacity;
+
+        T *at(const size_t index) const {
+            return reinterpret_cast<T *>(storage[index].bytes);
+        }
+    };
+
+    std::vector<Chunk> chunks;
+    size_t used = 0;
+    size_t objects = 0;
+};
+
+#endif //ARENA_H
@@ -0,0 +1,97 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+
+// Bounded lock-free multi-producer multi-consumer queue (Vyukov): a ring of cells, each with a sequence
+// number telling producers and consumers whose turn it is. Push fails instead of blocking when full
+template<typename T>
+class BoundedQueue {
+public:
+    // capacity is rounded up to a power of two
+    explicit BoundedQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) size <<= 1;
+        mask = size - 1;
+        cells = std::make_unique<Cell[]>(size);
+        for (size_t i = 0; i < size; i++) {
+            cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue &) = delete;
+
+    BoundedQueue &operator=(const BoundedQueue &) = delete;
+
+    // Returns false when the queue is full
+    bool tryPush(T value) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true) {
+            cell = &cells[position & mask];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false;
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Returns std::nullopt when the queue is empty
+    std::optional<T> tryPop() {
+        size_t position = head.load(std::memory_order_relaxed);
+        Cell *cell;
+        while (true) {
+            cell = &cells[position & mask];
+            const size_t sequence = cell->sequence.load(std::memory_order_acquire);
+            const auto diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+            if (diff == 0) {
+                if (head.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return std::nullopt;
+            } else {
+                position = head.load(std::memory_order_relaxed);
+            }
+        }
+        std::optional<T> value{std::move(cell->value)};
+        cell->value = T{};
+        cell->sequence.store(position + mask + 1, std::memory_order_release);
+        return value;
+    }
+
+    [[nodiscard]] size_t capacity() const {
+        return mask + 1;
+    }
+
+    // Approximate number of queued items
+    [[nodiscard]] size_t size() const {
+        const size_t h = head.load(std::memory_order_relaxed);
+        const size_t t = tail.load(std::memory_order_relaxed);
+        return t > h ? t - h : 0;
+    }
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        T value{};
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask = 0;
+    alignas(64) std::atomic<size_t> head{0};
+    alignas(64) std::atomic<size_t> tail{0};
+};
+
+#endif //BOUNDED_QUEUE_H
@@ -0,0 +1,184 @@
+#include "CallCache.h"
+#include <algorithm>
+#include <cctype>
+
+// Fraction of lookups answered without a network round trip
+double CallCache::Stats::hitRate() const {
+    const uint64_t total = hits + misses + coalesced;
+    return total == 0 ? 0.0 : static_cast<double>(hits + coalesced) / static_cast<double>(total);
+}
+
+// Constructor: Bound the number of pinned-block entries kept in the LRU
+CallCache::CallCache(const size_t capacity)
+    : capacity{capacity} {
+}
+
+// Build normalized cache key, addresses and hex data are case-insensitive
+std::string CallCache::makeKey(const std::string &to, const std::string &data, const std::string &blockTag) {
+    std::string key;
+    key.reserve(to.size() + data.size() + blockTag.size() + 2);
+    key += to;
+    key += ':';
+    key += data;
+    key += '@';
+    key += blockTag;
+    std::ranges::transform(key, key.begin(), [](const unsigned char c) { return std::tolower(c); });
+    return key;
+}
+
+// Check whether a block tag designates a block whose state can never change
+bool CallCache::isImmutable(const std::string &blockTag) {
+    return blockTag == "earliest" || (blockTag.length() > 2 && blockTag.substr(0, 2) == "0x");
+}
+
+// Only immutable tags and "latest" have well-defined invalidation rules
+bool CallCache::isCacheable(const std::string &blockTag) {
+    return isImmutable(blockTag) || blockTag == "latest";
+}
+
+// Look up a key, joining an identical request in flight or claiming ownership of a new one
+CallCache::Lookup CallCache::acquire(const std::string &key, const bool immutable) {
+    std::lock_guard lock(mutex);
+    Lookup lookup;
+
+    if (immutable) {
+        if (const auto it = immutableEntries.find(key); it != immutableEntries.end()) {
+            lru.splice(lru.begin(), lru, it->second);
+            lookup.kind = Lookup::Kind::Hit;
+            lookup.value = it->second->second;
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return lookup;
+        }
+    } else if (const auto it = latestEntries.find(key); it != latestEntries.end()) {
+        if (std::chrono::steady_clock::now() - it->second.storedAt <= maxLatestAge) {
+            lookup.kind = Lookup::Kind::Hit;
+            lookup.value = it->second.value;
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return lookup;
+        }
+        latestEntries.erase(it);
+        invalidations.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (const auto it = inFlightFutures.find(key); it != inFlightFutures.end()) {
+        lookup.kind = Lookup::Kind::Pending;
+        lookup.pending = it->second;
+        coalesced.fetch_add(1, std::memory_order_relaxed);
+        return lookup;
+    }
+
+    auto promise = std::make_shared<std::promise<std::string> >();
+    inFlightFutures[key] = promise->get_future().share();
+    inFlight[key] = std::move(promise);
+    lookup.kind = Lookup::Kind::Owner;
+    lookup.generation = headGeneration;
+    misses.fetch_add(1, std::memory_order_relaxed);
+    return lookup;
+}
+
+// Store an owned response and wake every coalesced waiter
+void CallCache::fulfill(const std::string &key, const bool immutable, const uint64_t generation,
+                        const std::string &value) {
+    std::shared_ptr<std::promise<std::string> > promise;
+    {
+        std::lock_guard lock(mutex);
+        if (immutable) {
+            if (const auto it = immutableEntries.find(key); it != immutableEntries.end()) {
+                it->second->second = value;
+                lru.splice(lru.begin(), lru, it->second);
+            } else {
+                lru.emplace_front(key, value);
+                immutableEntries[key] = lru.begin();
+                evictOverflow();
+            }
+        } else if (generation == headGeneration) {
+            // A response that raced with a head change may already be stale, serve it but do not keep it
+            latestEntries[key] = {value, std::chrono::steady_clock::now()};
+        }
+
+        if (const auto it = inFlight.find(key); it != inFlight.end()) {
+            promise = std::move(it->second);
+            inFlight.erase(it);
+        }
+        inFlightFutures.erase(key);
+    }
+
+    if (promise) {
+        promise->set_value(value);
+    }
+}
+
+// Propagate an owned request's failure to every coalesced waiter
+void CallCache::fail(const std::string &key, const std::exception_ptr &error) {
+    std::shared_ptr<std::promise<std::string> > promise;
+    {
+        std::lock_guard lock(mutex);
+        if (const auto it = inFlight.find(key); it != inFlight.end()) {
+            promise = std::move(it->second);
+            inFlight.erase(it);
+        }
+        inFlightFutures.erase(key);
+    }
+
+    if (promise) {
+        promise->set_exception(error);
+    }
+}
+
+// Invalidate "latest" entries when a newer head is seen
+void CallCache::advanceHead(const uint64_t blockNumber) {
+    std::lock_guard lock(mutex);
+    if (blockNumber <= headBlock) {
+        return;
+    }
+
+    headBlock = blockNumber;
+    headGeneration++;
+    invalidations.fetch_add(latestEntries.size(), std::memory_order_relaxed);
+    latestEntries.clear();
+}
+
+// Change LRU bound, evicting least recently used entries if needed
+void CallCache::setCapacity(const size_t newCapacity) {
+    std::lock_guard lock(mutex);
+    capacity = newCapacity;
+    evictOverflow();
+}
+
+// Bound how long a "latest" entry is served without a head observation
+void CallCache::setMaxLatestAge(const std::chrono::milliseconds maxAge) {
+    std::lock_guard lock(mutex);
+    maxLatestAge = maxAge;
+}
+
+// Drop all stored entries, in-flight requests are left untouched
+void CallCache::clear() {
+    std::lock_guard lock(mutex);
+    lru.clear();
+    immutableEntries.clear();
+    latestEntries.clear();
+}
+
+// Snapshot counters and sizes
+CallCache::Stats CallCache::stats() const {
+    Stats result;
+    result.hits = hits.load(std::memory_order_relaxed);
+    result.misses = misses.load(std::memory_order_relaxed);
+    result.coalesced = coalesced.load(std::memory_order_relaxed);
+    result.evictions = evictions.load(std::memory_order_relaxed);
+    result.invalidations = invalidations.load(std::memory_order_relaxed);
+
+    std::lock_guard lock(mutex);
+    result.immutableEntries = immutableEntries.size();
+    result.latestEntries = latestEntries.size();
+    return result;
+}
+
+// Remove least recently used entries above capacity, caller holds the mutex
+void CallCache::evictOverflow() {
+    while (immutableEntries.size() > capacity && !lru.empty()) {
+        immutableEntries.erase(lru.back().first);
+        lru.pop_back();
+        evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
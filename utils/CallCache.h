@@ -0,0 +1,96 @@
+#ifndef CALL_CACHE_H
+#define CALL_CACHE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Response cache for eth_call keyed by (to, calldata, block tag)
+// Pinned-block entries live in a bounded LRU, "latest" entries are dropped when the head advances
+// (or after maxLatestAge for callers that never poll the head), and identical requests issued
+// concurrently share one in-flight response
+class CallCache {
+public:
+    struct Stats {
+        uint64_t hits{0};
+        uint64_t misses{0};
+        uint64_t coalesced{0};
+        uint64_t evictions{0};
+        uint64_t invalidations{0};
+        size_t immutableEntries{0};
+        size_t latestEntries{0};
+
+        [[nodiscard]] double hitRate() const;
+    };
+
+    // Result of a cache lookup: a stored value, a request already in flight, or ownership of a new request
+    struct Lookup {
+        enum class Kind { Hit, Pending, Owner };
+
+        Kind kind{Kind::Owner};
+        std::string value;
+        std::shared_future<std::string> pending;
+        uint64_t generation{0};
+    };
+
+    explicit CallCache(size_t capacity = 65536);
+
+    static std::string makeKey(const std::string &to, const std::string &data, const std::string &blockTag);
+
+    // Pinned block numbers (and "earliest") never change, "latest" is valid until the next head
+    static bool isImmutable(const std::string &blockTag);
+
+    static bool isCacheable(const std::string &blockTag);
+
+    Lookup acquire(const std::string &key, bool immutable);
+
+    void fulfill(const std::string &key, bool immutable, uint64_t generation, const std::string &value);
+
+    void fail(const std::string &key, const std::exception_ptr &error);
+
+    // Drop every "latest" entry once a newer block is observed
+    void advanceHead(uint64_t blockNumber);
+
+    void setCapacity(size_t capacity);
+
+    void setMaxLatestAge(std::chrono::milliseconds maxAge);
+
+    void clear();
+
+    [[nodiscard]] Stats stats() const;
+
+private:
+    using LruList = std::list<std::pair<std::string, std::string> >;
+
+    struct LatestEntry {
+        std::string value;
+        std::chrono::steady_clock::time_point storedAt;
+    };
+
+    mutable std::mutex mutex;
+    size_t capacity;
+    LruList lru;
+    std::unordered_map<std::string, LruList::iterator> immutableEntries;
+    std::unordered_map<std::string, LatestEntry> latestEntries;
+    std::chrono::milliseconds maxLatestAge{250};
+    std::unordered_map<std::string, std::shared_ptr<std::promise<std::string> > > inFlight;
+    std::unordered_map<std::string, std::shared_future<std::string> > inFlightFutures;
+    uint64_t headBlock{0};
+    uint64_t headGeneration{0};
+
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> coalesced{0};
+    std::atomic<uint64_t> evictions{0};
+    std::atomic<uint64_t> invalidations{0};
+
+    void evictOverflow();
+};
+
+#endif //CALL_CACHE_H
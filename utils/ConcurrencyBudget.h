@@ -0,0 +1,70 @@
+#ifndef CONCURRENCY_BUDGET_H
+#define CONCURRENCY_BUDGET_H
+
+#include <atomic>
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <type_traits>
+
+#include "ThreadPool.h"
+
+// Caps how many threads of a shared pool one tenant (a chain) holds at once. Work over the cap runs inline
+// on a thread the tenant already holds, so nothing waits for budget and nested fan-out cannot deadlock
+class ConcurrencyBudget {
+public:
+    explicit ConcurrencyBudget(const size_t limit) : capacity{limit}, available{limit} {
+    }
+
+    ConcurrencyBudget(const ConcurrencyBudget &) = delete;
+
+    ConcurrencyBudget &operator=(const ConcurrencyBudget &) = delete;
+
+    // Queue on the pool if a slot is free, otherwise run now; the future is ready in the latter case
+    template<typename F>
+    auto submit(ThreadPool &pool, F &&task) -> std::future<std::invoke_result_t<std::decay_t<F> > > {
+        if (!tryAcquire()) {
+            return runInline(std::forward<F>(task));
+        }
+        return pool.submit([this, task = std::forward<F>(task)]() mutable {
+            const Slot slot{*this};
+            return task();
+        });
+    }
+
+    // Run a task on the calling thread, its result or exception in a ready future
+    template<typename F>
+    static auto runInline(F &&task) -> std::future<std::invoke_result_t<std::decay_t<F> > > {
+        std::packaged_task<std::invoke_result_t<std::decay_t<F> >()> packaged(std::forward<F>(task));
+        auto future = packaged.get_future();
+        packaged();
+        return future;
+    }
+
+    [[nodiscard]] size_t limit() const { return capacity; }
+
+    [[nodiscard]] size_t inUse() const { return capacity - available.load(std::memory_order_relaxed); }
+
+private:
+    // Releases the slot when the pooled task finishes, also when it throws
+    struct Slot {
+        ConcurrencyBudget &budget;
+
+        ~Slot() { budget.available.fetch_add(1, std::memory_order_release); }
+    };
+
+    const size_t capacity;
+    std::atomic<size_t> available;
+
+    bool tryAcquire() {
+        size_t free = available.load(std::memory_order_relaxed);
+        while (free > 0) {
+            if (available.compare_exchange_weak(free, free - 1, std::memory_order_acquire)) {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+#endif //CONCURRENCY_BUDGET_H
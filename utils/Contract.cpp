@@ -3,69 +3,52 @@
 #include <sstream>
 #include <nlohmann/json.hpp>
 #include <utility>
-#include <cryptopp/eccrypto.h>
 #include "Contract.h"
 #include <iostream>
 #include "Utils.h"
+#include "Metrics.h"
 
 using json = nlohmann::json;
 
-// Constructor: Load ABI and index functions by name
+// Constructor: Share the registry's parsed ABI
 Contract::Contract(std::string _address, const std::string &abiPath)
-    : address{std::move(_address)} {
-    abi = json::parse(Utils::loadFile(abiPath));
-    for (const auto &func: abi) {
-        if (func.contains("type") && func["type"] == "function" && func.contains("name")) {
-            std::string name{func["name"]};
-            functionsByName[name] = func;
-        }
-    }
+    : address{std::move(_address)}, abi{&AbiRegistry::instance().load(abiPath)} {
 }
 
-// Encode function call with parameters for blockchain transaction
-std::string Contract::encodeFunction(const std::string &name, const json &params) {
-    if (!functionsByName.contains(name)) {
-        throw std::runtime_error{"Function not found in ABI: " + name};
-    }
+// Look up a function descriptor in the shared ABI
+const AbiFunction &Contract::function(const std::string &name) const {
+    return abi->function(name);
+}
 
-    const nlohmann::json &func = functionsByName[name];
+// Encode function call with parameters for blockchain transaction
+std::string Contract::encodeFunction(const std::string &name, const json &params) const {
+    return encodeFunction(function(name), params);
+}
 
-    std::string signature = name + "(";
-
-    std::vector<std::string> types;
-    if (func.contains("inputs") && func["inputs"].is_array()) {
-        bool first = true;
-        for (const auto &input: func["inputs"]) {
-            if (!first) signature += ",";
-            if (input.contains("type")) {
-                const std::string &type = input["type"].get<std::string>();
-                signature += type;
-                types.push_back(type);
-                first = false;
-            }
-        }
-    }
-    signature += ")";
+// Encode a call from its descriptor, selector and types are precomputed by the registry
+std::string Contract::encodeFunction(const AbiFunction &function, const json &params) {
+    static Histogram &encodeTime = Metrics::instance().histogram("deds_abi_encode_seconds", {},
+                                                                 "Contract::encodeFunction duration");
+    ScopedTimer timer(encodeTime);
 
+    const std::vector<std::string> &types = function.inputTypes;
     if (types.size() != params.size()) {
         throw std::runtime_error("Parameter count mismatch: expected " +
                                  std::to_string(types.size()) + ", got " +
                                  std::to_string(params.size()));
     }
 
-    const std::string signatureHash = Web3Client::keccak256(signature);
-    const std::string selector = Web3Client::bytesToHex(signatureHash.substr(0, 4)).substr(2, 8);
-
     std::string parametersData;
     if (!types.empty()) {
         std::vector<std::string> paramStrings;
         for (const auto &p: params) {
-            paramStrings.push_back(p.dump());
+            // Strings must not keep the JSON quotes, numbers and booleans use their literal form
+            paramStrings.push_back(p.is_string() ? p.get<std::string>() : p.dump());
         }
         parametersData = encodeParameters(types, paramStrings);
     }
 
-    return "0x" + selector + parametersData;
+    return "0x" + function.selector + parametersData;
 }
 
 // Encode multiple parameters according to ABI specification
@@ -82,8 +65,30 @@ std::string Contract::encodeParameters(const std::vector<std::string> &types, co
         const std::string &type = types[i];
         const std::string &value = values[i];
 
-        if (!type.find('[')) {
-            throw std::runtime_error("Array not supported");
+        // Dynamic array: offset in the head, then its length and the elements encoded like a parameter list
+        if (type.ends_with("[]")) {
+            const json elements = json::parse(value);
+            if (!elements.is_array()) {
+                throw std::runtime_error("Expected a JSON array for type " + type);
+            }
+            std::vector<std::string> elementValues;
+            for (const auto &element: elements) {
+                elementValues.push_back(element.is_string() ? element.get<std::string>() : element.dump());
+            }
+            const std::vector<std::string> elementTypes(elements.size(), type.substr(0, type.size() - 2));
+
+            std::stringstream ss;
+            ss << std::hex << std::setfill('0') << std::setw(64) << dynamicOffset;
+            headBlock += ss.str();
+
+            const std::string encodedArray = encodeUint(std::to_string(elements.size())) +
+                                             encodeParameters(elementTypes, elementValues);
+            tailBlock += encodedArray;
+            dynamicOffset += encodedArray.length() / 2;
+            continue;
+        }
+        if (type.find('[') != std::string::npos) {
+            throw std::runtime_error("Fixed-size array not supported: " + type);
         }
 
         if (type == "address") {
@@ -222,14 +227,17 @@ std::string Contract::encodeUint(const std::string &value) {
 }
 
 // Decode function response data according to ABI outputs
-json Contract::decodeResponse(const std::string &responseData, const std::string &functionName) {
-    if (!functionsByName.contains(functionName)) {
-        throw std::runtime_error{"Function not found in ABI: " + functionName};
-    }
+json Contract::decodeResponse(const std::string &responseData, const std::string &functionName) const {
+    return decodeResponse(responseData, function(functionName));
+}
 
-    const nlohmann::json &func = functionsByName[functionName];
+// Decode a response from the function descriptor's outputs
+json Contract::decodeResponse(const std::string &responseData, const AbiFunction &function) {
+    static Histogram &decodeTime = Metrics::instance().histogram("deds_abi_decode_seconds", {},
+                                                                 "Contract::decodeResponse duration");
+    ScopedTimer timer(decodeTime);
 
-    if (!func.contains("outputs") || !func["outputs"].is_array()) {
+    if (!function.outputs.is_array()) {
         return json::object();
     }
 
@@ -240,13 +248,17 @@ json Contract::decodeResponse(const std::string &responseData, const std::string
     }
 
     size_t offset = 0;
-    for (const auto &output: func["outputs"]) {
+    for (const auto &output: function.outputs) {
         if (!output.contains("type")) continue;
         std::string type = output["type"].get<std::string>();
         std::string name = output.contains("name") ? output["name"].get<std::string>() : "";
 
 
-        if (type == "address") {
+        if (type.ends_with("[]")) {
+            const uint64_t arrayOffset = std::stoull(cleanData.substr(offset, 64), nullptr, 16) * 2;
+            result[name] = decodeArray(cleanData, arrayOffset, type.substr(0, type.size() - 2));
+            offset += 64;
+        } else if (type == "address") {
             std::string value = decodeAddress(cleanData.substr(offset, 64));
             result[name] = value;
             offset += 64;
@@ -288,6 +300,34 @@ json Contract::decodeResponse(const std::string &responseData, const std::string
     return result;
 }
 
+// Decode a dynamic array of static elements, which become strings like scalar outputs
+json Contract::decodeArray(const std::string &data, const size_t offset, const std::string &elementType) {
+    if (offset + 64 > data.length()) {
+        throw std::runtime_error("Array offset out of bounds");
+    }
+    const uint64_t length = std::stoull(data.substr(offset, 64), nullptr, 16);
+    if (length > (data.length() - offset - 64) / 64) {
+        throw std::runtime_error("Array length out of bounds: " + std::to_string(length));
+    }
+
+    json elements = json::array();
+    for (size_t i = 0; i < length; i++) {
+        const std::string word = data.substr(offset + 64 * (i + 1), 64);
+        if (elementType == "address") {
+            elements.push_back(decodeAddress(word));
+        } else if (elementType.find("uint") == 0) {
+            elements.push_back(decodeUint(word));
+        } else if (elementType.find("int") == 0) {
+            elements.push_back(decodeInt(word));
+        } else if (elementType == "bool") {
+            elements.push_back(decodeBool(word));
+        } else {
+            throw std::runtime_error("Unsupported array element type for decoding: " + elementType);
+        }
+    }
+    return elements;
+}
+
 // Decode padded address from 32-byte hex string
 std::string Contract::decodeAddress(const std::string &paddedAddress) {
     if (paddedAddress.length() != 64) {
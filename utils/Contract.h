@@ -2,18 +2,24 @@
 #define CONTRACT_H
 
 #include <string>
-#include <map>
 #include <nlohmann/json.hpp>
+#include "AbiRegistry.h"
 
 using json = nlohmann::json;
 
 // Smart contract interface for encoding/decoding function calls
+// A small handle: the address plus a pointer to the ABI parsed once by the AbiRegistry, cheap to copy
 class Contract {
 public:
     explicit Contract(std::string _address, const std::string &abiPath);
 
+    // Function descriptor by name, throws if the ABI has none
+    [[nodiscard]] const AbiFunction &function(const std::string &name) const;
+
     // Decode blockchain response data
-    json decodeResponse(const std::string &responseData, const std::string &functionName);
+    [[nodiscard]] json decodeResponse(const std::string &responseData, const std::string &functionName) const;
+
+    static json decodeResponse(const std::string &responseData, const AbiFunction &function);
 
     static std::string decodeAddress(const std::string &paddedAddress);
 
@@ -27,9 +33,14 @@ public:
 
     static std::string decodeString(const std::string &data, size_t offset);
 
+    // T[] of a static element type, data is the hex payload without "0x" and offset counts hex characters
+    static json decodeArray(const std::string &data, size_t offset, const std::string &elementType);
+
 
     // Encode function calls for blockchain transactions
-    std::string encodeFunction(const std::string &name, const json &params = json::array());
+    [[nodiscard]] std::string encodeFunction(const std::string &name, const json &params = json::array()) const;
+
+    static std::string encodeFunction(const AbiFunction &function, const json &params = json::array());
 
     static std::string encodeParameters(const std::vector<std::string> &types, const std::vector<std::string> &values);
 
@@ -46,10 +57,7 @@ public:
     static std::string encodeUint(const std::string &value);
 
     std::string address{};
-    nlohmann::json abi{};
-
-private:
-    std::map<std::string, nlohmann::json> functionsByName{};
+    const ContractAbi *abi = nullptr;
 };
 
 #endif //CONTRACT_H
@@ -0,0 +1,564 @@
+#include "HttpServer.h"
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#ifdef DEDS_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef DEDS_HAVE_NGHTTP2
+#include <fcntl.h>
+#include <memory>
+#include <poll.h>
+#include <nghttp2/nghttp2.h>
+#endif
+
+// Reason phrase for the status codes we emit
+static const char *reasonPhrase(const int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 413: return "Payload Too Large";
+        case 429: return "Too Many Requests";
+        case 431: return "Request Header Fields Too Large";
+        case 500: return "Internal Server Error";
+        case 503: return "Service Unavailable";
+        default: return "Unknown";
+    }
+}
+
+// Write the whole buffer, retrying on partial writes
+static bool sendAll(const int fd, const std::string &data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) {
+            return false;
+        }
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+// Run the handler, a throwing handler becomes a 500
+static HttpResponse respond(const HttpServer::Handler &handler, const HttpRequest &request) {
+    HttpResponse response;
+    try {
+        response = handler(request);
+    } catch (const std::exception &e) {
+        response.status = 500;
+        response.contentType = "text/plain";
+        response.body = e.what();
+    } catch (...) {
+        response = HttpResponse{500, "text/plain", "Unknown handler error"};
+    }
+    HttpServer::compressResponse(request, response);
+    return response;
+}
+
+// Serialize an HTTP/1.1 response and send it
+static bool sendResponse(const int fd, const HttpResponse &response, const bool keepAlive) {
+    std::string raw = "HTTP/1.1 " + std::to_string(response.status) + " " + reasonPhrase(response.status) + "\r\n";
+    raw += "Content-Type: " + response.contentType + "\r\n";
+    raw += "Content-Length: " + std::to_string(response.body.size()) + "\r\n";
+    for (const auto &[key, value]: response.headers) {
+        raw += key + ": " + value + "\r\n";
+    }
+    raw += keepAlive ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+    raw += response.body;
+    return sendAll(fd, raw);
+}
+
+// Constructor: Store configuration, the socket is opened by start()
+HttpServer::HttpServer(const uint16_t port, Handler handler, std::string bindAddress)
+    : listenPort{port}, handler{std::move(handler)}, bindAddress{std::move(bindAddress)} {
+}
+
+// Destructor: Stop serving and wait for open connections
+HttpServer::~HttpServer() {
+    stop();
+}
+
+// Bind, listen and spawn the accept thread
+void HttpServer::start() {
+    if (running) {
+        return;
+    }
+
+    listenFd = ::socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0) {
+        throw std::runtime_error{"Failed to create socket"};
+    }
+
+    constexpr int enable = 1;
+    ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(listenPort);
+    if (::inet_pton(AF_INET, bindAddress.c_str(), &addr.sin_addr) != 1) {
+        ::close(listenFd);
+        throw std::runtime_error{"Invalid bind address: " + bindAddress};
+    }
+
+    if (::bind(listenFd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || ::listen(listenFd, 128) < 0) {
+        ::close(listenFd);
+        throw std::runtime_error{"Failed to listen on " + bindAddress + ":" + std::to_string(listenPort)};
+    }
+
+    socklen_t length = sizeof(addr);
+    ::getsockname(listenFd, reinterpret_cast<sockaddr *>(&addr), &length);
+    listenPort = ntohs(addr.sin_port);
+
+    running = true;
+    acceptThread = std::thread(&HttpServer::acceptLoop, this);
+}
+
+// Close the listening socket and all open connections
+void HttpServer::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+
+    ::shutdown(listenFd, SHUT_RDWR);
+    ::close(listenFd);
+    if (acceptThread.joinable()) {
+        acceptThread.join();
+    }
+
+    std::unique_lock lock(connectionsMutex);
+    for (const int fd: connectionFds) {
+        ::shutdown(fd, SHUT_RDWR);
+    }
+    connectionsDone.wait(lock, [this] { return connectionFds.empty(); });
+}
+
+// Get the bound port, resolved after start() when constructed with port 0
+uint16_t HttpServer::port() const {
+    return listenPort;
+}
+
+// Accept connections until stopped
+void HttpServer::acceptLoop() {
+    while (running) {
+        const int fd = ::accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+
+        constexpr int enable = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+        {
+            std::lock_guard lock(connectionsMutex);
+            if (!running) {
+                ::close(fd);
+                break;
+            }
+            connectionFds.insert(fd);
+        }
+        std::thread(&HttpServer::serveConnection, this, fd).detach();
+    }
+}
+
+// Gzip the body when the client accepts it and it is worth the CPU
+void HttpServer::compressResponse(const HttpRequest &request, HttpResponse &response) {
+#ifdef DEDS_HAVE_ZLIB
+    const auto accepted = request.headers.find("accept-encoding");
+    if (accepted == request.headers.end() || accepted->second.find("gzip") == std::string::npos ||
+        response.body.size() < MinCompressedBody) {
+        return;
+    }
+    for (const auto &header: response.headers) {
+        std::string key = header.first;
+        std::ranges::transform(key, key.begin(), [](const unsigned char c) { return std::tolower(c); });
+        if (key == "content-encoding") {
+            return;
+        }
+    }
+
+    z_stream stream{};
+    // 15 window bits plus 16 for the gzip wrapper instead of zlib's
+    if (deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        return;
+    }
+    std::string compressed(deflateBound(&stream, response.body.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef *>(response.body.data());
+    stream.avail_in = static_cast<uInt>(response.body.size());
+    stream.next_out = reinterpret_cast<Bytef *>(compressed.data());
+    stream.avail_out = static_cast<uInt>(compressed.size());
+    const int result = deflate(&stream, Z_FINISH);
+    compressed.resize(stream.total_out);
+    deflateEnd(&stream);
+    if (result != Z_STREAM_END) {
+        return;
+    }
+    response.body = std::move(compressed);
+    response.headers.emplace_back("Content-Encoding", "gzip");
+#else
+    (void) request;
+    (void) response;
+#endif
+}
+
+// Serve one connection, nothing it throws may escape its detached thread
+void HttpServer::serveConnection(const int fd) {
+    try {
+        serveRequests(fd);
+    } catch (const std::exception &e) {
+        std::cerr << "HttpServer: connection dropped: " << e.what() << "\n";
+    } catch (...) {
+        std::cerr << "HttpServer: connection dropped\n";
+    }
+
+    ::close(fd);
+    std::lock_guard lock(connectionsMutex);
+    connectionFds.erase(fd);
+    connectionsDone.notify_all();
+}
+
+// Read requests from one keep-alive connection and answer them in order, or hand it to the HTTP/2 loop
+void HttpServer::serveRequests(const int fd) {
+    std::string buffer;
+    char chunk[16384];
+    bool keepAlive = true;
+
+    while (keepAlive && running) {
+        size_t headerEnd;
+        while ((headerEnd = buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (buffer.size() > MaxHeader) {
+                sendResponse(fd, {431, "text/plain", "Headers over " + std::to_string(MaxHeader) + " bytes"}, false);
+                return;
+            }
+            const ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                keepAlive = false;
+                break;
+            }
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+        if (!keepAlive) {
+            break;
+        }
+        // The HTTP/2 connection preface, sent first by prior-knowledge clients
+        if (buffer.starts_with("PRI * HTTP/2.0\r\n")) {
+            serveHttp2(fd, std::move(buffer));
+            break;
+        }
+
+        HttpRequest request;
+        std::string version;
+        {
+            const std::string head = buffer.substr(0, headerEnd);
+            size_t lineEnd = head.find("\r\n");
+            const std::string requestLine = head.substr(0, lineEnd);
+            const size_t firstSpace = requestLine.find(' ');
+            const size_t secondSpace = requestLine.find(' ', firstSpace + 1);
+            request.method = requestLine.substr(0, firstSpace);
+            request.path = requestLine.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+            version = secondSpace == std::string::npos ? "" : requestLine.substr(secondSpace + 1);
+
+            while (lineEnd != std::string::npos) {
+                const size_t start = lineEnd + 2;
+                lineEnd = head.find("\r\n", start);
+                const std::string line = head.substr(start, lineEnd == std::string::npos ? std::string::npos
+                                                                                         : lineEnd - start);
+                const size_t colon = line.find(':');
+                if (colon == std::string::npos) {
+                    continue;
+                }
+                std::string key = line.substr(0, colon);
+                std::ranges::transform(key, key.begin(), [](const unsigned char c) { return std::tolower(c); });
+                std::string value = line.substr(colon + 1);
+                value.erase(0, value.find_first_not_of(" \t"));
+                request.headers[key] = value;
+            }
+        }
+        buffer.erase(0, headerEnd + 4);
+
+        // A body we can't frame or won't buffer ends the connection after the error
+        size_t contentLength = 0;
+        if (const auto it = request.headers.find("content-length"); it != request.headers.end()) {
+            const std::string &value = it->second;
+            const auto end = value.data() + value.find_last_not_of(" \t") + 1;
+            const auto [parsed, error] = std::from_chars(value.data(), end, contentLength);
+            if (error == std::errc::result_out_of_range || (error == std::errc{} && contentLength > MaxBody)) {
+                sendResponse(fd, {413, "text/plain", "Body over " + std::to_string(MaxBody) + " bytes"}, false);
+                break;
+            }
+            if (error != std::errc{} || parsed != end) {
+                sendResponse(fd, {400, "text/plain", "Bad Content-Length"}, false);
+                break;
+            }
+        }
+        while (buffer.size() < contentLength) {
+            const ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (n <= 0) {
+                keepAlive = false;
+                break;
+            }
+            buffer.append(chunk, static_cast<size_t>(n));
+        }
+        if (!keepAlive) {
+            break;
+        }
+        request.body = buffer.substr(0, contentLength);
+        buffer.erase(0, contentLength);
+
+        const auto connection = request.headers.find("connection");
+        if (version == "HTTP/1.0") {
+            keepAlive = connection != request.headers.end() && connection->second == "keep-alive";
+        } else {
+            keepAlive = connection == request.headers.end() || connection->second != "close";
+        }
+
+        if (!sendResponse(fd, respond(handler, request), keepAlive)) {
+            break;
+        }
+    }
+}
+
+#ifdef DEDS_HAVE_NGHTTP2
+namespace {
+    // A request being received, then its response being sent
+    struct Http2Stream {
+        HttpRequest request;
+        HttpResponse response;
+        size_t sent = 0;
+    };
+
+    // Responses finished by handler threads, shared with them so a late one never outlives it
+    struct Http2Completions {
+        std::mutex mutex;
+        std::condition_variable idle;
+        std::vector<std::pair<int32_t, HttpResponse> > ready;
+        size_t outstanding = 0;
+        int wakeFd = -1;
+    };
+
+    struct Http2Connection {
+        const HttpServer::Handler *handler;
+        std::map<int32_t, Http2Stream> streams;
+        std::shared_ptr<Http2Completions> completions;
+    };
+
+    int onBeginHeaders(nghttp2_session *, const nghttp2_frame *frame, void *userData) {
+        if (frame->hd.type == NGHTTP2_HEADERS && frame->headers.cat == NGHTTP2_HCAT_REQUEST) {
+            static_cast<Http2Connection *>(userData)->streams[frame->hd.stream_id];
+        }
+        return 0;
+    }
+
+    // Header names arrive lowercase, as HTTP/2 requires
+    int onHeader(nghttp2_session *, const nghttp2_frame *frame, const uint8_t *name, const size_t nameLength,
+                 const uint8_t *value, const size_t valueLength, uint8_t, void *userData) {
+        auto &streams = static_cast<Http2Connection *>(userData)->streams;
+        const auto stream = streams.find(frame->hd.stream_id);
+        if (stream == streams.end()) {
+            return 0;
+        }
+        const std::string key(reinterpret_cast<const char *>(name), nameLength);
+        std::string text(reinterpret_cast<const char *>(value), valueLength);
+        if (key == ":method") {
+            stream->second.request.method = std::move(text);
+        } else if (key == ":path") {
+            stream->second.request.path = std::move(text);
+        } else if (!key.starts_with(":")) {
+            stream->second.request.headers[key] = std::move(text);
+        }
+        return 0;
+    }
+
+    int onDataChunk(nghttp2_session *, uint8_t, const int32_t streamId, const uint8_t *data, const size_t length,
+                    void *userData) {
+        auto &streams = static_cast<Http2Connection *>(userData)->streams;
+        if (const auto stream = streams.find(streamId); stream != streams.end()) {
+            stream->second.request.body.append(reinterpret_cast<const char *>(data), length);
+        }
+        return 0;
+    }
+
+    // A complete request runs on its own thread, so one slow call doesn't hold up the other streams
+    int onFrameRecv(nghttp2_session *, const nghttp2_frame *frame, void *userData) {
+        if ((frame->hd.type != NGHTTP2_HEADERS && frame->hd.type != NGHTTP2_DATA) ||
+            !(frame->hd.flags & NGHTTP2_FLAG_END_STREAM)) {
+            return 0;
+        }
+        auto *connection = static_cast<Http2Connection *>(userData);
+        const auto stream = connection->streams.find(frame->hd.stream_id);
+        if (stream == connection->streams.end()) {
+            return 0;
+        }
+        {
+            std::lock_guard lock(connection->completions->mutex);
+            connection->completions->outstanding++;
+        }
+        std::thread([handler = connection->handler, completions = connection->completions,
+                        streamId = frame->hd.stream_id, request = stream->second.request] {
+            HttpResponse response = respond(*handler, request);
+            std::lock_guard lock(completions->mutex);
+            completions->ready.emplace_back(streamId, std::move(response));
+            completions->outstanding--;
+            constexpr char wake = 1;
+            [[maybe_unused]] const ssize_t written = ::write(completions->wakeFd, &wake, 1);
+            completions->idle.notify_all();
+        }).detach();
+        return 0;
+    }
+
+    int onStreamClose(nghttp2_session *, const int32_t streamId, uint32_t, void *userData) {
+        static_cast<Http2Connection *>(userData)->streams.erase(streamId);
+        return 0;
+    }
+
+    // Copy the next piece of a response body into a DATA frame
+    ssize_t readBody(nghttp2_session *, const int32_t streamId, uint8_t *buffer, const size_t length,
+                     uint32_t *dataFlags, nghttp2_data_source *, void *userData) {
+        auto &streams = static_cast<Http2Connection *>(userData)->streams;
+        const auto stream = streams.find(streamId);
+        if (stream == streams.end()) {
+            return NGHTTP2_ERR_TEMPORAL_CALLBACK_FAILURE;
+        }
+        const std::string &body = stream->second.response.body;
+        const size_t count = std::min(length, body.size() - stream->second.sent);
+        std::memcpy(buffer, body.data() + stream->second.sent, count);
+        stream->second.sent += count;
+        if (stream->second.sent == body.size()) {
+            *dataFlags |= NGHTTP2_DATA_FLAG_EOF;
+        }
+        return static_cast<ssize_t>(count);
+    }
+
+    // Queue the response on its stream, unless the client reset it meanwhile
+    void submitResponse(nghttp2_session *session, Http2Connection &connection, const int32_t streamId,
+                        HttpResponse response) {
+        const auto stream = connection.streams.find(streamId);
+        if (stream == connection.streams.end()) {
+            return;
+        }
+        stream->second.response = std::move(response);
+        const HttpResponse &stored = stream->second.response;
+
+        std::vector<std::pair<std::string, std::string> > fields{
+            {":status", std::to_string(stored.status)},
+            {"content-type", stored.contentType},
+            {"content-length", std::to_string(stored.body.size())}
+        };
+        for (const auto &[key, value]: stored.headers) {
+            std::string name = key;
+            std::ranges::transform(name, name.begin(), [](const unsigned char c) { return std::tolower(c); });
+            fields.emplace_back(std::move(name), value);
+        }
+        std::vector<nghttp2_nv> headers;
+        for (auto &[name, value]: fields) {
+            headers.push_back({
+                reinterpret_cast<uint8_t *>(name.data()), reinterpret_cast<uint8_t *>(value.data()), name.size(),
+                value.size(), NGHTTP2_NV_FLAG_NONE
+            });
+        }
+        nghttp2_data_provider provider{};
+        provider.read_callback = readBody;
+        nghttp2_submit_response(session, streamId, headers.data(), headers.size(), &provider);
+    }
+
+    // Write everything the session has queued
+    bool flushSession(nghttp2_session *session, const int fd) {
+        while (true) {
+            const uint8_t *data = nullptr;
+            const ssize_t length = nghttp2_session_mem_send(session, &data);
+            if (length < 0) {
+                return false;
+            }
+            if (length == 0) {
+                return true;
+            }
+            if (!sendAll(fd, std::string(reinterpret_cast<const char *>(data), static_cast<size_t>(length)))) {
+                return false;
+            }
+        }
+    }
+}
+
+// Multiplexed loop: frames from the socket feed the session, finished handlers wake it through a pipe
+void HttpServer::serveHttp2(const int fd, std::string buffer) {
+    Http2Connection connection{&handler, {}, std::make_shared<Http2Completions>()};
+    int wake[2];
+    if (::pipe2(wake, O_NONBLOCK | O_CLOEXEC) < 0) {
+        return;
+    }
+    connection.completions->wakeFd = wake[1];
+
+    nghttp2_session_callbacks *callbacks;
+    nghttp2_session_callbacks_new(&callbacks);
+    nghttp2_session_callbacks_set_on_begin_headers_callback(callbacks, onBeginHeaders);
+    nghttp2_session_callbacks_set_on_header_callback(callbacks, onHeader);
+    nghttp2_session_callbacks_set_on_data_chunk_recv_callback(callbacks, onDataChunk);
+    nghttp2_session_callbacks_set_on_frame_recv_callback(callbacks, onFrameRecv);
+    nghttp2_session_callbacks_set_on_stream_close_callback(callbacks, onStreamClose);
+    nghttp2_session *session;
+    nghttp2_session_server_new(&session, callbacks, &connection);
+    nghttp2_session_callbacks_del(callbacks);
+
+    // Large windows and many streams, JSON-RPC batches are big and clients multiplex them
+    const nghttp2_settings_entry settings[] = {
+        {NGHTTP2_SETTINGS_MAX_CONCURRENT_STREAMS, 1024},
+        {NGHTTP2_SETTINGS_INITIAL_WINDOW_SIZE, 16 << 20}
+    };
+    nghttp2_submit_settings(session, NGHTTP2_FLAG_NONE, settings, std::size(settings));
+    nghttp2_session_set_local_window_size(session, NGHTTP2_FLAG_NONE, 0, 64 << 20);
+
+    bool open = nghttp2_session_mem_recv(session, reinterpret_cast<const uint8_t *>(buffer.data()),
+                                         buffer.size()) >= 0;
+    char chunk[16384];
+    while (open && running) {
+        if (!flushSession(session, fd) ||
+            (!nghttp2_session_want_read(session) && !nghttp2_session_want_write(session))) {
+            break;
+        }
+
+        pollfd fds[2] = {{fd, POLLIN, 0}, {wake[0], POLLIN, 0}};
+        if (::poll(fds, 2, 1000) < 0) {
+            break;
+        }
+        if (fds[0].revents) {
+            const ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+            open = n > 0 && nghttp2_session_mem_recv(session, reinterpret_cast<const uint8_t *>(chunk),
+                                                     static_cast<size_t>(n)) >= 0;
+        }
+        if (fds[1].revents) {
+            while (::read(wake[0], chunk, sizeof(chunk)) > 0) {
+            }
+            std::vector<std::pair<int32_t, HttpResponse> > ready;
+            {
+                std::lock_guard lock(connection.completions->mutex);
+                ready.swap(connection.completions->ready);
+            }
+            for (auto &[streamId, response]: ready) {
+                submitResponse(session, connection, streamId, std::move(response));
+            }
+        }
+    }
+
+    // Handlers still running hold the handler and the pipe
+    {
+        std::unique_lock lock(connection.completions->mutex);
+        connection.completions->idle.wait(lock, [&] { return connection.completions->outstanding == 0; });
+    }
+    nghttp2_session_del(session);
+    ::close(wake[0]);
+    ::close(wake[1]);
+}
+#else
+// Built without nghttp2, prior-knowledge HTTP/2 clients are dropped
+void HttpServer::serveHttp2(int, std::string) {
+}
+#endif
@@ -0,0 +1,83 @@
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct HttpRequest {
+    std::string method;
+    std::string path;
+    std::map<std::string, std::string> headers; // lowercase keys
+    std::string body;
+};
+
+struct HttpResponse {
+    int status{200};
+    std::string contentType{"application/json"};
+    std::string body;
+    std::vector<std::pair<std::string, std::string> > headers;
+};
+
+// Minimal HTTP/1.1 server with keep-alive, one thread per connection. Builds with nghttp2 also take cleartext
+// HTTP/2 with prior knowledge (h2c), each stream's handler on its own thread. Bodies of 1 KiB and more are
+// gzipped for clients accepting it, when built with zlib
+// Used for the metrics pull endpoint and the local JSON-RPC stand-in node
+class HttpServer {
+public:
+    using Handler = std::function<HttpResponse(const HttpRequest &)>;
+
+    // Port 0 picks an ephemeral port, see port()
+    HttpServer(uint16_t port, Handler handler, std::string bindAddress = "127.0.0.1");
+
+    ~HttpServer();
+
+    HttpServer(const HttpServer &) = delete;
+
+    HttpServer &operator=(const HttpServer &) = delete;
+
+    void start();
+
+    void stop();
+
+    [[nodiscard]] uint16_t port() const;
+
+    static constexpr size_t MinCompressedBody = 1024;
+
+    // Largest request head and body an HTTP/1.1 connection buffers, larger ones get a 431 or 413 and are closed
+    static constexpr size_t MaxHeader = 64 << 10;
+    static constexpr size_t MaxBody = 64 << 20;
+
+    // Gzip the body in place if the request accepts gzip and the handler set no encoding itself
+    static void compressResponse(const HttpRequest &request, HttpResponse &response);
+
+private:
+    uint16_t listenPort;
+    Handler handler;
+    std::string bindAddress;
+    int listenFd{-1};
+    std::atomic<bool> running{false};
+    std::thread acceptThread;
+
+    std::mutex connectionsMutex;
+    std::condition_variable connectionsDone;
+    std::set<int> connectionFds;
+
+    void acceptLoop();
+
+    void serveConnection(int fd);
+
+    void serveRequests(int fd);
+
+    // Serve an HTTP/2 connection whose first bytes, the preface included, are already in buffer
+    void serveHttp2(int fd, std::string buffer);
+};
+
+#endif //HTTP_SERVER_H
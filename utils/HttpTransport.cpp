@@ -0,0 +1,192 @@
+#include "HttpTransport.h"
+
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+
+// One POST in flight, owned by the thread waiting in post()
+struct HttpTransport::Transfer {
+    CURL *easy = nullptr;
+    curl_slist *headers = nullptr;
+    std::string response;
+    CURLcode result = CURLE_OK;
+    char error[CURL_ERROR_SIZE] = {};
+    std::promise<void> done;
+};
+
+// Callback function for curl to write response data
+static size_t writeCallback(void *contents, const size_t size, const size_t nmemb, std::string *s) {
+    const size_t newLength{size * nmemb};
+    try {
+        s->append(static_cast<char *>(contents), newLength);
+        return newLength;
+    } catch (const std::exception &) {
+        return 0;
+    }
+}
+
+// Map a config name to its protocol
+HttpVersion parseHttpVersion(const std::string &name) {
+    if (name == "1.1") {
+        return HttpVersion::Http1;
+    }
+    if (name == "2") {
+        return HttpVersion::Http2;
+    }
+    if (name == "h2c") {
+        return HttpVersion::Http2PriorKnowledge;
+    }
+    throw std::invalid_argument{"Unknown HTTP version: " + name};
+}
+
+// Constructor: Initialize curl and start the multi loop
+HttpTransport::HttpTransport(std::string url, TransportOptions options)
+    : url{std::move(url)}, transportOptions{options} {
+    curl_global_init(CURL_GLOBAL_DEFAULT);
+    multi = curl_multi_init();
+    if (!multi) {
+        curl_global_cleanup();
+        throw std::runtime_error{"Failed to initialize CURL multi handle"};
+    }
+    // libcurl before 8.0 fails every request after the first on a reused prior-knowledge connection
+    const curl_version_info_data *curlVersion = curl_version_info(CURLVERSION_NOW);
+    if (transportOptions.httpVersion == HttpVersion::Http2PriorKnowledge &&
+        (curlVersion->version_num < 0x080000 || !(curlVersion->features & CURL_VERSION_HTTP2))) {
+        std::cerr << "HttpTransport: h2c needs libcurl 8.0 or newer with HTTP/2, this is " << curlVersion->version
+                << ", using HTTP/1.1 for " << this->url << "\n";
+        transportOptions.httpVersion = HttpVersion::Http1;
+    }
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, transportOptions.maxConnections);
+    loop = std::thread(&HttpTransport::run, this);
+}
+
+// Destructor: Let in-flight requests finish, then clean up curl
+HttpTransport::~HttpTransport() {
+    {
+        std::lock_guard lock(mutex);
+        stopping = true;
+    }
+    curl_multi_wakeup(multi);
+    loop.join();
+    curl_multi_cleanup(multi);
+    curl_global_cleanup();
+}
+
+// Get the endpoint settings
+const TransportOptions &HttpTransport::options() const {
+    return transportOptions;
+}
+
+// Queue the request on the multi loop and wait for it
+TransportResponse HttpTransport::post(const std::string &body, const std::string &contentType) {
+    Transfer transfer;
+    transfer.easy = curl_easy_init();
+    if (!transfer.easy) {
+        throw std::runtime_error{"Failed to initialize CURL"};
+    }
+    const std::string contentTypeHeader = "Content-Type: " + contentType;
+    transfer.headers = curl_slist_append(nullptr, contentTypeHeader.c_str());
+
+    CURL *easy = transfer.easy;
+    curl_easy_setopt(easy, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(easy, CURLOPT_HTTPHEADER, transfer.headers);
+    curl_easy_setopt(easy, CURLOPT_POSTFIELDS, body.c_str());
+    curl_easy_setopt(easy, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(body.size()));
+    curl_easy_setopt(easy, CURLOPT_WRITEFUNCTION, writeCallback);
+    curl_easy_setopt(easy, CURLOPT_WRITEDATA, &transfer.response);
+    curl_easy_setopt(easy, CURLOPT_ERRORBUFFER, transfer.error);
+    curl_easy_setopt(easy, CURLOPT_PRIVATE, &transfer);
+    curl_easy_setopt(easy, CURLOPT_TIMEOUT_MS, static_cast<long>(transportOptions.timeout.count()));
+    curl_easy_setopt(easy, CURLOPT_NOSIGNAL, 1L);
+    if (transportOptions.compression) {
+        // Empty string: every encoding this libcurl build supports
+        curl_easy_setopt(easy, CURLOPT_ACCEPT_ENCODING, "");
+    }
+    switch (transportOptions.httpVersion) {
+        case HttpVersion::Http1:
+            curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1);
+            break;
+        case HttpVersion::Http2:
+            curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+            break;
+        case HttpVersion::Http2PriorKnowledge:
+            curl_easy_setopt(easy, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE);
+            break;
+    }
+    if (transportOptions.httpVersion != HttpVersion::Http1) {
+        // Wait for a connection being set up to multiplex on it rather than opening another
+        curl_easy_setopt(easy, CURLOPT_PIPEWAIT, 1L);
+    }
+
+    std::future<void> done = transfer.done.get_future();
+    {
+        std::lock_guard lock(mutex);
+        if (stopping) {
+            curl_slist_free_all(transfer.headers);
+            curl_easy_cleanup(easy);
+            throw std::runtime_error{"HTTP transport is shutting down"};
+        }
+        queued.push_back(&transfer);
+    }
+    curl_multi_wakeup(multi);
+    done.wait();
+
+    TransportResponse response;
+    curl_off_t wireBytes = 0;
+    long httpVersion = 0;
+    curl_easy_getinfo(easy, CURLINFO_RESPONSE_CODE, &response.status);
+    curl_easy_getinfo(easy, CURLINFO_SIZE_DOWNLOAD_T, &wireBytes);
+    curl_easy_getinfo(easy, CURLINFO_NUM_CONNECTS, &response.newConnections);
+    curl_easy_getinfo(easy, CURLINFO_HTTP_VERSION, &httpVersion);
+    response.wireBytes = static_cast<uint64_t>(wireBytes);
+    response.http2 = httpVersion == CURL_HTTP_VERSION_2_0;
+    response.body = std::move(transfer.response);
+
+    curl_slist_free_all(transfer.headers);
+    curl_easy_cleanup(easy);
+
+    if (transfer.result != CURLE_OK) {
+        throw std::runtime_error{std::string("HTTP request failed: ") +
+                                 (transfer.error[0] ? transfer.error : curl_easy_strerror(transfer.result))};
+    }
+    return response;
+}
+
+// Multi loop, the only thread touching the multi handle apart from curl_multi_wakeup
+void HttpTransport::run() {
+    int active = 0;
+    while (true) {
+        {
+            std::lock_guard lock(mutex);
+            for (Transfer *transfer: queued) {
+                curl_multi_add_handle(multi, transfer->easy);
+                active++;
+            }
+            queued.clear();
+            if (stopping && active == 0) {
+                break;
+            }
+        }
+
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        int left = 0;
+        while (const CURLMsg *message = curl_multi_info_read(multi, &left)) {
+            if (message->msg != CURLMSG_DONE) {
+                continue;
+            }
+            Transfer *transfer = nullptr;
+            curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &transfer);
+            transfer->result = message->data.result;
+            curl_multi_remove_handle(multi, message->easy_handle);
+            active--;
+            // The waiting thread owns the transfer from here on
+            transfer->done.set_value();
+        }
+
+        curl_multi_poll(multi, nullptr, 0, 1000, nullptr);
+    }
+}
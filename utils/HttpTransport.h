@@ -0,0 +1,80 @@
+#ifndef HTTP_TRANSPORT_H
+#define HTTP_TRANSPORT_H
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <curl/curl.h>
+
+// HTTP protocol a transport asks its endpoint for
+enum class HttpVersion {
+    // HTTP/1.1 only, concurrent requests use separate keep-alive connections
+    Http1,
+    // HTTP/2 when a TLS endpoint offers it through ALPN, HTTP/1.1 otherwise
+    Http2,
+    // HTTP/2 without negotiation, for cleartext endpoints known to speak it (h2c). HTTP/1.1 with libcurl before 8.0
+    Http2PriorKnowledge
+};
+
+// "1.1", "2" or "h2c", throws std::invalid_argument on anything else
+HttpVersion parseHttpVersion(const std::string &name);
+
+// Per-endpoint transport settings
+struct TransportOptions {
+    HttpVersion httpVersion = HttpVersion::Http2;
+    // Advertise every encoding libcurl can decode (gzip, deflate, br, zstd), responses are decoded transparently
+    bool compression = true;
+    // Open connections per host, 0 for no limit
+    long maxConnections = 0;
+    std::chrono::milliseconds timeout{10000};
+};
+
+struct TransportResponse {
+    long status = 0;
+    // Decoded body
+    std::string body;
+    // Body bytes as received, before decoding
+    uint64_t wireBytes = 0;
+    // Connections this request had to open, 0 when it reused or multiplexed onto an existing one
+    long newConnections = 0;
+    bool http2 = false;
+};
+
+// POST transport over one libcurl multi handle driven by its own thread. Requests from any number of threads
+// share its connection cache: keep-alive reuse on HTTP/1.1, concurrent streams of one connection on HTTP/2
+class HttpTransport {
+public:
+    explicit HttpTransport(std::string url, TransportOptions options = {});
+
+    ~HttpTransport();
+
+    HttpTransport(const HttpTransport &) = delete;
+
+    HttpTransport &operator=(const HttpTransport &) = delete;
+
+    // Blocking, safe from any thread. Throws std::runtime_error when no response arrives, HTTP errors are returned
+    TransportResponse post(const std::string &body, const std::string &contentType = "application/json");
+
+    // The settings in effect, httpVersion may have fallen back from the requested one
+    [[nodiscard]] const TransportOptions &options() const;
+
+private:
+    struct Transfer;
+
+    std::string url;
+    TransportOptions transportOptions;
+    CURLM *multi;
+
+    std::mutex mutex;
+    std::vector<Transfer *> queued;
+    bool stopping = false;
+    std::thread loop;
+
+    // Add queued transfers, drive the multi handle, complete finished ones, until stopped and drained
+    void run();
+};
+
+#endif //HTTP_TRANSPORT_H
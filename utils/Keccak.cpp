@@ -0,0 +1,204 @@
+#include "Keccak.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+// Four 64-bit lanes, lowered to AVX2 or pairs of SSE2 registers by the compiler
+typedef uint64_t LaneVector __attribute__((vector_size(Keccak::BatchLanes * sizeof(uint64_t))));
+
+static constexpr uint64_t RoundConstants[24] = {
+    0x0000000000000001ULL, 0x0000000000008082ULL, 0x800000000000808aULL, 0x8000000080008000ULL,
+    0x000000000000808bULL, 0x0000000080000001ULL, 0x8000000080008081ULL, 0x8000000000008009ULL,
+    0x000000000000008aULL, 0x0000000000000088ULL, 0x0000000080008009ULL, 0x000000008000000aULL,
+    0x000000008000808bULL, 0x800000000000008bULL, 0x8000000000008089ULL, 0x8000000000008003ULL,
+    0x8000000000008002ULL, 0x8000000000000080ULL, 0x000000000000800aULL, 0x800000008000000aULL,
+    0x8000000080008081ULL, 0x8000000000008080ULL, 0x0000000080000001ULL, 0x8000000080008008ULL
+};
+
+static constexpr int RotationOffsets[24] = {
+    1, 3, 6, 10, 15, 21, 28, 36, 45, 55, 2, 14, 27, 41, 56, 8, 25, 43, 62, 18, 39, 61, 20, 44
+};
+
+static constexpr int PiLanes[24] = {
+    10, 7, 11, 17, 18, 3, 5, 16, 8, 21, 24, 4, 15, 23, 19, 13, 12, 2, 20, 14, 22, 9, 6, 1
+};
+
+// Macro rather than a function so vector lanes are never passed by value (GCC AVX ABI note)
+#define ROTL64(x, n) (((x) << (n)) | ((x) >> (64 - (n))))
+
+// Keccak-f[1600] over scalar or vector lanes
+template<typename T>
+static inline void keccakF(T st[25]) {
+    T bc[5];
+    for (const uint64_t roundConstant: RoundConstants) {
+        // Theta
+#pragma GCC unroll 5
+        for (int i = 0; i < 5; i++) {
+            bc[i] = st[i] ^ st[i + 5] ^ st[i + 10] ^ st[i + 15] ^ st[i + 20];
+        }
+#pragma GCC unroll 5
+        for (int i = 0; i < 5; i++) {
+            const T t = bc[(i + 4) % 5] ^ ROTL64(bc[(i + 1) % 5], 1);
+            for (int j = 0; j < 25; j += 5) {
+                st[j + i] ^= t;
+            }
+        }
+
+        // Rho and pi
+        T t = st[1];
+#pragma GCC unroll 24
+        for (int i = 0; i < 24; i++) {
+            const int j = PiLanes[i];
+            const T previous = st[j];
+            st[j] = ROTL64(t, RotationOffsets[i]);
+            t = previous;
+        }
+
+        // Chi
+#pragma GCC unroll 5
+        for (int j = 0; j < 25; j += 5) {
+            for (int i = 0; i < 5; i++) {
+                bc[i] = st[j + i];
+            }
+            for (int i = 0; i < 5; i++) {
+                st[j + i] ^= ~bc[(i + 1) % 5] & bc[(i + 2) % 5];
+            }
+        }
+
+        // Iota
+        st[0] ^= roundConstant;
+    }
+}
+
+static inline uint64_t load64(const uint8_t *p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value; // Keccak lanes are little-endian, as are all supported targets
+}
+
+// Copy the final partial block with Keccak padding into a full rate-sized block
+static inline void padLastBlock(const uint8_t *tail, const size_t tailLength, uint8_t block[Keccak::Rate]) {
+    std::memset(block, 0, Keccak::Rate);
+    std::memcpy(block, tail, tailLength);
+    block[tailLength] ^= 0x01;
+    block[Keccak::Rate - 1] ^= 0x80;
+}
+
+// Run Keccak-f[1600]
+void Keccak::permute(uint64_t state[25]) {
+    keccakF(state);
+}
+
+// Hash into a caller-provided 32-byte buffer
+void Keccak::hash(const void *data, size_t length, uint8_t *out) {
+    uint64_t st[25] = {};
+    auto input = static_cast<const uint8_t *>(data);
+
+    while (length >= Rate) {
+        for (size_t i = 0; i < Rate / 8; i++) {
+            st[i] ^= load64(input + i * 8);
+        }
+        keccakF(st);
+        input += Rate;
+        length -= Rate;
+    }
+
+    uint8_t block[Rate];
+    padLastBlock(input, length, block);
+    for (size_t i = 0; i < Rate / 8; i++) {
+        st[i] ^= load64(block + i * 8);
+    }
+    keccakF(st);
+
+    std::memcpy(out, st, DigestSize);
+}
+
+// Hash a byte string
+Keccak::Digest Keccak::hash(const std::string_view input) {
+    Digest digest;
+    hash(input.data(), input.size(), digest.data());
+    return digest;
+}
+
+// Absorb one group of BatchLanes inputs sharing the same block count
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+__attribute__((target_clones("avx2", "default")))
+#endif
+static void hashLanes(const std::string_view *const lanes[Keccak::BatchLanes], const size_t blocks,
+                      uint8_t *const outputs[Keccak::BatchLanes]) {
+    LaneVector st[25] = {};
+    uint8_t lastBlocks[Keccak::BatchLanes][Keccak::Rate];
+    const uint8_t *blockPtr[Keccak::BatchLanes];
+
+    for (size_t lane = 0; lane < Keccak::BatchLanes; lane++) {
+        const size_t tailOffset = (blocks - 1) * Keccak::Rate;
+        padLastBlock(reinterpret_cast<const uint8_t *>(lanes[lane]->data()) + tailOffset,
+                     lanes[lane]->size() - tailOffset, lastBlocks[lane]);
+    }
+
+    for (size_t block = 0; block < blocks; block++) {
+        for (size_t lane = 0; lane < Keccak::BatchLanes; lane++) {
+            blockPtr[lane] = block + 1 == blocks
+                                 ? lastBlocks[lane]
+                                 : reinterpret_cast<const uint8_t *>(lanes[lane]->data()) + block * Keccak::Rate;
+        }
+        for (size_t i = 0; i < Keccak::Rate / 8; i++) {
+            const LaneVector words = {
+                load64(blockPtr[0] + i * 8), load64(blockPtr[1] + i * 8),
+                load64(blockPtr[2] + i * 8), load64(blockPtr[3] + i * 8)
+            };
+            st[i] ^= words;
+        }
+        keccakF(st);
+    }
+
+    for (size_t lane = 0; lane < Keccak::BatchLanes; lane++) {
+        for (size_t i = 0; i < Keccak::DigestSize / 8; i++) {
+            const uint64_t word = st[i][lane];
+            std::memcpy(outputs[lane] + i * 8, &word, sizeof(word));
+        }
+    }
+}
+
+// Group inputs by block count and hash full groups across SIMD lanes, leftovers go through the scalar path
+void Keccak::hashBatch(const std::string_view *inputs, const size_t count, uint8_t *outputs) {
+    static_assert(BatchLanes == 4, "hashLanes loads exactly four lanes");
+
+    const auto blockCount = [](const std::string_view input) { return input.size() / Rate + 1; };
+
+    // Common case: every input fits in one block (selectors, topics, storage keys), no sorting needed
+    const bool uniform = std::all_of(inputs, inputs + count, [&](const std::string_view input) {
+        return blockCount(input) == blockCount(inputs[0]);
+    });
+
+    thread_local std::vector<size_t> order;
+    order.resize(count);
+    std::iota(order.begin(), order.end(), 0);
+    if (!uniform) {
+        std::ranges::stable_sort(order, {}, [&](const size_t i) { return blockCount(inputs[i]); });
+    }
+
+    size_t i = 0;
+    while (i + BatchLanes <= count) {
+        const size_t blocks = blockCount(inputs[order[i]]);
+        if (blockCount(inputs[order[i + BatchLanes - 1]]) != blocks) {
+            hash(inputs[order[i]].data(), inputs[order[i]].size(), outputs + order[i] * DigestSize);
+            i++;
+            continue;
+        }
+
+        const std::string_view *lanes[BatchLanes];
+        uint8_t *laneOutputs[BatchLanes];
+        for (size_t lane = 0; lane < BatchLanes; lane++) {
+            lanes[lane] = &inputs[order[i + lane]];
+            laneOutputs[lane] = outputs + order[i + lane] * DigestSize;
+        }
+        hashLanes(lanes, blocks, laneOutputs);
+        i += BatchLanes;
+    }
+
+    for (; i < count; i++) {
+        hash(inputs[order[i]].data(), inputs[order[i]].size(), outputs + order[i] * DigestSize);
+    }
+}
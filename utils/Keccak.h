@@ -0,0 +1,32 @@
+#ifndef KECCAK_H
+#define KECCAK_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Keccak-256 (original Keccak padding, as used by Ethereum) on Keccak-f[1600]
+struct Keccak {
+    static constexpr size_t DigestSize = 32;
+    static constexpr size_t Rate = 136;
+
+    using Digest = std::array<uint8_t, DigestSize>;
+
+    // Single hash, no heap allocation
+    static void hash(const void *data, size_t length, uint8_t *out);
+
+    static Digest hash(std::string_view input);
+
+    // Hash many inputs at once, inputs with the same block count share SIMD lanes
+    // outputs must hold count * DigestSize bytes
+    static void hashBatch(const std::string_view *inputs, size_t count, uint8_t *outputs);
+
+    // Number of inputs hashed together per permutation in hashBatch
+    static constexpr size_t BatchLanes = 4;
+
+    static void permute(uint64_t state[25]);
+};
+
+#endif //KECCAK_H
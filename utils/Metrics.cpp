@@ -0,0 +1,353 @@
+#include "Metrics.h"
+#include "HttpServer.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <ranges>
+#include <sstream>
+#include <stdexcept>
+
+// Increment counter
+void Counter::inc(const uint64_t amount) {
+    count.fetch_add(amount, std::memory_order_relaxed);
+}
+
+// Read counter
+uint64_t Counter::value() const {
+    return count.load(std::memory_order_relaxed);
+}
+
+// Set gauge to an absolute value
+void Gauge::set(const double value) {
+    current.store(value, std::memory_order_relaxed);
+}
+
+// Add to gauge, negative amounts decrement
+void Gauge::add(const double amount) {
+    current.fetch_add(amount, std::memory_order_relaxed);
+}
+
+// Read gauge
+double Gauge::value() const {
+    return current.load(std::memory_order_relaxed);
+}
+
+// Constructor: Allocate one bucket per bound plus +Inf
+Histogram::Histogram(std::vector<double> upperBounds)
+    : upperBounds{std::move(upperBounds)},
+      buckets{std::make_unique<std::atomic<uint64_t>[]>(this->upperBounds.size() + 1)} {
+    std::ranges::sort(this->upperBounds);
+}
+
+// Record one observation
+void Histogram::observe(const double value) {
+    const auto it = std::ranges::lower_bound(upperBounds, value);
+    buckets[it - upperBounds.begin()].fetch_add(1, std::memory_order_relaxed);
+    observations.fetch_add(1, std::memory_order_relaxed);
+    total.fetch_add(value, std::memory_order_relaxed);
+}
+
+// Get bucket upper bounds
+const std::vector<double> &Histogram::bounds() const {
+    return upperBounds;
+}
+
+// Get per-bucket counts
+std::vector<uint64_t> Histogram::bucketCounts() const {
+    std::vector<uint64_t> counts(upperBounds.size() + 1);
+    for (size_t i = 0; i < counts.size(); i++) {
+        counts[i] = buckets[i].load(std::memory_order_relaxed);
+    }
+    return counts;
+}
+
+// Get number of observations
+uint64_t Histogram::count() const {
+    return observations.load(std::memory_order_relaxed);
+}
+
+// Get sum of observations
+double Histogram::sum() const {
+    return total.load(std::memory_order_relaxed);
+}
+
+// Latency buckets in seconds
+std::vector<double> Histogram::latencyBuckets() {
+    return {0.00005, 0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30};
+}
+
+// Size buckets for batch sizes and counts
+std::vector<double> Histogram::sizeBuckets() {
+    std::vector<double> bounds;
+    for (double bound = 1; bound <= 65536; bound *= 2) {
+        bounds.push_back(bound);
+    }
+    return bounds;
+}
+
+// Constructor: Start timing
+ScopedTimer::ScopedTimer(Histogram &histogram)
+    : histogram{histogram}, start{std::chrono::steady_clock::now()} {
+}
+
+// Destructor: Record elapsed seconds
+ScopedTimer::~ScopedTimer() {
+    histogram.observe(elapsed());
+}
+
+// Seconds since construction
+double ScopedTimer::elapsed() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Get process-wide registry
+Metrics &Metrics::instance() {
+    static Metrics metrics;
+    return metrics;
+}
+
+// Get or register a counter series
+Counter &Metrics::counter(const std::string &name, const MetricLabels &labels, const std::string &help) {
+    return *findOrCreate(name, Type::Counter, labels, help, nullptr).counter;
+}
+
+// Get or register a gauge series
+Gauge &Metrics::gauge(const std::string &name, const MetricLabels &labels, const std::string &help) {
+    return *findOrCreate(name, Type::Gauge, labels, help, nullptr).gauge;
+}
+
+// Get or register a histogram series, bounds are only used on first registration
+Histogram &Metrics::histogram(const std::string &name, const MetricLabels &labels, const std::string &help,
+                              const std::vector<double> &bounds) {
+    return *findOrCreate(name, Type::Histogram, labels, help, &bounds).histogram;
+}
+
+// Serialize labels into a stable map key
+std::string Metrics::labelsKey(const MetricLabels &labels) {
+    std::string key;
+    for (const auto &[name, value]: labels) {
+        key += name;
+        key += '\x1f';
+        key += value;
+        key += '\x1e';
+    }
+    return key;
+}
+
+// Find a series under a shared lock, registering it under an exclusive lock if missing
+Metrics::Series &Metrics::findOrCreate(const std::string &name, const Type type, const MetricLabels &labels,
+                                       const std::string &help, const std::vector<double> *bounds) {
+    const std::string key = labelsKey(labels);
+    {
+        std::shared_lock lock(mutex);
+        if (const auto family = families.find(name); family != families.end()) {
+            if (family->second.type != type) {
+                throw std::runtime_error{"Metric registered with a different type: " + name};
+            }
+            if (const auto series = family->second.series.find(key); series != family->second.series.end()) {
+                return series->second;
+            }
+        }
+    }
+
+    std::unique_lock lock(mutex);
+    auto [familyIt, inserted] = families.try_emplace(name, Family{type, help, {}});
+    Family &family = familyIt->second;
+    if (family.type != type) {
+        throw std::runtime_error{"Metric registered with a different type: " + name};
+    }
+    if (family.help.empty()) {
+        family.help = help;
+    }
+
+    auto [seriesIt, created] = family.series.try_emplace(key);
+    Series &series = seriesIt->second;
+    if (created) {
+        series.labels = labels;
+        switch (type) {
+            case Type::Counter:
+                series.counter = std::make_unique<Counter>();
+                break;
+            case Type::Gauge:
+                series.gauge = std::make_unique<Gauge>();
+                break;
+            case Type::Histogram:
+                series.histogram = std::make_unique<Histogram>(bounds ? *bounds : Histogram::latencyBuckets());
+                break;
+        }
+    }
+    return series;
+}
+
+// Escape a label value for the Prometheus text format
+static std::string escapeLabel(const std::string &value) {
+    std::string escaped;
+    for (const char c: value) {
+        if (c == '\\' || c == '"') {
+            escaped += '\\';
+            escaped += c;
+        } else if (c == '\n') {
+            escaped += "\\n";
+        } else {
+            escaped += c;
+        }
+    }
+    return escaped;
+}
+
+// Format a label set, with an optional extra label (used for histogram "le")
+static std::string formatLabels(const MetricLabels &labels, const std::string &extraName = "",
+                                const std::string &extraValue = "") {
+    if (labels.empty() && extraName.empty()) {
+        return "";
+    }
+
+    std::string out = "{";
+    bool first = true;
+    for (const auto &[name, value]: labels) {
+        if (!first) out += ",";
+        out += name + "=\"" + escapeLabel(value) + "\"";
+        first = false;
+    }
+    if (!extraName.empty()) {
+        if (!first) out += ",";
+        out += extraName + "=\"" + extraValue + "\"";
+    }
+    return out + "}";
+}
+
+// Format a double without trailing noise
+static std::string formatNumber(const double value) {
+    std::ostringstream ss;
+    ss.precision(12);
+    ss << value;
+    return ss.str();
+}
+
+// Render every series in the Prometheus text exposition format
+std::string Metrics::renderPrometheus() const {
+    std::shared_lock lock(mutex);
+    std::string out;
+
+    for (const auto &[name, family]: families) {
+        if (!family.help.empty()) {
+            out += "# HELP " + name + " " + family.help + "\n";
+        }
+
+        switch (family.type) {
+            case Type::Counter:
+                out += "# TYPE " + name + " counter\n";
+                for (const auto &series: family.series | std::views::values) {
+                    out += name + formatLabels(series.labels) + " " + std::to_string(series.counter->value()) + "\n";
+                }
+                break;
+            case Type::Gauge:
+                out += "# TYPE " + name + " gauge\n";
+                for (const auto &series: family.series | std::views::values) {
+                    out += name + formatLabels(series.labels) + " " + formatNumber(series.gauge->value()) + "\n";
+                }
+                break;
+            case Type::Histogram:
+                out += "# TYPE " + name + " histogram\n";
+                for (const auto &series: family.series | std::views::values) {
+                    const Histogram &histogram = *series.histogram;
+                    const std::vector<uint64_t> counts = histogram.bucketCounts();
+                    uint64_t cumulative = 0;
+                    for (size_t i = 0; i < histogram.bounds().size(); i++) {
+                        cumulative += counts[i];
+                        out += name + "_bucket" + formatLabels(series.labels, "le",
+                                                               formatNumber(histogram.bounds()[i]))
+                                + " " + std::to_string(cumulative) + "\n";
+                    }
+                    cumulative += counts.back();
+                    out += name + "_bucket" + formatLabels(series.labels, "le", "+Inf") + " "
+                            + std::to_string(cumulative) + "\n";
+                    out += name + "_sum" + formatLabels(series.labels) + " " + formatNumber(histogram.sum()) + "\n";
+                    out += name + "_count" + formatLabels(series.labels) + " " + std::to_string(histogram.count()) +
+                            "\n";
+                }
+                break;
+        }
+    }
+
+    return out;
+}
+
+// Render every series as JSON grouped by metric name
+json Metrics::renderJson() const {
+    std::shared_lock lock(mutex);
+    json out = json::object();
+
+    for (const auto &[name, family]: families) {
+        json entry;
+        entry["help"] = family.help;
+        entry["series"] = json::array();
+
+        for (const auto &series: family.series | std::views::values) {
+            json item;
+            item["labels"] = json::object();
+            for (const auto &[labelName, labelValue]: series.labels) {
+                item["labels"][labelName] = labelValue;
+            }
+
+            switch (family.type) {
+                case Type::Counter:
+                    entry["type"] = "counter";
+                    item["value"] = series.counter->value();
+                    break;
+                case Type::Gauge:
+                    entry["type"] = "gauge";
+                    item["value"] = series.gauge->value();
+                    break;
+                case Type::Histogram:
+                    entry["type"] = "histogram";
+                    item["count"] = series.histogram->count();
+                    item["sum"] = series.histogram->sum();
+                    item["bounds"] = series.histogram->bounds();
+                    item["buckets"] = series.histogram->bucketCounts();
+                    break;
+            }
+            entry["series"].push_back(item);
+        }
+        out[name] = entry;
+    }
+
+    return out;
+}
+
+// Write rendering to a temporary file then rename it over the target
+void Metrics::writeToFile(const std::string &path, const Format format) const {
+    const std::string tmpPath = path + ".tmp";
+    {
+        std::ofstream file(tmpPath, std::ios::trunc);
+        if (!file.is_open()) {
+            throw std::runtime_error{"Failed to open metrics file: " + tmpPath};
+        }
+        file << (format == Format::Prometheus ? renderPrometheus() : renderJson().dump(2));
+    }
+
+    if (std::rename(tmpPath.c_str(), path.c_str()) != 0) {
+        throw std::runtime_error{"Failed to replace metrics file: " + path};
+    }
+}
+
+// Start a pull endpoint for scrapers
+std::unique_ptr<HttpServer> Metrics::serve(const uint16_t port, const std::string &bindAddress) {
+    auto server = std::make_unique<HttpServer>(port, [this](const HttpRequest &request) {
+        HttpResponse response;
+        if (request.method != "GET") {
+            response.status = 405;
+        } else if (request.path == "/metrics") {
+            response.contentType = "text/plain; version=0.0.4";
+            response.body = renderPrometheus();
+        } else if (request.path == "/metrics.json") {
+            response.body = renderJson().dump();
+        } else {
+            response.status = 404;
+        }
+        return response;
+    }, bindAddress);
+    server->start();
+    return server;
+}
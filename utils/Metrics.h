@@ -0,0 +1,142 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+class HttpServer;
+
+using MetricLabels = std::vector<std::pair<std::string, std::string> >;
+
+// Monotonic counter, relaxed atomic increments
+class Counter {
+public:
+    void inc(uint64_t amount = 1);
+
+    [[nodiscard]] uint64_t value() const;
+
+private:
+    std::atomic<uint64_t> count{0};
+};
+
+// Last-value gauge
+class Gauge {
+public:
+    void set(double value);
+
+    void add(double amount);
+
+    [[nodiscard]] double value() const;
+
+private:
+    std::atomic<double> current{0.0};
+};
+
+// Fixed-bucket histogram, each observation is a few relaxed atomic adds
+class Histogram {
+public:
+    explicit Histogram(std::vector<double> upperBounds);
+
+    void observe(double value);
+
+    [[nodiscard]] const std::vector<double> &bounds() const;
+
+    // Non-cumulative count per bucket, last entry is the +Inf bucket
+    [[nodiscard]] std::vector<uint64_t> bucketCounts() const;
+
+    [[nodiscard]] uint64_t count() const;
+
+    [[nodiscard]] double sum() const;
+
+    // Default buckets: 50us to ~30s latencies
+    static std::vector<double> latencyBuckets();
+
+    // Powers of two from 1 to 65536
+    static std::vector<double> sizeBuckets();
+
+private:
+    std::vector<double> upperBounds;
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+    std::atomic<uint64_t> observations{0};
+    std::atomic<double> total{0.0};
+};
+
+// Records elapsed seconds into a histogram when it goes out of scope
+class ScopedTimer {
+public:
+    explicit ScopedTimer(Histogram &histogram);
+
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer &) = delete;
+
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+    [[nodiscard]] double elapsed() const;
+
+private:
+    Histogram &histogram;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Process-wide metric registry with Prometheus text and JSON export
+// Lookups take a shared lock, hot paths should keep the returned reference: the metric itself is lock-free
+class Metrics {
+public:
+    enum class Format { Prometheus, Json };
+
+    static Metrics &instance();
+
+    Counter &counter(const std::string &name, const MetricLabels &labels = {}, const std::string &help = "");
+
+    Gauge &gauge(const std::string &name, const MetricLabels &labels = {}, const std::string &help = "");
+
+    Histogram &histogram(const std::string &name, const MetricLabels &labels = {}, const std::string &help = "",
+                         const std::vector<double> &bounds = Histogram::latencyBuckets());
+
+    [[nodiscard]] std::string renderPrometheus() const;
+
+    [[nodiscard]] json renderJson() const;
+
+    // Atomically replace the file with the current rendering
+    void writeToFile(const std::string &path, Format format = Format::Prometheus) const;
+
+    // Serve GET /metrics (Prometheus) and GET /metrics.json from a background thread
+    std::unique_ptr<HttpServer> serve(uint16_t port, const std::string &bindAddress = "127.0.0.1");
+
+private:
+    enum class Type { Counter, Gauge, Histogram };
+
+    struct Series {
+        MetricLabels labels;
+        std::unique_ptr<Counter> counter;
+        std::unique_ptr<Gauge> gauge;
+        std::unique_ptr<Histogram> histogram;
+    };
+
+    struct Family {
+        Type type;
+        std::string help;
+        std::map<std::string, Series> series;
+    };
+
+    mutable std::shared_mutex mutex;
+    std::map<std::string, Family> families;
+
+    Series &findOrCreate(const std::string &name, Type type, const MetricLabels &labels, const std::string &help,
+                         const std::vector<double> *bounds);
+
+    static std::string labelsKey(const MetricLabels &labels);
+};
+
+#endif //METRICS_H
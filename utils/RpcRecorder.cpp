@@ -0,0 +1,62 @@
+#include "RpcRecorder.h"
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+#include <unordered_map>
+
+// Constructor: Open recording file in append mode
+RpcRecorder::RpcRecorder(const std::string &path)
+    : file{path, std::ios::app} {
+    if (!file.is_open()) {
+        throw std::runtime_error{"Failed to open recording file: " + path};
+    }
+}
+
+// Record a single request or a whole batch with its responses
+void RpcRecorder::record(const json &request, const json &response) {
+    std::lock_guard lock(mutex);
+
+    if (!request.is_array()) {
+        writeEntry(request, response);
+    } else if (response.is_array()) {
+        std::unordered_map<std::string, const json *> responsesById;
+        for (const auto &item: response) {
+            if (item.contains("id")) {
+                responsesById[item["id"].dump()] = &item;
+            }
+        }
+        for (const auto &item: request) {
+            if (const auto it = responsesById.find(item["id"].dump()); it != responsesById.end()) {
+                writeEntry(item, *it->second);
+            }
+        }
+    }
+    file.flush();
+}
+
+// Number of entries written so far
+size_t RpcRecorder::recorded() const {
+    std::lock_guard lock(mutex);
+    return count;
+}
+
+// Build replay lookup key
+std::string RpcRecorder::requestKey(const std::string &method, const json &params) {
+    std::string key = method + " " + params.dump();
+    std::ranges::transform(key, key.begin(), [](const unsigned char c) { return std::tolower(c); });
+    return key;
+}
+
+// Write one line, caller holds the mutex
+void RpcRecorder::writeEntry(const json &request, const json &response) {
+    json entry;
+    entry["method"] = request.value("method", "");
+    entry["params"] = request.contains("params") ? request["params"] : json::array();
+    if (response.contains("error")) {
+        entry["error"] = response["error"];
+    } else {
+        entry["result"] = response.contains("result") ? response["result"] : json();
+    }
+    file << entry.dump() << '\n';
+    count++;
+}
@@ -0,0 +1,32 @@
+#ifndef RPC_RECORDER_H
+#define RPC_RECORDER_H
+
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+// Appends JSON-RPC request/response pairs to a JSON Lines file
+// Batches are split into one line per sub-request, matched to its response by id
+class RpcRecorder {
+public:
+    explicit RpcRecorder(const std::string &path);
+
+    void record(const json &request, const json &response);
+
+    [[nodiscard]] size_t recorded() const;
+
+    // Key used to match a request on replay: method and params, case-insensitive
+    static std::string requestKey(const std::string &method, const json &params);
+
+private:
+    mutable std::mutex mutex;
+    std::ofstream file;
+    size_t count{0};
+
+    void writeEntry(const json &request, const json &response);
+};
+
+#endif //RPC_RECORDER_H
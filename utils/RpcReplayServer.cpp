@@ -0,0 +1,173 @@
+#include "RpcReplayServer.h"
+#include "RpcRecorder.h"
+#include <fstream>
+#include <stdexcept>
+#include <thread>
+
+// Constructor: Load the recording, the HTTP listener is opened by start()
+RpcReplayServer::RpcReplayServer(const std::string &recordingPath, ReplayOptions options, const uint16_t port)
+    : options{options}, rng{options.seed} {
+    load(recordingPath);
+    server = std::make_unique<HttpServer>(port, [this](const HttpRequest &request) { return serve(request); });
+}
+
+// Index recorded entries by request key, keeping their order
+void RpcReplayServer::load(const std::string &recordingPath) {
+    std::ifstream file(recordingPath);
+    if (!file.is_open()) {
+        throw std::runtime_error{"Failed to open recording file: " + recordingPath};
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        json entry = json::parse(line);
+        const std::string key = RpcRecorder::requestKey(entry["method"].get<std::string>(), entry["params"]);
+        auto &recording = recordings[key];
+        if (!recording) {
+            recording = std::make_unique<Recording>();
+        }
+        recording->answers.push_back(std::move(entry));
+    }
+}
+
+// Start listening
+void RpcReplayServer::start() {
+    server->start();
+}
+
+// Stop listening
+void RpcReplayServer::stop() {
+    server->stop();
+}
+
+// Get bound port
+uint16_t RpcReplayServer::port() const {
+    return server->port();
+}
+
+// Get URL to hand to Web3Client
+std::string RpcReplayServer::url() const {
+    return "http://127.0.0.1:" + std::to_string(server->port());
+}
+
+// Number of distinct recorded requests
+size_t RpcReplayServer::entries() const {
+    return recordings.size();
+}
+
+// Snapshot counters
+RpcReplayServer::Stats RpcReplayServer::stats() const {
+    return {httpRequests.load(), calls.load(), misses.load(), injectedErrors.load(), rejectedBatches.load()};
+}
+
+// Uniform random number in [0, 1)
+double RpcReplayServer::uniform() {
+    std::lock_guard lock(rngMutex);
+    return std::uniform_real_distribution(0.0, 1.0)(rng);
+}
+
+// Find the next recorded answer, falling back to a "latest" recording for pinned block tags
+const json *RpcReplayServer::lookup(const std::string &method, const json &params) {
+    auto it = recordings.find(RpcRecorder::requestKey(method, params));
+    if (it == recordings.end() && params.is_array() && !params.empty() && params.back().is_string()) {
+        json latestParams = params;
+        latestParams.back() = "latest";
+        it = recordings.find(RpcRecorder::requestKey(method, latestParams));
+    }
+    if (it == recordings.end()) {
+        return nullptr;
+    }
+
+    Recording &recording = *it->second;
+    const size_t index = std::min(recording.cursor.fetch_add(1), recording.answers.size() - 1);
+    return &recording.answers[index];
+}
+
+// Answer a single JSON-RPC request object
+json RpcReplayServer::answer(const json &request) {
+    calls.fetch_add(1);
+    json response = {{"jsonrpc", "2.0"}, {"id", request.contains("id") ? request["id"] : json()}};
+
+    if (options.errorRate > 0 && uniform() < options.errorRate) {
+        injectedErrors.fetch_add(1);
+        response["error"] = {{"code", -32603}, {"message", "injected error"}};
+        return response;
+    }
+
+    const json params = request.contains("params") ? request["params"] : json::array();
+    const json *recorded = lookup(request.value("method", ""), params);
+    if (!recorded) {
+        misses.fetch_add(1);
+        response["error"] = {{"code", -32000}, {"message", "request not found in recording"}};
+    } else if (recorded->contains("error")) {
+        response["error"] = (*recorded)["error"];
+    } else {
+        response["result"] = (*recorded)["result"];
+    }
+    return response;
+}
+
+// Answer a request or a batch
+json RpcReplayServer::handle(const json &request) {
+    if (!request.is_array()) {
+        return answer(request);
+    }
+
+    if (options.maxBatchSize > 0 && request.size() > options.maxBatchSize) {
+        rejectedBatches.fetch_add(1);
+        return {
+            {"jsonrpc", "2.0"}, {"id", nullptr},
+            {
+                "error", {
+                    {"code", -32005},
+                    {"message", "batch size " + std::to_string(request.size()) + " exceeds limit " +
+                                std::to_string(options.maxBatchSize)}
+                }
+            }
+        };
+    }
+
+    json responses = json::array();
+    for (const auto &item: request) {
+        responses.push_back(answer(item));
+    }
+    return responses;
+}
+
+// HTTP entry point: simulated delay, transport errors, then JSON-RPC handling
+HttpResponse RpcReplayServer::serve(const HttpRequest &request) {
+    httpRequests.fetch_add(1);
+    HttpResponse response;
+
+    auto delay = options.latency;
+    if (options.jitter.count() > 0) {
+        const double extra = uniform() * static_cast<double>(options.jitter.count());
+        delay += std::chrono::microseconds(static_cast<int64_t>(extra));
+    }
+    if (delay.count() > 0) {
+        std::this_thread::sleep_for(delay);
+    }
+
+    if (request.method != "POST") {
+        response.status = 405;
+        return response;
+    }
+    if (options.httpErrorRate > 0 && uniform() < options.httpErrorRate) {
+        injectedErrors.fetch_add(1);
+        response.status = 503;
+        response.body = R"({"error":"injected unavailability"})";
+        return response;
+    }
+
+    try {
+        response.body = handle(json::parse(request.body)).dump();
+    } catch (const json::parse_error &e) {
+        response.body = json{
+            {"jsonrpc", "2.0"}, {"id", nullptr}, {"error", {{"code", -32700}, {"message", e.what()}}}
+        }.dump();
+    }
+    return response;
+}
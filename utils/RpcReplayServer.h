@@ -0,0 +1,87 @@
+#ifndef RPC_REPLAY_SERVER_H
+#define RPC_REPLAY_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "HttpServer.h"
+
+using json = nlohmann::json;
+
+// Knobs for the stand-in node
+struct ReplayOptions {
+    std::chrono::microseconds latency{0};
+    std::chrono::microseconds jitter{0}; // uniform in [0, jitter] on top of latency
+    size_t maxBatchSize{0}; // 0 disables the limit
+    double errorRate{0.0}; // probability of a JSON-RPC error per sub-request
+    double httpErrorRate{0.0}; // probability of an HTTP 503 per request
+    uint64_t seed{1};
+};
+
+// Local JSON-RPC node answering from an RpcRecorder file, with injected latency, limits and errors
+class RpcReplayServer {
+public:
+    struct Stats {
+        uint64_t httpRequests{0};
+        uint64_t calls{0};
+        uint64_t misses{0};
+        uint64_t injectedErrors{0};
+        uint64_t rejectedBatches{0};
+    };
+
+    explicit RpcReplayServer(const std::string &recordingPath, ReplayOptions options = {}, uint16_t port = 0);
+
+    void start();
+
+    void stop();
+
+    [[nodiscard]] uint16_t port() const;
+
+    [[nodiscard]] std::string url() const;
+
+    [[nodiscard]] size_t entries() const;
+
+    [[nodiscard]] Stats stats() const;
+
+    // Answer one JSON-RPC request or batch, without the simulated network delay
+    json handle(const json &request);
+
+private:
+    // Recorded answers for one request key, replayed in order and then sticking to the last one
+    struct Recording {
+        std::vector<json> answers;
+        std::atomic<size_t> cursor{0};
+    };
+
+    ReplayOptions options;
+    std::unordered_map<std::string, std::unique_ptr<Recording> > recordings;
+    std::unique_ptr<HttpServer> server;
+
+    std::mutex rngMutex;
+    std::mt19937_64 rng;
+
+    std::atomic<uint64_t> httpRequests{0};
+    std::atomic<uint64_t> calls{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> injectedErrors{0};
+    std::atomic<uint64_t> rejectedBatches{0};
+
+    void load(const std::string &recordingPath);
+
+    json answer(const json &request);
+
+    const json *lookup(const std::string &method, const json &params);
+
+    double uniform();
+
+    HttpResponse serve(const HttpRequest &request);
+};
+
+#endif //RPC_REPLAY_SERVER_H
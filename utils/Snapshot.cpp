@@ -0,0 +1,138 @@
+#include "Snapshot.h"
+
+#include <stdexcept>
+#include "Metrics.h"
+
+// Per-thread reader slot, claimed on first pin and released at thread exit
+struct ThreadSlot {
+    EpochDomain::Slot *slot = nullptr;
+    unsigned depth = 0;
+
+    ~ThreadSlot() {
+        if (slot) {
+            slot->epoch.store(0, std::memory_order_release);
+            slot->used.store(false, std::memory_order_release);
+        }
+    }
+};
+
+static thread_local ThreadSlot threadState;
+
+// Retired objects not yet freed
+static Gauge &retiredGauge() {
+    static Gauge &gauge = Metrics::instance().gauge("deds_snapshot_retired_pending", {},
+                                                    "Replaced snapshots waiting for readers to unpin");
+    return gauge;
+}
+
+// Get process-wide domain
+EpochDomain &EpochDomain::instance() {
+    static EpochDomain domain;
+    return domain;
+}
+
+// Claim a free slot for the calling thread, once per thread
+EpochDomain::Slot &EpochDomain::threadSlot() {
+    if (!threadState.slot) {
+        for (auto &slot: slots) {
+            bool expected = false;
+            if (slot.used.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                threadState.slot = &slot;
+                break;
+            }
+        }
+        if (!threadState.slot) {
+            throw std::runtime_error{"EpochDomain: more than " + std::to_string(MaxThreads) + " reader threads"};
+        }
+    }
+    return *threadState.slot;
+}
+
+// Announce the current epoch before any shared pointer is loaded
+EpochDomain::Guard EpochDomain::pin() {
+    Slot &slot = threadSlot();
+    if (threadState.depth++ == 0) {
+        slot.epoch.store(globalEpoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+    }
+    return Guard(this);
+}
+
+// Clear the slot when the outermost guard goes away
+void EpochDomain::unpin() {
+    if (--threadState.depth == 0) {
+        threadState.slot->epoch.store(0, std::memory_order_release);
+    }
+}
+
+// Tag with the epoch the object was unlinked in, then advance so new readers cannot see it
+void EpochDomain::retire(std::function<void()> deleter) {
+    const uint64_t epoch = globalEpoch.fetch_add(1, std::memory_order_seq_cst);
+    std::lock_guard lock(retireMutex);
+    retired.emplace_back(epoch, std::move(deleter));
+    retiredGauge().set(static_cast<double>(retired.size()));
+}
+
+// Free what no pinned reader can reference, skip if another writer is already reclaiming
+size_t EpochDomain::reclaim() {
+    std::unique_lock lock(retireMutex, std::try_to_lock);
+    if (!lock.owns_lock()) {
+        return 0;
+    }
+
+    uint64_t oldestPinned = UINT64_MAX;
+    for (const auto &slot: slots) {
+        const uint64_t epoch = slot.epoch.load(std::memory_order_seq_cst);
+        if (epoch != 0 && epoch < oldestPinned) {
+            oldestPinned = epoch;
+        }
+    }
+
+    // A reader pinned at epoch e may hold anything retired at epoch >= e
+    std::vector<std::function<void()> > ready;
+    std::erase_if(retired, [&](auto &entry) {
+        if (entry.first < oldestPinned) {
+            ready.push_back(std::move(entry.second));
+            return true;
+        }
+        return false;
+    });
+    retiredGauge().set(static_cast<double>(retired.size()));
+    lock.unlock();
+
+    for (auto &deleter: ready) {
+        deleter();
+    }
+    return ready.size();
+}
+
+// Number of retired objects not yet freed
+size_t EpochDomain::pendingRetired() {
+    std::lock_guard lock(retireMutex);
+    return retired.size();
+}
+
+// Constructor: Hold a pin on the domain
+EpochDomain::Guard::Guard(EpochDomain *domain) : domain{domain} {
+}
+
+// Destructor: Release the pin
+EpochDomain::Guard::~Guard() {
+    if (domain) {
+        domain->unpin();
+    }
+}
+
+// Move constructor: Transfer the pin
+EpochDomain::Guard::Guard(Guard &&other) noexcept : domain{std::exchange(other.domain, nullptr)} {
+}
+
+// Move assignment: Release the held pin and take the other one
+EpochDomain::Guard &EpochDomain::Guard::operator=(Guard &&other) noexcept {
+    if (this != &other) {
+        if (domain) {
+            domain->unpin();
+        }
+        domain = std::exchange(other.domain, nullptr);
+    }
+    return *this;
+}
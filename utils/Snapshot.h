@@ -0,0 +1,145 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// Epoch-based reclamation shared by every SnapshotCell
+// Readers pin the global epoch in a per-thread slot (one store, wait-free); writers retire replaced
+// objects tagged with the epoch they were unlinked in and free them once no slot is pinned at or before it
+class EpochDomain {
+public:
+    static constexpr size_t MaxThreads = 256;
+
+    // Keeps everything published at pin time alive until destroyed
+    // Pins nest and must be released on the thread that took them
+    class Guard {
+    public:
+        Guard() = default;
+
+        ~Guard();
+
+        Guard(Guard &&other) noexcept;
+
+        Guard &operator=(Guard &&other) noexcept;
+
+        Guard(const Guard &) = delete;
+
+        Guard &operator=(const Guard &) = delete;
+
+    private:
+        friend class EpochDomain;
+
+        explicit Guard(EpochDomain *domain);
+
+        EpochDomain *domain = nullptr;
+    };
+
+    static EpochDomain &instance();
+
+    [[nodiscard]] Guard pin();
+
+    // Defer a deleter until every reader that could still see the object has unpinned
+    void retire(std::function<void()> deleter);
+
+    // Run deleters that are safe now, returns how many ran; never waits for readers
+    size_t reclaim();
+
+    [[nodiscard]] size_t pendingRetired();
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<uint64_t> epoch{0};
+        std::atomic<bool> used{false};
+    };
+
+    std::array<Slot, MaxThreads> slots{};
+    std::atomic<uint64_t> globalEpoch{1};
+
+    std::mutex retireMutex;
+    std::vector<std::pair<uint64_t, std::function<void()> > > retired;
+
+    EpochDomain() = default;
+
+    void unpin();
+
+    Slot &threadSlot();
+
+    friend struct ThreadSlot;
+};
+
+// Immutable, versioned, block-tagged state published by one writer and read by any number of threads
+// Readers never block and always see a complete snapshot; publishing never waits for readers
+template<typename T>
+class SnapshotCell {
+public:
+    struct Snapshot {
+        T state;
+        uint64_t version = 0;
+        uint64_t block = 0;
+    };
+
+    // Pinned view of one snapshot, valid for its own lifetime
+    class View {
+    public:
+        [[nodiscard]] const T &operator*() const { return snapshot->state; }
+
+        [[nodiscard]] const T *operator->() const { return &snapshot->state; }
+
+        [[nodiscard]] uint64_t version() const { return snapshot->version; }
+
+        [[nodiscard]] uint64_t block() const { return snapshot->block; }
+
+    private:
+        friend class SnapshotCell;
+
+        View(EpochDomain::Guard guard, const Snapshot *snapshot)
+            : guard{std::move(guard)}, snapshot{snapshot} {
+        }
+
+        EpochDomain::Guard guard;
+        const Snapshot *snapshot;
+    };
+
+    SnapshotCell() : current{new Snapshot{}} {
+    }
+
+    ~SnapshotCell() {
+        delete current.load();
+    }
+
+    SnapshotCell(const SnapshotCell &) = delete;
+
+    SnapshotCell &operator=(const SnapshotCell &) = delete;
+
+    // Wait-free read of the latest published snapshot
+    [[nodiscard]] View read() const {
+        EpochDomain::Guard guard = EpochDomain::instance().pin();
+        return View(std::move(guard), current.load(std::memory_order_seq_cst));
+    }
+
+    // Swap in a new snapshot and retire the previous one
+    void publish(T state, const uint64_t block) {
+        auto *next = new Snapshot{std::move(state), nextVersion.fetch_add(1, std::memory_order_relaxed), block};
+        const Snapshot *previous = current.exchange(next, std::memory_order_seq_cst);
+        EpochDomain &domain = EpochDomain::instance();
+        domain.retire([previous] { delete previous; });
+        domain.reclaim();
+    }
+
+    // Version of the latest snapshot, 0 before the first publish
+    [[nodiscard]] uint64_t version() const {
+        return current.load(std::memory_order_acquire)->version;
+    }
+
+private:
+    std::atomic<const Snapshot *> current;
+    std::atomic<uint64_t> nextVersion{1};
+};
+
+#endif //SNAPSHOT_H
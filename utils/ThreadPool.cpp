@@ -0,0 +1,117 @@
+#include "ThreadPool.h"
+
+// Worker identity of the calling thread
+static thread_local ThreadPool *currentPool = nullptr;
+static thread_local size_t currentIndex = 0;
+
+// Constructor: Start one worker per queue
+ThreadPool::ThreadPool(size_t threadCount)
+    : tasksRun{Metrics::instance().counter("deds_pool_tasks_total", {}, "Tasks run by the thread pool")},
+      tasksStolen{Metrics::instance().counter("deds_pool_steals_total", {}, "Tasks stolen from another worker")} {
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+    for (size_t i = 0; i < threadCount; i++) {
+        queues.push_back(std::make_unique<Queue>());
+    }
+    for (size_t i = 0; i < threadCount; i++) {
+        workers.emplace_back([this, i] { workerLoop(i); });
+    }
+}
+
+// Destructor: Drain remaining tasks and join workers
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock(idleMutex);
+        stopping = true;
+    }
+    idle.notify_all();
+    for (auto &worker: workers) {
+        worker.join();
+    }
+}
+
+// Number of worker threads
+size_t ThreadPool::size() const {
+    return workers.size();
+}
+
+// Pool owning the calling thread
+ThreadPool *ThreadPool::current() {
+    return currentPool;
+}
+
+// Push to the caller's own deque from a worker, round-robin otherwise
+void ThreadPool::enqueue(std::function<void()> task) {
+    const size_t index = currentPool == this
+                             ? currentIndex
+                             : nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+    {
+        // Count before pushing so a concurrent pop never drives the counter below zero,
+        // and under the idle lock so a worker about to sleep cannot miss it
+        std::lock_guard lock(idleMutex);
+        queued.fetch_add(1, std::memory_order_release);
+    }
+    {
+        std::lock_guard lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    idle.notify_one();
+}
+
+// Take the newest task from the own deque, or the oldest from another one
+bool ThreadPool::popTask(std::function<void()> &task) {
+    const size_t self = currentPool == this ? currentIndex : 0;
+
+    {
+        std::lock_guard lock(queues[self]->mutex);
+        if (!queues[self]->tasks.empty()) {
+            task = std::move(queues[self]->tasks.back());
+            queues[self]->tasks.pop_back();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    for (size_t offset = 1; offset < queues.size(); offset++) {
+        Queue &victim = *queues[(self + offset) % queues.size()];
+        std::lock_guard lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued.fetch_sub(1, std::memory_order_relaxed);
+            tasksStolen.inc();
+            return true;
+        }
+    }
+    return false;
+}
+
+// Run one queued task on the calling thread
+bool ThreadPool::runPending() {
+    std::function<void()> task;
+    if (!popTask(task)) {
+        return false;
+    }
+    task();
+    tasksRun.inc();
+    return true;
+}
+
+// Worker: run tasks until stopped and drained, sleep while nothing is queued
+void ThreadPool::workerLoop(const size_t index) {
+    currentPool = this;
+    currentIndex = index;
+
+    while (true) {
+        if (runPending()) {
+            continue;
+        }
+
+        std::unique_lock lock(idleMutex);
+        idle.wait(lock, [this] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping && queued.load(std::memory_order_acquire) == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "Metrics.h"
+
+// Work-stealing thread pool
+// Each worker owns a deque: it pops its newest task and steals the oldest from the others when empty.
+// Tasks submitted from a worker stay on that worker's deque, so nested fan-out keeps cache locality
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threadCount = std::thread::hardware_concurrency());
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    // Queue a task, the future carries its result or exception
+    template<typename F>
+    auto submit(F &&task) -> std::future<std::invoke_result_t<std::decay_t<F> > > {
+        using Result = std::invoke_result_t<std::decay_t<F> >;
+        auto packaged = std::make_shared<std::packaged_task<Result()> >(std::forward<F>(task));
+        std::future<Result> future = packaged->get_future();
+        enqueue([packaged] { (*packaged)(); });
+        return future;
+    }
+
+    // Wait for a future, running queued tasks meanwhile so waits from inside a task cannot starve the pool
+    template<typename T>
+    T await(std::future<T> &future) {
+        while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            if (!runPending()) {
+                future.wait_for(std::chrono::microseconds(200));
+            }
+        }
+        return future.get();
+    }
+
+    [[nodiscard]] size_t size() const;
+
+    // Pool owning the calling thread, nullptr outside of worker threads
+    static ThreadPool *current();
+
+private:
+    struct Queue {
+        std::mutex mutex;
+        std::deque<std::function<void()> > tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue> > queues;
+    std::vector<std::thread> workers;
+
+    std::mutex idleMutex;
+    std::condition_variable idle;
+    std::atomic<size_t> queued{0};
+    std::atomic<size_t> nextQueue{0};
+    bool stopping = false;
+
+    Counter &tasksRun;
+    Counter &tasksStolen;
+
+    void enqueue(std::function<void()> task);
+
+    // Run one queued task if any: own deque first, then steal
+    bool runPending();
+
+    bool popTask(std::function<void()> &task);
+
+    void workerLoop(size_t index);
+};
+
+#endif //THREAD_POOL_H
@@ -22,8 +22,8 @@ std::string Utils::loadFile(const std::string &path) {
 }
 
 // Initialize pools from address list file
-std::unordered_map<std::string, std::unique_ptr<Pool> > Utils::initPools(const std::string &path) {
-    std::unordered_map<std::string, std::unique_ptr<Pool> > pools;
+std::unordered_map<std::string, Pool *> Utils::initPools(const std::string &path, Arena<Pool> &arena) {
+    std::unordered_map<std::string, Pool *> pools;
 
     try {
         std::string content = loadFile(path);
@@ -38,10 +38,10 @@ std::unordered_map<std::string, std::unique_ptr<Pool> > Utils::initPools(const s
             line.erase(0, line.find_first_not_of(" \t\r\n"));
             line.erase(line.find_last_not_of(" \t\r\n") + 1);
 
-            if (!line.empty()) {
-                auto poolPtr = std::make_unique<Pool>();
-                poolPtr->address = line;
-                pools[line] = std::move(poolPtr);
+            if (!line.empty() && !pools.contains(line)) {
+                Pool *pool = arena.create();
+                pool->address = line;
+                pools[line] = pool;
             }
         }
     } catch (const std::exception &e) {
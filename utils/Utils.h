@@ -3,6 +3,7 @@
 
 #include <string>
 #include <unordered_map>
+#include "Arena.h"
 #include "../exchanges/Pool.h"
 
 struct Pool;
@@ -11,7 +12,8 @@ struct Pool;
 struct Utils {
     static std::string loadFile(const std::string &path);
 
-    static std::unordered_map<std::string, std::unique_ptr<Pool> > initPools(const std::string &path);
+    // Pools listed in the file, allocated from the exchange's arena
+    static std::unordered_map<std::string, Pool *> initPools(const std::string &path, Arena<Pool> &arena);
 };
 
 #endif //UTILS_H
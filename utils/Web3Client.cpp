@@ -1,64 +1,106 @@
 #include "Web3Client.h"
 #include <iostream>
 #include <sstream>
-#include <curl/curl.h>
 #include <nlohmann/json.hpp>
-#include <cryptopp/keccak.h>
-#include <cryptopp/filters.h>
+#include "Keccak.h"
 
 using json = nlohmann::json;
 
-// Callback function for curl to write response data
-static size_t WriteCallback(void *contents, const size_t size, const size_t nmemb, std::string *s) {
-    const size_t newLength{size * nmemb};
-    try {
-        s->append(static_cast<char *>(contents), newLength);
-        return newLength;
-    } catch (const std::exception &e) {
-        return 0;
+// Constructor: Register transport metrics, the transport starts its connection loop
+Web3Client::Web3Client(std::string rpcUrl, std::string chain, TransportOptions transportOptions)
+    : rpcUrl{std::move(rpcUrl)}, chain{std::move(chain)},
+      bytesOut{Metrics::instance().counter("deds_rpc_bytes_out_total", labels(), "JSON-RPC request bytes sent")},
+      bytesIn{Metrics::instance().counter("deds_rpc_bytes_in_total", labels(), "JSON-RPC response bytes received")},
+      wireBytesIn{
+          Metrics::instance().counter("deds_rpc_wire_bytes_in_total", labels(),
+                                      "JSON-RPC response bytes on the wire, before decompression")
+      },
+      connections{Metrics::instance().counter("deds_rpc_connections_total", labels(), "Connections opened")},
+      batchSize{
+          Metrics::instance().histogram("deds_rpc_batch_size", labels(), "Calls per eth_call batch sent on the wire",
+                                        Histogram::sizeBuckets())
+      },
+      transport{this->rpcUrl, transportOptions} {
+    const std::array<const char *, 4> kinds{"transport", "http_status", "parse", "rpc"};
+    for (size_t i = 0; i < kinds.size(); i++) {
+        errors[i] = &Metrics::instance().counter("deds_rpc_errors_total", labels({{"kind", kinds[i]}}),
+                                                 "Failed JSON-RPC requests by kind");
     }
 }
 
-// Constructor: Initialize curl globally
-Web3Client::Web3Client() {
-    curl_global_init(CURL_GLOBAL_DEFAULT);
+// Destructor: The transport waits for requests in flight
+Web3Client::~Web3Client() = default;
+
+// Build metric labels, chain first
+MetricLabels Web3Client::labels(MetricLabels extra) const {
+    if (!chain.empty()) {
+        extra.insert(extra.begin(), {"chain", chain});
+    }
+    return extra;
 }
 
-// Destructor: Clean up curl
-Web3Client::~Web3Client() {
-    curl_global_cleanup();
+// Count a failed request by kind
+void Web3Client::countError(const ErrorKind kind) const {
+    errors[static_cast<size_t>(kind)]->inc();
 }
 
-// Send HTTP request using curl and parse JSON response
-json Web3Client::sendHttpRequest(const std::string &requestBody) {
-    CURL *curl = curl_easy_init();
-    if (!curl) {
-        throw std::runtime_error{"Failed to initialize CURL"};
+// Get the latency histogram of a method, registered with the metrics on its first request
+Histogram &Web3Client::requestLatency(const std::string &method) {
+    {
+        std::shared_lock lock(latencyMutex);
+        if (const auto it = latencyByMethod.find(method); it != latencyByMethod.end()) return *it->second;
     }
+    Histogram &histogram = Metrics::instance().histogram("deds_rpc_request_seconds", labels({{"method", method}}),
+                                                         "JSON-RPC round trip latency by method");
+    std::lock_guard lock(latencyMutex);
+    latencyByMethod.emplace(method, &histogram);
+    return histogram;
+}
 
-    std::string responseString;
-    struct curl_slist *headers = nullptr;
-    headers = curl_slist_append(headers, "Content-Type: application/json");
+// Send the request through the transport and parse the JSON response
+json Web3Client::sendHttpRequest(const std::string &requestBody, const std::string &method) {
+    ScopedTimer timer(requestLatency(method));
 
-    curl_easy_setopt(curl, CURLOPT_URL, rpcUrl.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, requestBody.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &responseString);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+    TransportResponse response;
+    try {
+        response = transport.post(requestBody);
+    } catch (const std::exception &e) {
+        bytesOut.inc(requestBody.size());
+        countError(ErrorKind::Transport);
+        throw std::runtime_error{e.what()};
+    }
+    bytesOut.inc(requestBody.size());
+    bytesIn.inc(response.body.size());
+    wireBytesIn.inc(response.wireBytes);
+    connections.inc(static_cast<uint64_t>(response.newConnections));
 
-    const CURLcode res = curl_easy_perform(curl);
-    long response_code;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response_code);
+    if (response.body.empty()) {
+        countError(ErrorKind::Transport);
+        throw std::runtime_error{"HTTP request failed: empty response"};
+    }
+    if (response.status != 200) {
+        countError(ErrorKind::HttpStatus);
+        throw std::runtime_error{"HTTP request failed with status " + std::to_string(response.status)};
+    }
 
-    curl_slist_free_all(headers);
-    curl_easy_cleanup(curl);
+    json responseJson;
+    try {
+        responseJson = json::parse(response.body);
+    } catch (const json::parse_error &) {
+        countError(ErrorKind::Parse);
+        throw;
+    }
 
-    if (res != CURLE_OK || response_code != 200 || responseString.empty()) {
-        throw std::runtime_error{"HTTP request failed"};
+    std::shared_ptr<RpcRecorder> activeRecorder;
+    {
+        std::lock_guard lock(recorderMutex);
+        activeRecorder = recorder;
+    }
+    if (activeRecorder) {
+        activeRecorder->record(json::parse(requestBody), responseJson);
     }
 
-    return json::parse(responseString);
+    return responseJson;
 }
 
 // Convert byte string to hexadecimal representation
@@ -73,6 +115,13 @@ std::string Web3Client::bytesToHex(const std::string &bytes) {
     return "0x" + ss.str();
 }
 
+// Hex quantity of a block number
+std::string Web3Client::blockTag(const uint64_t block) {
+    std::stringstream ss;
+    ss << "0x" << std::hex << block;
+    return ss.str();
+}
+
 // Send JSON-RPC request to Ethereum node
 json Web3Client::sendRpcRequest(const std::string &method, const json &params) {
     const json requestJson{
@@ -82,18 +131,88 @@ json Web3Client::sendRpcRequest(const std::string &method, const json &params) {
         {"id", requestId++}
     };
 
-    json responseJson = sendHttpRequest(requestJson.dump());
+    json responseJson = sendHttpRequest(requestJson.dump(), method);
     if (responseJson.contains("error")) {
+        countError(ErrorKind::Rpc);
         throw std::runtime_error{"RPC error: " + responseJson["error"].dump()};
     }
+
+    if (method == "eth_blockNumber" && responseJson["result"].is_string()) {
+        const uint64_t head = std::stoull(responseJson["result"].get<std::string>(), nullptr, 16);
+        uint64_t previous = observedHead.load();
+        while (previous < head && !observedHead.compare_exchange_weak(previous, head)) {
+        }
+        cache.advanceHead(head);
+    }
     return responseJson["result"];
 }
 
+// Get latest block number, also advances the call cache head
+uint64_t Web3Client::getBlockNumber() {
+    const json result = sendRpcRequest("eth_blockNumber");
+    return std::stoull(result.get<std::string>(), nullptr, 16);
+}
+
+// Start appending request/response pairs to a recording file
+void Web3Client::startRecording(const std::string &path) {
+    auto newRecorder = std::make_shared<RpcRecorder>(path);
+    std::lock_guard lock(recorderMutex);
+    recorder = std::move(newRecorder);
+}
+
+// Stop recording, the file is closed once in-flight requests finish
+void Web3Client::stopRecording() {
+    std::lock_guard lock(recorderMutex);
+    recorder.reset();
+}
+
+// Get endpoint URL
+const std::string &Web3Client::getRpcUrl() const {
+    return rpcUrl;
+}
+
+// Get chain label, empty for a single-chain process
+const std::string &Web3Client::getChain() const {
+    return chain;
+}
+
+// Get the endpoint's transport settings
+const TransportOptions &Web3Client::getTransportOptions() const {
+    return transport.options();
+}
+
+// Get highest observed head
+uint64_t Web3Client::getObservedHead() const {
+    return observedHead.load();
+}
+
+// Get eth_call cache counters
+CallCache::Stats Web3Client::getCacheStats() const {
+    return cache.stats();
+}
+
+// Bound the number of pinned-block responses kept in memory
+void Web3Client::setCacheCapacity(const size_t capacity) {
+    cache.setCapacity(capacity);
+}
+
+// Bound how long "latest" responses are served between head observations
+void Web3Client::setCacheMaxLatestAge(const std::chrono::milliseconds maxAge) {
+    cache.setMaxLatestAge(maxAge);
+}
+
+// Enable or bypass the eth_call cache
+void Web3Client::setCacheEnabled(const bool enabled) {
+    cacheEnabled = enabled;
+    if (!enabled) {
+        cache.clear();
+    }
+}
+
 // Compute Keccak-256 hash of input string
 std::string Web3Client::keccak256(const std::string &input) {
-    std::string digest;
-    CryptoPP::Keccak_256 hash;
-    CryptoPP::StringSource ss(input, true, new CryptoPP::HashFilter(hash, new CryptoPP::StringSink(digest)));
+    std::string digest(Keccak::DigestSize, '\0');
+    Keccak::hash(input.data(), input.size(), reinterpret_cast<uint8_t *>(digest.data()));
     return digest;
 }
 
@@ -113,22 +232,50 @@ mpf_class Web3Client::getGasPrice() {
 }
 
 // Call smart contract function and decode response
-json Web3Client::call(Contract &contract, const std::string &functionName, const json &params) {
+json Web3Client::call(const Contract &contract, const std::string &functionName, const json &params,
+                      const std::string &blockTag) {
     std::string data = contract.encodeFunction(functionName, params);
-    json callParams = json::array({{{"to", contract.address}, {"data", data}}, "latest"});
-    json result = sendRpcRequest("eth_call", callParams);
-    return contract.decodeResponse(result.get<std::string>(), functionName);
+    return contract.decodeResponse(callRaw(contract.address, data, blockTag), functionName);
 }
 
-// Execute multiple contract calls in a single batch request
-json Web3Client::multicall(std::vector<CallRequest> &calls) {
-    // Create batch of individual call objects
-    json batch = json::array();
-    std::vector<std::pair<std::string, std::unique_ptr<Contract> > > callInfo;
+// Send a single eth_call through the response cache
+std::string Web3Client::callRaw(const std::string &to, const std::string &data, const std::string &blockTag) {
+    const auto sendCall = [&] {
+        json callParams = json::array({{{"to", to}, {"data", data}}, blockTag});
+        return sendRpcRequest("eth_call", callParams).get<std::string>();
+    };
 
-    for (size_t i = 0; i < calls.size(); i++) {
-        auto &call = calls[i];
-        std::string data = call.contract.encodeFunction(call.functionName, call.params);
+    if (!cacheEnabled || !CallCache::isCacheable(blockTag)) {
+        return sendCall();
+    }
+
+    const bool immutable = CallCache::isImmutable(blockTag);
+    const std::string key = CallCache::makeKey(to, data, blockTag);
+    CallCache::Lookup lookup = cache.acquire(key, immutable);
+
+    if (lookup.kind == CallCache::Lookup::Kind::Hit) {
+        return lookup.value;
+    }
+    if (lookup.kind == CallCache::Lookup::Kind::Pending) {
+        return lookup.pending.get();
+    }
+
+    try {
+        std::string result = sendCall();
+        cache.fulfill(key, immutable, lookup.generation, result);
+        return result;
+    } catch (...) {
+        cache.fail(key, std::current_exception());
+        throw;
+    }
+}
+
+// Build a JSON-RPC batch of eth_call requests with consecutive ids starting at firstId
+json Web3Client::buildCallBatch(const std::vector<std::pair<std::string, std::string> > &targets,
+                                const std::string &blockTag, const unsigned int firstId, const json &stateOverrides) {
+    json batch = json::array();
+    for (size_t j = 0; j < targets.size(); j++) {
+        const auto &[to, data] = targets[j];
 
         // Create individual eth_call request
         json callRequest = {
@@ -137,38 +284,184 @@ json Web3Client::multicall(std::vector<CallRequest> &calls) {
             {
                 "params", json::array({
                     {
-                        {"to", call.contract.address},
+                        {"to", to},
                         {"data", data}
                     },
-                    "latest"
+                    blockTag
                 })
             },
-            {"id", static_cast<int>(requestId + i)}
+            {"id", firstId + j}
         };
+        if (!stateOverrides.is_null()) {
+            callRequest["params"].push_back(stateOverrides);
+        }
 
         batch.push_back(callRequest);
-        callInfo.emplace_back(call.functionName, std::make_unique<Contract>(call.contract));
+    }
+    return batch;
+}
+
+// Build eth_getStorageAt batch
+json Web3Client::buildStorageBatch(const std::vector<std::pair<std::string, std::string> > &slots,
+                                   const std::string &blockTag, const unsigned int firstId) {
+    json batch = json::array();
+    for (size_t j = 0; j < slots.size(); j++) {
+        const auto &[contract, slot] = slots[j];
+        batch.push_back({
+            {"jsonrpc", "2.0"},
+            {"method", "eth_getStorageAt"},
+            {"params", json::array({contract, slot, blockTag})},
+            {"id", firstId + j}
+        });
+    }
+    return batch;
+}
+
+// Execute multiple contract calls in a single batch request
+json Web3Client::multicall(std::vector<CallRequest> &calls, const std::string &blockTag) {
+    std::vector<std::pair<std::string, std::string> > targets;
+    targets.reserve(calls.size());
+    for (auto &call: calls) {
+        targets.emplace_back(call.contract->address, Contract::encodeFunction(*call.function, call.params));
     }
 
-    // Send batch request using shared HTTP method
-    std::string requestBody = batch.dump();
-    json batchResponse = sendHttpRequest(requestBody);
+    std::vector<std::string> responses = multicallRaw(targets, blockTag);
 
-    requestId += calls.size(); // Update request ID counter
     json results = json::object();
+    for (size_t i = 0; i < calls.size(); i++) {
+        auto &call = calls[i];
+        results[call.function->name].push_back(Contract::decodeResponse(responses[i], *call.function));
+    }
 
-    // Process each response in the batch
-    for (size_t i = 0; i < batchResponse.size(); i++) {
-        const auto &response = batchResponse[i];
+    return results;
+}
+
+// Batch pre-encoded eth_calls, returns raw hex results in call order
+std::vector<std::string> Web3Client::multicallRaw(const std::vector<std::pair<std::string, std::string> > &calls,
+                                                  const std::string &blockTag) {
+    return sendRawBatch(BatchMethod::Call, calls, blockTag);
+}
+
+// Batch eth_call with state overrides, returns raw hex results in call order
+std::vector<std::string> Web3Client::multicallRawOverride(
+    const std::vector<std::pair<std::string, std::string> > &calls, const json &stateOverrides,
+    const std::string &blockTag) {
+    return sendRawBatch(BatchMethod::Call, calls, blockTag, stateOverrides);
+}
+
+// Batch storage slot reads, returns raw words in slot order
+std::vector<std::string> Web3Client::getStorageAtBatch(const std::vector<std::pair<std::string, std::string> > &slots,
+                                                       const std::string &blockTag) {
+    return sendRawBatch(BatchMethod::StorageAt, slots, blockTag);
+}
+
+// Send (to, data) or (contract, slot) items as one batch, skipping cached and in-flight ones
+std::vector<std::string> Web3Client::sendRawBatch(const BatchMethod method,
+                                                  const std::vector<std::pair<std::string, std::string> > &calls,
+                                                  const std::string &blockTag, const json &stateOverrides) {
+    const bool cacheable = cacheEnabled && CallCache::isCacheable(blockTag) && stateOverrides.is_null();
+    const bool immutable = CallCache::isImmutable(blockTag);
+
+    std::vector<std::string> responses(calls.size());
+    std::vector<std::string> keys(calls.size());
+    std::vector<uint64_t> generations(calls.size(), 0);
+    std::vector<std::pair<size_t, std::shared_future<std::string> > > pending;
+    std::vector<std::pair<size_t, std::string> > owned;
 
-        if (response.contains("error")) {
-            throw std::runtime_error{"RPC error in batch item " + std::to_string(i) + ": " + response["error"].dump()};
+    // Resolve cached and in-flight calls, only the remaining ones go on the wire. Calls arrive encoded, nothing
+    // here should throw once an entry is owned, but if it does the owned entries are released so coalesced
+    // callers are not left waiting on them
+    try {
+        for (size_t i = 0; i < calls.size(); i++) {
+            const auto &[to, data] = calls[i];
+
+            if (cacheable) {
+                // Storage keys cannot collide with calldata, which always starts with "0x"
+                keys[i] = CallCache::makeKey(to, method == BatchMethod::Call ? data : "slot:" + data, blockTag);
+                CallCache::Lookup lookup = cache.acquire(keys[i], immutable);
+                if (lookup.kind == CallCache::Lookup::Kind::Hit) {
+                    responses[i] = std::move(lookup.value);
+                    continue;
+                }
+                if (lookup.kind == CallCache::Lookup::Kind::Pending) {
+                    pending.emplace_back(i, std::move(lookup.pending));
+                    continue;
+                }
+                generations[i] = lookup.generation;
+            }
+            owned.emplace_back(i, data);
+        }
+    } catch (...) {
+        if (cacheable) {
+            for (const auto &[index, data]: owned) cache.fail(keys[index], std::current_exception());
         }
+        throw;
+    }
+
+    if (!owned.empty()) {
+        std::vector<bool> settled(owned.size(), false);
+        try {
+            const unsigned int firstId = requestId.fetch_add(static_cast<unsigned int>(owned.size()));
+
+            std::vector<std::pair<std::string, std::string> > targets;
+            targets.reserve(owned.size());
+            for (auto &[index, data]: owned) {
+                targets.emplace_back(calls[index].first, std::move(data));
+            }
+
+            // Send batch request using shared HTTP method
+            const bool isCall = method == BatchMethod::Call;
+            std::string requestBody = (isCall ? buildCallBatch(targets, blockTag, firstId, stateOverrides)
+                                              : buildStorageBatch(targets, blockTag, firstId)).dump();
+            batchSize.observe(static_cast<double>(owned.size()));
+            json batchResponse = sendHttpRequest(requestBody, isCall ? "eth_call_batch" : "eth_getStorageAt_batch");
+
+            if (!batchResponse.is_array()) {
+                countError(ErrorKind::Rpc);
+                throw std::runtime_error{"RPC batch error: " + batchResponse.dump()};
+            }
+
+            // Process each response in the batch, nodes may answer out of order
+            for (const auto &response: batchResponse) {
+                const size_t j = response["id"].get<unsigned int>() - firstId;
+                if (j >= owned.size()) {
+                    throw std::runtime_error{"Unexpected id in batch response: " + response["id"].dump()};
+                }
+                if (response.contains("error")) {
+                    countError(ErrorKind::Rpc);
+                    throw std::runtime_error{
+                        "RPC error in batch item " + std::to_string(j) + ": " + response["error"].dump()
+                    };
+                }
 
-        const auto &[functionName, contract] = callInfo[i];
-        json result = response["result"];
-        results[functionName].push_back(contract->decodeResponse(result.get<std::string>(), functionName));
+                const size_t index = owned[j].first;
+                responses[index] = response["result"].get<std::string>();
+                if (cacheable) {
+                    cache.fulfill(keys[index], immutable, generations[index], responses[index]);
+                }
+                settled[j] = true;
+            }
+
+            for (size_t j = 0; j < owned.size(); j++) {
+                if (!settled[j]) {
+                    throw std::runtime_error{"Missing response for batch item " + std::to_string(j)};
+                }
+            }
+        } catch (...) {
+            if (cacheable) {
+                for (size_t j = 0; j < owned.size(); j++) {
+                    if (!settled[j]) {
+                        cache.fail(keys[owned[j].first], std::current_exception());
+                    }
+                }
+            }
+            throw;
+        }
     }
 
-    return results;
+    for (auto &[index, future]: pending) {
+        responses[index] = future.get();
+    }
+
+    return responses;
 }
@@ -1,46 +1,152 @@
 #ifndef WEB3CLIENT_H
 #define WEB3CLIENT_H
 
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <unordered_map>
 #include <nlohmann/json.hpp>
 #include "Contract.h"
+#include "CallCache.h"
+#include "HttpTransport.h"
+#include "Metrics.h"
+#include "RpcRecorder.h"
 #include <gmpxx.h>
 
 using json = nlohmann::json;
 
 // Structure for batching multiple contract calls
+// A handle, not a copy: the contract must outlive the multicall it is passed to
 struct CallRequest {
-    Contract contract;
-    std::string functionName;
+    const Contract *contract;
+    const AbiFunction *function;
     json params;
+
+    CallRequest(const Contract &contract, const std::string &functionName, json params = json::array())
+        // Parentheses, braces would wrap the json in a one-element array
+        : contract{&contract}, function{&contract.function(functionName)}, params(std::move(params)) {
+    }
 };
 
 // Web3 client for Ethereum JSON-RPC communication
 class Web3Client {
 public:
-    Web3Client();
+    // A non-empty chain name labels this client's metrics, for several chains in one process
+    explicit Web3Client(std::string rpcUrl = "https://arb1.arbitrum.io/rpc", std::string chain = "",
+                        TransportOptions transportOptions = {});
 
     ~Web3Client();
 
     // Contract interaction methods
-    json call(Contract &contract, const std::string &functionName, const json &params = json::array());
+    json call(const Contract &contract, const std::string &functionName, const json &params = json::array(),
+              const std::string &blockTag = "latest");
+
+    json multicall(std::vector<CallRequest> &calls, const std::string &blockTag = "latest");
+
+    // Raw eth_call paths for pre-encoded calldata (typed bindings), results are undecoded hex
+    std::string callRaw(const std::string &to, const std::string &data, const std::string &blockTag = "latest");
+
+    std::vector<std::string> multicallRaw(const std::vector<std::pair<std::string, std::string> > &calls,
+                                          const std::string &blockTag = "latest");
 
-    json multicall(std::vector<CallRequest> &calls);
+    // eth_call batch against state overrides (e.g. code placed at an unused address), never cached
+    std::vector<std::string> multicallRawOverride(const std::vector<std::pair<std::string, std::string> > &calls,
+                                                  const json &stateOverrides, const std::string &blockTag = "latest");
+
+    // Batched eth_getStorageAt, slots are (contract, 32-byte hex slot) pairs; results are 32-byte hex words
+    std::vector<std::string> getStorageAtBatch(const std::vector<std::pair<std::string, std::string> > &slots,
+                                               const std::string &blockTag = "latest");
 
     json sendRpcRequest(const std::string &method, const json &params = json::array());
 
+    uint64_t getBlockNumber();
+
+    // Highest block number seen from eth_blockNumber so far
+    [[nodiscard]] uint64_t getObservedHead() const;
+
+    // eth_call response cache
+    [[nodiscard]] CallCache::Stats getCacheStats() const;
+
+    void setCacheCapacity(size_t capacity);
+
+    void setCacheMaxLatestAge(std::chrono::milliseconds maxAge);
+
+    void setCacheEnabled(bool enabled);
+
+    // Capture every request/response pair to a JSON Lines file for RpcReplayServer
+    void startRecording(const std::string &path);
+
+    void stopRecording();
+
+    [[nodiscard]] const std::string &getRpcUrl() const;
+
+    [[nodiscard]] const std::string &getChain() const;
+
+    [[nodiscard]] const TransportOptions &getTransportOptions() const;
+
+    // Metric labels with the chain prepended when set
+    [[nodiscard]] MetricLabels labels(MetricLabels extra = {}) const;
+
     // Utility methods
     static std::string keccak256(const std::string &input);
 
     static std::string bytesToHex(const std::string &bytes);
 
+    // Block tag of a block number, for reads at that block
+    static std::string blockTag(uint64_t block);
+
+    // Build a JSON-RPC batch of eth_call requests, targets are (to, calldata) pairs. Non-null stateOverrides
+    // become every call's third parameter
+    static json buildCallBatch(const std::vector<std::pair<std::string, std::string> > &targets,
+                               const std::string &blockTag, unsigned int firstId, const json &stateOverrides = nullptr);
+
+    // Build a JSON-RPC batch of eth_getStorageAt requests, slots are (contract, slot) pairs
+    static json buildStorageBatch(const std::vector<std::pair<std::string, std::string> > &slots,
+                                  const std::string &blockTag, unsigned int firstId);
+
     mpf_class getGasPrice();
 
 private:
-    std::string rpcUrl{"https://arb1.arbitrum.io/rpc"};
-    unsigned int requestId{1};
+    std::string rpcUrl;
+    std::string chain;
+    std::atomic<unsigned int> requestId{1};
+    CallCache cache;
+    std::atomic<bool> cacheEnabled{true};
+    std::atomic<uint64_t> observedHead{0};
+
+    std::mutex recorderMutex;
+    std::shared_ptr<RpcRecorder> recorder;
+
+    // Hot-path metrics, registered once per client
+    Counter &bytesOut;
+    Counter &bytesIn;
+    Counter &wireBytesIn;
+    Counter &connections;
+    Histogram &batchSize;
+    // Failed requests per ErrorKind, and round trip latency per method, resolved on first use
+    enum class ErrorKind { Transport, HttpStatus, Parse, Rpc };
+    std::array<Counter *, 4> errors{};
+    std::shared_mutex latencyMutex;
+    std::unordered_map<std::string, Histogram *> latencyByMethod;
+
+    // Declared last, its loop thread stops before the rest of the client is torn down
+    HttpTransport transport;
+
+    json sendHttpRequest(const std::string &requestBody, const std::string &method);
+
+    enum class BatchMethod { Call, StorageAt };
+
+    // Shared path of the raw batches: cache, coalescing, one batch for the misses. Overridden calls skip the cache
+    std::vector<std::string> sendRawBatch(BatchMethod method,
+                                          const std::vector<std::pair<std::string, std::string> > &items,
+                                          const std::string &blockTag, const json &stateOverrides = nullptr);
+
+    void countError(ErrorKind kind) const;
 
-    json sendHttpRequest(const std::string &requestBody);
+    Histogram &requestLatency(const std::string &method);
 };
 
 #endif //WEB3CLIENT_H